@@ -223,7 +223,8 @@ sys_res chl_RecData(chl p, buf b, size_t nTmo)
 	case CHL_T_SOC_TS:
 	case CHL_T_SOC_UC:
 	case CHL_T_SOC_US:
-		for (nTmo /= OS_TICK_MS; nTmo; nTmo--)
+		//nTmo == 0 polls once
+		for (nTmo /= OS_TICK_MS; ; nTmo--)
 		{
 			while ((nLen = recv((int)(p->pIf), aBuf, sizeof(aBuf), MSG_DONTWAIT)) > 0)
 			{
@@ -231,7 +232,7 @@ sys_res chl_RecData(chl p, buf b, size_t nTmo)
 				res = SYS_R_OK;
 			}
 			
-			if (res == SYS_R_OK)
+			if ((res == SYS_R_OK) || (nTmo == 0))
 				break;
 		
 			os_thd_slp1tick();
@@ -268,6 +268,15 @@ typedef const struct
 	p_gw3761_item item; 	//ӦDT1ĵַ
 } t_gw3761_dt, *p_gw3761_dt;
 
+//
+typedef const struct
+{
+	u16	ofs;		//Դ¼еֶƫ
+	u8	type;		//ԼGW3761_DATA_T_xx
+	u8	sign : 1,	//з
+		scale : 7;	//Сλ,ٷΪ2
+} t_gw3761_conv;
+
 
 
 //External Functions
@@ -305,6 +314,7 @@ void gw3761_ConvertData_22(void *p, u32 nData);
 void gw3761_ConvertData_23(void *p, u32 nData);
 void gw3761_ConvertData_25(void *p, u32 nData, int nSign);
 void gw3761_ConvertData_26(void *p, u32 nData);
+int gw3761_ConvertRecord(void *p, const void *pRec, size_t nRecSize, int nRecQty, t_gw3761_conv *pConv, int nQty);
 
 u64 gw3761_EvtCount(void);
 
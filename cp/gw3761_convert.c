@@ -1,6 +1,78 @@
+//Private Typedefs
+typedef const struct
+{
+	u8	dec;		//Сλ
+	u8	size;		//볤
+	u8	signbit;	//λ,0Ϊ޷
+	u32	mask;
+} t_gw3761_format;
+
+
+//Private Variables
+//ݸʽ,GW3761_DATA_T_xx,sizeΪ0gw3761_ConvertRecord
+static t_gw3761_format gw3761_tblFormat[GW3761_DATA_T_27 + 1] = {
+	{0},
+	{0},							//A.1
+	{0},							//A.2
+	{0, 4, 28, 0x0FFFFFFF},			//A.3
+	{0},							//A.4
+	{1, 2, 15, 0x00007FFF},			//A.5
+	{2, 2, 15, 0x00007FFF},			//A.6
+	{1, 2, 0, 0x0000FFFF},			//A.7
+	{0},							//A.8
+	{4, 3, 23, 0x007FFFFF},			//A.9
+	{0},							//A.10
+	{2, 4, 0, 0xFFFFFFFF},			//A.11
+	{0},							//A.12
+	{4, 4, 0, 0xFFFFFFFF},			//A.13
+	{0},							//A.14
+	{0},							//A.15
+	{0},							//A.16
+	{0},							//A.17
+	{0},							//A.18
+	{0},							//A.19
+	{0},							//A.20
+	{0},							//A.21
+	{1, 1, 0, 0x000000FF},			//A.22
+	{4, 3, 0, 0x00FFFFFF},			//A.23
+	{0},							//A.24
+	{3, 3, 23, 0x007FFFFF},			//A.25
+	{3, 2, 0, 0x0000FFFF},			//A.26
+	{0},							//A.27
+};
+
+
+
+//Internal Functions
+static void gw3761_ConvertFix(u8 *p, u32 nData, t_gw3761_format *pFmt, int nDec, int nSign)
+{
+	u32 nResult;
+	u64 nTemp;
+
+	if (nData == GW3761_DATA_INVALID)
+	{
+		memset(p, 0xEE, pFmt->size);
+		return;
+	}
+	if (nSign && pFmt->signbit && ((fixpoint)nData < 0))
+	{
+		nData = -(fixpoint)nData;
+		nSign = BITMASK(pFmt->signbit);
+	}
+	else
+	{
+		nSign = 0;
+	}
+	//,
+	nTemp = ((u64)nData * math_pow10[nDec] + (1 << (EXP - 1))) >> EXP;
+	nResult = ((u32)bin2bcd64(nTemp) & pFmt->mask) | nSign;
+	memcpy(p, &nResult, pFmt->size);
+}
 
 
 
+
+//External Functions
 //-------------------------------------------------------------------------
 //ת
 //-------------------------------------------------------------------------
@@ -316,6 +388,77 @@ void gw3761_ConvertData_26(void *p, u32 nData)
 	gw3761_ConvertData(p, nData, 3, 0x0000FFFF, 0, 2, 0);
 }
 
+//-------------------------------------------------------------------------
+//nRecQty¼Ϊ,ر볤,-1Ϊ
+//ֶΪfixpoint,A.14Ϊfloat,A.1/A.15/A.17/A.18Ϊtime_t,
+//ֵΪGW3761_DATA_INVALIDĶֶαΪ0xEE
+//-------------------------------------------------------------------------
+int gw3761_ConvertRecord(void *p, const void *pRec, size_t nRecSize, int nRecQty, t_gw3761_conv *pConv, int nQty)
+{
+	t_gw3761_conv *pc, *pEnd;
+	t_gw3761_format *pFmt;
+	u8 *pData = (u8 *)p;
+	const u8 *pSrc;
+	u32 nData;
+	time_t tTime;
+	float fData;
+	u64 nTemp;
+
+	for (pEnd = pConv + nQty; nRecQty; nRecQty--, pRec = (const u8 *)pRec + nRecSize)
+	{
+		for (pc = pConv; pc < pEnd; pc++)
+		{
+			pSrc = (const u8 *)pRec + pc->ofs;
+			if (pc->type <= GW3761_DATA_T_27)
+			{
+				pFmt = &gw3761_tblFormat[pc->type];
+				if (pFmt->size)
+				{
+					memcpy(&nData, pSrc, sizeof(nData));
+					gw3761_ConvertFix(pData, nData, pFmt, pFmt->dec + pc->scale, pc->sign);
+					pData += pFmt->size;
+					continue;
+				}
+			}
+			switch (pc->type)
+			{
+			case GW3761_DATA_T_01:
+				memcpy(&tTime, pSrc, sizeof(tTime));
+				gw3761_ConvertData_01(pData, tTime);
+				pData += 6;
+				break;
+			case GW3761_DATA_T_14:
+				memcpy(&fData, pSrc, sizeof(fData));
+				nTemp = fData * 100.0f + 0.5f;
+				*pData++ = 0;
+				nData = bin2bcd64(nTemp);
+				memcpy(pData, &nData, 4);
+				pData += 4;
+				break;
+			case GW3761_DATA_T_15:
+				memcpy(&tTime, pSrc, sizeof(tTime));
+				gw3761_ConvertData_15(pData, tTime);
+				pData += 5;
+				break;
+			case GW3761_DATA_T_17:
+				memcpy(&tTime, pSrc, sizeof(tTime));
+				gw3761_ConvertData_17(pData, tTime);
+				pData += 4;
+				break;
+			case GW3761_DATA_T_18:
+				memcpy(&tTime, pSrc, sizeof(tTime));
+				gw3761_ConvertData_18(pData, tTime);
+				pData += 3;
+				break;
+			default:
+				return -1;
+			}
+		}
+	}
+
+	return pData - (u8 *)p;
+}
+
 
 
 
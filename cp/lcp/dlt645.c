@@ -2,7 +2,14 @@
 
 
 //Private Defines
+#if DLT645_POLL_ENABLE
+#define DLT645_POLL_S_IDLE		0
+#define DLT645_POLL_S_WAIT		1
+#define DLT645_POLL_S_GAP		2
+#define DLT645_POLL_S_TURN		3
 
+#define DLT645_POLL_NONE		0xFFFF
+#endif
 
 
 //Private Typedef
@@ -24,21 +31,13 @@ struct dlt645_header
 #if DLT645_DEBUG_ENABLE
 static void dlt645_DbgOut(int nType, const void *pBuf, size_t nLen)
 {
-	const u8 *pData, *pEnd;
 	char str[DBG_BUF_SIZE];
 
-	pData = (const u8 *)pBuf;
-	pEnd = pData + nLen;
-
 	if (nType)
-		nLen = sprintf(str, "%s", "<645T>");
+		memcpy(str, "<645T>", 6);
 	else
-		nLen = sprintf(str, "%s", "<645R>");
-
-	while ((pData < pEnd) && (nLen < (sizeof(str) - 3)))
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
+		memcpy(str, "<645R>", 6);
+	hexdump(&str[6], sizeof(str) - 6, pBuf, nLen);
 
 	dbg_trace(str);
 }
@@ -101,45 +100,57 @@ u8 *dlt645_PacketAnalyze(const u8 *p, size_t len)
 }
 
 static const u8 dlt645_aFE[] = {0xFE, 0xFE, 0xFE, 0xFE};
-sys_res dlt645_Meter(chl c, buf b, size_t nTmo)
-{
-	u8 *pH, aAdr[6];
 #if DLT645_DIR_CTRL
+//ͺ󱣳ַͷʱ(ms),ȴڷ
+static int dlt645_DirHold(chl c)
+{
 	uart_t *pUart;
+
+	pUart = (uart_t *)(c->pIf);
+	if (pUart->para.baud < 2400)
+		return 200;
+	return 100;
+}
 #endif
 
+//֡,ʱnDirеͷ󷵻,ɵл
+static void dlt645_SendFrame(chl c, int nDir, buf b)
+{
+
 #if DLT645_DIR_CTRL
-	gpio_Set(2, 0);
+	gpio_Set(nDir, 0);
+#endif
 	//ȶ
 	chl_Send(c, dlt645_aFE, 4);
 	chl_Send(c, b->p, b->len);
-	pUart = (uart_t *)(c->pIf);
-	if (pUart->para.baud < 2400)
-		sys_Delay(200000);
-	else
-		sys_Delay(100000);
-	gpio_Set(2, 1);
+
+	dlt645_DbgOut(1, b->p, b->len);
+}
+
+static void dlt645_Send(chl c, buf b)
+{
+
+#if DLT645_DIR_CTRL
+	dlt645_SendFrame(c, DLT645_DIR_PIN, b);
+	sys_Delay(dlt645_DirHold(c) * 1000);
+	gpio_Set(DLT645_DIR_PIN, 1);
 #else
-	chl_Send(c, dlt645_aFE, 4);
-	chl_Send(c, b->p, b->len);
+	dlt645_SendFrame(c, 0, b);
 #endif
+}
 
-	dlt645_DbgOut(1, b->p, b->len);
+//ڽջвpAdrӦ֡,ҵ󻺳ӿ뿪ʼ
+static sys_res dlt645_Response(buf b, const u8 *pAdr)
+{
+	u8 *pH;
 
-	memcpy(aAdr, &b->p[1], 6);
-	buf_Release(b);
-	for (nTmo /= OS_TICK_MS; nTmo; nTmo--)
+	while ((pH = dlt645_PacketAnalyze(b->p, b->len)) != NULL)
 	{
-		if (chl_RecData(c, b, OS_TICK_MS) != SYS_R_OK)
-			continue;
-		pH = dlt645_PacketAnalyze(b->p, b->len);
-		if (pH == NULL)
-			continue;
 		buf_Remove(b, pH - b->p);
 
 		dlt645_DbgOut(0, b->p, b->p[9] + (DLT645_HEADER_SIZE + 2));
 
-		if (memcmp(&b->p[1], aAdr, 6))
+		if (memcmp(&b->p[1], pAdr, 6))
 		{
 			buf_Remove(b, DLT645_HEADER_SIZE);
 			continue;
@@ -151,6 +162,24 @@ sys_res dlt645_Meter(chl c, buf b, size_t nTmo)
 			return SYS_R_OK;
 		}
 	}
+	return SYS_R_ERR;
+}
+
+sys_res dlt645_Meter(chl c, buf b, size_t nTmo)
+{
+	u8 aAdr[6];
+
+	dlt645_Send(c, b);
+
+	memcpy(aAdr, &b->p[1], 6);
+	buf_Release(b);
+	for (nTmo /= OS_TICK_MS; nTmo; nTmo--)
+	{
+		if (chl_RecData(c, b, OS_TICK_MS) != SYS_R_OK)
+			continue;
+		if (dlt645_Response(b, aAdr) == SYS_R_OK)
+			return SYS_R_OK;
+	}
 	return SYS_R_TMO;
 }
 
@@ -182,3 +211,543 @@ sys_res dlt645_Transmit(chl c, buf b, size_t nTmo)
 }
 
 
+
+#if DLT645_POLL_ENABLE
+//-------------------------------------------------------------------------
+//˿ڲֳ
+//ÿ˿һշ״̬,ҵȼŶ,ͨص
+//-------------------------------------------------------------------------
+static int dlt645_JobBefore(dlt645_job_t *a, dlt645_job_t *b)
+{
+
+	if (a->prio != b->prio)
+		return a->prio < b->prio;
+	//طҵŵͬҵ֮,ռס˿
+	if (a->tries != b->tries)
+		return a->tries < b->tries;
+	if (a->deadline != b->deadline)
+	{
+		if (a->deadline == 0)
+			return 0;
+		if (b->deadline == 0)
+			return 1;
+		return (s32)(a->deadline - b->deadline) < 0;
+	}
+	return (s16)(a->seq - b->seq) < 0;
+}
+
+static void dlt645_HeapPush(dlt645_poll_t *p, dlt645_port_t *pPort, int nJob)
+{
+	int i, nUp;
+
+	for (i = pPort->qty++; i; i = nUp)
+	{
+		nUp = (i - 1) >> 1;
+		if (dlt645_JobBefore(&p->job[nJob], &p->job[pPort->heap[nUp]]) == 0)
+			break;
+		pPort->heap[i] = pPort->heap[nUp];
+	}
+	pPort->heap[i] = nJob;
+}
+
+static int dlt645_HeapPop(dlt645_poll_t *p, dlt645_port_t *pPort)
+{
+	int i, nDown, nJob, nLast;
+
+	if (pPort->qty == 0)
+		return DLT645_POLL_NONE;
+	
+	nJob = pPort->heap[0];
+	nLast = pPort->heap[--pPort->qty];
+	for (i = 0; (nDown = i * 2 + 1) < pPort->qty; i = nDown)
+	{
+		if ((nDown + 1 < pPort->qty) && dlt645_JobBefore(&p->job[pPort->heap[nDown + 1]], &p->job[pPort->heap[nDown]]))
+			nDown += 1;
+		if (dlt645_JobBefore(&p->job[pPort->heap[nDown]], &p->job[nLast]) == 0)
+			break;
+		pPort->heap[i] = pPort->heap[nDown];
+	}
+	pPort->heap[i] = nLast;
+	
+	return nJob;
+}
+
+static void dlt645_JobDone(dlt645_poll_t *p, int nJob, sys_res res, const u8 *pData, size_t nLen)
+{
+	dlt645_job_t *pJob = &p->job[nJob];
+
+	if (pJob->cb != NULL)
+		pJob->cb(pJob, res, pData, nLen);
+	
+	os_thd_lock();
+	p->free[p->nfree++] = nJob;
+	os_thd_unlock();
+}
+
+static int dlt645_TickAfter(u32 nTick, u32 nRef)
+{
+
+	return (s32)(nTick - nRef) >= 0;
+}
+
+void dlt645_PollInit(dlt645_poll_t *p)
+{
+	int i;
+
+	memset(p, 0, sizeof(dlt645_poll_t));
+	for (i = 0; i < DLT645_POLL_JOB_MAX; i++)
+		p->free[i] = DLT645_POLL_JOB_MAX - 1 - i;
+	p->nfree = DLT645_POLL_JOB_MAX;
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+		p->port[i].cur = DLT645_POLL_NONE;
+}
+
+//-------------------------------------------------------------------------
+//˿nPortͨc,nDirΪö˿ڵķ,޷ʱ
+//-------------------------------------------------------------------------
+sys_res dlt645_PollAttach(dlt645_poll_t *p, int nPort, chl c, int nDir)
+{
+
+	if (nPort >= DLT645_POLL_PORT_MAX)
+		return SYS_R_ERR;
+	
+	p->port[nPort].chl = c;
+	p->port[nPort].dir = nDir;
+#if DLT645_DIR_CTRL
+	gpio_Set(nDir, 1);
+#endif
+	
+	return SYS_R_OK;
+}
+
+sys_res dlt645_PollSubmit(dlt645_poll_t *p, const dlt645_job_t *pJob)
+{
+	int nJob;
+	dlt645_port_t *pPort;
+
+	if ((pJob->port >= DLT645_POLL_PORT_MAX) || (pJob->len > DLT645_POLL_DATA_MAX))
+		return SYS_R_ERR;
+	
+	pPort = &p->port[pJob->port];
+	if (pPort->chl == NULL)
+		return SYS_R_ERR;
+	
+	os_thd_lock();
+	if (p->nfree == 0)
+	{
+		os_thd_unlock();
+		return SYS_R_FULL;
+	}
+	nJob = p->free[--p->nfree];
+	memcpy(&p->job[nJob], pJob, sizeof(dlt645_job_t));
+	p->job[nJob].tries = 0;
+	p->job[nJob].seq = p->seq++;
+	dlt645_HeapPush(p, pPort, nJob);
+	os_thd_unlock();
+	
+	return SYS_R_OK;
+}
+
+//-------------------------------------------------------------------------
+//ֳ,,ڹĶ˿
+//ڷط0ʱԼÿtickһ
+//-------------------------------------------------------------------------
+int dlt645_PollHandler(dlt645_poll_t *p)
+{
+	dlt645_port_t *pPort;
+	dlt645_job_t *pJob;
+	buf b = {0};
+	int i, nJob, nBusy = 0;
+	u32 nTick;
+
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+	{
+		pPort = &p->port[i];
+		if (pPort->chl == NULL)
+			continue;
+		
+		nTick = os_tick_get();
+		switch (pPort->ste)
+		{
+		case DLT645_POLL_S_GAP:
+			if (dlt645_TickAfter(nTick, pPort->tick) == 0)
+				break;
+			pPort->ste = DLT645_POLL_S_IDLE;
+			//fall through
+		case DLT645_POLL_S_IDLE:
+			os_thd_lock();
+			nJob = dlt645_HeapPop(p, pPort);
+			os_thd_unlock();
+			if (nJob == DLT645_POLL_NONE)
+				break;
+			
+			pJob = &p->job[nJob];
+			if (pJob->deadline && dlt645_TickAfter(nTick, pJob->deadline))
+			{
+				dlt645_JobDone(p, nJob, SYS_R_TMO, NULL, 0);
+				break;
+			}
+			
+			buf_Release(pPort->rbuf);
+			dlt645_Packet2Buf(b, pJob->adr, pJob->code, pJob->data, pJob->len);
+			dlt645_SendFrame(pPort->chl, pPort->dir, b);
+			buf_Release(b);
+			
+			pPort->cur = nJob;
+#if DLT645_DIR_CTRL
+			//лĵȴ״̬,˿
+			pPort->tick = os_tick_get() + dlt645_DirHold(pPort->chl) / OS_TICK_MS;
+			pPort->ste = DLT645_POLL_S_TURN;
+#else
+			pPort->tick = os_tick_get() + pJob->tmo / OS_TICK_MS;
+			pPort->ste = DLT645_POLL_S_WAIT;
+#endif
+			break;
+			
+#if DLT645_DIR_CTRL
+		case DLT645_POLL_S_TURN:
+			if (dlt645_TickAfter(nTick, pPort->tick) == 0)
+				break;
+			gpio_Set(pPort->dir, 1);
+			pPort->tick = nTick + p->job[pPort->cur].tmo / OS_TICK_MS;
+			pPort->ste = DLT645_POLL_S_WAIT;
+			break;
+#endif
+			
+
+		case DLT645_POLL_S_WAIT:
+			nJob = pPort->cur;
+			pJob = &p->job[nJob];
+			if (chl_RecData(pPort->chl, pPort->rbuf, 0) == SYS_R_OK)
+			{
+				if (dlt645_Response(pPort->rbuf, pJob->adr) == SYS_R_OK)
+				{
+					pPort->cur = DLT645_POLL_NONE;
+					pPort->tick = nTick + DLT645_POLL_GAP / OS_TICK_MS;
+					pPort->ste = DLT645_POLL_S_GAP;
+					dlt645_JobDone(p, nJob, SYS_R_OK, pPort->rbuf->p, pPort->rbuf->p[1] + 2);
+					buf_Release(pPort->rbuf);
+					break;
+				}
+			}
+			
+			if (dlt645_TickAfter(nTick, pPort->tick) == 0)
+				break;
+			
+			//ʱ,δطҵŶ
+			pPort->cur = DLT645_POLL_NONE;
+			pPort->ste = DLT645_POLL_S_IDLE;
+			pJob->tries += 1;
+			if ((pJob->tries <= pJob->retry) && ((pJob->deadline == 0) || (dlt645_TickAfter(nTick, pJob->deadline) == 0)))
+			{
+				os_thd_lock();
+				dlt645_HeapPush(p, pPort, nJob);
+				os_thd_unlock();
+			}
+			else
+			{
+				dlt645_JobDone(p, nJob, SYS_R_TMO, NULL, 0);
+			}
+			break;
+			
+		default:
+			break;
+		}
+		
+		if ((pPort->ste != DLT645_POLL_S_IDLE) || pPort->qty)
+			nBusy += 1;
+	}
+	
+	return nBusy;
+}
+#endif
+
+
+
+#if DLT645_CACHE_ENABLE
+//-------------------------------------------------------------------------
+//Ӧ𻺴
+//(ַ, , ݱʶ)Ӧ,Чڰݱʶ
+//ͬһݵĲֻһα,ȴ
+//-------------------------------------------------------------------------
+#define DLT645_CACHE_S_EMPTY	0
+#define DLT645_CACHE_S_VALID	1
+#define DLT645_CACHE_S_PEND		2
+#define DLT645_CACHE_S_FAIL		3
+
+typedef struct
+{
+	u8		ste;
+	u8		code;
+	u8		adr[6];
+	u32		di;
+	u32		tick;		//ʱ
+	u32		ttl;		//Ч(tick)
+	u16		lru;
+	u16		seq;
+	sys_res	res;
+	u8		len;
+	u8		data[DLT645_CACHE_DATA_MAX];
+} dlt645_cache_t;
+
+static dlt645_cache_t dlt645_aCache[DLT645_CACHE_MAX];
+static u16 dlt645_nCacheLru, dlt645_nCacheSeq;
+static u32 dlt645_aCacheCnt[3];
+
+//ĬЧ,˳ƥ,0Ϊ
+//DL/T645-2007,4ֽDI
+static const t_dlt645_cache_rule dlt645_aCacheRule07[] = {
+	{0x04000100, 0xFFFFFFFC, 0},	//ڡʱ
+	{0x00000000, 0xFF000000, 60},	//
+	{0x01000000, 0xFF000000, 60},	//
+	{0x02000000, 0xFF000000, 15},	//
+	{0x03000000, 0xFF000000, 300},	//¼¼
+	{0x04000000, 0xFF000000, 600},	//α
+	{0x05000000, 0xFF000000, 3600},	//
+};
+//DL/T645-1997,2ֽDI
+static const t_dlt645_cache_rule dlt645_aCacheRule97[] = {
+	{0xC010, 0xFFF0, 0},			//ڡʱ
+	{0x9000, 0xF000, 60},			//
+	{0xA000, 0xF000, 60},			//
+	{0xB600, 0xFF00, 15},			//
+	{0xB000, 0xF000, 300},			//¼ͳ
+	{0xC000, 0xC000, 600},			//α
+};
+//[0]Ϊ1997Լ,[1]Ϊ2007Լ
+static const t_dlt645_cache_rule *dlt645_pCacheRule[2] = {dlt645_aCacheRule97, dlt645_aCacheRule07};
+static int dlt645_nCacheRule[2] = {ARR_SIZE(dlt645_aCacheRule97), ARR_SIZE(dlt645_aCacheRule07)};
+
+static int dlt645_CacheTtl(int nCode, u32 nDI)
+{
+	const t_dlt645_cache_rule *pRule, *pEnd;
+	int nType = (nCode == DLT645_CODE_READ07);
+
+	pRule = dlt645_pCacheRule[nType];
+	for (pEnd = &pRule[dlt645_nCacheRule[nType]]; pRule < pEnd; pRule++)
+	{
+		if ((nDI & pRule->mask) == pRule->di)
+			return pRule->ttl;
+	}
+	
+	return 0;
+}
+
+static dlt645_cache_t *dlt645_CacheFind(const u8 *pAdr, int nCode, u32 nDI)
+{
+	dlt645_cache_t *p;
+
+	for (p = dlt645_aCache; p < &dlt645_aCache[DLT645_CACHE_MAX]; p++)
+	{
+		if ((p->ste == DLT645_CACHE_S_VALID) || (p->ste == DLT645_CACHE_S_PEND))
+		{
+			if ((p->di == nDI) && (p->code == nCode) && (memcmp(p->adr, pAdr, 6) == 0))
+				return p;
+		}
+	}
+	
+	return NULL;
+}
+
+//ձ,̭δõɱ
+static dlt645_cache_t *dlt645_CacheAlloc(void)
+{
+	dlt645_cache_t *p, *pOld = NULL;
+
+	for (p = dlt645_aCache; p < &dlt645_aCache[DLT645_CACHE_MAX]; p++)
+	{
+		if (p->ste == DLT645_CACHE_S_EMPTY)
+			return p;
+		
+		if (p->ste == DLT645_CACHE_S_PEND)
+			continue;
+		
+		if ((pOld == NULL) || ((s16)(p->lru - pOld->lru) < 0))
+			pOld = p;
+	}
+	
+	return pOld;
+}
+
+//-------------------------------------------------------------------------
+//nCode(DLT645_CODE_READ97/READ07)ԼЧڹ,pRuleΪNULLʱָĬ
+//-------------------------------------------------------------------------
+void dlt645_CacheRule(int nCode, const t_dlt645_cache_rule *pRule, int nQty)
+{
+	int nType = (nCode == DLT645_CODE_READ07);
+
+	if (pRule == NULL)
+	{
+		pRule = nType ? dlt645_aCacheRule07 : dlt645_aCacheRule97;
+		nQty = nType ? ARR_SIZE(dlt645_aCacheRule07) : ARR_SIZE(dlt645_aCacheRule97);
+	}
+	
+	os_thd_lock();
+	dlt645_pCacheRule[nType] = pRule;
+	dlt645_nCacheRule[nType] = nQty;
+	os_thd_unlock();
+}
+
+//-------------------------------------------------------------------------
+//ĳ,pfReadʵʳ,bͬdlt645_Meter
+//-------------------------------------------------------------------------
+sys_res dlt645_CacheRead(buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, dlt645_read_t pfRead, void *pArg)
+{
+	dlt645_cache_t *p;
+	sys_res res;
+	u32 nDI = 0, nTtl;
+	u16 nSeq;
+	size_t nTmo;
+	int nCopy;
+	u8 aBuf[DLT645_CACHE_DATA_MAX];
+
+	//áƺñĻ
+	if ((nCode != DLT645_CODE_READ07) && (nCode != DLT645_CODE_READ97))
+	{
+		res = pfRead(pArg, b, pAdr, nCode, pData, nLen);
+		dlt645_CacheFlush(pAdr);
+		return res;
+	}
+	
+	//ֻDIΪ,DI(¼,ʱ)󲻻
+	if (nLen > ((nCode == DLT645_CODE_READ07) ? 4 : 2))
+		return pfRead(pArg, b, pAdr, nCode, pData, nLen);
+	
+	memcpy(&nDI, pData, nLen);
+	nTtl = dlt645_CacheTtl(nCode, nDI) * (1000 / OS_TICK_MS);
+	if (nTtl == 0)
+		return pfRead(pArg, b, pAdr, nCode, pData, nLen);
+	
+	os_thd_lock();
+	p = dlt645_CacheFind(pAdr, nCode, nDI);
+	if ((p != NULL) && (p->ste == DLT645_CACHE_S_VALID) && ((os_tick_get() - p->tick) >= p->ttl))
+	{
+		p->ste = DLT645_CACHE_S_EMPTY;
+		p = NULL;
+	}
+	
+	if (p != NULL)
+	{
+		p->lru = dlt645_nCacheLru++;
+		if (p->ste == DLT645_CACHE_S_VALID)
+		{
+			nCopy = p->len;
+			memcpy(aBuf, p->data, nCopy);
+			dlt645_aCacheCnt[0] += 1;
+			os_thd_unlock();
+			
+			buf_Push(b, aBuf, nCopy);
+			return SYS_R_OK;
+		}
+		
+		//ͬڳ,ȴ
+		dlt645_aCacheCnt[2] += 1;
+		nSeq = p->seq;
+		os_thd_unlock();
+		
+		for (nTmo = DLT645_CACHE_WAIT / OS_TICK_MS; nTmo; nTmo--)
+		{
+			os_thd_slp1tick();
+			
+			os_thd_lock();
+			if ((p->seq != nSeq) || (p->ste != DLT645_CACHE_S_PEND))
+				break;
+			os_thd_unlock();
+		}
+		if (nTmo == 0)
+			return SYS_R_TMO;
+		
+		res = SYS_R_ERR;
+		nCopy = 0;
+		if (p->seq == nSeq)
+		{
+			res = p->res;
+			if (p->ste == DLT645_CACHE_S_VALID)
+			{
+				nCopy = p->len;
+				memcpy(aBuf, p->data, nCopy);
+			}
+		}
+		os_thd_unlock();
+		
+		//Ӧδܱ,г
+		if (res == SYS_R_FULL)
+			return pfRead(pArg, b, pAdr, nCode, pData, nLen);
+		if (nCopy)
+			buf_Push(b, aBuf, nCopy);
+		return res;
+	}
+	
+	dlt645_aCacheCnt[1] += 1;
+	p = dlt645_CacheAlloc();
+	if (p == NULL)
+	{
+		os_thd_unlock();
+		return pfRead(pArg, b, pAdr, nCode, pData, nLen);
+	}
+	
+	p->ste = DLT645_CACHE_S_PEND;
+	p->code = nCode;
+	memcpy(p->adr, pAdr, 6);
+	p->di = nDI;
+	p->ttl = nTtl;
+	p->lru = dlt645_nCacheLru++;
+	p->seq = dlt645_nCacheSeq++;
+	os_thd_unlock();
+	
+	res = pfRead(pArg, b, pAdr, nCode, pData, nLen);
+	
+	os_thd_lock();
+	p->res = res;
+	p->tick = os_tick_get();
+	if ((res == SYS_R_OK) && (b->len <= DLT645_CACHE_DATA_MAX))
+	{
+		memcpy(p->data, b->p, b->len);
+		p->len = b->len;
+		p->ste = DLT645_CACHE_S_VALID;
+	}
+	else
+	{
+		//ʧܵĽȴ;Ӧ𲻻,ȴ߸Գ
+		p->ste = DLT645_CACHE_S_FAIL;
+		if (res == SYS_R_OK)
+			p->res = SYS_R_FULL;
+	}
+	os_thd_unlock();
+	
+	return res;
+}
+
+//-------------------------------------------------------------------------
+//ñĻ(áƺ),pAdrΪNULLʱȫ
+//-------------------------------------------------------------------------
+void dlt645_CacheFlush(const u8 *pAdr)
+{
+	dlt645_cache_t *p;
+
+	os_thd_lock();
+	for (p = dlt645_aCache; p < &dlt645_aCache[DLT645_CACHE_MAX]; p++)
+	{
+		if ((pAdr != NULL) && memcmp(p->adr, pAdr, 6))
+			continue;
+		
+		if (p->ste == DLT645_CACHE_S_VALID)
+			p->ste = DLT645_CACHE_S_EMPTY;
+		//ڳĽֻȴ,ٻ
+		if (p->ste == DLT645_CACHE_S_PEND)
+			p->ttl = 0;
+	}
+	os_thd_unlock();
+}
+
+//Сϲ
+void dlt645_CacheCount(u32 *pHit, u32 *pRead, u32 *pShare)
+{
+
+	*pHit = dlt645_aCacheCnt[0];
+	*pRead = dlt645_aCacheCnt[1];
+	*pShare = dlt645_aCacheCnt[2];
+}
+#endif
+
+
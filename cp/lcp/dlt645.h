@@ -16,6 +16,111 @@ extern "C" {
 #define DLT645_CODE_BROADCAST		0x08
 #define DLT645_CODE_HEARTBEAT		0x1E
 
+//RS485,DLT645_DIR_PINΪڳõķ
+#ifndef DLT645_DIR_CTRL
+#define DLT645_DIR_CTRL				0
+#endif
+#if DLT645_DIR_CTRL
+#ifndef DLT645_DIR_PIN
+#define DLT645_DIR_PIN				2
+#endif
+#endif
+
+//˿ڲֳ
+#ifndef DLT645_POLL_ENABLE
+#define DLT645_POLL_ENABLE			0
+#endif
+
+#if DLT645_POLL_ENABLE
+#ifndef DLT645_POLL_PORT_MAX
+#define DLT645_POLL_PORT_MAX		4
+#endif
+#ifndef DLT645_POLL_JOB_MAX
+#define DLT645_POLL_JOB_MAX			64
+#endif
+//Ӧ߼(ms)
+#ifndef DLT645_POLL_GAP
+#define DLT645_POLL_GAP				20
+#endif
+#define DLT645_POLL_DATA_MAX		16
+#endif
+
+//Ӧ𻺴
+#ifndef DLT645_CACHE_ENABLE
+#define DLT645_CACHE_ENABLE			0
+#endif
+
+#if DLT645_CACHE_ENABLE
+#ifndef DLT645_CACHE_MAX
+#define DLT645_CACHE_MAX			32
+#endif
+#ifndef DLT645_CACHE_DATA_MAX
+#define DLT645_CACHE_DATA_MAX		64
+#endif
+//ȴͬʱ(ms)
+#ifndef DLT645_CACHE_WAIT
+#define DLT645_CACHE_WAIT			120000
+#endif
+#endif
+
+
+//Public Typedefs
+#if DLT645_POLL_ENABLE
+typedef struct dlt645_job dlt645_job_t;
+struct dlt645_job
+{
+	u8		port;		//˿ں
+	u8		prio;		//ȼ,ԽСԽ
+	u8		retry;		//ʱط
+	u8		code;		//
+	u8		adr[6];		//ַ
+	u8		len;		//򳤶(δ0x33)
+	u8		data[DLT645_POLL_DATA_MAX];
+	u16		tmo;		//Ӧʱ(ms)
+	u32		deadline;	//ֹtick,0Ϊ
+	//ص,pDataӿ뿪ʼ,Ѽ0x33
+	void	(*cb)(dlt645_job_t *pJob, sys_res res, const u8 *pData, size_t nLen);
+	void *	arg;
+	//ڲʹ
+	u8		tries;
+	u16		seq;
+};
+
+typedef struct
+{
+	u8		ste;
+	u16		cur;
+	u16		qty;
+	u8		dir;		//
+	chl_t *	chl;
+	u32		tick;
+	buf		rbuf;
+	u16		heap[DLT645_POLL_JOB_MAX];
+} dlt645_port_t;
+
+typedef struct
+{
+	dlt645_port_t	port[DLT645_POLL_PORT_MAX];
+	dlt645_job_t	job[DLT645_POLL_JOB_MAX];
+	u16		free[DLT645_POLL_JOB_MAX];
+	u16		nfree;
+	u16		seq;
+} dlt645_poll_t;
+#endif
+
+#if DLT645_CACHE_ENABLE
+//Чڹ,(DI & mask) == diʱЧΪttl
+typedef struct
+{
+	u32		di;
+	u32		mask;
+	u16		ttl;
+} t_dlt645_cache_rule;
+
+//ʵʳ,bͬdlt645_Meter
+typedef sys_res (*dlt645_read_t)(void *pArg, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen);
+#endif
+
 
 
 
@@ -29,6 +134,20 @@ u8 *dlt645_PacketAnalyze(const u8 *p, size_t nLen);
 sys_res dlt645_Meter(chl c, buf b, size_t nTmo);
 sys_res dlt645_Transmit(chl c, buf b, size_t nTmo);
 
+#if DLT645_POLL_ENABLE
+void dlt645_PollInit(dlt645_poll_t *p);
+sys_res dlt645_PollAttach(dlt645_poll_t *p, int nPort, chl c, int nDir);
+sys_res dlt645_PollSubmit(dlt645_poll_t *p, const dlt645_job_t *pJob);
+int dlt645_PollHandler(dlt645_poll_t *p);
+#endif
+
+#if DLT645_CACHE_ENABLE
+void dlt645_CacheRule(int nCode, const t_dlt645_cache_rule *pRule, int nQty);
+sys_res dlt645_CacheRead(buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, dlt645_read_t pfRead, void *pArg);
+void dlt645_CacheFlush(const u8 *pAdr);
+void dlt645_CacheCount(u32 *pHit, u32 *pRead, u32 *pShare);
+#endif
+
 
 #ifdef __cplusplus
 }
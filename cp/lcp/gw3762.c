@@ -56,20 +56,13 @@ static void GW3762_DBGOUT(int nType, const void *pBuf, size_t nLen)
 #else
 static void GW3762_DBGOUT(int nType, const void *pBuf, size_t nLen)
 {
-	const u8 *pData, *pEnd;
 	char str[DBG_BUF_SIZE];
 
-	pData = (const u8 *)pBuf;
-	pEnd = pData + nLen;
-
 	if (nType)
-		nLen = sprintf(str, "%s", "<376.2T>");
+		memcpy(str, "<376.2T>", 8);
 	else
-		nLen = sprintf(str, "%s", "<376.2R>");
-	while ((pData < pEnd) && (nLen < (sizeof(str) - 3)))
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
+		memcpy(str, "<376.2R>", 8);
+	hexdump(&str[8], sizeof(str) - 8, pBuf, nLen);
 
 	dbg_trace(str);
 }
@@ -146,11 +139,22 @@ static sys_res gw3762_Transmit2Meter(plc_t *p, int nRoute, int nAfn, u16 nDT, co
 
 	buf_PushData(bTx, nAfn, 1);
 	buf_PushData(bTx, nDT, 2);
-	if (nAfn == GW3762_AFN_ROUTE_TRANSMIT)
+	switch (nAfn)
+	{
+	case GW3762_AFN_ROUTE_TRANSMIT:
 		buf_PushData(bTx, 0x0002, 2);
-	else
+		buf_PushData(bTx, nLen, 1);
+		break;
+	case GW3762_AFN_CONCURRENT:
+		//Լ +  + 2ֽڱĳ
+		buf_PushData(bTx, 0x0002, 2);
+		buf_PushData(bTx, nLen, 2);
+		break;
+	default:
 		buf_PushData(bTx, 0x02, 1);
-	buf_PushData(bTx, nLen, 1);
+		buf_PushData(bTx, nLen, 1);
+		break;
+	}
 	buf_Push(bTx, pData, nLen);
 	buf_PushData(bTx, cs8(&bTx->p[1 + GW3762_HEADER_L_SIZE], bTx->len - (1 + GW3762_HEADER_L_SIZE)) | 0x1600, 2);
 	memcpy(&bTx->p[1], (const void *)&bTx->len, GW3762_HEADER_L_SIZE);
@@ -314,6 +318,13 @@ sys_res gw3762_MeterRT(plc_t *p, const void *pAdr, const void *pData, size_t nLe
 	return gw3762_Transmit2Meter(p, 1, nAfn, 0x0001, pAdr, 0, NULL, pData, nLen);
 }
 
+//,Ӧ𰴱ַ
+sys_res gw3762_MeterConcurrent(plc_t *p, const void *pAdr, const void *pData, size_t nLen)
+{
+
+	return gw3762_Transmit2Meter(p, 1, GW3762_AFN_CONCURRENT, 0x0001, pAdr, 0, NULL, pData, nLen);
+}
+
 
 //-------------------------------------------------------------------------------------
 // ȷ
@@ -503,12 +514,15 @@ sys_res gw3762_SubAdrQty(plc_t *p, u16 *pQty)
 //-------------------------------------------------------------------------------------
 // ȡӽڵϢ
 //-------------------------------------------------------------------------------------
-sys_res gw3762_SubAdrRead(plc_t *p, int nSn, u16 *pQty, u8 *pAdr)
+sys_res gw3762_SubAdrReadN(plc_t *p, int nSn, int *pCnt, u16 *pQty, u8 *pAdr)
 {
 	size_t nTmo;
+	int i, nCnt, nMax, nStep;
 	u32 nTemp;
 
-	nTemp = 0x00010000 | nSn;
+	nMax = *pCnt;
+	nTemp = (nMax << 16) | nSn;
+	*pCnt = 0;
 	gw3762_Transmit2Module(p, GW3762_AFN_ROUTE_FETCH, 0x0002, &nTemp, 3);
 	
 	for (nTmo = 2000 / OS_TICK_MS; nTmo; nTmo--)
@@ -526,12 +540,40 @@ sys_res gw3762_SubAdrRead(plc_t *p, int nSn, u16 *pQty, u8 *pAdr)
 	if (p->fn != 0x0002)
 		return SYS_R_ERR;
 	
+	if (p->data->len < 3)
+		return SYS_R_ERR;
+	
 	if (pQty != NULL)
 		memcpy(pQty, &p->data->p[0], 2);
-	if (p->data->p[2] == 0)
+	nCnt = p->data->p[2];
+	if (nCnt == 0)
+		return SYS_R_OK;
+	if (nCnt > nMax)
 		return SYS_R_ERR;
 	
-	memcpy(pAdr, &p->data->p[3], 6);
+	//ڵϢģ,ʵ֡
+	nStep = (p->data->len - 3) / nCnt;
+	if (nStep < 6)
+		return SYS_R_ERR;
+	
+	for (i = 0; i < nCnt; i++)
+		memcpy(&pAdr[i * 6], &p->data->p[3 + i * nStep], 6);
+	*pCnt = nCnt;
+
+	return SYS_R_OK;
+}
+
+sys_res gw3762_SubAdrRead(plc_t *p, int nSn, u16 *pQty, u8 *pAdr)
+{
+	sys_res res;
+	int nCnt = 1;
+
+	res = gw3762_SubAdrReadN(p, nSn, &nCnt, pQty, pAdr);
+	if (res != SYS_R_OK)
+		return res;
+	
+	if (nCnt == 0)
+		return SYS_R_ERR;
 
 	return SYS_R_OK;
 }
@@ -584,17 +626,15 @@ sys_res gw3762_StateGet(plc_t *p, int nRetry)
 //-------------------------------------------------------------------------------------
 // Ӵӽڵ
 //-------------------------------------------------------------------------------------
-sys_res gw3762_SubAdrAdd(plc_t *p, int nSn, const void *pAdr, int nPrtl)
+sys_res gw3762_SubAdrAddN(plc_t *p, const void *pList, int nCnt)
 {
 	size_t nTmo;
-	u8 aBuf[10];
+	buf b = {0};
 
-	aBuf[0] = 1;
-	memcpy(&aBuf[1], pAdr, 6);
-	memcpy(&aBuf[7], &nSn, 2);
-	aBuf[9] = nPrtl;
-	
-	gw3762_Transmit2Module(p, GW3762_AFN_ROUTE_SET, 0x0001, aBuf, 10);
+	buf_PushData(b, nCnt, 1);
+	buf_Push(b, pList, nCnt * GW3762_SUBADR_ADD_SIZE);
+	gw3762_Transmit2Module(p, GW3762_AFN_ROUTE_SET, 0x0001, b->p, b->len);
+	buf_Release(b);
 	
 	for (nTmo = 2000 / OS_TICK_MS; nTmo; nTmo--)
 	{
@@ -614,18 +654,30 @@ sys_res gw3762_SubAdrAdd(plc_t *p, int nSn, const void *pAdr, int nPrtl)
 	return SYS_R_OK;
 }
 
+sys_res gw3762_SubAdrAdd(plc_t *p, int nSn, const void *pAdr, int nPrtl)
+{
+	u8 aBuf[GW3762_SUBADR_ADD_SIZE];
+
+	memcpy(&aBuf[0], pAdr, 6);
+	memcpy(&aBuf[6], &nSn, 2);
+	aBuf[8] = nPrtl;
+
+	return gw3762_SubAdrAddN(p, aBuf, 1);
+}
+
 
 //-------------------------------------------------------------------------------------
 // ɾӽڵ
 //-------------------------------------------------------------------------------------
-sys_res gw3762_SubAdrDelete(plc_t *p, const void *pAdr)
+sys_res gw3762_SubAdrDeleteN(plc_t *p, const void *pAdr, int nCnt)
 {
 	size_t nTmo;
-	u8 aBuf[7];
+	buf b = {0};
 
-	aBuf[0] = 1;
-	memcpy(&aBuf[1], pAdr, 6);
-	gw3762_Transmit2Module(p, GW3762_AFN_ROUTE_SET, 0x0002, aBuf, 7);
+	buf_PushData(b, nCnt, 1);
+	buf_Push(b, pAdr, nCnt * 6);
+	gw3762_Transmit2Module(p, GW3762_AFN_ROUTE_SET, 0x0002, b->p, b->len);
+	buf_Release(b);
 	
 	for (nTmo = 2000 / OS_TICK_MS; nTmo; nTmo--)
 	{
@@ -645,6 +697,12 @@ sys_res gw3762_SubAdrDelete(plc_t *p, const void *pAdr)
 	return SYS_R_OK;
 }
 
+sys_res gw3762_SubAdrDelete(plc_t *p, const void *pAdr)
+{
+
+	return gw3762_SubAdrDeleteN(p, pAdr, 1);
+}
+
 //-------------------------------------------------------------------------------------
 // ģʽ
 //-------------------------------------------------------------------------------------
@@ -21,6 +21,14 @@ extern "C" {
 #define GW3762_AFN_ROUTE_TRANSMIT	0x13
 #define GW3762_AFN_ROUTE_REQUEST	0x14
 #define GW3762_AFN_AUTOREPORT		0xF0
+#define GW3762_AFN_CONCURRENT		0xF1
+
+//ӽڵȡ/ÿ֡ڵ
+#ifndef GW3762_SUBADR_N_MAX
+#define GW3762_SUBADR_N_MAX			32
+#endif
+//ӴӽڵĿ(ַ6 + 2 + Լ1)
+#define GW3762_SUBADR_ADD_SIZE		9
 
 
 
@@ -38,6 +46,7 @@ sys_res gw3762_Analyze(plc_t *p);
 sys_res gw3762_Broadcast(plc_t *p, const void *pAdr, const void *pData, size_t nLen);
 sys_res gw3762_MeterRead(plc_t *p, const void *pAdr, int nRelay, const void *pRtAdr, const void *pData, size_t nLen);
 sys_res gw3762_MeterRT(plc_t *p, const void *pAdr, const void *pData, size_t nLen);
+sys_res gw3762_MeterConcurrent(plc_t *p, const void *pAdr, const void *pData, size_t nLen);
 
 sys_res gw3762_Confirm(plc_t *p, int nFlag, size_t nTmo);
 sys_res gw3762_HwReset(plc_t *p);
@@ -46,9 +55,12 @@ sys_res gw3762_InfoGet(plc_t *p, int nRetry);
 sys_res gw3762_ModAdrSet(plc_t *p);
 sys_res gw3762_SubAdrQty(plc_t *p, u16 *pQty);
 sys_res gw3762_SubAdrRead(plc_t *p, int nSn, u16 *pQty, u8 *pAdr);
+sys_res gw3762_SubAdrReadN(plc_t *p, int nSn, int *pCnt, u16 *pQty, u8 *pAdr);
 sys_res gw3762_StateGet(plc_t *p, int nRetry);
 sys_res gw3762_SubAdrAdd(plc_t *p, int nSn, const void *pAdr, int nPrtl);
+sys_res gw3762_SubAdrAddN(plc_t *p, const void *pList, int nCnt);
 sys_res gw3762_SubAdrDelete(plc_t *p, const void *pAdr);
+sys_res gw3762_SubAdrDeleteN(plc_t *p, const void *pAdr, int nCnt);
 sys_res gw3762_ModeSet(plc_t *p, int nMode);
 sys_res gw3762_MeterProbe(plc_t *p, int nTime);
 sys_res gw3762_RtCtrl(plc_t *p, u16 nDT, int nRetry);
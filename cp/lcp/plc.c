@@ -9,8 +9,46 @@
 //3ģʽ֧(ϱ)
 #define PLC_ES_III_ENABLE	0
 
+//ÿͨͳƱ(2)
+#ifndef PLC_STAT_MAX
+#define PLC_STAT_MAX		128
+#endif
+//Ӧʱ޼(ms)
+#define PLC_WAIT_MIN		2000
+#define PLC_WAIT_MARGIN		500
+//ʱﵽֵصģ̶ȴʱ
+#define PLC_WAIT_FALLBACK	3
+
+//ģ鲢·,1Ϊ
+#ifndef PLC_CONCURRENT_MAX
+#define PLC_CONCURRENT_MAX	1
+#endif
+
+
+//Private Typedefs
+typedef struct {
+	int		qty;
+	int		ndel;
+	int		size;
+	u16		*hash;
+	u8		*tag;
+	u8		*mark;
+	u8		*del;
+} plc_sync_t;
+
+//ÿʱɹ(EWMA)
+typedef struct {
+	u8		adr[6];
+	u8		rate;		//ɹ,255Ϊ100%
+	u8		cnt;		//
+	u16		srtt;		//ƽʱ(ms)
+	u16		rttvar;		//ʱƫ(ms)
+	u8		fail;		//ʱ
+} plc_stat_t;
+
 
 //Private Variables
+static plc_stat_t plc_aStat[PLC_STAT_MAX];
 
 
 
@@ -161,11 +199,184 @@ static int plc_MeterInit()
 	return i;
 }
 
+//ַϣ,ʼλ,*pTagΪַָ
+static int plc_SyncHash(plc_sync_t *s, const u8 *pAdr, u8 *pTag)
+{
+	u32 nKey;
+
+	nKey = (pAdr[0] | (pAdr[1] << 8) | (pAdr[2] << 16) | ((u32)pAdr[3] << 24)) ^ (pAdr[4] | (pAdr[5] << 8));
+	*pTag = (nKey * 0x85EBCA6B) >> 24;
+	
+	return (nKey * 0x9E3779B1) % s->size;
+}
+
+//:ÿ۱+1(2ֽ)ָ(1ֽ),װ2/3
+//ַ,ȶʱӵض,ÿԼ4.5ֽ
+static sys_res plc_SyncInit(plc_sync_t *s, int nValid)
+{
+	int i, nHash;
+	u8 aAdr[6], nTag;
+
+	s->size = nValid + nValid / 2 + 1;
+	s->hash = mem_Malloc(s->size * 3 + (nValid + 7) / 8);
+	if (s->hash == NULL)
+		return SYS_R_EMEM;
+	
+	memset(s->hash, 0, s->size * sizeof(u16));
+	s->tag = (u8 *)&s->hash[s->size];
+	s->mark = &s->tag[s->size];
+	s->del = NULL;
+	
+	for (i = 0; i < nValid; i++)
+	{
+		//ڼ䵵ɾʵͬ
+		if (plc_MeterAdr(i, aAdr) == 0)
+			break;
+		for (nHash = plc_SyncHash(s, aAdr, &nTag); s->hash[nHash]; )
+		{
+			if (++nHash >= s->size)
+				nHash = 0;
+		}
+		s->hash[nHash] = i + 1;
+		s->tag[nHash] = nTag;
+	}
+	s->qty = i;
+
+	return SYS_R_OK;
+}
+
+static int plc_SyncFind(plc_sync_t *s, const u8 *pAdr)
+{
+	int nHash, nSn;
+	u8 aAdr[6], nTag;
+
+	for (nHash = plc_SyncHash(s, pAdr, &nTag); s->hash[nHash]; )
+	{
+		if (s->tag[nHash] == nTag)
+		{
+			nSn = s->hash[nHash] - 1;
+			if (plc_MeterAdr(nSn, aAdr) && (memcmp(aAdr, pAdr, 6) == 0))
+				return nSn;
+		}
+		if (++nHash >= s->size)
+			nHash = 0;
+	}
+	
+	return -1;
+}
+
+//ģ·ɱ,е,ռڵ
+static sys_res plc_SyncRead(plc_t *p, plc_sync_t *s, int nQty, int nFrom1)
+{
+	int i, nSn, nCnt, nDel, nBatch = GW3762_SUBADR_N_MAX;
+	u8 aAdr[GW3762_SUBADR_N_MAX * 6], *pDel;
+
+	memset(s->mark, 0, (s->qty + 7) / 8);
+	for (nDel = 0, nSn = 0; nSn < nQty; nSn += nCnt)
+	{
+		nCnt = MIN(nBatch, nQty - nSn);
+		if (gw3762_SubAdrReadN(p, nSn + nFrom1, &nCnt, NULL, aAdr) != SYS_R_OK)
+		{
+			//ģ鲻ָ֧֡ʱ,ȡʧ
+			if (nBatch > 1)
+			{
+				nBatch >>= 1;
+				nCnt = 0;
+			}
+			else
+			{
+				nCnt = 1;
+			}
+			continue;
+		}
+		
+		if (nCnt == 0)
+			break;
+		
+		for (i = 0; i < nCnt; i++)
+		{
+			int nMeter = plc_SyncFind(s, &aAdr[i * 6]);
+			
+			if ((nMeter >= 0) && (getbit(s->mark, nMeter) == 0))
+			{
+				setbit(s->mark, nMeter);
+				continue;
+			}
+			
+			if ((nDel % GW3762_SUBADR_N_MAX) == 0)
+			{
+				pDel = mem_Realloc(s->del, (nDel + GW3762_SUBADR_N_MAX) * 6);
+				if (pDel == NULL)
+					return SYS_R_EMEM;
+				s->del = pDel;
+			}
+			memcpy(&s->del[nDel * 6], &aAdr[i * 6], 6);
+			nDel += 1;
+		}
+	}
+	s->ndel = nDel;
+	
+	return SYS_R_OK;
+}
+
+//ڵ㰴ɾ,ȱٵĵ
+static sys_res plc_SyncUpdate(plc_t *p, plc_sync_t *s, int nFrom1)
+{
+	int i, nSn, nCnt, nBatch;
+	u8 aBuf[GW3762_SUBADR_N_MAX * GW3762_SUBADR_ADD_SIZE], *pTemp;
+
+	nBatch = GW3762_SUBADR_N_MAX;
+	for (i = 0; i < s->ndel; i += nCnt)
+	{
+		nCnt = MIN(nBatch, s->ndel - i);
+		if (gw3762_SubAdrDeleteN(p, &s->del[i * 6], nCnt) != SYS_R_OK)
+		{
+			if (nBatch > 1)
+			{
+				nBatch >>= 1;
+				nCnt = 0;
+			}
+		}
+	}
+	
+	nBatch = GW3762_SUBADR_N_MAX;
+	for (nSn = 0; nSn < s->qty; )
+	{
+		for (nCnt = 0, i = nSn; (i < s->qty) && (nCnt < nBatch); i++)
+		{
+			if (getbit(s->mark, i))
+				continue;
+			
+			pTemp = &aBuf[nCnt * GW3762_SUBADR_ADD_SIZE];
+			pTemp[8] = plc_MeterAdr(i, pTemp);
+			pTemp[6] = (i + nFrom1) & 0xFF;
+			pTemp[7] = (i + nFrom1) >> 8;
+			nCnt += 1;
+		}
+		
+		if (nCnt == 0)
+			break;
+		
+		if (gw3762_SubAdrAddN(p, aBuf, nCnt) != SYS_R_OK)
+		{
+			if (nBatch == 1)
+				return SYS_R_ERR;
+			
+			nBatch >>= 1;
+			continue;
+		}
+		nSn = i;
+	}
+
+	return SYS_R_OK;
+}
+
 static sys_res plc_Sync(plc_t *p)
 {
-	int i, nSn, nPrtl, nFrom1, nValid, nErr;
+	int i, nFrom1, nValid, nErr;
 	u16 nQty;
-	u8 aBuf[6], aMadr[6], aMeter[(LCP_SN_MAX + 7) / 8];
+	sys_res res = SYS_R_ERR;
+	plc_sync_t xSync;
 
 #if XCN6N12_ENABLE
 	if (p->type != PLC_T_XC_GD)
@@ -194,120 +405,186 @@ static sys_res plc_Sync(plc_t *p)
 	else
 		nFrom1 = 1;
 
+	if (plc_SyncInit(&xSync, nValid) != SYS_R_OK)
+	{
+		PLC_DBGOUT("<PLC> Sync no memory...");
+		return SYS_R_EMEM;
+	}
+
 	for (i = 0; i < 2; i++)
 	{
 		if (p->type != PLC_T_XC_RT)
 		{
 			if (gw3762_SubAdrQty(p, &nQty) != SYS_R_OK)
-				return SYS_R_TMO;
+			{
+				res = SYS_R_TMO;
+				break;
+			}
 		}
 		else
 		{
 			nQty = LCP_SN_MAX;
 		}
 		
-		memset(aMeter, 0, sizeof(aMeter));
-		for (nSn = 0; nSn < nQty; nSn++)
-		{
-			if (gw3762_SubAdrRead(p, nSn + nFrom1, NULL, aBuf) == SYS_R_OK)
-			{
-				if (plc_MeterAdr(nSn, aMadr) == 0)
-					continue;
-				
-				if (memcmp(aBuf, aMadr, 6)) {
-					gw3762_SubAdrDelete(p, aBuf);
-					continue;
-				}
-				
-				setbit(aMeter, nSn);
-			}
-		}
-		
 		nErr = 0;
-		for (nSn = 0; nSn < nValid; nSn++)
-		{
-			if (getbit(aMeter, nSn))
-				continue;
-			
-			nPrtl = plc_MeterAdr(nSn, aMadr);
-			gw3762_SubAdrAdd(p, nSn + nFrom1, aMadr, nPrtl);
-			if (gw3762_SubAdrRead(p, nSn + nFrom1, NULL, aBuf) != SYS_R_OK)
-				return SYS_R_TMO;
-			
-			if (memcmp(aBuf, aMadr, 6)) {
-				nErr = 1;
-				break;
-			}
-		}
+		if (plc_SyncRead(p, &xSync, nQty, nFrom1) != SYS_R_OK)
+			nErr = 1;
+		else if (plc_SyncUpdate(p, &xSync, nFrom1) != SYS_R_OK)
+			nErr = 1;
 		
 		if (gw3762_SubAdrQty(p, &nQty) != SYS_R_OK)
-			return SYS_R_TMO;
+		{
+			res = SYS_R_TMO;
+			break;
+		}
 		
 		if (nErr || (nQty != nValid))
 		{
 			if (i == 0)
 			{
 				if (gw3762_ParaReset(p) != SYS_R_OK)
-					return SYS_R_TMO;
+				{
+					res = SYS_R_TMO;
+					break;
+				}
 			}
 			continue;
 		}
+		res = SYS_R_OK;
 		break;
 	}
 	
-	if (i < 2)
-		return SYS_R_OK;
+	if (xSync.del != NULL)
+		mem_Free(xSync.del);
+	mem_Free(xSync.hash);
+
+	if (res == SYS_R_ERR)
+		PLC_DBGOUT("<PLC> Sync failed...");
 	
-	PLC_DBGOUT("<PLC> Sync failed...");
+	return res;
+}
+
+static plc_stat_t *plc_StatGet(const u8 *pAdr, int nCreate)
+{
+	plc_stat_t *s;
+	u32 nKey;
+
+	nKey = pAdr[0] | (pAdr[1] << 8) | (pAdr[2] << 16);
+	s = &plc_aStat[((nKey * 0x9E3779B1) >> 16) & (PLC_STAT_MAX - 1)];
+	if (s->cnt && (memcmp(s->adr, pAdr, 6) == 0))
+		return s;
 	
-	return SYS_R_ERR;
+	if (nCreate == 0)
+		return NULL;
+	
+	memset(s, 0, sizeof(plc_stat_t));
+	memcpy(s->adr, pAdr, 6);
+	s->rate = 255;
+	
+	return s;
+}
+
+static void plc_StatUpdate(const u8 *pAdr, int nOk, u32 nRtt)
+{
+	plc_stat_t *s;
+	int nErr;
+
+	s = plc_StatGet(pAdr, 1);
+	if (nOk)
+	{
+		nRtt = MIN(MAX(nRtt, 1), 0xFFFF);
+		if (s->srtt == 0)
+		{
+			s->srtt = nRtt;
+			s->rttvar = nRtt / 2;
+		}
+		else
+		{
+			nErr = (int)nRtt - s->srtt;
+			s->srtt += nErr / 8;
+			if (nErr < 0)
+				nErr = -nErr;
+			s->rttvar += (nErr - s->rttvar) / 4;
+		}
+		s->rate += (255 - s->rate) >> 3;
+		s->fail = 0;
+	}
+	else
+	{
+		s->rate -= s->rate >> 3;
+		//ʱ˱:Ŵʱƫ,ȴʱÿһsrtt
+		s->rttvar = MIN((u32)s->rttvar + MAX(s->rttvar, s->srtt / 4), 0xFFFF);
+		if (s->fail < 255)
+			s->fail += 1;
+	}
+	if (s->cnt < 255)
+		s->cnt += 1;
+}
+
+//ӵǰ376.2֡ȡת645֡,ת֡NULL
+static u8 *plc_Recv645(plc_t *p)
+{
+	u8 *pTemp;
+
+	if (p->fn != 0x0001)
+		return NULL;
+	
+	switch (p->afn)
+	{
+	case GW3762_AFN_TRANSMIT:
+	case GW3762_AFN_ROUTE_TRANSMIT:
+		buf_Remove(p->data, 2);
+		break;
+	case GW3762_AFN_CONCURRENT:
+		buf_Remove(p->data, 4);
+		break;
+	default:
+		return NULL;
+	}
+	
+	//645
+	pTemp = dlt645_PacketAnalyze(p->data->p, p->data->len);
+	if (pTemp == NULL)
+		return NULL;
+	
+	//Уַ
+	if (p->rup.module)
+	{
+		if (memcmp(p->madr, &pTemp[1], 6))
+			return NULL;
+	}
+	
+	return pTemp;
+}
+
+static void plc_Push645(buf b, const u8 *pTemp)
+{
+
+	buf_Push(b, &pTemp[DLT645_HEADER_SIZE - 2], pTemp[DLT645_HEADER_SIZE - 1] + 2);
+	byteadd(&b->p[2], -0x33, b->p[1]);
 }
 
 static sys_res plc_Recv(plc_t *p, buf b, const u8 *pAdr, size_t nTmo)
 {
 	u8 *pTemp;
 
-	for (nTmo *= (1000 / OS_TICK_MS); nTmo; nTmo--)
+	for (nTmo /= OS_TICK_MS; nTmo; nTmo--)
 	{
 		if (gw3762_Analyze(p) != SYS_R_OK)
 			continue;
 		
-		switch (p->afn)
+		//
+		if ((p->afn == GW3762_AFN_CONFIRM) && (p->fn == 0x0002))
+			return SYS_R_ERR;
+		
+		pTemp = plc_Recv645(p);
+		if (pTemp == NULL)
+			continue;
+		
+		if (memcmp(&pTemp[1], pAdr, 6) == 0)
 		{
-		case GW3762_AFN_CONFIRM:
-			//
-			if (p->fn == 0x0002)
-				return SYS_R_ERR;
-			break;
-			
-		case GW3762_AFN_TRANSMIT:
-		case GW3762_AFN_ROUTE_TRANSMIT:
-			if (p->fn == 0x0001)
-			{
-				buf_Remove(p->data, 2);
-				//645
-				pTemp = dlt645_PacketAnalyze(p->data->p, p->data->len);
-				if (pTemp != NULL)
-				{
-					//Уַ
-					if (p->rup.module)
-					{
-						if (memcmp(p->madr, &pTemp[1], 6))
-							break;;
-					}
-					
-					if (memcmp(&pTemp[1], pAdr, 6) == 0)
-					{
-						buf_Push(b, &pTemp[DLT645_HEADER_SIZE - 2], pTemp[DLT645_HEADER_SIZE - 1] + 2);
-						byteadd(&b->p[2], -0x33, b->p[1]);
-						return SYS_R_OK;
-					}
-				}
-			}
-			break;
-			
-		default:
-			break;
+			plc_Push645(b, pTemp);
+			return SYS_R_OK;
 		}
 	}
 	
@@ -537,6 +814,46 @@ int plc_GetWait(plc_t *p, int nRelay)
 	}
 }
 
+//-------------------------------------------------------------------------
+//ñʱͳƵõĵȴʱ(ms),ͳʱȡģ̶ֵ
+//-------------------------------------------------------------------------
+int plc_MeterWait(plc_t *p, const u8 *pAdr, int nRelay)
+{
+	plc_stat_t *s;
+	int nMax, nTmo;
+
+	nMax = plc_GetWait(p, nRelay) * 1000;
+	s = plc_StatGet(pAdr, 0);
+	if ((s == NULL) || (s->srtt == 0) || (s->fail >= PLC_WAIT_FALLBACK))
+		return nMax;
+	
+	nTmo = s->srtt + 4 * s->rttvar + PLC_WAIT_MARGIN;
+	
+	return MIN(MAX(nTmo, PLC_WAIT_MIN), nMax);
+}
+
+//-------------------------------------------------------------------------
+//ñɹʵԴ,ڲͨıֻһ
+//-------------------------------------------------------------------------
+int plc_MeterRetry(plc_t *p, const u8 *pAdr)
+{
+	plc_stat_t *s;
+	int nRetry;
+
+	nRetry = plc_GetRetry(p);
+	s = plc_StatGet(pAdr, 0);
+	if ((s == NULL) || (s->cnt < 4))
+		return nRetry;
+	
+	if (s->rate < 64)
+		return 0;
+	
+	if (s->rate < 192)
+		return nRetry + 1;
+	
+	return nRetry;
+}
+
 
 
 void plc_Init(plc_t *p, const u8 *pAdr)
@@ -553,9 +870,10 @@ void plc_Init(plc_t *p, const u8 *pAdr)
 	chl_Bind(p->chl, CHL_T_RS232, pDef->uartid, OS_TICK_MS);
 }
 
-sys_res plc_RealRead(plc_t *p, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, int nRelay, const u8 *pRtAdr)
+static sys_res plc_MeterRead(plc_t *p, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, int nRelay, const u8 *pRtAdr)
 {
 	sys_res res = SYS_R_ERR;
+	u32 nTick;
 
 #if XCN6N12_ENABLE
 	if (p->type == PLC_T_XC_GD)
@@ -591,12 +909,196 @@ sys_res plc_RealRead(plc_t *p, buf b, const u8 *pAdr, int nCode, const void *pDa
 		
 		buf_Release(b);
 		
-		res = plc_Recv(p, b, pAdr, plc_GetWait(p, nRelay));
+		nTick = os_tick_get();
+		res = plc_Recv(p, b, pAdr, plc_MeterWait(p, pAdr, nRelay));
+		if (res != SYS_R_ERR)
+			plc_StatUpdate(pAdr, res == SYS_R_OK, (os_tick_get() - nTick) * OS_TICK_MS);
 	}
 
 	return res;
 }
 
+#if DLT645_CACHE_ENABLE
+static sys_res plc_CacheRead(void *pArg, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen)
+{
+
+	return plc_MeterRead((plc_t *)pArg, b, pAdr, nCode, pData, nLen, 0, NULL);
+}
+#endif
+
+sys_res plc_RealRead(plc_t *p, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, int nRelay, const u8 *pRtAdr)
+{
+#if DLT645_CACHE_ENABLE
+	sys_res res;
+
+	//ֱȲӦ𻺴,ָм̵ճ
+	if (nRelay == 0)
+		return dlt645_CacheRead(b, pAdr, nCode, pData, nLen, plc_CacheRead, p);
+
+	res = plc_MeterRead(p, b, pAdr, nCode, pData, nLen, nRelay, pRtAdr);
+	if ((nCode != DLT645_CODE_READ07) && (nCode != DLT645_CODE_READ97))
+		dlt645_CacheFlush(pAdr);
+	return res;
+#else
+	return plc_MeterRead(p, b, pAdr, nCode, pData, nLen, nRelay, pRtAdr);
+#endif
+}
+
+static void plc_ConcSend(plc_t *p, plc_req_t *pReq)
+{
+	buf b = {0};
+
+	dlt645_Packet2Buf(b, pReq->adr, pReq->code, pReq->data, pReq->len);
+	gw3762_MeterConcurrent(p, pReq->adr, b->p, b->len);
+	buf_Release(b);
+	
+	p->tmo = 100;
+}
+
+//-------------------------------------------------------------------------
+//һ,ģͬʱp->conc·
+//ÿ·ʱ԰ñͳ,ģϲʱµ
+//-------------------------------------------------------------------------
+typedef struct {
+	int		req;
+	int		tries;
+	u32		tick;
+	u32		tmo;
+} plc_slot_t;
+
+static int plc_ConcBusy(plc_t *p, plc_slot_t *pSlot, plc_req_t *pReq, const u8 *pAdr)
+{
+	int i;
+
+	for (i = 0; i < p->conc; i++)
+	{
+		if ((pSlot[i].req >= 0) && (memcmp(pReq[pSlot[i].req].adr, pAdr, 6) == 0))
+			return 1;
+	}
+	
+	return 0;
+}
+
+sys_res plc_RealReadN(plc_t *p, plc_req_t *pReq, int nQty)
+{
+	plc_slot_t aSlot[PLC_CONCURRENT_MAX];
+	plc_req_t *pR;
+	u8 *pTemp;
+	int i, j, nNext, nDone, nRetry;
+	u32 nTick;
+
+	for (i = 0; i < nQty; i++)
+		pReq[i].res = SYS_R_EMPTY;
+	
+	if ((p->conc > 1) && (plc_Pause(p, 100) == SYS_R_OK))
+	{
+		for (i = 0; i < p->conc; i++)
+			aSlot[i].req = -1;
+		
+		for (nNext = 0, nDone = 0; (nDone < nQty) && (p->conc > 1); )
+		{
+			//·,ͬһͬʱռ·
+			for (i = 0; (i < p->conc) && (nNext < nQty); i++)
+			{
+				if (aSlot[i].req >= 0)
+					continue;
+				
+				for (j = nNext; j < nQty; j++)
+				{
+					if ((pReq[j].res == SYS_R_EMPTY) && (plc_ConcBusy(p, aSlot, pReq, pReq[j].adr) == 0))
+						break;
+				}
+				if (j >= nQty)
+					break;
+				
+				pReq[j].res = SYS_R_BUSY;
+				aSlot[i].req = j;
+				aSlot[i].tries = 0;
+				aSlot[i].tick = os_tick_get();
+				aSlot[i].tmo = plc_MeterWait(p, pReq[j].adr, 0) / OS_TICK_MS;
+				plc_ConcSend(p, &pReq[j]);
+				
+				for (; (nNext < nQty) && (pReq[nNext].res != SYS_R_EMPTY); nNext++);
+			}
+			
+			if (gw3762_Analyze(p) == SYS_R_OK)
+			{
+				if ((p->afn == GW3762_AFN_CONFIRM) && (p->fn == 0x0002))
+				{
+					//ģ鲻ֲ֧,;δΪ
+					for (i = 0; i < p->conc; i++)
+					{
+						if (aSlot[i].req >= 0)
+							pReq[aSlot[i].req].res = SYS_R_EMPTY;
+					}
+					p->conc = 1;
+					break;
+				}
+				
+				pTemp = plc_Recv645(p);
+				for (i = 0; (pTemp != NULL) && (i < p->conc); i++)
+				{
+					if (aSlot[i].req < 0)
+						continue;
+					
+					pR = &pReq[aSlot[i].req];
+					if (memcmp(&pTemp[1], pR->adr, 6))
+						continue;
+					
+					plc_Push645(pR->b, pTemp);
+					pR->res = SYS_R_OK;
+					plc_StatUpdate(pR->adr, 1, (os_tick_get() - aSlot[i].tick) * OS_TICK_MS);
+					aSlot[i].req = -1;
+					nDone += 1;
+					break;
+				}
+			}
+			
+			nTick = os_tick_get();
+			for (i = 0; i < p->conc; i++)
+			{
+				if (aSlot[i].req < 0)
+					continue;
+				
+				if ((nTick - aSlot[i].tick) < aSlot[i].tmo)
+					continue;
+				
+				pR = &pReq[aSlot[i].req];
+				plc_StatUpdate(pR->adr, 0, 0);
+				aSlot[i].tries += 1;
+				if (aSlot[i].tries <= plc_MeterRetry(p, pR->adr))
+				{
+					aSlot[i].tick = nTick;
+					aSlot[i].tmo = plc_MeterWait(p, pR->adr, 0) / OS_TICK_MS;
+					plc_ConcSend(p, pR);
+					continue;
+				}
+				pR->res = SYS_R_TMO;
+				aSlot[i].req = -1;
+				nDone += 1;
+			}
+		}
+	}
+	
+	for (i = 0; i < nQty; i++)
+	{
+		pR = &pReq[i];
+		if (pR->res != SYS_R_EMPTY)
+			continue;
+		
+		nRetry = plc_MeterRetry(p, pR->adr);
+		for (j = 0; j <= nRetry; j++)
+		{
+			buf_Release(pR->b);
+			pR->res = plc_RealRead(p, pR->b, pR->adr, pR->code, pR->data, pR->len, 0, NULL);
+			if (pR->res == SYS_R_OK)
+				break;
+		}
+	}
+
+	return SYS_R_OK;
+}
+
 
 sys_res plc_Transmit(plc_t *p, buf b, const void *pData, size_t nLen)
 {
@@ -781,6 +1283,11 @@ sys_res plc_Handler(plc_t *p, buf b, u8 *pAdr)
 		}
 		else
 		{
+			//նָм·ģ鲻ܲ,ʶģͺж
+			p->conc = PLC_CONCURRENT_MAX;
+			if (plc_IsNeedRt(p))
+				p->conc = 1;
+			
 			p->ste = PLC_S_SYNC;
 			p->inited = 20;
 		}
@@ -92,6 +92,7 @@ struct plc
 	u8	time;
 	u8	inited;
 	u8	rstcnt;
+	u8	conc;
 #if PLC_PROBE_ENABLE
 	u8	probe;
 #endif
@@ -109,6 +110,16 @@ struct plc
 	buf data;
 } PACK_STRUCT_STRUCT;
 typedef struct plc plc_t;
+
+typedef struct
+{
+	u8			adr[6];
+	u8			code;
+	u8			len;
+	const void *data;
+	sys_res		res;
+	buf			b;
+} plc_req_t;
  
 
 
@@ -116,6 +127,7 @@ typedef struct plc plc_t;
 void plc_Init(plc_t *p, const u8 *pAdr);
 
 sys_res plc_RealRead(plc_t *p, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen, int nRelay, const u8 *pRtAdr);
+sys_res plc_RealReadN(plc_t *p, plc_req_t *pReq, int nQty);
 sys_res plc_Transmit(plc_t *p, buf b, const void *pData, size_t nLen);
 void plc_Broadcast(plc_t *p);
 void plc_Heartbeat(plc_t *p, const void *pData, size_t nLen);
@@ -123,6 +135,8 @@ sys_res plc_Handler(plc_t *p, buf b, u8 *pAdr);
 
 int plc_GetRetry(plc_t *p);
 int plc_GetWait(plc_t *p, int nRelay);
+int plc_MeterWait(plc_t *p, const u8 *pAdr, int nRelay);
+int plc_MeterRetry(plc_t *p, const u8 *pAdr);
 int plc_IsNeedRt(plc_t *p);
 int plc_IsNotSync(plc_t *p);
 void plc_GetInfo(plc_t *p, char *pInfo);
@@ -14,21 +14,13 @@
 #if XCN6N12_DEBUG_ENABLE
 static void XC_DBGOUT(int nType, const void *pBuf, size_t nLen)
 {
-	const u8 *pData, *pEnd;
 	char str[DBG_BUF_SIZE];
 
-	pData = (const u8 *)pBuf;
-	pEnd = pData + nLen;
-
 	if (nType)
-		nLen = sprintf(str, "%s", "<XCT>");
+		memcpy(str, "<XCT>", 5);
 	else
-		nLen = sprintf(str, "%s", "<XCR>");
-	
-	while ((pData < pEnd) && (nLen < (sizeof(str) - 3)))
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
+		memcpy(str, "<XCR>", 5);
+	hexdump(&str[5], sizeof(str) - 5, pBuf, nLen);
 
 	dbg_trace(str);
 }
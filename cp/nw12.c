@@ -44,43 +44,21 @@ static int nw12_IsPW(int nAfn)
 #if NW12_DEBUG_ENABLE
 static void NW12_DBGTX(const void *pHeader, const void *pBuf, size_t nTxLen)
 {
-	const u8 *pData, *pEnd;
 	char str[DBG_BUF_SIZE];
 	size_t nLen;
 
-	nLen = sprintf(str, "%s", "<NWT>");
-
-	pData = (const u8 *)pHeader;
-	pEnd = pData + sizeof(struct nw12_header);
-
-	while (pData < pEnd)
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
-
-	pData = (const u8 *)pBuf;
-	pEnd = pData + nTxLen;
-
-	while ((pData < pEnd) && (nLen < (sizeof(str) - 3)))
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
+	memcpy(str, "<NWT>", 5);
+	nLen = 5 + hexdump(&str[5], sizeof(str) - 5, pHeader, sizeof(struct nw12_header));
+	hexdump(&str[nLen], sizeof(str) - nLen, pBuf, nTxLen);
 
 	dbg_trace(str);
 }
 static void NW12_DBGRX(const void *pBuf, size_t nLen)
 {
-	const u8 *pData, *pEnd;
 	char str[DBG_BUF_SIZE];
 
-	pData = (const u8 *)pBuf;
-	pEnd = pData + nLen;
-
-	nLen = sprintf(str, "%s", "<NWR>");
-	while ((pData < pEnd) && (nLen < (sizeof(str) - 3)))
-	{
-		nLen += sprintf(&str[nLen], " %02X", *pData++);
-	}
+	memcpy(str, "<NWR>", 5);
+	hexdump(&str[5], sizeof(str) - 5, pBuf, nLen);
 
 	dbg_trace(str);
 }
@@ -227,6 +227,7 @@ struct CLIENT {
 #define CLSET_SVC_ADDR       16   /* get server's address (netbuf)      XXX */
 #define CLSET_PUSH_TIMOD     17   /* push timod if not already present  XXX */
 #define CLSET_POP_TIMOD      18   /* pop timod                          XXX */
+#define CLSET_SINK           19   /* opaque destination for next reply (xdr_sink) */
 /*
  * Connectionless only control operations
  */
@@ -308,6 +309,29 @@ extern CLIENT *clntudp_bufcreate (struct sockaddr_in *__raddr,
 				  struct timeval __wait_resend, int *__sockp,
 				  unsigned int __sendsz, unsigned int __recvsz);
 
+/*
+ * Split-phase UDP calls, several may be in flight on one handle.
+ * enum clnt_stat
+ * clntudp_send(rh, proc, xargs, argsp, xidp)
+ *	starts a call and returns its transaction id in *xidp;
+ * enum clnt_stat
+ * clntudp_recv(rh, xid, xres, resp)
+ *	waits for (or takes the already received) reply of xid;
+ * void
+ * clntudp_cancel(rh, xid)
+ *	gives up on xid, a late reply is dropped.
+ *
+ * A CLSET_SINK destination applies to the reply decoded by the next
+ * clnt_call or clntudp_recv. Payloads referenced in place stay valid
+ * until the next call or receive on the handle.
+ */
+extern enum clnt_stat clntudp_send (CLIENT *__rh, unsigned long __proc,
+				    xdrproc_t __xargs, char *__argsp,
+				    uint32_t *__xidp);
+extern enum clnt_stat clntudp_recv (CLIENT *__rh, uint32_t __xid,
+				    xdrproc_t __xres, char *__resp);
+extern void clntudp_cancel (CLIENT *__rh, uint32_t __xid);
+
 extern int callrpc (const char *__host, const unsigned long __prognum,
 		    const unsigned long __versnum, const unsigned long __procnum,
 		    const xdrproc_t __inproc, const char *__in,
@@ -67,6 +67,36 @@ static struct clnt_ops udp_ops =
 	clntudp_control
 };
 
+/*
+ * Number of split-phase calls (clntudp_send/clntudp_recv) that may be
+ * outstanding on one client handle.
+ */
+#ifndef CLNTUDP_PENDING
+#define CLNTUDP_PENDING		4
+#endif
+
+/*
+ * Times a call is sent again when no reply arrives within the
+ * receive timeout.
+ */
+#ifndef CLNTUDP_RETRY
+#define CLNTUDP_RETRY		3
+#endif
+
+/*
+ * An outstanding split-phase call; a reply that arrives while another
+ * xid is being waited for is kept in buf until collected.
+ */
+struct cu_pend
+{
+	bool_t busy;
+	uint32_t xid;
+	int len;
+	char *buf;
+	int reqlen;
+	char *req;		/* copy of the call for retransmission */
+};
+
 /*
  * Private data kept per client handle
  */
@@ -83,7 +113,11 @@ struct cu_data
 	unsigned int cu_xdrpos;
 	unsigned int cu_sendsz;
 	char *cu_outbuf;
+	int cu_outlen;			/* length of the call in cu_outbuf */
 	unsigned int cu_recvsz;
+	struct xdr_sink *cu_sink;	/* destination for the next reply payload */
+	char *cu_held;			/* stashed reply the last payload may point into */
+	struct cu_pend cu_pend[CLNTUDP_PENDING];
 	char cu_inbuf[1];
 };
 
@@ -131,6 +165,9 @@ CLIENT *clntudp_bufcreate(struct sockaddr_in *raddr,
 		goto fooy;
 	}
 	cu->cu_outbuf = &cu->cu_inbuf[recvsz];
+	memset(cu->cu_pend, 0, sizeof(cu->cu_pend));
+	cu->cu_sink = NULL;
+	cu->cu_held = NULL;
 
 	if (raddr->sin_port == 0) {
 		unsigned short port;
@@ -199,28 +236,42 @@ CLIENT *clntudp_create(struct sockaddr_in *raddr,
 							  UDPMSGSIZE, UDPMSGSIZE));
 }
 
-static enum clnt_stat clntudp_call(CLIENT *cl, unsigned long proc, 
-	xdrproc_t xargs, char* argsp, 
-	xdrproc_t xresults, char* resultsp, 
-	struct timeval utimeout)
+/*
+ * Send an already marshalled call.
+ */
+static enum clnt_stat clntudp_resend(struct cu_data *cu, char *buf, int len)
+{
+	if (sendto(cu->cu_sock, buf, len, 0,
+			   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen)
+			!= len)
+	{
+		cu->cu_error.re_errno = errno;
+		return (cu->cu_error.re_status = RPC_CANTSEND);
+	}
+
+	return (cu->cu_error.re_status = RPC_SUCCESS);
+}
+
+/*
+ * Marshal a call into the out buffer under a fresh xid and send it.
+ */
+static enum clnt_stat clntudp_xmit(CLIENT *cl, unsigned long proc,
+	xdrproc_t xargs, char* argsp)
 {
 	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
 	register XDR *xdrs;
 	register int outlen;
-	register int inlen;
-	socklen_t fromlen;
 
-	struct sockaddr_in from;
-	struct rpc_msg reply_msg;
-	XDR reply_xdrs;
-	bool_t ok;
-	int nrefreshes = 2;			/* number of times to refresh cred */
-
-call_again:
 	xdrs = &(cu->cu_outxdrs);
 	xdrs->x_op = XDR_ENCODE;
 	XDR_SETPOS(xdrs, cu->cu_xdrpos);
 
+	if (cu->cu_held != NULL)
+	{
+		mem_Free(cu->cu_held);
+		cu->cu_held = NULL;
+	}
+
 	/*
 	 * the transaction is the first thing in the out buffer
 	 */
@@ -230,26 +281,20 @@ call_again:
 			(!AUTH_MARSHALL(cl->cl_auth, xdrs)) || (!(*xargs) (xdrs, argsp)))
 		return (cu->cu_error.re_status = RPC_CANTENCODEARGS);
 	outlen = (int) XDR_GETPOS(xdrs);
+	cu->cu_outlen = outlen;
 
-send_again:
-	if (sendto(cu->cu_sock, cu->cu_outbuf, outlen, 0,
-			   (struct sockaddr *) &(cu->cu_raddr), cu->cu_rlen)
-			!= outlen)
-	{
-		cu->cu_error.re_errno = errno;
-		return (cu->cu_error.re_status = RPC_CANTSEND);
-	}
+	return (clntudp_resend(cu, cu->cu_outbuf, outlen));
+}
 
-	/*
-	 * sub-optimal code appears here because we have
-	 * some clock time to spare while the packets are in flight.
-	 * (We assume that this is actually only executed once.)
-	 */
-	reply_msg.acpted_rply.ar_verf = _null_auth;
-	reply_msg.acpted_rply.ar_results.where = resultsp;
-	reply_msg.acpted_rply.ar_results.proc = xresults;
+/*
+ * Receive one datagram into the in buffer, returns its length.
+ */
+static int clntudp_rcv(struct cu_data *cu)
+{
+	register int inlen;
+	socklen_t fromlen;
+	struct sockaddr_in from;
 
-	/* do recv */
 	do
 	{
 		fromlen = sizeof(struct sockaddr);
@@ -263,19 +308,86 @@ send_again:
 	{
 		rt_kprintf("recv error, len %d\n", inlen);
 		cu->cu_error.re_errno = errno;
-		return (cu->cu_error.re_status = RPC_CANTRECV);
+		cu->cu_error.re_status = RPC_CANTRECV;
 	}
 
-	/* see if reply transaction id matches sent id */
-	if (*((uint32_t *) (cu->cu_inbuf)) != *((uint32_t *) (cu->cu_outbuf)))
-		goto send_again;
+	return (inlen);
+}
 
-	/* we now assume we have the proper reply */
+/*
+ * Keep a reply that belongs to an outstanding split-phase call.
+ * Replies nobody waits for (duplicates, cancelled calls) are dropped.
+ */
+static void clntudp_stash(struct cu_data *cu, int inlen)
+{
+	register struct cu_pend *p;
+	uint32_t xid = *((uint32_t *) (cu->cu_inbuf));
+
+	for (p = cu->cu_pend; p < &cu->cu_pend[CLNTUDP_PENDING]; p++)
+	{
+		if (p->busy && p->xid == xid)
+		{
+			if (p->buf == NULL && (p->buf = mem_Malloc(inlen)) != NULL)
+			{
+				memcpy(p->buf, cu->cu_inbuf, inlen);
+				p->len = inlen;
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * Results decoded with the CLSET_SINK destination applied.
+ */
+struct cu_results
+{
+	xdrproc_t proc;
+	char *where;
+	struct xdr_sink *sink;
+};
+
+static bool_t clntudp_results(XDR *xdrs, struct cu_results *res)
+{
+	bool_t ok;
+
+	xdrmem_setsink(xdrs, res->sink);
+	ok = (*res->proc) (xdrs, res->where);
+	xdrs->x_public = NULL;
+
+	return (ok);
+}
+
+/*
+ * Decode and validate a reply message, returns TRUE when the reply
+ * carried an error the credentials might be refreshed for.
+ */
+static bool_t clntudp_reply(CLIENT *cl, char *buf, int inlen,
+	xdrproc_t xresults, char* resultsp, struct xdr_sink *sink)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	struct rpc_msg reply_msg;
+	struct cu_results res;
+	XDR reply_xdrs;
+	bool_t ok;
+
+	reply_msg.rm_reply.rp_stat = MSG_DENIED;
+	reply_msg.acpted_rply.ar_verf = _null_auth;
+	reply_msg.acpted_rply.ar_results.where = resultsp;
+	reply_msg.acpted_rply.ar_results.proc = xresults;
+	if (sink != NULL)
+	{
+		res.proc = xresults;
+		res.where = resultsp;
+		res.sink = sink;
+		reply_msg.acpted_rply.ar_results.where = (char*) &res;
+		reply_msg.acpted_rply.ar_results.proc = (xdrproc_t) clntudp_results;
+	}
 
 	/*
 	 * now decode and validate the response
 	 */
-	xdrmem_create(&reply_xdrs, cu->cu_inbuf, (unsigned int) inlen, XDR_DECODE);
+	xdrmem_create(&reply_xdrs, buf, (unsigned int) inlen, XDR_DECODE);
 	ok = xdr_replymsg(&reply_xdrs, &reply_msg);
 	/* XDR_DESTROY(&reply_xdrs);  save a few cycles on noop destroy */
 	if (ok)
@@ -291,28 +403,213 @@ send_again:
 			}
 			if (reply_msg.acpted_rply.ar_verf.oa_base != NULL)
 			{
-				xdrs->x_op = XDR_FREE;
-				(void) xdr_opaque_auth(xdrs, &(reply_msg.acpted_rply.ar_verf));
+				reply_xdrs.x_op = XDR_FREE;
+				(void) xdr_opaque_auth(&reply_xdrs, &(reply_msg.acpted_rply.ar_verf));
 			}
 		} /* end successful completion */
 		else
 		{
 			/* maybe our credentials need to be refreshed ... */
-			if (nrefreshes > 0 && AUTH_REFRESH(cl->cl_auth))
-			{
-				nrefreshes--;
-				goto call_again;
-			}
+			return (TRUE);
 		} /* end of unsuccessful completion */
 	} /* end of valid reply message */
 	else
 	{
+		/* results that do not fit the sink fail after the verifier */
+		if (reply_msg.rm_reply.rp_stat == MSG_ACCEPTED &&
+			reply_msg.acpted_rply.ar_verf.oa_base != NULL)
+		{
+			reply_xdrs.x_op = XDR_FREE;
+			(void) xdr_opaque_auth(&reply_xdrs, &(reply_msg.acpted_rply.ar_verf));
+		}
 		cu->cu_error.re_status = RPC_CANTDECODERES;
 	}
 
+	return (FALSE);
+}
+
+static enum clnt_stat clntudp_call(CLIENT *cl, unsigned long proc, 
+	xdrproc_t xargs, char* argsp, 
+	xdrproc_t xresults, char* resultsp, 
+	struct timeval utimeout)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register int inlen;
+	int nrefreshes = 2;			/* number of times to refresh cred */
+	int nretry;
+	struct xdr_sink *sink = cu->cu_sink;
+
+	cu->cu_sink = NULL;
+
+call_again:
+	if (clntudp_xmit(cl, proc, xargs, argsp) != RPC_SUCCESS)
+		return (cu->cu_error.re_status);
+
+	/*
+	 * Wait for the reply with our xid; replies to outstanding
+	 * split-phase calls are kept for them, anything else is stale.
+	 * The call goes out again when nothing is heard in time.
+	 */
+	for (nretry = CLNTUDP_RETRY; ; )
+	{
+		inlen = clntudp_rcv(cu);
+		if (inlen < 4)
+		{
+			if (nretry-- <= 0 ||
+				clntudp_resend(cu, cu->cu_outbuf, cu->cu_outlen) != RPC_SUCCESS)
+				return (cu->cu_error.re_status);
+			continue;
+		}
+
+		/* see if reply transaction id matches sent id */
+		if (*((uint32_t *) (cu->cu_inbuf)) == *((uint32_t *) (cu->cu_outbuf)))
+			break;
+		clntudp_stash(cu, inlen);
+	}
+
+	/* we now assume we have the proper reply */
+	if (clntudp_reply(cl, cu->cu_inbuf, inlen, xresults, resultsp, sink))
+	{
+		if (nrefreshes > 0 && AUTH_REFRESH(cl->cl_auth))
+		{
+			nrefreshes--;
+			goto call_again;
+		}
+	}
+
+	return (cu->cu_error.re_status);
+}
+
+/*
+ * Send a call without waiting for its reply, the xid to collect it
+ * with is returned in *xidp. At most CLNTUDP_PENDING may be outstanding.
+ */
+enum clnt_stat clntudp_send(CLIENT *cl, unsigned long proc,
+	xdrproc_t xargs, char* argsp, uint32_t *xidp)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register struct cu_pend *p;
+
+	for (p = cu->cu_pend; p < &cu->cu_pend[CLNTUDP_PENDING]; p++)
+	{
+		if (p->busy == FALSE)
+			break;
+	}
+	if (p == &cu->cu_pend[CLNTUDP_PENDING])
+	{
+		cu->cu_error.re_errno = 0;
+		return (cu->cu_error.re_status = RPC_CANTSEND);
+	}
+
+	if (clntudp_xmit(cl, proc, xargs, argsp) != RPC_SUCCESS)
+		return (cu->cu_error.re_status);
+
+	p->busy = TRUE;
+	p->xid = *((uint32_t *) (cu->cu_outbuf));
+	p->len = 0;
+	p->buf = NULL;
+	/* the out buffer is reused by the next call, keep a copy to resend */
+	p->reqlen = cu->cu_outlen;
+	p->req = mem_Malloc(p->reqlen);
+	if (p->req != NULL)
+		memcpy(p->req, cu->cu_outbuf, p->reqlen);
+	*xidp = p->xid;
+
+	return (RPC_SUCCESS);
+}
+
+static struct cu_pend *clntudp_pend(struct cu_data *cu, uint32_t xid)
+{
+	register struct cu_pend *p;
+
+	for (p = cu->cu_pend; p < &cu->cu_pend[CLNTUDP_PENDING]; p++)
+	{
+		if (p->busy && p->xid == xid)
+			return (p);
+	}
+
+	return (NULL);
+}
+
+static void clntudp_release(struct cu_pend *p)
+{
+	if (p->buf != NULL)
+		mem_Free(p->buf);
+	if (p->req != NULL)
+		mem_Free(p->req);
+	p->buf = NULL;
+	p->req = NULL;
+	p->busy = FALSE;
+}
+
+/*
+ * Collect the reply of a call started with clntudp_send, waiting for
+ * it up to the receive timeout and sending the call again up to
+ * CLNTUDP_RETRY times. The call is finished either way.
+ */
+enum clnt_stat clntudp_recv(CLIENT *cl, uint32_t xid,
+	xdrproc_t xresults, char* resultsp)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register struct cu_pend *p;
+	register int inlen;
+	int nretry = CLNTUDP_RETRY;
+	struct xdr_sink *sink = cu->cu_sink;
+
+	cu->cu_sink = NULL;
+	p = clntudp_pend(cu, xid);
+	if (p == NULL)
+	{
+		cu->cu_error.re_errno = 0;
+		return (cu->cu_error.re_status = RPC_CANTRECV);
+	}
+
+	while (p->buf == NULL)
+	{
+		inlen = clntudp_rcv(cu);
+		if (inlen < 4)
+		{
+			/* nothing heard in time, send the same call again */
+			if (nretry-- > 0 && p->req != NULL &&
+				clntudp_resend(cu, p->req, p->reqlen) == RPC_SUCCESS)
+				continue;
+			clntudp_release(p);
+			return (cu->cu_error.re_status);
+		}
+
+		if (*((uint32_t *) (cu->cu_inbuf)) == xid)
+		{
+			clntudp_reply(cl, cu->cu_inbuf, inlen, xresults, resultsp, sink);
+			clntudp_release(p);
+			return (cu->cu_error.re_status);
+		}
+		clntudp_stash(cu, inlen);
+	}
+
+	clntudp_reply(cl, p->buf, p->len, xresults, resultsp, sink);
+	/* results may reference the stashed reply until the next call */
+	if (cu->cu_held != NULL)
+		mem_Free(cu->cu_held);
+	cu->cu_held = p->buf;
+	p->buf = NULL;
+	clntudp_release(p);
+
 	return (cu->cu_error.re_status);
 }
 
+/*
+ * Forget an outstanding split-phase call, a late reply is dropped.
+ */
+void clntudp_cancel(CLIENT *cl, uint32_t xid)
+{
+	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	register struct cu_pend *p;
+
+	p = clntudp_pend(cu, xid);
+	if (p != NULL)
+		clntudp_release(p);
+}
+
 static void clntudp_geterr(CLIENT *cl, struct rpc_err *errp)
 {
 	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
@@ -363,6 +660,9 @@ static bool_t clntudp_control(CLIENT *cl, int request, char *info)
 	case CLGET_SERVER_ADDR:
 		*(struct sockaddr_in *) info = cu->cu_raddr;
 		break;
+	case CLSET_SINK:
+		cu->cu_sink = (struct xdr_sink *) info;
+		break;
 	default:
 		return (FALSE);
 	}
@@ -372,12 +672,18 @@ static bool_t clntudp_control(CLIENT *cl, int request, char *info)
 static void clntudp_destroy(CLIENT *cl)
 {
 	register struct cu_data *cu = (struct cu_data *) cl->cl_private;
+	int i;
 
 	if (cu->cu_closeit)
 	{
 		lwip_close(cu->cu_sock);
 	}
 
+	for (i = 0; i < CLNTUDP_PENDING; i++)
+		clntudp_release(&cu->cu_pend[i]);
+	if (cu->cu_held != NULL)
+		mem_Free(cu->cu_held);
+
 	XDR_DESTROY(&(cu->cu_outxdrs));
 	mem_Free(cu);
 	mem_Free(cl);
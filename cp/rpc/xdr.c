@@ -190,7 +190,7 @@ bool_t xdr_u_long(XDR* xdrs, unsigned long* ulp)
  */
 bool_t xdr_longlong_t (XDR * xdrs, long long* llp)
 {
-  int32_t t1, t2;
+  long t1, t2;
 
   switch (xdrs->x_op)
     {
@@ -202,7 +202,7 @@ bool_t xdr_longlong_t (XDR * xdrs, long long* llp)
     case XDR_DECODE:
       if (!XDR_GETLONG (xdrs, &t1) || !XDR_GETLONG (xdrs, &t2))
         return FALSE;
-      *llp = ((int64_t) t1) << 32;
+      *llp = ((int64_t) (int32_t) t1) << 32;
       *llp |= (uint32_t) t2;
       return TRUE;
 
@@ -217,22 +217,20 @@ bool_t xdr_longlong_t (XDR * xdrs, long long* llp)
  */
 bool_t xdr_u_longlong_t (XDR * xdrs, unsigned long long* ullp)
 {
-  uint32_t t1, t2;
+  long t1, t2;
 
   switch (xdrs->x_op)
     {
     case XDR_ENCODE:
-      t1 = (uint32_t) ((*ullp) >> 32);
-      t2 = (uint32_t) (*ullp);
-      return (XDR_PUTLONG (xdrs, (int32_t *)&t1) &&
-              XDR_PUTLONG (xdrs, (int32_t *)&t2));
+      t1 = (int32_t) ((*ullp) >> 32);
+      t2 = (int32_t) (*ullp);
+      return (XDR_PUTLONG (xdrs, &t1) && XDR_PUTLONG (xdrs, &t2));
 
     case XDR_DECODE:
-      if (!XDR_GETLONG (xdrs, (int32_t *)&t1) ||
-          !XDR_GETLONG (xdrs, (int32_t *)&t2))
+      if (!XDR_GETLONG (xdrs, &t1) || !XDR_GETLONG (xdrs, &t2))
         return FALSE;
-      *ullp = ((uint64_t) t1) << 32;
-      *ullp |= t2;
+      *ullp = ((uint64_t) (uint32_t) t1) << 32;
+      *ullp |= (uint32_t) t2;
       return TRUE;
 
     case XDR_FREE:
@@ -362,7 +360,7 @@ enum_t *ep;
 	/*
 	 * enums are treated as ints
 	 */
-	return (xdr_long(xdrs, (long *) ep));
+	return (xdr_int(xdrs, (int *) ep));
 }
 
 /*
@@ -450,6 +448,10 @@ unsigned int maxsize;
 		if (nodesize == 0) {
 			return (TRUE);
 		}
+		if (sp == NULL && xdrs->x_public != NULL) {
+			/* caller supplied destination */
+			return (xdrmem_sink(xdrs, cpp, nodesize));
+		}
 		if (sp == NULL) {
 			*cpp = sp = (char *) rt_malloc(nodesize);
 		}
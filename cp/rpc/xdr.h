@@ -340,6 +340,23 @@ extern bool_t xdr_netobj (XDR *__xdrs, struct netobj *__np);
 extern void xdrmem_create (XDR *__xdrs, const char* __addr,
 			   unsigned int __size, enum xdr_op __xop);
 
+/*
+ * Destination of the next variable length opaque (xdr_bytes) decoded
+ * from a memory stream with no buffer of its own: the payload is copied
+ * to addr (at most size bytes), or with addr NULL it is referenced in
+ * place in the stream buffer. size returns the payload length. The
+ * pointer left in the object is not heap memory and must be cleared
+ * before xdr_free().
+ */
+struct xdr_sink
+{
+	char *addr;
+	unsigned int size;
+};
+
+extern void xdrmem_setsink (XDR *__xdrs, struct xdr_sink *__sink);
+extern bool_t xdrmem_sink (XDR *__xdrs, char **__cpp, unsigned int __cnt);
+
 /* XDR pseudo records for tcp */
 extern void xdrrec_create (XDR *__xdrs, unsigned int __sendsize,
 			   unsigned int __recvsize, char* __tcp_handle,
@@ -81,6 +81,42 @@ xdrmem_create (XDR *xdrs, const char* addr, unsigned int size, enum xdr_op op)
 	xdrs->x_ops = &xdrmem_ops;
 	xdrs->x_private = xdrs->x_base = (char*)addr;
 	xdrs->x_handy = size;
+	xdrs->x_public = NULL;
+}
+
+/*
+ * Let the next opaque payload skip the heap, see struct xdr_sink.
+ * The sink is used once.
+ */
+void
+xdrmem_setsink (XDR *xdrs, struct xdr_sink *sink)
+{
+	xdrs->x_public = (char*)sink;
+}
+
+bool_t
+xdrmem_sink (XDR *xdrs, char **cpp, unsigned int cnt)
+{
+  struct xdr_sink *sink = (struct xdr_sink *) xdrs->x_public;
+  unsigned int len;
+
+  xdrs->x_public = NULL;
+  if (xdrs->x_handy < cnt) return FALSE;
+  len = RNDUP(cnt);
+  if (xdrs->x_handy < len) return FALSE;
+
+  if (sink->addr == NULL)
+	*cpp = xdrs->x_private;
+  else
+  {
+	if (cnt > sink->size) return FALSE;
+	memcpy(sink->addr, xdrs->x_private, cnt);
+	*cpp = sink->addr;
+  }
+  sink->size = cnt;
+  xdrs->x_handy -= len;
+  xdrs->x_private += len;
+  return TRUE;
 }
 
 static void
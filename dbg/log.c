@@ -39,7 +39,7 @@ extern flash_dev_t log_Sfs;
 static void log_Decode(buf b, size_t nLen)
 {
 	char str[24];
-	u8 aTime[6], *p, *pEnd;
+	u8 aTime[6], *p;
 	log_t xLog;
 	
 	buf_Push(b, STRING_0D0A, 2);
@@ -70,11 +70,7 @@ static void log_Decode(buf b, size_t nLen)
 			break;
 		}
 
-		for (pEnd = p + nLen; p < pEnd; )
-		{
-			sprintf(str, " %02X", *p++);
-			buf_Push(b, str, 3);
-		}
+		hexdump_to_buf(b, p, nLen);
 	}
 }
 
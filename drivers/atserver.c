@@ -24,51 +24,184 @@ static atsvr_t xATServer = {0};
 #if ATSVR_CMUX_ENABLE
 static const u8 CMUX_HEADER = 0xF9;
 
-static void atsvr_CmuxSend(uart_t *p, u8 adr, u8 c, const void *data, size_t len)
+//Frame types, P/F bit masked
+#define CMUX_F_SABM					0x2F
+#define CMUX_F_UA					0x63
+#define CMUX_F_DM					0x0F
+#define CMUX_F_DISC					0x43
+#define CMUX_F_UIH					0xEF
+#define CMUX_F_UI					0x03
+#define CMUX_F_PF					0x10
+
+//Control channel message types, C/R bit set
+#define CMUX_M_PSC					0x43
+#define CMUX_M_CLD					0xC3
+#define CMUX_M_TEST					0x23
+#define CMUX_M_FCON					0xA3
+#define CMUX_M_FCOFF				0x63
+#define CMUX_M_MSC					0xE3
+#define CMUX_M_CR					0x02
+
+#define CMUX_V24_FC					0x02
+
+//Frame decoder states
+#define CMUX_S_FLAG					0
+#define CMUX_S_ADR					1
+#define CMUX_S_CTRL					2
+#define CMUX_S_LEN					3
+#define CMUX_S_LEN2					4
+#define CMUX_S_INFO					5
+#define CMUX_S_FCS					6
+#define CMUX_S_CLOSE				7
+
+#define atsvr_CmuxAdr(dlci)			(((dlci) << 2) | 0x03)
+
+
+static u8 atsvr_aCmuxFrame[ATSVR_CMUX_N1 + 7];
+
+static void atsvr_CmuxFrame(uart_t *p, u8 adr, u8 c, const void *data, size_t len)
 {
-	u8 buf[4], fcs;
-	u8 *ptmp = (u8 *)data;
-	int send, once;
+	u8 *frame = atsvr_aCmuxFrame, *ptmp;
+	size_t hlen;
+
+	ptmp = frame;
+	*ptmp++ = CMUX_HEADER;
+	*ptmp++ = adr;
+	*ptmp++ = c;
+#if ATSVR_CMUX_N1 > 127
+	if (len > 127)
+	{
+		*ptmp++ = len << 1;
+		*ptmp++ = len >> 7;
+	}
+	else
+#endif
+	{
+		*ptmp++ = (len << 1) + 1;
+	}
+	hlen = ptmp - frame - 1;
+	ptmp = ptrcpy(ptmp, data, len);
+	*ptmp++ = ~fcs8(&frame[1], hlen);
+	*ptmp++ = CMUX_HEADER;
 
-	buf[0] = adr;
-	buf[1] = c;
+	//One write per frame instead of one per field
+	uart_Send(p, frame, ptmp - frame);
+}
 
-	if (len == 0)
-		once = 1;
+static void atsvr_CmuxSend(atsvr_t *p, u8 adr, u8 c, const void *data, size_t len)
+{
+	const u8 *ptmp = (const u8 *)data;
+	size_t send;
 
-	for (; once || len; len -= send, ptmp += send)
+	do
 	{
-		once = 0;
-		
-		send = MIN(0x1F, len);
-		buf[2] = (send << 1) + 1;
-		fcs = ~fcs8(buf, 3);
+		send = MIN(p->mux.n1, len);
+		atsvr_CmuxFrame(p->uart, adr, c, ptmp, send);
+		ptmp += send;
+		len -= send;
+	} while (len);
+}
 
-		uart_Send(p, &CMUX_HEADER, 1);
-		uart_Send(p, buf, 3);
-		uart_Send(p, ptmp, send);
-		uart_Send(p, &fcs, 1);
-		uart_Send(p, &CMUX_HEADER, 1);
+//-------------------------------------------------------------------------
+//Queue data for a DLCI, frames go out from atsvr_CmuxFlush.
+//A write that would overflow the queue is dropped whole, so a PPP frame
+//is never cut in half.
+//-------------------------------------------------------------------------
+static int atsvr_CmuxPush(atsvr_t *p, int dlci, const void *data, size_t len)
+{
 
-#if 0 && ATSVR_DEBUG_ENABLE
+	if ((dlci <= 0) || (dlci >= ATSVR_CMUX_DLCI_QTY))
+		return -1;
+	
+	if ((p->ch[dlci].tbuf->len + len) > ATSVR_CMUX_TBUF_MAX)
+		return -1;
+	
+	return buf_Push(p->ch[dlci].tbuf, data, len);
+}
+
+//-------------------------------------------------------------------------
+//Nonzero while a DLCI should not be fed: the peer has flow control on,
+//or the queue is more than half full
+//-------------------------------------------------------------------------
+static int atsvr_CmuxBusy(atsvr_t *p, int dlci)
+{
+	struct atsvr_dlci *ch = &p->ch[dlci];
+
+	if (p->mux.fc || ch->fc)
+		return 1;
+	
+	return ch->tbuf->len > (ATSVR_CMUX_TBUF_MAX / 2);
+}
+
+//-------------------------------------------------------------------------
+//N1 from AT+CMUX=<mode>[,<subset>[,<speed>[,<N1>...]]], clipped to the
+//frame buffer; ATSVR_CMUX_N1 when not given
+//-------------------------------------------------------------------------
+static int atsvr_CmuxN1(const char *cmd)
+{
+	int i, n1;
+
+	for (i = 0; i < 3; i++)
+	{
+		for (; *cmd != ','; cmd++)
 		{
-			int i;
-			char str[8];
+			if ((*cmd == '\r') || (*cmd == '\0'))
+				return ATSVR_CMUX_N1;
+		}
+		cmd++;
+	}
+	
+	n1 = atoi(cmd);
+	if ((n1 <= 0) || (n1 > ATSVR_CMUX_N1))
+		return ATSVR_CMUX_N1;
+	
+	return n1;
+}
 
-			ATSVR_DBGOUT("[CMUX>] ");
-			for (i = 0; i < 3; i++)
-			{
-				sprintf(str, "%02X ", buf[i]);
-				ATSVR_DBGOUT(str);
-			}
-			for (i = 0; i < send; i++)
-			{
-				sprintf(str, "%02X ", ptmp[i]);
-				ATSVR_DBGOUT(str);
-			}
-			ATSVR_DBGOUT(STRING_0D0A);
+//-------------------------------------------------------------------------
+//Send queued data one frame per DLCI in turn, so a long PPP burst does
+//not hold back AT replies. DLCIs stopped by the peer are skipped.
+//-------------------------------------------------------------------------
+static void atsvr_CmuxFlush(atsvr_t *p)
+{
+	struct atsvr_dlci *ch;
+	int i, idle;
+	size_t send;
+
+	if (p->mux.fc)
+		return;
+	
+	for (idle = 0; idle < (ATSVR_CMUX_DLCI_QTY - 1); )
+	{
+		if (++p->mux.tx >= ATSVR_CMUX_DLCI_QTY)
+			p->mux.tx = 1;
+		
+		i = p->mux.tx;
+		ch = &p->ch[i];
+		if ((ch->tbuf->len == 0) || ch->fc)
+		{
+			idle += 1;
+			continue;
 		}
-#endif
+		
+		idle = 0;
+		send = MIN(p->mux.n1, ch->tbuf->len);
+		atsvr_CmuxFrame(p->uart, atsvr_CmuxAdr(i), CMUX_F_UIH, ch->tbuf->p, send);
+		buf_Remove(ch->tbuf, send);
+	}
+}
+
+static void atsvr_CmuxReset(atsvr_t *p)
+{
+	int i;
+
+	memset(&p->mux, 0, sizeof(p->mux));
+	for (i = 0; i < ATSVR_CMUX_DLCI_QTY; i++)
+	{
+		p->ch[i].ste = 0;
+		p->ch[i].fc = 0;
+		buf_Release(p->ch[i].rbuf);
+		buf_Release(p->ch[i].tbuf);
 	}
 }
 #endif
@@ -87,12 +220,8 @@ static void atsvr_SendStr(atsvr_t *p, const char *str)
 #if ATSVR_CMUX_ENABLE
 	if (p->cmux)
 	{
-		buf b = {0};
-
-		buf_Push(b, STRING_0D0A, 2);
-		buf_Push(b, str, strlen(str));
-		atsvr_CmuxSend(p->uart, ((p->dlci + 1) << 2) | 0x03, 0xEF, b->p, b->len);
-		buf_Release(b);
+		atsvr_CmuxPush(p, p->dlci + 1, STRING_0D0A, 2);
+		atsvr_CmuxPush(p, p->dlci + 1, str, strlen(str));
 	}
 	else
 #endif
@@ -107,6 +236,18 @@ static void atsvr_SendStr(atsvr_t *p, const char *str)
 }
 
 
+static void atsvr_Send(atsvr_t *p, const void *data, size_t len)
+{
+
+#if ATSVR_CMUX_ENABLE
+	if (p->cmux)
+		atsvr_CmuxPush(p, p->dlci + 1, data, len);
+	else
+#endif
+		uart_Send(p->uart, data, len);
+}
+
+
 static int atsvr_Reply(atsvr_t *p, buf b)
 {
 	char str[64];
@@ -136,6 +277,7 @@ static int atsvr_Reply(atsvr_t *p, buf b)
 	{
 		atsvr_SendStr(p, "CONNECT");
 		p->ppp = p->dlci + 1;
+		ppp_reset();
 	}
 #endif
 
@@ -343,7 +485,7 @@ static int atsvr_Reply(atsvr_t *p, buf b)
 			sprintf(str, "$MYNETREAD: %d,%d\r\n", p->soc, i);
 			atsvr_SendStr(p, str);
 			
-			uart_Send(p->uart, p->tbuf->p, i);
+			atsvr_Send(p, p->tbuf->p, i);
 
 #if 1 && ATSVR_DEBUG_ENABLE
 			{
@@ -398,6 +540,8 @@ static void atsvr_RxAT(atsvr_t *p, buf b)
 		
 #if ATSVR_CMUX_ENABLE
 		case 2:
+			atsvr_CmuxReset(p);
+			p->mux.n1 = atsvr_CmuxN1((const char *)&b->p[2]);
 			p->cmux = 1;
 #endif
 		default:
@@ -411,122 +555,255 @@ static void atsvr_RxAT(atsvr_t *p, buf b)
 }
 
 #if ATSVR_CMUX_ENABLE
-static void atsvr_CmuxRun(atsvr_t *p, buf b)
+static void atsvr_CmuxCtrl(atsvr_t *p, u8 *pu, size_t len)
 {
-	u8 *ph, *pu, pf, fcs;
-	int len, hlen, ilen, dlci;
+	int type, dlci;
+
+	if (len < 2)
+		return;
 	
-	//
-	if (uart_Recive(p->uart, b) == 0)
+	type = pu[0];
+	
+	//Responses need no answer
+	if ((type & CMUX_M_CR) == 0)
 		return;
+	
+	switch (type)
+	{
+	case CMUX_M_MSC:
+		if (len < 4)
+			return;
+		dlci = pu[2] >> 2;
+		if ((dlci > 0) && (dlci < ATSVR_CMUX_DLCI_QTY))
+			p->ch[dlci].fc = (pu[3] & CMUX_V24_FC) ? 1 : 0;
+		break;
+
+	case CMUX_M_FCON:
+		p->mux.fc = 0;
+		break;
+
+	case CMUX_M_FCOFF:
+		p->mux.fc = 1;
+		break;
+
+	case CMUX_M_TEST:
+		//Echoed back unchanged, as peers in the field expect
+		atsvr_CmuxSend(p, atsvr_CmuxAdr(0), CMUX_F_UIH, pu, len);
+		return;
+
+	case CMUX_M_PSC:
+	case CMUX_M_CLD:
+		break;
 
-	//CMUXԼ
-	for (; b->len > 5; buf_Remove(b, 1))
+	default:
+		return;
+	}
+	
+	pu[0] = type & ~CMUX_M_CR;
+	atsvr_CmuxSend(p, atsvr_CmuxAdr(0), CMUX_F_UIH, pu, len);
+	
+	if (type == CMUX_M_CLD)
 	{
-		if (b->p[0] != CMUX_HEADER)
-			continue;
+		atsvr_CmuxReset(p);
+		p->cmux = 0;
+	}
+}
 
-		ph = &b->p[1];
-		if (ph[0] == CMUX_HEADER)
-			continue;
+static void atsvr_CmuxInput(atsvr_t *p)
+{
+	struct atsvr_cmux *mux = &p->mux;
+	struct atsvr_dlci *ch;
+	int dlci, pf;
+
+	dlci = mux->hdr[0] >> 2;
+	pf = mux->hdr[1] & CMUX_F_PF;
 
-		ilen = (ph[2] >> 1);
-		if (ph[2] & 1)
+#if 0 && ATSVR_DEBUG_ENABLE
+	{
+		int i;
+		char str[8];
+
+		ATSVR_DBGOUT("[CMUX<] ");
+		for (i = 0; i < mux->ilen; i++)
+		{
+			sprintf(str, "%02X ", mux->info[i]);
+			ATSVR_DBGOUT(str);
+		}
+		ATSVR_DBGOUT(STRING_0D0A);
+	}
+#endif
+
+	if (dlci >= ATSVR_CMUX_DLCI_QTY)
+	{
+		if ((mux->hdr[1] & ~CMUX_F_PF) == CMUX_F_SABM)
+			atsvr_CmuxFrame(p->uart, mux->hdr[0], CMUX_F_DM | pf, NULL, 0);
+		return;
+	}
+	
+	ch = &p->ch[dlci];
+	switch (mux->hdr[1] & ~CMUX_F_PF)
+	{
+	case CMUX_F_DISC:
+		atsvr_CmuxFrame(p->uart, mux->hdr[0], CMUX_F_UA | pf, NULL, 0);
+		//DISC on channel 0 leaves CMUX mode
+		if (dlci == 0)
+		{
+			atsvr_CmuxReset(p);
+			p->cmux = 0;
+		}
+		ch->ste = 0;
+		break;
+
+	case CMUX_F_SABM:
+		atsvr_CmuxFrame(p->uart, mux->hdr[0], CMUX_F_UA | pf, NULL, 0);
+		ch->ste = 1;
+		ch->fc = 0;
+		break;
+
+	case CMUX_F_UIH:
+	case CMUX_F_UI:
+		if (dlci == 0)
+		{
+			atsvr_CmuxCtrl(p, mux->info, mux->ilen);
+			break;
+		}
+		
+		p->dlci = dlci - 1;
+		buf_Push(ch->rbuf, mux->info, mux->ilen);
+#if ATSVR_PPP_ENABLE
+		if (p->ppp == dlci)
 		{
-			//ֽڳ
-			hlen = 3;
+			ppp_process(ch->rbuf);
 		}
 		else
+#endif
 		{
-			//˫ֽڳ
-			ilen += (ph[3] << 7);
-			hlen = 4;
+			atsvr_RxAT(p, ch->rbuf);
 		}
-		len = hlen + ilen;
-		if (len > PPP_MRU)
-			continue;
+		break;
 
-		//Ȳ
-		if (b->len < (len + 2))
-			break;
+	default:
+		break;
+	}
+}
 
-		//CSУ
-		fcs = ~fcs8(ph, hlen);
-		if (ph[len] != fcs)
-			continue;
+static int atsvr_CmuxLenSte(struct atsvr_cmux *mux)
+{
 
-		dlci = ph[0] >> 2;
-		//֧4ͨ
-		if (dlci > 3)
-			continue;
+	//Longer than the negotiated N1, resync on the next flag
+	if (mux->ilen > mux->n1)
+		return CMUX_S_FLAG;
+	
+	mux->cnt = 0;
+	if (mux->ilen)
+		return CMUX_S_INFO;
+	
+	return CMUX_S_FCS;
+}
 
-		//ȷ
-#if 0 && ATSVR_DEBUG_ENABLE
+//-------------------------------------------------------------------------
+//Incremental 07.10 basic option decoder, fed with whatever the UART has.
+//Information fields are copied in runs, a bad frame just restarts the
+//search for the next flag.
+//-------------------------------------------------------------------------
+static void atsvr_CmuxDecode(atsvr_t *p, const u8 *data, size_t len)
+{
+	struct atsvr_cmux *mux = &p->mux;
+	const u8 *end = data + len;
+	size_t copy;
+	int c;
+
+	while (data < end)
+	{
+		if (mux->ste == CMUX_S_INFO)
 		{
-			int i;
-			char str[8];
-	
-			ATSVR_DBGOUT("[CMUX<] ");
-			for (i = 0; i < len; i++)
-			{
-				sprintf(str, "%02X ", ph[i]);
-				ATSVR_DBGOUT(str);
-			}
-			ATSVR_DBGOUT(STRING_0D0A);
+			copy = MIN(mux->ilen - mux->cnt, end - data);
+			memcpy(&mux->info[mux->cnt], data, copy);
+			mux->cnt += copy;
+			data += copy;
+			if (mux->cnt >= mux->ilen)
+				mux->ste = CMUX_S_FCS;
+			continue;
 		}
-#endif
 		
-		pf = ph[1] & 0x10;
-		switch (ph[1] & 0xEF)
+		c = *data++;
+		switch (mux->ste)
 		{
-		case 0x43:		//DISC
-			//ͨ0յDISC˳CMUX״̬
-			if (dlci == 0)
-				p->cmux = 0;
-			
-		case 0x2F:		//SABM
-			atsvr_CmuxSend(p->uart, ph[0], 0x63 | pf, NULL, 0);		//UA
-
+		case CMUX_S_FLAG:
+			if (c == CMUX_HEADER)
+				mux->ste = CMUX_S_ADR;
 			break;
 
-		case 0xEF:		//UIH
-			pu = &ph[hlen];
-			switch (dlci)
-			{
-			case 1:
-			case 2:
-				p->dlci = dlci - 1;
-				buf_Push(p->rbuf[p->dlci], pu, ilen);
-#if ATSVR_PPP_ENABLE
-				if (p->ppp == dlci)
-				{
-					ppp_process(p->rbuf[p->dlci]);
-				}
-				else
-#endif
-				{
-					atsvr_RxAT(p, p->rbuf[p->dlci]);
-				}
+		case CMUX_S_ADR:
+			//Back to back flags
+			if (c == CMUX_HEADER)
 				break;
+			mux->hdr[0] = c;
+			mux->ste = CMUX_S_CTRL;
+			break;
 
-			default:
-				switch (pu[0])
-				{
-				case 0x23:
-					atsvr_CmuxSend(p->uart, ph[0], ph[1], pu, ilen);
+		case CMUX_S_CTRL:
+			mux->hdr[1] = c;
+			mux->ste = CMUX_S_LEN;
+			break;
 
-					break;
-				}
+		case CMUX_S_LEN:
+			mux->hdr[2] = c;
+			mux->ilen = c >> 1;
+			mux->hlen = 3;
+			if (c & 1)
+				mux->ste = atsvr_CmuxLenSte(mux);
+			else
+				mux->ste = CMUX_S_LEN2;
+			break;
 
-				break;
-			}
+		case CMUX_S_LEN2:
+			mux->hdr[3] = c;
+			mux->ilen += c << 7;
+			mux->hlen = 4;
+			mux->ste = atsvr_CmuxLenSte(mux);
+			break;
+
+		case CMUX_S_FCS:
+			if (c == (u8)~fcs8(mux->hdr, mux->hlen))
+				mux->ste = CMUX_S_CLOSE;
+			else
+				mux->ste = CMUX_S_FLAG;
+			break;
 
+		case CMUX_S_CLOSE:
+			if (c == CMUX_HEADER)
+			{
+				//The closing flag may open the next frame
+				mux->ste = CMUX_S_ADR;
+				atsvr_CmuxInput(p);
+			}
+			else
+			{
+				mux->ste = CMUX_S_FLAG;
+			}
 			break;
 
 		default:
+			mux->ste = CMUX_S_FLAG;
 			break;
 		}
+		
+		if (p->cmux == 0)
+			break;
+	}
+}
+
+static void atsvr_CmuxRun(atsvr_t *p, buf b)
+{
+
+	if (uart_Recive(p->uart, b))
+	{
+		atsvr_CmuxDecode(p, b->p, b->len);
+		buf_Release(b);
 	}
+	
+	atsvr_CmuxFlush(p);
 }
 #endif
 
@@ -564,7 +841,10 @@ void atsvr_Run()
 		{
 			//256ղκppp֡˳ATģʽ
 			if (p->tmo++ == 0xFF)
+			{
 				p->ppp = 0;
+				ppp_reset();
+			}
 		}
 		else
 #endif
@@ -584,23 +864,28 @@ void atsvr_Run()
 		atsvr_CmuxRun(p, p->cbuf);
 #if ATSVR_PPP_ENABLE
 		if (p->ppp)
-			ppp_send();
+		{
+			//Hold TCP/UDP data back while the PPP DLCI is stopped or backed up
+			if (atsvr_CmuxBusy(p, p->ppp) == 0)
+				ppp_send();
+			atsvr_CmuxFlush(p);
+		}
 #endif
 	}
 	else
 #endif
 	{
-		uart_Recive(p->uart, p->rbuf[0]);
+		uart_Recive(p->uart, p->rbuf);
 #if ATSVR_PPP_ENABLE
 		if (p->ppp)
 		{
-			ppp_process(p->rbuf[0]);
+			ppp_process(p->rbuf);
 			ppp_send();
 		}
 		else
 #endif
 		{
-			atsvr_RxAT(p, p->rbuf[0]);
+			atsvr_RxAT(p, p->rbuf);
 		}
 	}
 }
@@ -10,9 +10,41 @@ extern "C" {
 
 
 //Public Defines
+#ifndef ATSVR_CMUX_DLCI_QTY
+#define ATSVR_CMUX_DLCI_QTY		4		//including control channel 0
+#endif
+#ifndef ATSVR_CMUX_N1
+#define ATSVR_CMUX_N1			1500	//max information field length, fits a PPP MRU
+#endif
+#ifndef ATSVR_CMUX_TBUF_MAX
+#define ATSVR_CMUX_TBUF_MAX		4096	//per DLCI transmit queue limit
+#endif
 	
 
 //Public Typedefs
+#if ATSVR_CMUX_ENABLE
+struct atsvr_dlci
+{
+	u8		ste;
+	u8		fc;			//flow stopped by peer (MSC FC bit)
+	buf		rbuf;
+	buf		tbuf;
+};
+
+struct atsvr_cmux
+{
+	u8		ste;		//frame decoder state
+	u8		hlen;
+	u8		fc;			//aggregate flow stopped by peer (FCoff)
+	u8		tx;			//round-robin transmit cursor
+	u16		n1;			//information field length negotiated by +CMUX
+	u8		hdr[4];		//address, control, length
+	u16		ilen;
+	u16		cnt;
+	u8		info[ATSVR_CMUX_N1];
+};
+#endif
+
 struct atserver
 {
 	u8		ste;
@@ -32,8 +64,10 @@ struct atserver
 	uart_t *uart;
 #if ATSVR_CMUX_ENABLE
 	buf		cbuf;
+	struct atsvr_cmux	mux;
+	struct atsvr_dlci	ch[ATSVR_CMUX_DLCI_QTY];
 #endif
-	buf		rbuf[2];
+	buf		rbuf;
 	buf		tbuf;
 };
 typedef struct atserver atsvr_t;
@@ -44,6 +44,16 @@ static void att7022_SpiGet()
 }
 
 
+static u32 att7022_Xfer(att7022_t *p, u32 nReg)
+{
+	u32 nData;
+
+	spi_Transce(p->spi, &nReg, 1, &nData, 3);
+	invert(&nData, 3);
+
+	return (nData & ATT7022_DATA_MASK);
+}
+
 static sys_res att7022_Write(u32 nReg, u32 nData)
 {
 	u32 nCrc1, nCrc2, nTemp;
@@ -280,16 +290,11 @@ u32 att7022_Read(u32 nReg)
 	att7022_SpiGet();
 
 	//ݼĴ
-	spi_Transce(p->spi, &nReg, 1, &nData, 3);
+	nData = att7022_Xfer(p, nReg);
 	os_thd_slp1tick();
-	invert(&nData, 3);
-	nData &= ATT7022_DATA_MASK;
 	
 	//УĴ	
-	nReg = ATT7022_REG_RSPIData;
-	spi_Transce(p->spi, &nReg, 1, &nCrc, 3);
-	invert(&nCrc, 3);
-	nCrc &= ATT7022_DATA_MASK;
+	nCrc = att7022_Xfer(p, ATT7022_REG_RSPIData);
 
 	spi_Close(p->spi);
 
@@ -673,6 +678,133 @@ void att7022_CaliPhase(att7022_cali_t *pCali)
 }
 
 
+#if ATT7022_SNAP_ENABLE
+//------------------------------------------------------------------------
+//	: att7022_SnapConfig()
+//	: 
+//	: pReg - Ĵб
+//		  nQty - Ĵ
+//	: -
+//	: SYS_R_OK - ɹ
+//	: ÿռĴб,ѷĿ
+//		  att7022_Snapshotͬһ̵߳
+//------------------------------------------------------------------------
+sys_res att7022_SnapConfig(const u8 *pReg, int nQty)
+{
+	att7022_t *p = &att_x7022;
+
+	if ((nQty <= 0) || (nQty > ATT7022_SNAP_MAX))
+		return SYS_R_ERR;
+
+	os_thd_lock();
+	memcpy(p->reg, pReg, nQty);
+	p->qty = nQty;
+	p->snap[0].seq = 0;
+	p->snap[1].seq = 0;
+	os_thd_unlock();
+
+	return SYS_R_OK;
+}
+
+//------------------------------------------------------------------------
+//	: att7022_Snapshot()
+//	: 
+//	: -
+//	: -
+//	: SYS_R_OK - ȫĴУͨ
+//		  SYS_R_ERR - мĴضУʧ,ֵΪ0
+//	: ȡĴб
+//		  бֻռһSPI,Ĵ֮䲻,
+//		  УʧܵļĴбͳһضһ
+//------------------------------------------------------------------------
+sys_res att7022_Snapshot()
+{
+	att7022_t *p = &att_x7022;
+	att7022_snap_t *pSnap;
+	u8 aErr[ATT7022_SNAP_MAX];
+	u32 nData;
+	int i, j, nErr = 0;
+
+	if (p->qty == 0)
+		return SYS_R_ERR;
+
+	//дδĻ,
+	pSnap = &p->snap[p->idx ^ 1];
+	pSnap->seq = 0;
+
+	att7022_SpiGet();
+	for (i = 0; i < p->qty; i++)
+	{
+		nData = att7022_Xfer(p, p->reg[i]);
+		if (att7022_Xfer(p, ATT7022_REG_RSPIData) == nData)
+			pSnap->data[i] = nData;
+		else
+			aErr[nErr++] = i;
+	}
+	if (nErr)
+	{
+		os_thd_slp1tick();
+		for (j = 0, i = 0; i < nErr; i++)
+		{
+			nData = att7022_Xfer(p, p->reg[aErr[i]]);
+			if (att7022_Xfer(p, ATT7022_REG_RSPIData) != nData)
+			{
+				ATT7022_DBGOUT("<ATT7022>SnapReg %02X Err", p->reg[aErr[i]]);
+				nData = 0;
+				j += 1;
+			}
+			pSnap->data[aErr[i]] = nData;
+		}
+		nErr = j;
+	}
+	spi_Close(p->spi);
+
+	pSnap->tick = os_tick_get();
+	pSnap->qty = p->qty;
+	pSnap->err = nErr;
+
+	//
+	p->seq += 1;
+	if (p->seq == 0)
+		p->seq = 1;
+	os_thd_lock();
+	pSnap->seq = p->seq;
+	p->idx ^= 1;
+	os_thd_unlock();
+
+	if (nErr)
+		return SYS_R_ERR;
+	return SYS_R_OK;
+}
+
+//------------------------------------------------------------------------
+//	: att7022_SnapGet()
+//	: 
+//	: -
+//	: pSnap - ¿
+//	: ,0Ϊ޿
+//	: ȡ¿,SPI
+//		  ڼ仺屻дʱŻ仯,¿
+//------------------------------------------------------------------------
+u32 att7022_SnapGet(att7022_snap_t *pSnap)
+{
+	att7022_t *p = &att_x7022;
+	att7022_snap_t *pCur;
+	u32 nSeq;
+
+	do {
+		pCur = &p->snap[p->idx];
+		nSeq = pCur->seq;
+		if (nSeq == 0)
+			return 0;
+		memcpy(pSnap, pCur, sizeof(att7022_snap_t));
+	} while (pCur->seq != nSeq);
+
+	return nSeq;
+}
+#endif
+
+
 
 #endif
 
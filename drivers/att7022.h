@@ -237,12 +237,41 @@ extern "C" {
 
 
 
+//Ĵ
+#ifndef ATT7022_SNAP_ENABLE
+#define ATT7022_SNAP_ENABLE			0
+#endif
+
+#if ATT7022_SNAP_ENABLE
+#ifndef ATT7022_SNAP_MAX
+#define ATT7022_SNAP_MAX			48
+#endif
+#endif
+
 
 //Public Typedefs
+#if ATT7022_SNAP_ENABLE
+typedef struct
+{
+	volatile u32	seq;		//,0ΪЧ
+	u32		tick;				//ɼʱ
+	u16		qty;				//Ĵ
+	u16		err;				//УʧܵļĴ
+	u32		data[ATT7022_SNAP_MAX];	//õļĴбһһӦ
+}att7022_snap_t;
+#endif
+
 typedef struct
 {
 	u16		ec;
 	spi_t *	spi;
+#if ATT7022_SNAP_ENABLE
+	u8		qty;
+	volatile u8	idx;		//ǰĻ
+	u32		seq;
+	u8		reg[ATT7022_SNAP_MAX];
+	att7022_snap_t	snap[2];
+#endif
 }att7022_t;
 
 typedef struct
@@ -326,6 +355,12 @@ u16 att7022_GetEConst(void);
 void att7022_CaliUIP(att7022_cali_t *pCali);
 void att7022_CaliPhase(att7022_cali_t *pCali);
 
+#if ATT7022_SNAP_ENABLE
+sys_res att7022_SnapConfig(const u8 *pReg, int nQty);
+sys_res att7022_Snapshot(void);
+u32 att7022_SnapGet(att7022_snap_t *pSnap);
+#endif
+
 
 
 #ifdef __cplusplus
@@ -5,6 +5,27 @@
 #define MODEM_CMD_DIAL_GPRS			"ATD*99***1#\r\n"
 #define MODEM_CMD_DIAL_CDMA			"ATDT#777\r\n"
 
+#define MODEM_AT_TMO				1000
+#define MODEM_AT_ITV				1000
+#define MODEM_URC_SIZE				64
+
+#define MODEM_AT_R_WAIT				0
+#define MODEM_AT_R_OK				1
+#define MODEM_AT_R_ERR				2
+
+
+//Private Typedefs
+struct modem_at
+{
+	const char *cmd;
+	const char *res;		//expected response
+	u16			tmo;		//per attempt in ms
+	u16			itv;		//ms between attempts after an unexpected answer
+	u8			retry;
+	u8			must;		//abort the queue on failure
+};
+typedef const struct modem_at t_modem_at;
+
 
 //Private Macros
 #if MODEM_DEBUG_ENABLE
@@ -25,6 +46,31 @@
 //Private Variables
 static t_modem gsm_xModem;
 
+//Private Consts
+static const char * const tbl_modemUrc[] = {
+	"RING",
+	"+CRING:",
+	"+CMTI:",
+	"$MYURC",
+};
+
+static const char * const tbl_modemFinalErr[] = {
+	"ERROR",
+	"+CME ERROR",
+	"+CMS ERROR",
+};
+
+static t_modem_at tbl_modemAtReset[] = {
+	{"Z0",	"OK\r",	MODEM_AT_TMO,	MODEM_AT_ITV,	30,	1},
+	{"E0",	"OK\r",	MODEM_AT_TMO,	MODEM_AT_ITV,	4,	1},
+};
+
+
+//Internal Functions
+#if MODEM_TCP_ENABLE
+static void mtcp_RxUrc(p_modem p, const char *pLine);
+#endif
+
 
 static void modem_Act(int nHL)
 {
@@ -63,37 +109,152 @@ static void modem_Rst(int nHL)
 
 
 
-static sys_res modem_SendCmd(p_modem p, const char *pCmd, const char *pRes, int nRetry)
+//-------------------------------------------------------------------------
+//AT command engine
+//A command completes as soon as its expected response or a final error
+//result code arrives, instead of after a fixed sleep and polling window.
+//Unsolicited result codes are cut out of the response buffer and handed
+//to modem_Urc, so command parsers only ever see their own answer.
+//-------------------------------------------------------------------------
+static void modem_Urc(p_modem p, const char *pLine)
 {
-	size_t nTmo;
 
-	for (; nRetry; nRetry--)
+#if MODEM_TCP_ENABLE
+	if (memscmp(pLine, "$MYURC") == 0)
+	{
+		mtcp_RxUrc(p, pLine);
+		return;
+	}
+#endif
+	MODEM_DBGOUT("<Modem> URC %s", pLine);
+}
+
+static int modem_LineMatch(const char *pLine, size_t nLen, const char * const *pTbl, size_t nQty)
+{
+	const char * const *pEnd = pTbl + nQty;
+	size_t nStr;
+
+	for (; pTbl < pEnd; pTbl++)
+	{
+		nStr = strlen(*pTbl);
+		if ((nLen >= nStr) && (memcmp(pLine, *pTbl, nStr) == 0))
+			return 1;
+	}
+	
+	return 0;
+}
+
+static int modem_AtScan(p_modem p, size_t *pOffset)
+{
+	char *pLine, *pEnd, str[MODEM_URC_SIZE];
+	size_t nLen;
+	int res = MODEM_AT_R_WAIT;
+
+	while (*pOffset < p->rbuf->len)
+	{
+		pLine = (char *)p->rbuf->p + *pOffset;
+		pEnd = memchr(pLine, '\n', p->rbuf->len - *pOffset);
+		if (pEnd == NULL)
+			break;
+		
+		nLen = pEnd - pLine;
+		if (nLen && (pLine[nLen - 1] == '\r'))
+			nLen -= 1;
+		
+		if (modem_LineMatch(pLine, nLen, tbl_modemUrc, ARR_SIZE(tbl_modemUrc)))
+		{
+			nLen = MIN(nLen, sizeof(str) - 1);
+			memcpy(str, pLine, nLen);
+			str[nLen] = '\0';
+			nLen = pEnd - pLine + 1;
+			//Take the blank line in front of the URC with it
+			if ((*pOffset >= 2) && (memcmp(pLine - 2, "\r\n", 2) == 0) &&
+				((*pOffset == 2) || (pLine[-3] == '\n')))
+			{
+				*pOffset -= 2;
+				nLen += 2;
+			}
+			buf_Cut(p->rbuf, *pOffset, nLen);
+			modem_Urc(p, str);
+			continue;
+		}
+		
+		if ((nLen == 2) && (memcmp(pLine, "OK", 2) == 0))
+			res = MODEM_AT_R_OK;
+		else if (modem_LineMatch(pLine, nLen, tbl_modemFinalErr, ARR_SIZE(tbl_modemFinalErr)))
+			res = MODEM_AT_R_ERR;
+		
+		*pOffset += pEnd - pLine + 1;
+	}
+	
+	return res;
+}
+
+static sys_res modem_AtExec(p_modem p, t_modem_at *pAt)
+{
+	size_t nOffset, nTmo;
+	int nRetry, res;
+
+	for (nRetry = pAt->retry; nRetry; nRetry--)
 	{
 		buf_Release(p->rbuf);
+		nOffset = 0;
 
 		uart_SendStr(p->uart, "AT");
-		uart_SendStr(p->uart, pCmd);
+		uart_SendStr(p->uart, pAt->cmd);
 		uart_SendStr(p->uart, STRING_0D0A);
 
-		os_thd_sleep(100);
-		for (nTmo = 900 / OS_TICK_MS; nTmo; nTmo--)
+		res = MODEM_AT_R_WAIT;
+		for (nTmo = pAt->tmo / OS_TICK_MS; nTmo && (res == MODEM_AT_R_WAIT); nTmo--)
 		{
 			if (uart_RecTmo(p->uart, p->rbuf, OS_TICK_MS) != SYS_R_OK)
 				continue;
 			
-			if (buffstr(p->rbuf, pRes) != NULL)
+			res = modem_AtScan(p, &nOffset);
+			if (buffstr(p->rbuf, pAt->res) != NULL)
 			{
-				MODEM_DBGOUT("<Modem> %s OK", pCmd);
+				MODEM_DBGOUT("<Modem> %s OK", pAt->cmd);
 				return SYS_R_OK;
 			}
 		}
+		
+		//Final result code without the expected answer, space the next try
+		if ((res != MODEM_AT_R_WAIT) && (nRetry > 1))
+			os_thd_sleep(pAt->itv);
 	}
 	
-	MODEM_DBGOUT("<Modem> %s ERR", pCmd);
+	MODEM_DBGOUT("<Modem> %s ERR", pAt->cmd);
 	
 	return SYS_R_TMO;
 }
 
+static sys_res modem_AtQueue(p_modem p, t_modem_at *pAt, size_t nQty)
+{
+	t_modem_at *pEnd = pAt + nQty;
+
+	for (; pAt < pEnd; pAt++)
+	{
+		if ((modem_AtExec(p, pAt) != SYS_R_OK) && (pAt->must))
+			return SYS_R_TMO;
+	}
+	
+	return SYS_R_OK;
+}
+
+static sys_res modem_SendCmd(p_modem p, const char *pCmd, const char *pRes, int nRetry)
+{
+	struct modem_at xAt;
+
+	xAt.cmd = pCmd;
+	xAt.res = pRes;
+	xAt.tmo = MODEM_AT_TMO;
+	xAt.itv = MODEM_AT_ITV;
+	xAt.retry = nRetry;
+	xAt.must = 1;
+	
+	return modem_AtExec(p, &xAt);
+}
+
 static sys_res modem_InitCmd(p_modem p)
 {
 	int i, nTemp;
@@ -102,7 +263,7 @@ static sys_res modem_InitCmd(p_modem p)
 	uart_Config(p->uart, MODEM_UART_BAUD, UART_PARI_NO, UART_DATA_8D, UART_STOP_1D);
 
 #if MODEM_BAUD_ADJUST
-	if (modem_SendCmd(p, "Z0", "OK\r", 30) != SYS_R_OK)
+	if (modem_AtExec(p, &tbl_modemAtReset[0]) != SYS_R_OK)
 	{
 		uart_Config(p->uart, MODEM_BAUD_ADJUST, UART_PARI_NO, UART_DATA_8D, UART_STOP_1D);
 		if (modem_SendCmd(p, "Z0", "OK\r", 10) != SYS_R_OK)
@@ -114,13 +275,12 @@ static sys_res modem_InitCmd(p_modem p)
 		
 		uart_Config(p->uart, MODEM_UART_BAUD, UART_PARI_NO, UART_DATA_8D, UART_STOP_1D);
 	}
+	if (modem_AtQueue(p, &tbl_modemAtReset[1], ARR_SIZE(tbl_modemAtReset) - 1) != SYS_R_OK)
+		return SYS_R_TMO;
 #else
-	if (modem_SendCmd(p, "Z0", "OK\r", 30) != SYS_R_OK)
+	if (modem_AtQueue(p, tbl_modemAtReset, ARR_SIZE(tbl_modemAtReset)) != SYS_R_OK)
 		return SYS_R_TMO;
-	
 #endif
-	if (modem_SendCmd(p, "E0", "OK\r", 4) != SYS_R_OK)
-		return SYS_R_TMO;
 	
 	//ģϢ
 	p->ver[0] = '\0';
@@ -1053,6 +1213,9 @@ void modem_Run()
 {
 	p_modem p = &gsm_xModem;
 	sys_res res;
+#if MODEM_DEBUG_ENABLE
+	u32 nTick;
+#endif
 #if MODEM_TCP_ENABLE
 	char *pTemp;
 #endif
@@ -1128,7 +1291,11 @@ void modem_Run()
 		
 	case MODEM_S_INIT:
 		//Initiate modem and get type of modem
+#if MODEM_DEBUG_ENABLE
+		nTick = os_tick_get();
+#endif
 		res = modem_InitCmd(p);
+		MODEM_DBGOUT("<Modem> Init %dms", (os_tick_get() - nTick) * OS_TICK_MS);
 		
 		buf_Release(p->rbuf);
 		
@@ -1418,78 +1585,269 @@ void modem_Refresh()
 
 
 #if MODEM_TCP_ENABLE
-int modem_IsMTcp()
+//-------------------------------------------------------------------------
+//Internal TCP stack receive path
+//Bytes from the modem are demultiplexed as they arrive: URC lines mark a
+//link readable, $MYNETREAD answers switch the parser to a counted payload
+//block delivered straight into the link buffer, and the next read is
+//issued as soon as the final result code of the previous one is seen.
+//-------------------------------------------------------------------------
+//Private Defines
+#ifndef MODEM_MTCP_LINK_QTY
+#define MODEM_MTCP_LINK_QTY		1
+#endif
+
+#define MTCP_READ_SIZE			1460
+#define MTCP_READ_TMO			(1000 / OS_TICK_MS)
+#define MTCP_LINE_SIZE			64
+
+#define MTCP_RX_S_LINE			0
+#define MTCP_RX_S_DATA			1
+
+#define MTCP_PEND_NONE			0
+#define MTCP_PEND_URC			1
+#define MTCP_PEND_READ			2
+
+
+//Private Typedefs
+struct mtcp_rx
+{
+	u8		ste;
+	u8		id;			//link of the running read
+	u8		reading;	//AT$MYNETREAD outstanding
+	u8		writing;	//AT$MYNETWRITE outstanding, hold reads back
+	u8		wres;		//payload sent, result code of the write outstanding
+	u8		prompt;		//$MYNETWRITE answer seen
+	u8		pend[MODEM_MTCP_LINK_QTY];
+	u16		llen;
+	u16		dlen;		//payload bytes still expected
+	u16		rlen;		//payload length announced
+	u32		tick;		//tick the running read was issued
+	char	line[MTCP_LINE_SIZE];
+	buf		rx[MODEM_MTCP_LINK_QTY];
+};
+typedef struct mtcp_rx t_mtcp_rx;
+
+
+//Private Variables
+static t_mtcp_rx mtcp_xRx;
+
+
+
+static void mtcp_RxReset(t_mtcp_rx *r)
+{
+	int i;
+
+	r->ste = MTCP_RX_S_LINE;
+	r->reading = 0;
+	r->writing = 0;
+	r->wres = 0;
+	r->prompt = 0;
+	r->llen = 0;
+	r->dlen = 0;
+	for (i = 0; i < MODEM_MTCP_LINK_QTY; i++)
+	{
+		r->pend[i] = MTCP_PEND_NONE;
+		buf_Release(r->rx[i]);
+	}
+}
+
+static void mtcp_RxIssue(p_modem p, t_mtcp_rx *r)
 {
+	char str[32];
+	int i;
+
+	if (r->reading || r->writing || r->wres)
+		return;
 	
-	return gsm_xModem.mtcp;
+	for (i = 0; i < MODEM_MTCP_LINK_QTY; i++)
+	{
+		if (r->pend[i] == MTCP_PEND_URC)
+			break;
+	}
+	if (i >= MODEM_MTCP_LINK_QTY)
+		return;
+	
+	r->id = i;
+	r->rlen = 0;
+	r->reading = 1;
+	r->pend[i] = MTCP_PEND_READ;
+	r->tick = os_tick_get();
+	sprintf(str, "AT$MYNETREAD=%d,%d\r\n", i, MTCP_READ_SIZE);
+	uart_SendStr(p->uart, str);
 }
 
-int mtcp_IsTcpCon()
+static void mtcp_RxUrc(p_modem p, const char *pLine)
 {
+	t_mtcp_rx *r = &mtcp_xRx;
+	int nId;
+
+	if (memcmp(pLine, "$MYURCREAD:", 11) == 0)
+	{
+		nId = atoi(&pLine[11]);
+		if ((nId >= 0) && (nId < MODEM_MTCP_LINK_QTY))
+			r->pend[nId] = MTCP_PEND_URC;
+		return;
+	}
 	
-	return gsm_xModem.mcon;
+	if (memcmp(pLine, "$MYURCCLOSE:", 12) == 0)
+		p->mcon = 0;
 }
 
-sys_res mtcp_TcpRecv(buf b)
+static void mtcp_RxLine(p_modem p, t_mtcp_rx *r)
 {
-	p_modem p = &gsm_xModem;
-	size_t i, nLen;
 	char *pTemp;
 
-	if (modem_IsOnline() == 0)
-		return SYS_R_ERR;
+	if (memcmp(r->line, "$MYURC", 6) == 0)
+	{
+		mtcp_RxUrc(p, r->line);
+		return;
+	}
 	
-	if (uart_RecTmo(p->uart, p->rbuf, OS_TICK_MS) != SYS_R_OK)
-		return SYS_R_ERR;
+	if (memcmp(r->line, "$MYNETREAD:", 11) == 0)
+	{
+		pTemp = strchr(&r->line[11], ',');
+		if (pTemp == NULL)
+			return;
+		
+		r->rlen = MIN(atoi(pTemp + 1), MTCP_READ_SIZE);
+		if (r->rlen)
+		{
+			r->dlen = r->rlen;
+			r->ste = MTCP_RX_S_DATA;
+		}
+		return;
+	}
 	
-	pTemp = buffstr(p->rbuf, "$MYURCREAD:");
-	if (pTemp == NULL)
-		return SYS_R_ERR;
-
-	buf_Release(p->rbuf);
-	uart_SendStr(p->uart, "AT$MYNETREAD=0,1460\r\n");
-	os_thd_sleep(100);
-	for (i = 500 / OS_TICK_MS; i; i--)
+	if (memcmp(r->line, "$MYNETWRITE:", 12) == 0)
 	{
-		if (uart_RecTmo(p->uart, p->rbuf, OS_TICK_MS) != SYS_R_OK)
-			continue;
-
-		pTemp = buffstr(p->rbuf, "OK\r\n");
-		if (pTemp)
-			break;
+		r->prompt = 1;
+		return;
+	}
+	
+	//The result code of a write must not be taken for the next read's
+	if (r->wres)
+	{
+		if ((strcmp(r->line, "OK") == 0) || (strstr(r->line, "ERROR") != NULL))
+			r->wres = 0;
+		return;
+	}
+	
+	if (r->reading == 0)
+		return;
+	
+	if (strcmp(r->line, "OK") == 0)
+	{
+		//A full read means more may be waiting, keep the link pending
+		r->reading = 0;
+		if ((r->rlen >= MTCP_READ_SIZE) || (r->pend[r->id] == MTCP_PEND_URC))
+			r->pend[r->id] = MTCP_PEND_URC;
+		else
+			r->pend[r->id] = MTCP_PEND_NONE;
+		return;
+	}
+	
+	if (strstr(r->line, "ERROR") != NULL)
+	{
+		r->reading = 0;
+		r->pend[r->id] = MTCP_PEND_NONE;
 	}
-	if (i)
+}
+
+static void mtcp_RxInput(p_modem p, t_mtcp_rx *r, const u8 *pData, size_t nLen)
+{
+	const u8 *pEnd = pData + nLen;
+	size_t nSize;
+	int c;
+
+	while (pData < pEnd)
 	{
-		pTemp = buffstr(p->rbuf, "$MYNETREAD:");
-		if (pTemp)
+		if (r->ste == MTCP_RX_S_DATA)
 		{
-			pTemp = memfind(pTemp, 3, ",");
-			if (pTemp)
-			{
-				nLen = atoi(pTemp);
-				if (nLen > 1460)
-					nLen = 1460;
-				pTemp = memfind(pTemp, 6, STRING_0D0A);
-				if (pTemp)
-				{
-					buf_Remove(p->rbuf, (u8 *)pTemp - p->rbuf->p);
-					if (p->rbuf->len >= nLen)
-					{
-						buf_Push(b, p->rbuf->p, nLen);
-						buf_Remove(p->rbuf, nLen);
+			nSize = MIN(r->dlen, pEnd - pData);
+			buf_Push(r->rx[r->id], pData, nSize);
 #if MODEM_FLOWCTL_ENABLE
-						gsm_xModem.flow_r += nLen;
+			p->flow_r += nSize;
 #endif
-						return SYS_R_OK;
-					}
-				}
-			}
+			pData += nSize;
+			r->dlen -= nSize;
+			if (r->dlen == 0)
+				r->ste = MTCP_RX_S_LINE;
+			continue;
+		}
+		
+		c = *pData++;
+		if (c == '\n')
+		{
+			if (r->llen && (r->line[r->llen - 1] == '\r'))
+				r->llen -= 1;
+			r->line[r->llen] = '\0';
+			if (r->llen)
+				mtcp_RxLine(p, r);
+			r->llen = 0;
+		}
+		else if (r->llen < (MTCP_LINE_SIZE - 1))
+		{
+			r->line[r->llen++] = c;
 		}
 	}
+}
+
+static void mtcp_RxPoll(p_modem p, size_t nTmo)
+{
+	t_mtcp_rx *r = &mtcp_xRx;
+
+	if (uart_RecTmo(p->uart, p->rbuf, nTmo) == SYS_R_OK)
+	{
+		mtcp_RxInput(p, r, p->rbuf->p, p->rbuf->len);
+		buf_Release(p->rbuf);
+	}
+	
+	if (r->reading && ((os_tick_get() - r->tick) > MTCP_READ_TMO))
+	{
+		MODEM_DBGOUT("<Modem> MYNETREAD tmo");
+		r->ste = MTCP_RX_S_LINE;
+		r->reading = 0;
+		r->pend[r->id] = MTCP_PEND_URC;
+	}
+	
+	if (r->wres && ((os_tick_get() - r->tick) > MTCP_READ_TMO))
+		r->wres = 0;
+	
+	mtcp_RxIssue(p, r);
+}
+
+
+
+int modem_IsMTcp()
+{
+	
+	return gsm_xModem.mtcp;
+}
+
+int mtcp_IsTcpCon()
+{
 	
-	buf_Release(p->rbuf);
+	return gsm_xModem.mcon;
+}
+
+sys_res mtcp_TcpRecv(buf b)
+{
+	p_modem p = &gsm_xModem;
+	t_mtcp_rx *r = &mtcp_xRx;
 
-	return SYS_R_ERR;
+	if (modem_IsOnline() == 0)
+		return SYS_R_ERR;
+	
+	mtcp_RxPoll(p, OS_TICK_MS);
+	
+	if (r->rx[0]->len == 0)
+		return SYS_R_ERR;
+	
+	buf_Push(b, r->rx[0]->p, r->rx[0]->len);
+	buf_Release(r->rx[0]);
+	
+	return SYS_R_OK;
 }
 
 sys_res mtcp_TcpConnect(const u8 *pIp, int nPort)
@@ -1507,6 +1865,7 @@ sys_res mtcp_TcpConnect(const u8 *pIp, int nPort)
 	{
 		p->mcon = 1;
 		buf_Release(p->rbuf);
+		mtcp_RxReset(&mtcp_xRx);
 		
 		return SYS_R_OK;
 	}
@@ -1517,7 +1876,8 @@ sys_res mtcp_TcpConnect(const u8 *pIp, int nPort)
 sys_res mtcp_TcpSend(const void *pData, size_t nLen)
 {
 	p_modem p = &gsm_xModem;
-	char str[20];
+	t_mtcp_rx *r = &mtcp_xRx;
+	char str[32];
 	size_t nTmo;
 
 	if (modem_IsOnline() == 0)
@@ -1526,23 +1886,33 @@ sys_res mtcp_TcpSend(const void *pData, size_t nLen)
 	if (p->mcon == 0)
 		return SYS_R_ERR;
 	
+	//Let a running read or write finish, the modem takes commands one at a time
+	r->writing = 1;
+	for (nTmo = MTCP_READ_TMO; (r->reading || r->wres) && nTmo; nTmo--)
+		mtcp_RxPoll(p, OS_TICK_MS);
+	
+	r->prompt = 0;
 	sprintf(str, "AT$MYNETWRITE=0,%d\r\n", nLen);
 	uart_SendStr(p->uart, str);
-	os_thd_sleep(100);
 	
 	for (nTmo = 8000 / OS_TICK_MS; nTmo; nTmo--)
 	{
-		uart_RecTmo(p->uart, p->rbuf, OS_TICK_MS);
-		if (buffstr(p->rbuf, "$MYNETWRITE:") == NULL)
+		mtcp_RxPoll(p, OS_TICK_MS);
+		if (r->prompt == 0)
 			continue;
 		
 		uart_Send(p->uart, pData, nLen);
 #if MODEM_FLOWCTL_ENABLE
 		gsm_xModem.flow_t += nLen;
 #endif
+		r->writing = 0;
+		r->wres = 1;
+		r->tick = os_tick_get();
 		return SYS_R_OK;
 	}
 	
+	r->writing = 0;
+	
 	return SYS_R_TMO;
 }
 
@@ -1552,6 +1922,7 @@ sys_res mtcp_TcpClose()
 	size_t nTmo;
 
 	p->mcon = 0;
+	mtcp_RxReset(&mtcp_xRx);
 	uart_SendStr(p->uart, "AT$MYNETCLOSE=0\r\n");
 	os_thd_sleep(100);
 	
@@ -41,6 +41,41 @@ static void rn8302_SpiGet()
 #endif
 }
 
+static s32 rn8302_Xfer(rn8302_t *p, u16 nReg, size_t nLen)
+{
+	s32 nData = 0;
+
+	spi_Transce(p->spi, &nReg, 2, &nData, nLen);
+	invert(&nData, nLen);
+
+	return nData;
+}
+
+//УĴ,ȡһζ
+static s32 rn8302_RData(rn8302_t *p, size_t nLen)
+{
+	u16 nReg = RN8302_REG_RData;
+	s32 nCrc = 0;
+
+	spi_Transce(p->spi, &nReg, 2, &nCrc, 4);
+	switch (nLen)
+	{
+	case 2:
+		nCrc >>= 16;
+		nCrc &= 0x0000FFFF;
+		break;
+	case 3:
+		nCrc >>= 8;
+		nCrc &= 0x00FFFFFF;
+		break;
+	default:
+		break;
+	}
+	invert(&nCrc, nLen);
+
+	return nCrc;
+}
+
 
 
 
@@ -120,29 +155,11 @@ int rn8302_Read(u16 nReg, void *pData, size_t nLen)
 	rn8302_SpiGet();
 
 	//ݼĴ
-	nData = 0;
-	spi_Transce(p->spi, &nReg, 2, &nData, nLen);
-	invert(&nData, nLen);
+	nData = rn8302_Xfer(p, nReg, nLen);
 
 	//УĴ
 	os_thd_slp1tick();
-	nReg = RN8302_REG_RData;
-	nCrc = 0;
-	spi_Transce(p->spi, &nReg, 2, &nCrc, 4);
-	switch (nLen)
-	{
-	case 2:
-		nCrc >>= 16;
-		nCrc &= 0x0000FFFF;
-		break;
-	case 3:
-		nCrc >>= 8;
-		nCrc &= 0x00FFFFFF;
-		break;
-	default:
-		break;
-	}
-	invert(&nCrc, nLen);
+	nCrc = rn8302_RData(p, nLen);
 
 	spi_Close(p->spi);
 
@@ -493,6 +510,142 @@ u16 rn8302_GetEConst()
 }
 
 
+#if RN8302_SNAP_ENABLE
+//------------------------------------------------------------------------
+//	: rn8302_SnapConfig()
+//	: 
+//	: pReg - Ĵб
+//		  nQty - Ĵ
+//	: -
+//	: SYS_R_OK - ɹ
+//	: ÿռĴб,ѷĿ
+//		  rn8302_Snapshotͬһ̵߳
+//------------------------------------------------------------------------
+sys_res rn8302_SnapConfig(const rn8302_snapreg_t *pReg, int nQty)
+{
+	rn8302_t *p = &rn_x8302;
+	int i;
+
+	if ((nQty <= 0) || (nQty > RN8302_SNAP_MAX))
+		return SYS_R_ERR;
+	for (i = 0; i < nQty; i++)
+	{
+		if ((pReg[i].len < 2) || (pReg[i].len > 4))
+			return SYS_R_ERR;
+	}
+
+	os_thd_lock();
+	memcpy(p->reg, pReg, nQty * sizeof(rn8302_snapreg_t));
+	p->qty = nQty;
+	p->snap[0].seq = 0;
+	p->snap[1].seq = 0;
+	os_thd_unlock();
+
+	return SYS_R_OK;
+}
+
+//------------------------------------------------------------------------
+//	: rn8302_Snapshot()
+//	: 
+//	: -
+//	: -
+//	: SYS_R_OK - ȫĴУͨ
+//		  SYS_R_ERR - мĴضУʧ,ֵΪ0
+//	: ȡĴб
+//		  бֻռһSPI,Ĵ֮䲻,
+//		  УʧܵļĴбͳһضһ
+//------------------------------------------------------------------------
+sys_res rn8302_Snapshot()
+{
+	rn8302_t *p = &rn_x8302;
+	rn8302_snapreg_t *pReg;
+	rn8302_snap_t *pSnap;
+	u8 aErr[RN8302_SNAP_MAX];
+	s32 nData;
+	int i, j, nErr = 0;
+
+	if (p->qty == 0)
+		return SYS_R_ERR;
+
+	//дδĻ,
+	pSnap = &p->snap[p->idx ^ 1];
+	pSnap->seq = 0;
+
+	rn8302_SpiGet();
+	for (i = 0; i < p->qty; i++)
+	{
+		pReg = &p->reg[i];
+		nData = rn8302_Xfer(p, pReg->reg, pReg->len);
+		if (rn8302_RData(p, pReg->len) == nData)
+			pSnap->data[i] = nData;
+		else
+			aErr[nErr++] = i;
+	}
+	if (nErr)
+	{
+		os_thd_slp1tick();
+		for (j = 0, i = 0; i < nErr; i++)
+		{
+			pReg = &p->reg[aErr[i]];
+			nData = rn8302_Xfer(p, pReg->reg, pReg->len);
+			if (rn8302_RData(p, pReg->len) != nData)
+			{
+				RN8302_DBGOUT("<RN8302>SnapReg %04X Err", pReg->reg);
+				nData = 0;
+				j += 1;
+			}
+			pSnap->data[aErr[i]] = nData;
+		}
+		nErr = j;
+	}
+	spi_Close(p->spi);
+
+	pSnap->tick = os_tick_get();
+	pSnap->qty = p->qty;
+	pSnap->err = nErr;
+
+	//
+	p->seq += 1;
+	if (p->seq == 0)
+		p->seq = 1;
+	os_thd_lock();
+	pSnap->seq = p->seq;
+	p->idx ^= 1;
+	os_thd_unlock();
+
+	if (nErr)
+		return SYS_R_ERR;
+	return SYS_R_OK;
+}
+
+//------------------------------------------------------------------------
+//	: rn8302_SnapGet()
+//	: 
+//	: -
+//	: pSnap - ¿
+//	: ,0Ϊ޿
+//	: ȡ¿,SPI
+//		  ڼ仺屻дʱŻ仯,¿
+//------------------------------------------------------------------------
+u32 rn8302_SnapGet(rn8302_snap_t *pSnap)
+{
+	rn8302_t *p = &rn_x8302;
+	rn8302_snap_t *pCur;
+	u32 nSeq;
+
+	do {
+		pCur = &p->snap[p->idx];
+		nSeq = pCur->seq;
+		if (nSeq == 0)
+			return 0;
+		memcpy(pSnap, pCur, sizeof(rn8302_snap_t));
+	} while (pCur->seq != nSeq);
+
+	return nSeq;
+}
+#endif
+
+
 #endif
 
 
@@ -188,10 +188,35 @@ extern "C" {
 #define	RN8302_REG_WData		0x108D
 #define	RN8302_REG_DeviceID		0x108F
 
+//Ĵ
+#ifndef RN8302_SNAP_ENABLE
+#define RN8302_SNAP_ENABLE			0
+#endif
+
+#if RN8302_SNAP_ENABLE
+#ifndef RN8302_SNAP_MAX
+#define RN8302_SNAP_MAX			48
+#endif
+#endif
 
 
 
 //Public Typedefs
+#if RN8302_SNAP_ENABLE
+typedef struct {
+	u16		reg;
+	u8		len;				//2~4ֽ
+}rn8302_snapreg_t;
+
+typedef struct {
+	volatile u32	seq;		//,0ΪЧ
+	u32		tick;				//ɼʱ
+	u16		qty;				//Ĵ
+	u16		err;				//УʧܵļĴ
+	u32		data[RN8302_SNAP_MAX];	//õļĴбһһӦ
+}rn8302_snap_t;
+#endif
+
 typedef struct {
 	u32		crc;
 	u16		ec;
@@ -199,6 +224,13 @@ typedef struct {
 	float	ki;
 	float	kp;
 	spi_t *	spi;
+#if RN8302_SNAP_ENABLE
+	u8		qty;
+	volatile u8	idx;		//ǰĻ
+	u32		seq;
+	rn8302_snapreg_t	reg[RN8302_SNAP_MAX];
+	rn8302_snap_t		snap[2];
+#endif
 }rn8302_t;
 
 typedef struct {
@@ -235,7 +267,13 @@ float rn8302_GetPFV(int nPhase);
 float rn8302_GetPAG(int nPhase, int nType) ;
 u16 rn8302_GetPowerDir(void);
 void rn8302_Cali(rn8302_cali_t *pCali, float fUn, float fIb, int nIs3P3);
-int rn8302_GetEConst(void);
+u16 rn8302_GetEConst(void);
+
+#if RN8302_SNAP_ENABLE
+sys_res rn8302_SnapConfig(const rn8302_snapreg_t *pReg, int nQty);
+sys_res rn8302_Snapshot(void);
+u32 rn8302_SnapGet(rn8302_snap_t *pSnap);
+#endif
 
 #if 0
 
@@ -5,36 +5,145 @@
 
 
 
+#if BKP_TYPE != BKP_T_INT
+//Private Defines
+//дϲΪдʽ,Ҫ´ηʻbkp_FlushдEEPROM,
+//ᶪʧ,Ҫʱд򿪲֤ʱbkp_Flush
+#ifndef BKP_SHADOW_ENABLE
+#define BKP_SHADOW_ENABLE		0
+#endif
+
+#define BKP_PAGE_INVALID		((adr_t)-1)
+
+
+//Private Typedefs
+struct bkp_shadow
+{
+	adr_t	page;
+	u16		start;
+	u16		end;
+	u8		buf[BKP_PAGE_SIZE];
+};
+typedef struct bkp_shadow bkp_shadow_t;
+
+
+//Private Variables
+#if BKP_SHADOW_ENABLE
+static bkp_shadow_t bkp_shadow = {BKP_PAGE_INVALID, 0, 0};
+#endif
+
+
+
+
 //Internal Functions
-static sys_res bkp_EepromWrite(adr_t nAdr, const u8 *pBuf, size_t nLen)
+#if BKP_WAIT_MS
+//-------------------------------------------------------------------------
+//ACK polling: the device does not acknowledge its address while an
+//internal write cycle is in progress, so probe it after each page instead
+//of sleeping a fixed BKP_WAIT_MS. The page is in the array when this
+//returns OK; BKP_WAIT_MS is the upper bound.
+//-------------------------------------------------------------------------
+static sys_res bkp_EepromWait(i2c_t *p)
 {
-	i2c_t *p;
-	adr_t nEnd;
-	size_t nSize;
-	u8 aBuf[BKP_PAGE_SIZE + 2];
+	size_t nTry;
 
-	p = i2c_Open(BKP_COMID, OS_TMO_FOREVER);
-	nEnd = nAdr + nLen;
-	for (; nAdr < nEnd; nAdr += nSize, pBuf += nSize, nLen -= nSize)
+	for (nTry = BKP_WAIT_MS / OS_TICK_MS + 1; nTry; nTry--)
 	{
-		aBuf[0] = nAdr >> 8;
-		aBuf[1] = nAdr;
-		nSize = nLen < BKP_PAGE_SIZE ? nLen : BKP_PAGE_SIZE;
-		memcpy(&aBuf[2], pBuf, nSize);
-		if (i2c_Write(p, BKP_DEVID, aBuf, nSize + 2))
-			break;
-#if BKP_WAIT_MS
-		os_thd_sleep(BKP_WAIT_MS);
+		if (i2c_Write(p, BKP_DEVID, NULL, 0) == SYS_R_OK)
+			return SYS_R_OK;
+		os_thd_slp1tick();
+	}
+	
+	return SYS_R_TMO;
+}
+#else
+#define bkp_EepromWait(p)		SYS_R_OK
 #endif
+
+static sys_res bkp_EepromPage(i2c_t *p, adr_t nAdr, const u8 *pBuf, size_t nLen)
+{
+	u8 aBuf[BKP_PAGE_SIZE + 2];
+
+	aBuf[0] = nAdr >> 8;
+	aBuf[1] = nAdr;
+	memcpy(&aBuf[2], pBuf, nLen);
+	if (i2c_Write(p, BKP_DEVID, aBuf, nLen + 2))
+		return SYS_R_ERR;
+	
+	return bkp_EepromWait(p);
+}
+
+static sys_res bkp_EepromWrite(i2c_t *p, adr_t nAdr, const u8 *pBuf, size_t nLen)
+{
+	size_t nSize;
+
+	//Never let a chunk cross a page boundary, the device would wrap it
+	for (; nLen; nAdr += nSize, pBuf += nSize, nLen -= nSize)
+	{
+		nSize = MIN(BKP_PAGE_SIZE - (nAdr % BKP_PAGE_SIZE), nLen);
+		if (bkp_EepromPage(p, nAdr, pBuf, nSize))
+			return SYS_R_ERR;
 	}
 	
-	i2c_Close(p);
+	return SYS_R_OK;
+}
+
+#if BKP_SHADOW_ENABLE
+static sys_res bkp_ShadowFlush(i2c_t *p)
+{
+	bkp_shadow_t *s = &bkp_shadow;
+	sys_res res;
+
+	if (s->page == BKP_PAGE_INVALID)
+		return SYS_R_OK;
 	
-	if (nAdr < nEnd)
-		return SYS_R_ERR;
+	res = bkp_EepromPage(p, s->page + s->start, &s->buf[s->start], s->end - s->start);
+	s->page = BKP_PAGE_INVALID;
+	
+	return res;
+}
+
+//-------------------------------------------------------------------------
+//Write combining: consecutive bkp_WriteData to adjacent or overlapping
+//bytes of the same page are merged and go out as one page write
+//-------------------------------------------------------------------------
+static sys_res bkp_ShadowWrite(i2c_t *p, adr_t nAdr, const u8 *pBuf, size_t nLen)
+{
+	bkp_shadow_t *s = &bkp_shadow;
+	adr_t nPage;
+	size_t nStart, nEnd;
+
+	nPage = nAdr - (nAdr % BKP_PAGE_SIZE);
+	nStart = nAdr - nPage;
+	nEnd = nStart + nLen;
+	if (nEnd > BKP_PAGE_SIZE)
+	{
+		if (bkp_ShadowFlush(p))
+			return SYS_R_ERR;
+		return bkp_EepromWrite(p, nAdr, pBuf, nLen);
+	}
+	
+	if ((s->page != nPage) || (nStart > s->end) || (nEnd < s->start))
+	{
+		if (bkp_ShadowFlush(p))
+			return SYS_R_ERR;
+		s->page = nPage;
+		s->start = nStart;
+		s->end = nEnd;
+	}
+	else
+	{
+		s->start = MIN(s->start, nStart);
+		s->end = MAX(s->end, nEnd);
+	}
+	memcpy(&s->buf[nStart], pBuf, nLen);
 	
 	return SYS_R_OK;
 }
+#else
+#define bkp_ShadowFlush(p)		SYS_R_OK
+#endif
+#endif
 
 
 
@@ -68,7 +177,18 @@ sys_res bkp_Write(adr_t nAdr, const void *pBuf, size_t nLen)
 #if BKP_TYPE == BKP_T_INT
 	return arch_BkpWrite(nAdr, pBuf, nLen);
 #else
-	return bkp_EepromWrite(nAdr, pBuf, nLen);
+	sys_res res;
+	i2c_t *p;
+
+	p = i2c_Open(BKP_COMID, OS_TMO_FOREVER);
+	
+	res = bkp_ShadowFlush(p);
+	if (res == SYS_R_OK)
+		res = bkp_EepromWrite(p, nAdr, pBuf, nLen);
+	
+	i2c_Close(p);
+	
+	return res;
 #endif
 }
 
@@ -76,23 +196,54 @@ sys_res bkp_Write(adr_t nAdr, const void *pBuf, size_t nLen)
 sys_res bkp_WriteData(adr_t nAdr, const u64 nData, size_t nLen)
 {
 
+#if (BKP_TYPE != BKP_T_INT) && BKP_SHADOW_ENABLE
+	sys_res res;
+	i2c_t *p;
+
+	p = i2c_Open(BKP_COMID, OS_TMO_FOREVER);
+	res = bkp_ShadowWrite(p, nAdr, (const u8 *)&nData, nLen);
+	i2c_Close(p);
+	
+	return res;
+#else
 	return bkp_Write(nAdr, &nData, nLen);
+#endif
 }
 
 void bkp_Fill(adr_t nAdr, adr_t nEnd, int nVal)
 {
 	size_t nLen, nFill;
+#if BKP_TYPE != BKP_T_INT
+	u8 aBuf[BKP_PAGE_SIZE];
+#else
 	u8 aBuf[64];
+#endif
 
 	memset(aBuf, nVal, sizeof(aBuf));
 	nLen = nEnd - nAdr;
 	for (; nLen; nLen -= nFill, nAdr += nFill)
 	{
+#if BKP_TYPE != BKP_T_INT
+		nFill = MIN(sizeof(aBuf) - (nAdr % sizeof(aBuf)), nLen);
+#else
 		nFill = MIN(sizeof(aBuf), nLen);
+#endif
 		bkp_Write(nAdr, aBuf, nFill);
 	}
 }
 
+void bkp_Flush()
+{
+
+#if (BKP_TYPE != BKP_T_INT) && BKP_SHADOW_ENABLE
+	i2c_t *p;
+
+	p = i2c_Open(BKP_COMID, OS_TMO_FOREVER);
+	bkp_ShadowFlush(p);
+	i2c_Close(p);
+#endif
+}
+
 
 //-------------------------------------------------------------------------
 //Function Name  :bkp_Read
@@ -115,8 +266,11 @@ sys_res bkp_Read(adr_t nAdr, void *pBuf, size_t nLen)
 
 	p = i2c_Open(BKP_COMID, OS_TMO_FOREVER);
 	
+	res = bkp_ShadowFlush(p);
+	
 	invert(&nAdr, 2);
-	res = i2c_Write(p, BKP_DEVID, &nAdr, 2);
+	if (res == SYS_R_OK)
+		res = i2c_Write(p, BKP_DEVID, &nAdr, 2);
 	if (res == SYS_R_OK)
 		res = i2c_Read(p, BKP_DEVID, pBuf, nLen);
 	
@@ -22,6 +22,7 @@ void bkp_Init(void);
 sys_res bkp_Write(adr_t nAdr, const void *pBuf, size_t nLen);
 sys_res bkp_WriteData(adr_t nAdr, const u64 nData, size_t nLen);
 void bkp_Fill(adr_t nAdr, adr_t nEnd, int nVal);
+void bkp_Flush(void);
 sys_res bkp_Read(adr_t nAdr, void *pBuf, size_t nLen);
 
 
@@ -12,6 +12,7 @@
  * 2005-02-22     Bernard      The first version.
  */
 
+#include <os/rtt/rthw.h>
 #include <fs/dfs.h>
 #include <fs/dfs_fs.h>
 #include <fs/dfs_file.h>
@@ -30,10 +31,15 @@ char working_directory[DFS_PATH_MAX] = {"/"};
 #endif
 
 #ifdef DFS_USING_STDIO
-struct dfs_fd fd_table[3 + DFS_FD_MAX];
+#define FD_BASE		3
 #else
-struct dfs_fd fd_table[DFS_FD_MAX];
+#define FD_BASE		0
 #endif
+struct dfs_fd fd_table[FD_BASE + DFS_FD_MAX];
+
+/* free descriptors chained by index below FD_BASE, -1 ends the list */
+static int fd_free_head;
+static int fd_free_next[DFS_FD_MAX];
 
 /**
  * @addtogroup DFS
@@ -51,6 +57,10 @@ void dfs_init(void)
 	rt_memset(filesystem_table, 0, sizeof(filesystem_table));
 	/* clean fd table */
 	rt_memset(fd_table, 0, sizeof(fd_table));
+	for (fd_free_head = 0; fd_free_head < DFS_FD_MAX - 1; fd_free_head++)
+		fd_free_next[fd_free_head] = fd_free_head + 1;
+	fd_free_next[DFS_FD_MAX - 1] = -1;
+	fd_free_head = 0;
 
 	/* create device filesystem lock */
 	rt_mutex_init(&fslock, "fslock", RT_IPC_FLAG_FIFO);
@@ -96,35 +106,20 @@ void dfs_unlock(void)
  */
 int fd_new(void)
 {
-	struct dfs_fd *d;
+	rt_base_t level;
 	int idx;
 
-	/* lock filesystem */
-	dfs_lock();
-
-	/* find an empty fd entry */
-#ifdef DFS_USING_STDIO
-	for (idx = 3; idx < DFS_FD_MAX + 3 && fd_table[idx].ref_count > 0; idx++);
-#else
-	for (idx = 0; idx < DFS_FD_MAX && fd_table[idx].ref_count > 0; idx++);
-#endif
-
-	/* can't find an empty fd entry */
-#ifdef DFS_USING_STDIO
-	if (idx == DFS_FD_MAX + 3)
-#else
-	if (idx == DFS_FD_MAX)
-#endif
+	/* take the head of the free list */
+	level = rt_hw_interrupt_disable();
+	idx = fd_free_head;
+	if (idx >= 0)
 	{
-		idx = -1;
-		goto __result;
+		fd_free_head = fd_free_next[idx];
+		idx += FD_BASE;
+		fd_table[idx].ref_count = 1;
 	}
+	rt_hw_interrupt_enable(level);
 
-	d = &(fd_table[idx]);
-	d->ref_count = 1;
-
-__result:
-	dfs_unlock();
 	return idx;
 }
 
@@ -140,21 +135,20 @@ __result:
 struct dfs_fd *fd_get(int fd)
 {
 	struct dfs_fd *d;
+	rt_base_t level;
 
-#ifdef DFS_USING_STDIO
-	if (fd < 3 || fd > DFS_FD_MAX + 3) 
-		return RT_NULL;
-#else
-	if (fd < 0 || fd > DFS_FD_MAX) 
+	if (fd < FD_BASE || fd >= FD_BASE + DFS_FD_MAX) 
 		return RT_NULL;
-#endif
 
-	dfs_lock();
 	d = &fd_table[fd];
 
-	/* increase the reference count */
-	d->ref_count ++;
-	dfs_unlock();
+	/* increase the reference count, a free entry is not handed out */
+	level = rt_hw_interrupt_disable();
+	if (d->ref_count > 0)
+		d->ref_count ++;
+	else
+		d = RT_NULL;
+	rt_hw_interrupt_enable(level);
 
 	return d;
 }
@@ -166,15 +160,25 @@ struct dfs_fd *fd_get(int fd)
  */
 void fd_put(struct dfs_fd *fd)
 {
-	dfs_lock();
-	fd->ref_count --;
+	rt_base_t level;
+	int idx, ref_count;
 
-	/* clear this fd entry */
-	if (fd->ref_count == 0)
+	level = rt_hw_interrupt_disable();
+	ref_count = -- fd->ref_count;
+	rt_hw_interrupt_enable(level);
+	RT_ASSERT(ref_count >= 0);
+
+	/* clear this fd entry and give it back to the free list */
+	if (ref_count == 0)
 	{
 		rt_memset(fd, 0, sizeof(struct dfs_fd));
+
+		idx = fd - &fd_table[FD_BASE];
+		level = rt_hw_interrupt_disable();
+		fd_free_next[idx] = fd_free_head;
+		fd_free_head = idx;
+		rt_hw_interrupt_enable(level);
 	}
-	dfs_unlock();
 };
 
 /** 
@@ -212,7 +216,7 @@ int fd_is_open(const char *pathname)
 			mountpath = fullpath + strlen(fs->path);
 
 		dfs_lock();
-		for (index = 0; index < DFS_FD_MAX; index++)
+		for (index = FD_BASE; index < FD_BASE + DFS_FD_MAX; index++)
 		{
 			fd = &(fd_table[index]);
 			if (fd->fs == RT_NULL) 
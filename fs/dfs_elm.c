@@ -17,6 +17,7 @@
 #include <os/rtt/rtthread.h>
 #include <fs/elmfat/ffconf.h>
 #include <fs/elmfat/ff.h>
+#include <fs/elmfat/diskio.h>
 
 /* ELM FatFs provide a DIR struct */
 #define HAVE_DIR_STRUCTURE
@@ -26,6 +27,41 @@
 
 static rt_device_t disk[_VOLUMES] = {0};
 
+#if _USE_FASTSEEK
+/* items of the cluster link map kept inside each open file, enough for
+ * (RT_DFS_ELM_CLMT_SIZE - 2) / 2 fragments */
+#ifndef RT_DFS_ELM_CLMT_SIZE
+#define RT_DFS_ELM_CLMT_SIZE	32
+#endif
+/* largest map allocated from heap for a fragmented file */
+#ifndef RT_DFS_ELM_CLMT_MAX
+#define RT_DFS_ELM_CLMT_MAX		512
+#endif
+
+#define ELM_CLMT_NONE		0	/* no map, build one on the next seek */
+#define ELM_CLMT_VALID		1	/* fd->cltbl is in use */
+#define ELM_CLMT_OFF		2	/* too fragmented, until the file grows */
+
+#if _MAX_SS != 512
+#define ELM_SS(fs)			((fs)->ssize)
+#else
+#define ELM_SS(fs)			512U
+#endif
+
+/* largest sector count handed to the disk driver in one direct transfer */
+#define ELM_DIRECT_MAX		128
+#endif
+
+/* open file, FIL must be the first member as file->data is used as FIL * */
+struct elm_file
+{
+	FIL fil;
+#if _USE_FASTSEEK
+	rt_uint8_t clmt_state;
+	DWORD clmt[RT_DFS_ELM_CLMT_SIZE];
+#endif
+};
+
 static int elm_result_to_dfs(FRESULT result)
 {
 	int status = DFS_STATUS_OK;
@@ -204,6 +240,132 @@ int dfs_elm_statfs(struct dfs_filesystem *fs, struct statfs *buf)
 	return 0;
 }
 
+#if _USE_FASTSEEK
+static void elm_clmt_drop(struct elm_file *ef, rt_uint8_t state)
+{
+	if (ef->fil.cltbl != RT_NULL && ef->fil.cltbl != ef->clmt)
+		rt_free(ef->fil.cltbl);
+	ef->fil.cltbl = RT_NULL;
+	ef->clmt_state = state;
+}
+
+/* returns the cluster link map of the file, walking the FAT chain once to
+ * build it when there is none yet */
+static DWORD *elm_clmt_get(struct elm_file *ef)
+{
+	FIL *fd = &ef->fil;
+	DWORD *tbl;
+	FRESULT result;
+
+	if (ef->clmt_state != ELM_CLMT_NONE || fd->sclust == 0)
+		return fd->cltbl;
+
+	fd->cltbl = ef->clmt;
+	ef->clmt[0] = RT_DFS_ELM_CLMT_SIZE;
+	result = f_lseek(fd, CREATE_LINKMAP);
+	if (result == FR_NOT_ENOUGH_CORE && ef->clmt[0] <= RT_DFS_ELM_CLMT_MAX)
+	{
+		/* the required size has been returned in the first item */
+		tbl = (DWORD *)rt_malloc(ef->clmt[0] * sizeof(DWORD));
+		if (tbl != RT_NULL)
+		{
+			tbl[0] = ef->clmt[0];
+			fd->cltbl = tbl;
+			result = f_lseek(fd, CREATE_LINKMAP);
+		}
+	}
+
+	if (result != FR_OK)
+		elm_clmt_drop(ef, ELM_CLMT_OFF);
+	else
+		ef->clmt_state = ELM_CLMT_VALID;
+
+	return fd->cltbl;
+}
+
+/* number of sectors contiguous on the disk from the file pointer on, the
+ * first one is returned in sect */
+static DWORD elm_clmt_run(FIL *fd, DWORD *sect)
+{
+	FATFS *fs = fd->fs;
+	DWORD cl, ncl, csect, *tbl;
+
+	csect = fd->fptr / ELM_SS(fs);
+	cl = csect / fs->csize;
+	csect &= fs->csize - 1;
+	for (tbl = fd->cltbl + 1; ; tbl += 2)
+	{
+		ncl = tbl[0];
+		if (ncl == 0)
+			return 0;
+		if (cl < ncl)
+			break;
+		cl -= ncl;
+	}
+
+	*sect = fs->database + (tbl[1] + cl - 2) * fs->csize + csect;
+	return (ncl - cl) * fs->csize - csect;
+}
+
+/* moves whole sectors between buf and the disk without the sector buffer of
+ * FatFs, a run of contiguous clusters goes in one driver call. Returns the
+ * bytes transferred or a negative dfs status. */
+static int elm_direct(FIL *fd, BYTE *buf, rt_size_t len, int write)
+{
+	FATFS *fs = fd->fs;
+	DWORD sect, cc;
+	DRESULT res;
+	int total = 0;
+
+	if (len > fd->fsize - fd->fptr)
+		len = fd->fsize - fd->fptr;
+
+	while (len >= ELM_SS(fs))
+	{
+		cc = elm_clmt_run(fd, &sect);
+		if (cc == 0)
+			break;
+		if (cc > len / ELM_SS(fs))
+			cc = len / ELM_SS(fs);
+		if (cc > ELM_DIRECT_MAX)
+			cc = ELM_DIRECT_MAX;
+
+		if (write)
+		{
+			res = disk_write(fs->drv, buf, sect, (BYTE)cc);
+			/* the sector buffer is overwritten by the new data */
+			if (fd->dsect - sect < cc)
+			{
+				rt_memcpy(fd->buf, buf + (fd->dsect - sect) * ELM_SS(fs), ELM_SS(fs));
+				fd->flag &= ~FA__DIRTY;
+			}
+			fd->flag |= FA__WRITTEN;
+		}
+		else
+		{
+			res = disk_read(fs->drv, buf, sect, (BYTE)cc);
+			/* a dirty sector buffer is newer than the disk */
+			if ((fd->flag & FA__DIRTY) && fd->dsect - sect < cc)
+				rt_memcpy(buf + (fd->dsect - sect) * ELM_SS(fs), fd->buf, ELM_SS(fs));
+		}
+		if (res != RES_OK)
+		{
+			fd->flag |= FA__ERROR;
+			return -DFS_STATUS_EIO;
+		}
+
+		/* FatFs expects the cluster holding the last byte transferred */
+		fd->clust = (sect + cc - 1 - fs->database) / fs->csize + 2;
+		fd->fptr += cc * ELM_SS(fs);
+		buf += cc * ELM_SS(fs);
+		len -= cc * ELM_SS(fs);
+		total += cc * ELM_SS(fs);
+	}
+
+	return total;
+}
+#endif
+
 int dfs_elm_open(struct dfs_fd *file)
 {
 	FIL *fd;
@@ -286,11 +448,14 @@ int dfs_elm_open(struct dfs_fd *file)
 			mode |= FA_CREATE_NEW;
 
 		/* allocate a fd */
-		fd = (FIL *)rt_malloc(sizeof(FIL));
+		fd = (FIL *)rt_malloc(sizeof(struct elm_file));
 		if (fd == RT_NULL)
 		{
 			return -DFS_STATUS_ENOMEM;
 		}
+#if _USE_FASTSEEK
+		((struct elm_file *)fd)->clmt_state = ELM_CLMT_NONE;
+#endif
 
 		result = f_open(fd, drivers_fn, mode);
 #if _VOLUMES > 1
@@ -340,11 +505,12 @@ int dfs_elm_close(struct dfs_fd *file)
 		RT_ASSERT(fd != RT_NULL);
 
 		result = f_close(fd);
-		if (result == FR_OK)
-		{
-			/* release memory */
-			rt_free(fd);
-		}
+
+		/* release memory, the dfs fd goes away even if close failed */
+#if _USE_FASTSEEK
+		elm_clmt_drop((struct elm_file *)fd, ELM_CLMT_NONE);
+#endif
+		rt_free(fd);
 	}
 
 	return elm_result_to_dfs(result);
@@ -360,6 +526,7 @@ int dfs_elm_read(struct dfs_fd *file, void *buf, rt_size_t len)
 	FIL *fd;
 	FRESULT result;
 	UINT byte_read;
+	int direct = 0;
 
 	if (file->type == FT_DIRECTORY)
 	{
@@ -369,11 +536,28 @@ int dfs_elm_read(struct dfs_fd *file, void *buf, rt_size_t len)
 	fd = (FIL *)(file->data);
 	RT_ASSERT(fd != RT_NULL);
 
+#if _USE_FASTSEEK
+	/* whole sectors go straight to the driver */
+	if ((fd->fptr % ELM_SS(fd->fs)) == 0 && len >= ELM_SS(fd->fs) &&
+		!(fd->flag & FA__ERROR) &&
+		elm_clmt_get((struct elm_file *)fd) != RT_NULL)
+	{
+		direct = elm_direct(fd, buf, len, 0);
+		if (direct < 0)
+		{
+			file->pos = fd->fptr;
+			return direct;
+		}
+		buf = (BYTE *)buf + direct;
+		len -= direct;
+	}
+#endif
+
 	result = f_read(fd, buf, len, &byte_read);
 	/* update position */
 	file->pos  = fd->fptr;
 	if (result == FR_OK)
-		return byte_read;
+		return byte_read + direct;
 
 	return elm_result_to_dfs(result);
 }
@@ -383,6 +567,7 @@ int dfs_elm_write(struct dfs_fd *file, const void *buf, rt_size_t len)
 	FIL *fd;
 	FRESULT result;
 	UINT byte_write;
+	int direct = 0;
 
 	if (file->type == FT_DIRECTORY)
 	{
@@ -392,12 +577,35 @@ int dfs_elm_write(struct dfs_fd *file, const void *buf, rt_size_t len)
 	fd = (FIL *)(file->data);
 	RT_ASSERT(fd != RT_NULL);
 
+#if _USE_FASTSEEK
+	if (fd->fptr + len > fd->fsize)
+	{
+		/* the map does not follow the cluster chain as it grows */
+		if (fd->cltbl != RT_NULL)
+			elm_clmt_drop((struct elm_file *)fd, ELM_CLMT_NONE);
+	}
+	else if ((fd->fptr % ELM_SS(fd->fs)) == 0 && len >= ELM_SS(fd->fs) &&
+		(fd->flag & FA_WRITE) && !(fd->flag & FA__ERROR) &&
+		elm_clmt_get((struct elm_file *)fd) != RT_NULL)
+	{
+		/* overwriting whole sectors goes straight to the driver */
+		direct = elm_direct(fd, (BYTE *)buf, len, 1);
+		if (direct < 0)
+		{
+			file->pos = fd->fptr;
+			return direct;
+		}
+		buf = (const BYTE *)buf + direct;
+		len -= direct;
+	}
+#endif
+
 	result = f_write(fd, buf, len, &byte_write);
 	/* update position and file size */
 	file->pos  = fd->fptr;
 	file->size = fd->fsize;
 	if (result == FR_OK)
-		return byte_write;
+		return byte_write + direct;
 
 	return elm_result_to_dfs(result);
 }
@@ -424,7 +632,18 @@ int dfs_elm_lseek(struct dfs_fd *file, rt_off_t offset)
 		/* regular file type */
 		fd = (FIL *)(file->data);
 		RT_ASSERT(fd != RT_NULL);
-		
+
+#if _USE_FASTSEEK
+		/* the fast seek clips at the end of file, a writer extends it */
+		if (offset > fd->fsize && (fd->flag & FA_WRITE))
+		{
+			if (fd->cltbl != RT_NULL)
+				elm_clmt_drop((struct elm_file *)fd, ELM_CLMT_NONE);
+		}
+		else
+			elm_clmt_get((struct elm_file *)fd);
+#endif
+
 		result = f_lseek(fd, offset);
 		if (result == FR_OK)
 		{
@@ -677,7 +896,6 @@ int elm_init(void)
 /*
  * RT-Thread Device Interface for ELM FatFs
  */
-#include <fs/elmfat/diskio.h>
 
 /* Initialize a Drive */
 DSTATUS disk_initialize(BYTE drv)
@@ -758,6 +976,12 @@ DRESULT disk_ioctl(BYTE drv, BYTE ctrl, void *buff)
 
 		*(DWORD *)buff = geometry.block_size/geometry.bytes_per_sector;
 	}
+	else if (ctrl == CTRL_SYNC)
+	{
+		/* write back what the device driver has cached */
+		if (rt_device_control(device, RT_DEVICE_CTRL_BLK_SYNC, RT_NULL) != RT_EOK)
+			return RES_ERROR;
+	}
 
 	return RES_OK;
 }
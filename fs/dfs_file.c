@@ -21,6 +21,16 @@
  */
 /*@{*/
 
+/* clear fd, its reference count is kept by the descriptor table */
+static void dfs_file_clear(struct dfs_fd *fd)
+{
+	int ref_count;
+
+	ref_count = fd->ref_count;
+	rt_memset(fd, 0, sizeof(struct dfs_fd));
+	fd->ref_count = ref_count;
+}
+
 /**
  * this function will open a file which specified by path with specified flags.
  *
@@ -85,16 +95,19 @@ int dfs_file_open(struct dfs_fd *fd, const char *path, int flags)
 	{
 		/* clear fd */
 		rt_free(fd->path);
-		rt_memset(fd, 0, sizeof(*fd));
+		dfs_file_clear(fd);
 
 		return -DFS_STATUS_ENOSYS;
 	}
 
-	if ((result = fs->ops->open(fd)) < 0)
+	dfs_fs_lock(fs);
+	result = fs->ops->open(fd);
+	dfs_fs_unlock(fs);
+	if (result < 0)
 	{
 		/* clear fd */
 		rt_free(fd->path);
-		rt_memset(fd, 0, sizeof(*fd));
+		dfs_file_clear(fd);
 
 		dfs_log(DFS_DEBUG_INFO, ("open failed"));
 
@@ -123,15 +136,20 @@ int dfs_file_close(struct dfs_fd *fd)
 {
 	int result = 0;
 
-	if (fd != RT_NULL && fd->fs->ops->close != RT_NULL) 
-		result = fd->fs->ops->close(fd);
+	if (fd == RT_NULL)
+		return -DFS_STATUS_EINVAL;
 
-	/* close fd error, return */
-	if (result < 0) 
-		return result;
+	if (fd->fs->ops->close != RT_NULL) 
+	{
+		dfs_fs_lock(fd->fs);
+		result = fd->fs->ops->close(fd);
+		dfs_fs_unlock(fd->fs);
+	}
 
+	/* the file system has released the file even when close reports an
+	 * error, so the fd is released as well */
 	rt_free(fd->path);
-	rt_memset(fd, 0, sizeof(struct dfs_fd));
+	dfs_file_clear(fd);
 
 	return result;
 }
@@ -148,13 +166,19 @@ int dfs_file_close(struct dfs_fd *fd)
 int dfs_file_ioctl(struct dfs_fd *fd, int cmd, void *args)
 {
 	struct dfs_filesystem *fs;
+	int result;
 
 	if (fd == RT_NULL || fd->type != FT_REGULAR)
 		return -DFS_STATUS_EINVAL;
 
 	fs = fd->fs;
 	if (fs->ops->ioctl != RT_NULL) 
-		return fs->ops->ioctl(fd, cmd, args);
+	{
+		dfs_fs_lock(fs);
+		result = fs->ops->ioctl(fd, cmd, args);
+		dfs_fs_unlock(fs);
+		return result;
+	}
 
 	return -DFS_STATUS_ENOSYS;
 }
@@ -180,7 +204,10 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, rt_size_t len)
 	if (fs->ops->read == RT_NULL) 
 		return -DFS_STATUS_ENOSYS;
 
-	if ((result = fs->ops->read(fd, buf, len)) < 0)
+	dfs_fs_lock(fs);
+	result = fs->ops->read(fd, buf, len);
+	dfs_fs_unlock(fs);
+	if (result < 0)
 		fd->flags |= DFS_F_EOF;
 
 	return result;
@@ -198,6 +225,7 @@ int dfs_file_read(struct dfs_fd *fd, void *buf, rt_size_t len)
 int dfs_file_getdents(struct dfs_fd *fd, struct dirent *dirp, rt_size_t nbytes)
 {
 	struct dfs_filesystem *fs;
+	int result;
 
 	/* parameter check */
 	if (fd == RT_NULL || fd->type != FT_DIRECTORY) 
@@ -205,7 +233,12 @@ int dfs_file_getdents(struct dfs_fd *fd, struct dirent *dirp, rt_size_t nbytes)
 
 	fs = (struct dfs_filesystem *)fd->fs;
 	if (fs->ops->getdents != RT_NULL)
-		return fs->ops->getdents(fd, dirp, nbytes);
+	{
+		dfs_fs_lock(fs);
+		result = fs->ops->getdents(fd, dirp, nbytes);
+		dfs_fs_unlock(fs);
+		return result;
+	}
 
 	return -DFS_STATUS_ENOSYS;
 }
@@ -248,6 +281,7 @@ int dfs_file_unlink(const char *path)
 
 	if (fs->ops->unlink != RT_NULL)
 	{
+		dfs_fs_lock(fs);
 		if (!(fs->ops->flags & DFS_FS_FLAG_FULLPATH))
 		{
 			if (dfs_subdir(fs->path, fullpath) == RT_NULL)
@@ -257,6 +291,7 @@ int dfs_file_unlink(const char *path)
 		}
 		else
 			result = fs->ops->unlink(fs, fullpath);				
+		dfs_fs_unlock(fs);
 	}
 	else result = -DFS_STATUS_ENOSYS;
 
@@ -277,6 +312,7 @@ __exit:
 int dfs_file_write(struct dfs_fd *fd, const void *buf, rt_size_t len)
 {
 	struct dfs_filesystem *fs;
+	int result;
 
 	if (fd == RT_NULL)
 		return -DFS_STATUS_EINVAL;
@@ -285,7 +321,11 @@ int dfs_file_write(struct dfs_fd *fd, const void *buf, rt_size_t len)
 	if (fs->ops->write == RT_NULL)
 		return -DFS_STATUS_ENOSYS;
 
-	return fs->ops->write(fd, buf, len);
+	dfs_fs_lock(fs);
+	result = fs->ops->write(fd, buf, len);
+	dfs_fs_unlock(fs);
+
+	return result;
 }
 
 /**
@@ -298,6 +338,7 @@ int dfs_file_write(struct dfs_fd *fd, const void *buf, rt_size_t len)
 int dfs_file_flush(struct dfs_fd *fd)
 {
 	struct dfs_filesystem *fs;
+	int result;
 
 	if (fd == RT_NULL)
 		return -DFS_STATUS_EINVAL;
@@ -306,7 +347,11 @@ int dfs_file_flush(struct dfs_fd *fd)
 	if (fs->ops->flush == RT_NULL)
 		return -DFS_STATUS_ENOSYS;
 
-	return fs->ops->flush(fd);
+	dfs_fs_lock(fs);
+	result = fs->ops->flush(fd);
+	dfs_fs_unlock(fs);
+
+	return result;
 }
 
 /**
@@ -320,14 +365,17 @@ int dfs_file_flush(struct dfs_fd *fd)
 int dfs_file_lseek(struct dfs_fd *fd, rt_off_t offset)
 {
 	int result;
-	struct dfs_filesystem *fs = fd->fs;
+	struct dfs_filesystem *fs;
 
 	if (fd == RT_NULL)
 		return -DFS_STATUS_EINVAL;
+	fs = fd->fs;
 	if (fs->ops->lseek == RT_NULL)
 		return -DFS_STATUS_ENOSYS;
 
+	dfs_fs_lock(fs);
 	result = fs->ops->lseek(fd, offset);
+	dfs_fs_unlock(fs);
 
 	/* update current position */
 	if (result >= 0)
@@ -392,10 +440,12 @@ int dfs_file_stat(const char *path, struct stat *buf)
 		}
 
 		/* get the real file path and get file stat */
+		dfs_fs_lock(fs);
 		if (fs->ops->flags & DFS_FS_FLAG_FULLPATH)
 			result = fs->ops->stat(fs, fullpath, buf);	 
 		else
 			result = fs->ops->stat(fs, dfs_subdir(fs->path, fullpath), buf);
+		dfs_fs_unlock(fs);
 			
 	}
 
@@ -447,12 +497,14 @@ int dfs_file_rename(const char *oldpath, const char *newpath)
 		}
 		else
 		{
+			dfs_fs_lock(oldfs);
 			if (oldfs->ops->flags & DFS_FS_FLAG_FULLPATH)
 				result = oldfs->ops->rename(oldfs, oldfullpath, newfullpath);
 			else
 				/* use sub directory to rename in file system */
 				result = oldfs->ops->rename(oldfs, dfs_subdir(oldfs->path, oldfullpath),
 					dfs_subdir(newfs->path, newfullpath));
+			dfs_fs_unlock(oldfs);
 		}
 	}
 	else
@@ -291,6 +291,7 @@ int dfs_mount(const char *device_name, const char *path,
 	fs->path = fullpath;
 	fs->ops = ops;
 	fs->dev_id = dev_id;
+	rt_mutex_init(&fs->lock, "fs", RT_IPC_FLAG_FIFO);
 	/* release filesystem_table lock */
 	dfs_unlock();
 
@@ -304,6 +305,7 @@ int dfs_mount(const char *device_name, const char *path,
 			rt_device_close(dev_id);
 		dfs_lock();
 		/* clear filesystem table entry */
+		rt_mutex_detach(&fs->lock);
 		rt_memset(fs, 0, sizeof(struct dfs_filesystem));
 		dfs_unlock();
 
@@ -321,6 +323,7 @@ int dfs_mount(const char *device_name, const char *path,
 		/* mount failed */
 		dfs_lock();
 		/* clear filesystem table entry */
+		rt_mutex_detach(&fs->lock);
 		rt_memset(fs, 0, sizeof(struct dfs_filesystem));
 		dfs_unlock();
 
@@ -361,16 +364,23 @@ int dfs_unmount(const char *specialfile)
 	dfs_lock();
 
 	fs = dfs_filesystem_lookup(fullpath);
-	if (fs != RT_NULL && fs->ops->unmount != RT_NULL && fs->ops->unmount(fs) < 0)
+	if (fs == RT_NULL)
+		goto err1;
+
+	dfs_fs_lock(fs);
+	if (fs->ops->unmount != RT_NULL && fs->ops->unmount(fs) < 0)
 	{
+		dfs_fs_unlock(fs);
 		goto err1;
 	}
+	dfs_fs_unlock(fs);
 
 	/* close device, but do not check the status of device */
 	if (fs->dev_id != RT_NULL)
 		rt_device_close(fs->dev_id);
 
 	/* clear this filesystem table entry */
+	rt_mutex_detach(&fs->lock);
 	rt_memset(fs, 0, sizeof(struct dfs_filesystem));
 
 	dfs_unlock();
@@ -431,17 +441,52 @@ int dfs_mkfs(const char *fs_name, const char *device_name)
 int dfs_statfs(const char *path, struct statfs *buffer)
 {
 	struct dfs_filesystem *fs;
+	int result;
 
 	fs = dfs_filesystem_lookup(path);
 	if (fs != NULL)
 	{
 		if (fs->ops->statfs!= RT_NULL)
-			return fs->ops->statfs(fs, buffer);
+		{
+			dfs_fs_lock(fs);
+			result = fs->ops->statfs(fs, buffer);
+			dfs_fs_unlock(fs);
+			return result;
+		}
 	}
 
 	return -1;
 }
 
+/**
+ * this function will lock a mounted file system, the operations of one file
+ * system are serialized while different file systems run in parallel.
+ *
+ * @param fs the mounted file system.
+ *
+ * @note please don't invoke it on ISR.
+ */
+void dfs_fs_lock(struct dfs_filesystem *fs)
+{
+	rt_err_t result;
+
+	result = rt_mutex_take(&fs->lock, RT_WAITING_FOREVER);
+	if (result != RT_EOK)
+	{
+		RT_ASSERT(0);
+	}
+}
+
+/**
+ * this function will unlock a mounted file system.
+ *
+ * @param fs the mounted file system.
+ */
+void dfs_fs_unlock(struct dfs_filesystem *fs)
+{
+	rt_mutex_release(&fs->lock);
+}
+
 #ifdef RT_USING_FINSH
 #include <finsh.h>
 void mkfs(const char *fs_name, const char *device_name)
@@ -61,6 +61,8 @@ struct dfs_filesystem
 	const struct dfs_filesystem_operation *ops;	/* Operations for file system type */
 
 	void *data;				/* Specific file system data */
+
+	struct rt_mutex lock;	/* Serializes the operations on this file system */
 };
 
 /* file system partition table */
@@ -89,6 +91,8 @@ extern char working_directory[];
 
 void dfs_lock(void);
 void dfs_unlock(void);
+void dfs_fs_lock(struct dfs_filesystem *fs);
+void dfs_fs_unlock(struct dfs_filesystem *fs);
 int dfs_statfs(const char *path, struct statfs *buffer);
 
 #endif
@@ -10,6 +10,41 @@
 
 #define NAME_MAX	64
 
+/* path -> handle/attribute cache, 0 to disable */
+#ifndef NFS_CACHE_SIZE
+#define NFS_CACHE_SIZE		8
+#endif
+#ifndef NFS_CACHE_TTL
+#define NFS_CACHE_TTL		(3 * RT_TICK_PER_SECOND)
+#endif
+
+/* read-ahead pages per file for sequential reads, 0 to disable */
+#ifndef NFS_RA_PAGES
+#define NFS_RA_PAGES		2
+#endif
+/* READ/WRITE transfer unit, must fit in UDPMSGSIZE */
+#ifndef NFS_PAGE_SIZE
+#define NFS_PAGE_SIZE		4096
+#endif
+/* UNSTABLE writes in flight per file before COMMIT, 0 for FILE_SYNC */
+#ifndef NFS_WB_DEPTH
+#define NFS_WB_DEPTH		2
+#endif
+
+#define NFS_PAGE_EMPTY		0
+#define NFS_PAGE_PENDING	1
+#define NFS_PAGE_VALID		2
+
+struct nfs_page
+{
+	size_t offset;		/* file offset of the first byte */
+	size_t len;			/* valid bytes */
+	uint32_t xid;		/* outstanding READ */
+	rt_uint8_t state;
+	bool_t eof;
+	char *buf;
+};
+
 struct nfs_file
 {
 	nfs_fh3 handle;		/* handle */
@@ -17,6 +52,21 @@ struct nfs_file
 
 	size_t size;		/* total size */
 	bool_t eof;			/* end of file */
+
+#if NFS_RA_PAGES
+	struct nfs_page page[NFS_RA_PAGES];
+	size_t ra_next;		/* offset a sequential read continues at */
+#endif
+#if NFS_WB_DEPTH
+	uint32_t wb_xid[NFS_WB_DEPTH];	/* outstanding WRITEs, oldest at wb_head */
+	count3 wb_count[NFS_WB_DEPTH];
+	int wb_head;
+	int wb_n;
+	bool_t dirty;		/* UNSTABLE data not yet committed */
+	bool_t verf_valid;
+	writeverf3 verf;	/* server instance the data was written to */
+	int error;			/* deferred write error */
+#endif
 };
 
 struct nfs_dir
@@ -29,6 +79,16 @@ struct nfs_dir
 	READDIR3res res;
 };
 
+struct nfs_cache
+{
+	char path[NAME_MAX];	/* empty when unused */
+	nfs_fh3 handle;
+	fattr3 attr;
+	bool_t attr_valid;
+	rt_tick_t tick;			/* last revalidation */
+	rt_uint32_t lru;
+};
+
 #define HOST_LENGTH			32
 #define EXPORT_PATH_LENGTH	32
 struct nfs_filesystem
@@ -40,6 +100,11 @@ struct nfs_filesystem
 
 	char host[HOST_LENGTH];
 	char export[EXPORT_PATH_LENGTH];
+
+#if NFS_CACHE_SIZE
+	struct nfs_cache cache[NFS_CACHE_SIZE];
+	rt_uint32_t cache_lru;
+#endif
 };
 typedef struct nfs_file nfs_file;
 typedef struct nfs_dir nfs_dir;
@@ -99,171 +164,244 @@ static void copy_handle(nfs_fh3 *dest, const nfs_fh3 *source)
 	memcpy(dest->data.data_val, source->data.data_val, dest->data.data_len);
 }
 
-static nfs_fh3 *get_handle(struct nfs_filesystem* nfs, const char *name)
+#if NFS_CACHE_SIZE
+static void nfs_cache_free(struct nfs_cache *c)
 {
-	nfs_fh3 *handle=RT_NULL;
-	char *file;
-	char *path;
-	char *init;
-
-	init = path = rt_malloc(strlen(name)+1);
-	if(init==RT_NULL)
-		return RT_NULL;
-
-	memcpy(init, name, strlen(name)+1);
-
-	handle = rt_malloc(sizeof(nfs_fh3));
-	if(handle==RT_NULL)
+	if (c->path[0] != '\0')
 	{
-		rt_free(init);
-		return RT_NULL;
+		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&c->handle);
+		c->path[0] = '\0';
 	}
+	c->attr_valid = FALSE;
+}
 
-	if(path[0]=='/')
-	{
-		path++;
-		copy_handle(handle, &nfs->root_handle);
-	}
-	else
-	{
-		copy_handle(handle, &nfs->current_handle);
-	}
+/* entry of the first len bytes of path, expired entries are dropped */
+static struct nfs_cache *nfs_cache_find(struct nfs_filesystem* nfs, const char *path, size_t len)
+{
+	struct nfs_cache *c;
+	int index;
+
+	if (len >= NAME_MAX) return RT_NULL;
 
-	while((file=strtok_r(RT_NULL, "/", &path))!=RT_NULL)
+	for (index = 0; index < NFS_CACHE_SIZE; index ++)
 	{
-		LOOKUP3args args;
-		LOOKUP3res res;
-		memset(&res, 0, sizeof(res));
-		copy_handle(&args.what.dir, handle);
-		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-		args.what.name=file;
+		c = &nfs->cache[index];
+		if (c->path[0] == '\0' || c->path[len] != '\0' || strncmp(c->path, path, len) != 0)
+			continue;
 
-		if(nfsproc3_lookup_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS)
+		if (rt_tick_get() - c->tick >= NFS_CACHE_TTL)
 		{
-			rt_kprintf("Lookup failed\n");
-			rt_free(init);
-			rt_free(handle);
-			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
+			nfs_cache_free(c);
 			return RT_NULL;
 		}
-		else if(res.status!=NFS3_OK)
+
+		c->lru = ++nfs->cache_lru;
+		return c;
+	}
+
+	return RT_NULL;
+}
+
+static void nfs_cache_add(struct nfs_filesystem* nfs, const char *path, size_t len,
+	const nfs_fh3 *handle, const post_op_attr *attr)
+{
+	struct nfs_cache *c, *victim;
+	int index;
+
+	if (len >= NAME_MAX) return;
+
+	/* free slot, or the least recently used one */
+	victim = &nfs->cache[0];
+	for (index = 0; index < NFS_CACHE_SIZE; index ++)
+	{
+		c = &nfs->cache[index];
+		if (c->path[0] == '\0')
 		{
-			rt_kprintf("Lookup failed: %d\n", res.status);
-			rt_free(init);
-			rt_free(handle);
-			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-			xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
-			return RT_NULL;
+			victim = c;
+			break;
 		}
-		copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
-		xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
+		if (c->lru < victim->lru) victim = c;
 	}
+	nfs_cache_free(victim);
 
-	rt_free(init);
-	return handle;
+	copy_handle(&victim->handle, handle);
+	if (victim->handle.data.data_val == RT_NULL) return;
+
+	memcpy(victim->path, path, len);
+	victim->path[len] = '\0';
+	if (attr != RT_NULL && attr->attributes_follow)
+	{
+		victim->attr = attr->post_op_attr_u.attributes;
+		victim->attr_valid = TRUE;
+	}
+	victim->tick = rt_tick_get();
+	victim->lru = ++nfs->cache_lru;
 }
 
-static nfs_fh3 *get_dir_handle(struct nfs_filesystem* nfs, const char *name)
+/* drop path and everything below it */
+static void nfs_cache_invalidate(struct nfs_filesystem* nfs, const char *path)
 {
-	nfs_fh3 *handle=RT_NULL;
-	char *file;
-	char *path;
-	char *init;
+	struct nfs_cache *c;
+	size_t len;
+	int index;
 
-	init = path = rt_malloc(strlen(name)+1);
-	if(init==RT_NULL)
-		return RT_NULL;
-	memcpy(init, name, strlen(name)+1);
+	len = strlen(path);
+	if (len >= NAME_MAX) return;
 
-	handle = rt_malloc(sizeof(nfs_fh3));
-	if(handle == RT_NULL)
+	for (index = 0; index < NFS_CACHE_SIZE; index ++)
 	{
-		rt_free(init);
-		return RT_NULL;
+		c = &nfs->cache[index];
+		if (strncmp(c->path, path, len) == 0 &&
+			(c->path[len] == '\0' || c->path[len] == '/'))
+			nfs_cache_free(c);
 	}
+}
+
+/* attributes of handle changed by ourselves */
+static void nfs_cache_stale(struct nfs_filesystem* nfs, const nfs_fh3 *handle)
+{
+	struct nfs_cache *c;
+	int index;
 
-	if(path[0]=='/')
+	for (index = 0; index < NFS_CACHE_SIZE; index ++)
 	{
-		path++;
-		copy_handle(handle, &nfs->root_handle);
+		c = &nfs->cache[index];
+		if (c->path[0] != '\0' &&
+			c->handle.data.data_len == handle->data.data_len &&
+			memcmp(c->handle.data.data_val, handle->data.data_val, handle->data.data_len) == 0)
+			c->attr_valid = FALSE;
 	}
-	else
+}
+
+static void nfs_cache_flush(struct nfs_filesystem* nfs)
+{
+	int index;
+
+	for (index = 0; index < NFS_CACHE_SIZE; index ++)
+		nfs_cache_free(&nfs->cache[index]);
+}
+#else
+#define nfs_cache_invalidate(nfs, path)
+#define nfs_cache_stale(nfs, handle)
+#define nfs_cache_flush(nfs)
+#endif
+
+/* handle of the first len bytes of name, one LOOKUP per uncached component */
+static nfs_fh3 *lookup_handle(struct nfs_filesystem* nfs, const char *name, size_t len)
+{
+	nfs_fh3 *handle;
+	const nfs_fh3 *base;
+	const char *file;
+	char component[NAME_MAX];
+	size_t done, n;
+
+	handle = rt_malloc(sizeof(nfs_fh3));
+	if(handle==RT_NULL)
+		return RT_NULL;
+
+	base = (name[0] == '/') ? &nfs->root_handle : &nfs->current_handle;
+	done = 0;
+
+#if NFS_CACHE_SIZE
+	/* start from the longest cached prefix */
+	for (n = len; n > 0; n --)
 	{
-		copy_handle(handle, &nfs->current_handle);
+		struct nfs_cache *c;
+
+		if (n != len && name[n] != '/')
+			continue;
+
+		c = nfs_cache_find(nfs, name, n);
+		if (c != RT_NULL)
+		{
+			base = &c->handle;
+			done = n;
+			break;
+		}
 	}
+#endif
+
+	copy_handle(handle, base);
 
-	while((file=strtok_r(RT_NULL, "/", &path))!=RT_NULL && path[0]!='\0')
+	for (file = name + done; ; file += n)
 	{
 		LOOKUP3args args;
 		LOOKUP3res res;
+
+		while (file < name + len && *file == '/')
+			file ++;
+		for (n = 0; file + n < name + len && file[n] != '/'; n ++);
+		if (n == 0)
+			break;
+
+		if (n >= NAME_MAX)
+		{
+			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
+			rt_free(handle);
+			return RT_NULL;
+		}
+		memcpy(component, file, n);
+		component[n] = '\0';
+
 		memset(&res, 0, sizeof(res));
-		copy_handle(&args.what.dir, handle);
-		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-		args.what.name=file;
+		args.what.dir=*handle;
+		args.what.name=component;
 
 		if(nfsproc3_lookup_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS)
 		{
 			rt_kprintf("Lookup failed\n");
-			rt_free(init);
+			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 			rt_free(handle);
-			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
 			return RT_NULL;
 		}
 		else if(res.status!=NFS3_OK)
 		{
 			rt_kprintf("Lookup failed: %d\n", res.status);
-			rt_free(init);
+			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 			rt_free(handle);
-			xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
 			xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
 			return RT_NULL;
 		}
+		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 		copy_handle(handle, &res.LOOKUP3res_u.resok.object);
-		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&args.what.dir);
+#if NFS_CACHE_SIZE
+		nfs_cache_add(nfs, name, file + n - name, &res.LOOKUP3res_u.resok.object,
+			&res.LOOKUP3res_u.resok.obj_attributes);
+#endif
 		xdr_free((xdrproc_t)xdr_LOOKUP3res, (char *)&res);
 	}
 
-	rt_free(init);
 	return handle;
 }
 
-static size_t nfs_get_filesize(struct nfs_filesystem* nfs, nfs_fh3 *handle)
+static nfs_fh3 *get_handle(struct nfs_filesystem* nfs, const char *name)
 {
-	GETATTR3args args;
-	GETATTR3res res;
-	fattr3 *info;
-	size_t size;
-
-	args.object = *handle;
-
-	memset(&res, '\0', sizeof(res));
+	return lookup_handle(nfs, name, strlen(name));
+}
 
-	if ((nfsproc3_getattr_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS) ||
-		res.status != NFS3_OK)
-	{
-		rt_kprintf("GetAttr failed: %d\n", res.status);
-		return 0;
-	}
+static nfs_fh3 *get_dir_handle(struct nfs_filesystem* nfs, const char *name)
+{
+	const char *file;
 
-	info=&res.GETATTR3res_u.resok.obj_attributes;
-	size = info->size;
-	xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-	
-	return size;
+	file = strrchr(name, '/');
+	return lookup_handle(nfs, name, (file == RT_NULL) ? 0 : file - name);
 }
 
-rt_bool_t nfs_is_directory(struct nfs_filesystem* nfs, const char* name)
+/* attributes of path, GETATTR only when not cached */
+static int get_attr(struct nfs_filesystem* nfs, const char *path, nfs_fh3 *handle, fattr3 *attr)
 {
 	GETATTR3args args;
 	GETATTR3res res;
-	fattr3 *info;
-	nfs_fh3 *handle;
-	rt_bool_t result;
+#if NFS_CACHE_SIZE
+	struct nfs_cache *c;
 
-	result = RT_FALSE;
-	handle = get_handle(nfs, name);
-	if(handle == RT_NULL) return RT_FALSE;
+	c = nfs_cache_find(nfs, path, strlen(path));
+	if (c != RT_NULL && c->attr_valid)
+	{
+		*attr = c->attr;
+		return 0;
+	}
+#endif
 
 	args.object = *handle;
 
@@ -272,19 +410,49 @@ rt_bool_t nfs_is_directory(struct nfs_filesystem* nfs, const char* name)
 	if (nfsproc3_getattr_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS)
 	{
 		rt_kprintf("GetAttr failed\n");
-		return RT_FALSE;
+		return -1;
 	}
 	else if(res.status!=NFS3_OK)
 	{
 		rt_kprintf("Getattr failed: %d\n", res.status);
-		return RT_FALSE;
+		return -1;
 	}
 
-	info=&res.GETATTR3res_u.resok.obj_attributes;
+	*attr = res.GETATTR3res_u.resok.obj_attributes;
+	xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
 
-	if (info->type == NFS3DIR) result = RT_TRUE;
+#if NFS_CACHE_SIZE
+	if (c != RT_NULL)
+	{
+		c->attr = *attr;
+		c->attr_valid = TRUE;
+	}
+	else
+	{
+		post_op_attr op;
+
+		op.attributes_follow = TRUE;
+		op.post_op_attr_u.attributes = *attr;
+		nfs_cache_add(nfs, path, strlen(path), handle, &op);
+	}
+#endif
+
+	return 0;
+}
+
+rt_bool_t nfs_is_directory(struct nfs_filesystem* nfs, const char* name)
+{
+	fattr3 info;
+	nfs_fh3 *handle;
+	rt_bool_t result;
+
+	result = RT_FALSE;
+	handle = get_handle(nfs, name);
+	if(handle == RT_NULL) return RT_FALSE;
+
+	if (get_attr(nfs, name, handle, &info) == 0 && info.type == NFS3DIR)
+		result = RT_TRUE;
 
-	xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
 	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 	rt_free(handle);
 	
@@ -336,6 +504,7 @@ int nfs_create(struct nfs_filesystem* nfs, const char *name, mode_t mode)
 		rt_kprintf("Create failed: %d\n", res.status);
 		ret = -1;
 	}
+	nfs_cache_invalidate(nfs, name);
 	xdr_free((xdrproc_t)xdr_CREATE3res, (char *)&res);
 	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 	rt_free(handle);
@@ -384,6 +553,7 @@ int nfs_mkdir(struct nfs_filesystem* nfs, const char *name, mode_t mode)
 		rt_kprintf("Mkdir failed: %d\n", res.status);
 		ret=-1;
 	}
+	nfs_cache_invalidate(nfs, name);
 	xdr_free((xdrproc_t)xdr_MKDIR3res, (char *)&res);
 	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
 	rt_free(handle);
@@ -429,10 +599,12 @@ int nfs_mount(struct dfs_filesystem* fs, unsigned long rwflag, const void* data)
 	if(nfs->nfs_client == RT_NULL)
 	{
 		rt_kprintf("creat nfs client failed\n");
+		xdr_free((xdrproc_t)xdr_mountres3, (char *)&res);
 		goto __return;
 	}
 	copy_handle(&nfs->root_handle, (nfs_fh3 *)&res.mountres3_u.mountinfo.fhandle);
 	copy_handle(&nfs->current_handle, &nfs->root_handle);
+	xdr_free((xdrproc_t)xdr_mountres3, (char *)&res);
 
 	nfs->nfs_client->cl_auth=authnone_create();
 	fs->data = nfs;
@@ -475,6 +647,8 @@ int nfs_unmount(struct dfs_filesystem* fs)
 		return -1;
 	}
 
+	nfs_cache_flush(nfs);
+
 	/* destroy nfs client */
 	if(nfs->nfs_client != RT_NULL)
 	{
@@ -499,6 +673,8 @@ int nfs_unmount(struct dfs_filesystem* fs)
 		nfs->mount_client=RT_NULL;
 	}
 
+	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&nfs->root_handle);
+	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&nfs->current_handle);
 	rt_free(nfs);
 	fs->data = RT_NULL;
 
@@ -510,10 +686,333 @@ int nfs_ioctl(struct dfs_fd* file, int cmd,	void* args)
 	return -DFS_STATUS_ENOSYS;
 }
 
+#if NFS_RA_PAGES
+static struct nfs_page *nfs_ra_find(nfs_file *fd, size_t offset)
+{
+	struct nfs_page *page;
+
+	for (page = fd->page; page < &fd->page[NFS_RA_PAGES]; page++)
+	{
+		if (page->state != NFS_PAGE_EMPTY && offset >= page->offset &&
+			offset < page->offset + NFS_PAGE_SIZE)
+			return page;
+	}
+
+	return RT_NULL;
+}
+
+/* a page that is unused or lies behind the current offset */
+static struct nfs_page *nfs_ra_slot(nfs_file *fd)
+{
+	struct nfs_page *page;
+
+	for (page = fd->page; page < &fd->page[NFS_RA_PAGES]; page++)
+	{
+		if (page->state == NFS_PAGE_EMPTY ||
+			page->offset + NFS_PAGE_SIZE <= fd->offset)
+			return page;
+	}
+
+	return RT_NULL;
+}
+
+static void nfs_ra_drop(struct nfs_filesystem* nfs, nfs_file *fd)
+{
+	struct nfs_page *page;
+
+	for (page = fd->page; page < &fd->page[NFS_RA_PAGES]; page++)
+	{
+		if (page->state == NFS_PAGE_PENDING)
+			clntudp_cancel(nfs->nfs_client, page->xid);
+		page->state = NFS_PAGE_EMPTY;
+	}
+}
+
+static void nfs_ra_release(struct nfs_filesystem* nfs, nfs_file *fd)
+{
+	struct nfs_page *page;
+
+	nfs_ra_drop(nfs, fd);
+	for (page = fd->page; page < &fd->page[NFS_RA_PAGES]; page++)
+	{
+		if (page->buf != RT_NULL)
+			rt_free(page->buf);
+		page->buf = RT_NULL;
+	}
+}
+
+/* start an asynchronous READ of one page */
+static int nfs_ra_send(struct nfs_filesystem* nfs, nfs_file *fd, struct nfs_page *page, size_t offset)
+{
+	READ3args args;
+
+	if (page->state == NFS_PAGE_PENDING)
+		clntudp_cancel(nfs->nfs_client, page->xid);
+	page->state = NFS_PAGE_EMPTY;
+
+	if (page->buf == RT_NULL)
+	{
+		page->buf = rt_malloc(NFS_PAGE_SIZE);
+		if (page->buf == RT_NULL)
+			return -1;
+	}
+
+	args.file = fd->handle;
+	args.offset = offset;
+	args.count = NFS_PAGE_SIZE;
+	if (clntudp_send(nfs->nfs_client, NFSPROC3_READ, (xdrproc_t)xdr_READ3args,
+		(char *)&args, &page->xid) != RPC_SUCCESS)
+		return -1;
+
+	page->offset = offset;
+	page->len = 0;
+	page->eof = FALSE;
+	page->state = NFS_PAGE_PENDING;
+
+	return 0;
+}
+
+/* wait for the READ of a page to complete */
+static int nfs_ra_wait(struct nfs_filesystem* nfs, struct nfs_page *page)
+{
+	READ3res res;
+	struct xdr_sink sink;
+
+	if (page->state == NFS_PAGE_VALID)
+		return 0;
+
+	/* decode the data straight into the page, nothing is left to free */
+	memset(&res, 0, sizeof(res));
+	sink.addr = page->buf;
+	sink.size = NFS_PAGE_SIZE;
+	clnt_control(nfs->nfs_client, CLSET_SINK, (char *)&sink);
+	page->state = NFS_PAGE_EMPTY;
+	if (clntudp_recv(nfs->nfs_client, page->xid, (xdrproc_t)xdr_READ3res,
+		(char *)&res) != RPC_SUCCESS)
+	{
+		rt_kprintf("Read failed\n");
+		return -1;
+	}
+	if (res.status != NFS3_OK)
+	{
+		rt_kprintf("Read failed: %d\n", res.status);
+		return -1;
+	}
+
+	page->len = res.READ3res_u.resok.data.data_len;
+	page->eof = res.READ3res_u.resok.eof;
+	page->state = NFS_PAGE_VALID;
+
+	return 0;
+}
+
+/* keep NFS_RA_PAGES pages from offset on requested */
+static void nfs_ra_fill(struct nfs_filesystem* nfs, nfs_file *fd, size_t offset)
+{
+	struct nfs_page *page;
+	int i;
+
+	for (i = 0; i < NFS_RA_PAGES; i++)
+	{
+		page = nfs_ra_find(fd, offset);
+		if (page == RT_NULL)
+		{
+			/* nothing to read ahead past the known end of file */
+			if (i > 0 && offset >= fd->size)
+				break;
+			page = nfs_ra_slot(fd);
+			if (page == RT_NULL || nfs_ra_send(nfs, fd, page, offset) < 0)
+				break;
+		}
+		else if (page->state == NFS_PAGE_VALID &&
+			(page->eof || page->len < NFS_PAGE_SIZE))
+		{
+			break;
+		}
+		offset = page->offset + NFS_PAGE_SIZE;
+	}
+}
+
+static int nfs_ra_read(struct nfs_filesystem* nfs, nfs_file *fd, char *buf, rt_size_t count)
+{
+	struct nfs_page *page;
+	size_t n;
+	int bytes = 0;
+
+	while (count > 0)
+	{
+		nfs_ra_fill(nfs, fd, fd->offset);
+		page = nfs_ra_find(fd, fd->offset);
+		if (page == RT_NULL || nfs_ra_wait(nfs, page) < 0)
+			break;
+
+		if (fd->offset >= page->offset + page->len)
+		{
+			if (page->eof)
+				fd->eof = TRUE;
+			else
+				page->state = NFS_PAGE_EMPTY;	/* short read, ask again from here */
+			break;
+		}
+
+		n = page->offset + page->len - fd->offset;
+		if (n > count)
+			n = count;
+		memcpy(buf, page->buf + (fd->offset - page->offset), n);
+		buf += n;
+		count -= n;
+		bytes += n;
+		fd->offset += n;
+
+		if (page->eof && fd->offset == page->offset + page->len)
+		{
+			fd->eof = TRUE;
+			break;
+		}
+	}
+
+	/* keep the next pages coming while the caller is busy */
+	if (fd->eof == FALSE)
+		nfs_ra_fill(nfs, fd, fd->offset);
+
+	return bytes;
+}
+#endif
+
+#if NFS_WB_DEPTH
+/* collect the reply of the oldest outstanding WRITE */
+static void nfs_wb_collect(struct nfs_filesystem* nfs, nfs_file *fd)
+{
+	WRITE3res res;
+	int i = fd->wb_head;
+
+	memset(&res, 0, sizeof(res));
+	if (clntudp_recv(nfs->nfs_client, fd->wb_xid[i], (xdrproc_t)xdr_WRITE3res,
+		(char *)&res) != RPC_SUCCESS)
+	{
+		rt_kprintf("Write failed\n");
+		fd->error = -DFS_STATUS_EIO;
+	}
+	else if (res.status != NFS3_OK)
+	{
+		rt_kprintf("Write failed: %d\n", res.status);
+		fd->error = -DFS_STATUS_EIO;
+	}
+	else
+	{
+		if (res.WRITE3res_u.resok.count != fd->wb_count[i])
+		{
+			rt_kprintf("Write short: %d\n", res.WRITE3res_u.resok.count);
+			fd->error = -DFS_STATUS_EIO;
+		}
+		/* the server restarted in between, earlier data may be lost */
+		if (fd->verf_valid && memcmp(fd->verf, res.WRITE3res_u.resok.verf,
+			NFS3_WRITEVERFSIZE) != 0)
+		{
+			rt_kprintf("Write failed: server restarted\n");
+			fd->error = -DFS_STATUS_EIO;
+		}
+		memcpy(fd->verf, res.WRITE3res_u.resok.verf, NFS3_WRITEVERFSIZE);
+		fd->verf_valid = TRUE;
+	}
+	xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
+
+	fd->wb_head = (i + 1) % NFS_WB_DEPTH;
+	fd->wb_n--;
+}
+
+static void nfs_wb_wait(struct nfs_filesystem* nfs, nfs_file *fd)
+{
+	while (fd->wb_n > 0)
+		nfs_wb_collect(nfs, fd);
+}
+
+/* send UNSTABLE WRITEs without waiting, returns the bytes queued */
+static int nfs_wb_write(struct nfs_filesystem* nfs, nfs_file *fd, const char *buf, rt_size_t count)
+{
+	WRITE3args args;
+	rt_size_t n;
+	int i, bytes = 0;
+
+	while (count > 0)
+	{
+		if (fd->wb_n == NFS_WB_DEPTH)
+			nfs_wb_collect(nfs, fd);
+
+		n = count;
+		if (n > NFS_PAGE_SIZE)
+			n = NFS_PAGE_SIZE;
+
+		args.file = fd->handle;
+		args.stable = UNSTABLE;
+		args.offset = fd->offset;
+		args.data.data_val = (void *)buf;
+		args.count = args.data.data_len = n;
+
+		i = (fd->wb_head + fd->wb_n) % NFS_WB_DEPTH;
+		if (clntudp_send(nfs->nfs_client, NFSPROC3_WRITE, (xdrproc_t)xdr_WRITE3args,
+			(char *)&args, &fd->wb_xid[i]) != RPC_SUCCESS)
+			break;
+		fd->wb_count[i] = n;
+		fd->wb_n++;
+		fd->dirty = TRUE;
+
+		buf += n;
+		count -= n;
+		bytes += n;
+		fd->offset += n;
+	}
+
+	return bytes;
+}
+
+/* wait for all WRITEs and make them stable */
+static int nfs_wb_commit(struct nfs_filesystem* nfs, nfs_file *fd)
+{
+	COMMIT3args args;
+	COMMIT3res res;
+	int ret;
+
+	nfs_wb_wait(nfs, fd);
+	ret = fd->error;
+	fd->error = 0;
+	if (fd->dirty == FALSE)
+		return ret;
+	fd->dirty = FALSE;
+
+	args.file = fd->handle;
+	args.offset = 0;
+	args.count = 0;
+
+	memset(&res, 0, sizeof(res));
+	if (nfsproc3_commit_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
+	{
+		rt_kprintf("Commit failed\n");
+		ret = -DFS_STATUS_EIO;
+	}
+	else if (res.status != NFS3_OK)
+	{
+		rt_kprintf("Commit failed: %d\n", res.status);
+		ret = -DFS_STATUS_EIO;
+	}
+	else if (memcmp(fd->verf, res.COMMIT3res_u.resok.verf, NFS3_WRITEVERFSIZE) != 0)
+	{
+		/* unstable data was dropped by a server restart */
+		rt_kprintf("Commit failed: server restarted\n");
+		ret = -DFS_STATUS_EIO;
+	}
+	xdr_free((xdrproc_t)xdr_COMMIT3res, (char *)&res);
+	fd->verf_valid = FALSE;
+
+	return ret;
+}
+#endif
+
 int nfs_read(struct dfs_fd* file, void *buf, rt_size_t count)
 {
 	READ3args args;
 	READ3res res;
+	struct xdr_sink sink;
 	ssize_t bytes;
 	nfs_file *fd;
 	struct nfs_filesystem* nfs;
@@ -533,11 +1032,34 @@ int nfs_read(struct dfs_fd* file, void *buf, rt_size_t count)
 	/* end of file */
 	if (fd->eof == TRUE) return 0;
 
+#if NFS_WB_DEPTH
+	/* let the server see our writes first */
+	nfs_wb_wait(nfs, fd);
+#endif
+#if NFS_RA_PAGES
+	/* sequential access is served from the read-ahead pages */
+	if (fd->offset == fd->ra_next)
+	{
+		bytes = nfs_ra_read(nfs, fd, buf, count);
+		if (bytes > 0 || fd->eof == TRUE)
+		{
+			fd->ra_next = fd->offset;
+			file->pos = fd->offset;
+			return bytes;
+		}
+	}
+	nfs_ra_drop(nfs, fd);
+#endif
+
 	args.file=fd->handle;
 	args.offset=fd->offset;
 	args.count=count;
 
+	/* decode the data straight into the caller's buffer */
 	memset(&res, 0, sizeof(res));
+	sink.addr = buf;
+	sink.size = count;
+	clnt_control(nfs->nfs_client, CLSET_SINK, (char *)&sink);
 	if(nfsproc3_read_3(args, &res, nfs->nfs_client) != RPC_SUCCESS)
 	{
 		rt_kprintf("Read failed\n");
@@ -555,13 +1077,16 @@ int nfs_read(struct dfs_fd* file, void *buf, rt_size_t count)
 			/* something should probably be here */
 			fd->eof = TRUE;
 		}
-		bytes=res.READ3res_u.resok.count;
+		bytes=res.READ3res_u.resok.data.data_len;
 		fd->offset += bytes;
 		/* update current position */
 		file->pos = fd->offset;
-		memcpy(buf, res.READ3res_u.resok.data.data_val, bytes);
 	}
+	res.READ3res_u.resok.data.data_val = RT_NULL;
 	xdr_free((xdrproc_t)xdr_READ3res, (char *)&res);
+#if NFS_RA_PAGES
+	fd->ra_next = fd->offset;
+#endif
 
 	return bytes;
 }
@@ -586,6 +1111,31 @@ int nfs_write(struct dfs_fd* file, const void *buf, rt_size_t count)
 	if(nfs->nfs_client==RT_NULL)
 		return -1;
 
+#if NFS_RA_PAGES
+	/* pages read ahead may be overwritten */
+	nfs_ra_drop(nfs, fd);
+#endif
+#if NFS_WB_DEPTH
+	/* report a failed earlier write */
+	if (fd->error != 0)
+	{
+		bytes = fd->error;
+		fd->error = 0;
+		return bytes;
+	}
+
+	bytes = nfs_wb_write(nfs, fd, buf, count);
+	if (bytes > 0)
+	{
+		/* update current position */
+		file->pos = fd->offset;
+		if (fd->offset > fd->size)
+			fd->size = fd->offset;
+		nfs_cache_stale(nfs, &fd->handle);
+		return bytes;
+	}
+#endif
+
 	args.file=fd->handle;
 	args.stable=FILE_SYNC;
 	args.offset=fd->offset;
@@ -610,13 +1160,39 @@ int nfs_write(struct dfs_fd* file, const void *buf, rt_size_t count)
 		fd->offset+=bytes;
 		/* update current position */
 		file->pos = fd->offset;
-		/* todo: update file size */
+		if (fd->offset > fd->size)
+			fd->size = fd->offset;
+		nfs_cache_stale(nfs, &fd->handle);
 	}
 	xdr_free((xdrproc_t)xdr_WRITE3res, (char *)&res);
 
 	return bytes;
 }
 
+int nfs_flush(struct dfs_fd* file)
+{
+#if NFS_WB_DEPTH
+	nfs_file *fd;
+	struct nfs_filesystem* nfs;
+
+	if (file->type != FT_REGULAR)
+		return 0;
+
+	fd = (nfs_file *)(file->data);
+	RT_ASSERT(fd != RT_NULL);
+	RT_ASSERT(file->fs != RT_NULL);
+	RT_ASSERT(file->fs->data != RT_NULL);
+	nfs = (struct nfs_filesystem *)file->fs->data;
+
+	if(nfs->nfs_client==RT_NULL)
+		return -1;
+
+	return nfs_wb_commit(nfs, fd);
+#else
+	return 0;
+#endif
+}
+
 int nfs_lseek(struct dfs_fd* file, rt_off_t offset)
 {
 	nfs_file *fd;
@@ -630,6 +1206,7 @@ int nfs_lseek(struct dfs_fd* file, rt_off_t offset)
 	if (offset < fd->size)
 	{
 		fd->offset = offset;
+		fd->eof = FALSE;
 		return offset;
 	}
 
@@ -638,6 +1215,8 @@ int nfs_lseek(struct dfs_fd* file, rt_off_t offset)
 
 int nfs_close(struct dfs_fd* file)
 {
+	int ret = 0;
+
 	if (file->type == FT_DIRECTORY)
 	{
 		struct nfs_dir* dir;
@@ -653,12 +1232,20 @@ int nfs_close(struct dfs_fd* file)
 
 		fd = (struct nfs_file*)file->data;
 
+		/* the fd is torn down whatever happens, but a lost write must
+		 * still reach the caller */
+		ret = nfs_flush(file);
+		if (ret < 0)
+			rt_kprintf("Flush on close failed\n");
+#if NFS_RA_PAGES
+		nfs_ra_release((struct nfs_filesystem *)file->fs->data, fd);
+#endif
 		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)&fd->handle);
 		rt_free(fd);
 	}
 
 	file->data = RT_NULL;
-	return 0;
+	return ret;
 }
 
 int nfs_open(struct dfs_fd* file)
@@ -687,6 +1274,7 @@ int nfs_open(struct dfs_fd* file)
 	{
 		nfs_file *fp;
 		nfs_fh3 *handle;
+		fattr3 info;
 
 		/* create file */
 		if (file->flags & DFS_O_CREAT)
@@ -698,6 +1286,7 @@ int nfs_open(struct dfs_fd* file)
 		fp=rt_malloc(sizeof(nfs_file));
 		if(fp == RT_NULL)
 			return -1;
+		memset(fp, 0, sizeof(nfs_file));
 
 		handle = get_handle(nfs, file->path);
 		if(handle == RT_NULL)
@@ -707,7 +1296,9 @@ int nfs_open(struct dfs_fd* file)
 		}
 
 		/* get size of file */
-		fp->size = nfs_get_filesize(nfs, handle);
+		fp->size = 0;
+		if (get_attr(nfs, file->path, handle, &info) == 0)
+			fp->size = info.size;
 		fp->offset=0;
 		fp->eof = FALSE;
 
@@ -719,6 +1310,9 @@ int nfs_open(struct dfs_fd* file)
 		{
 			fp->offset = fp->size;
 		}
+#if NFS_RA_PAGES
+		fp->ra_next = fp->offset;
+#endif
 
 		/* set private file */
 		file->data = fp;
@@ -729,11 +1323,10 @@ int nfs_open(struct dfs_fd* file)
 
 int nfs_stat(struct dfs_filesystem* fs, const char *path, struct stat *st)
 {
-	GETATTR3args args;
-	GETATTR3res res;
-	fattr3 *info;
+	fattr3 info;
 	nfs_fh3 *handle;
 	struct nfs_filesystem* nfs;
+	int ret;
 
 	RT_ASSERT(fs != RT_NULL);
 	RT_ASSERT(fs->data != RT_NULL);
@@ -743,41 +1336,26 @@ int nfs_stat(struct dfs_filesystem* fs, const char *path, struct stat *st)
 	if(handle == RT_NULL)
 		return -1;
 
-	args.object = *handle;
-
-	memset(&res, '\0', sizeof(res));
-
-	if (nfsproc3_getattr_3(args, &res, nfs->nfs_client)!=RPC_SUCCESS)
-	{
-		rt_kprintf("GetAttr failed\n");
-		return -1;
-	}
-	else if(res.status!=NFS3_OK)
-	{
-		rt_kprintf("Getattr failed: %d\n", res.status);
+	ret = get_attr(nfs, path, handle, &info);
+	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
+	rt_free(handle);
+	if (ret < 0)
 		return -1;
-	}
-
-	info = &res.GETATTR3res_u.resok.obj_attributes;
 
 	st->st_dev   = 0;
 
 	st->st_mode = DFS_S_IFREG | DFS_S_IRUSR | DFS_S_IRGRP | DFS_S_IROTH |
 	DFS_S_IWUSR | DFS_S_IWGRP | DFS_S_IWOTH;
-	if (info->type == NFS3DIR)
+	if (info.type == NFS3DIR)
 	{
 		st->st_mode &= ~DFS_S_IFREG;
 		st->st_mode |= DFS_S_IFDIR | DFS_S_IXUSR | DFS_S_IXGRP | DFS_S_IXOTH;
 	}
 
-	st->st_size  = info->size;
-	st->st_mtime = info->mtime.seconds;
+	st->st_size  = info.size;
+	st->st_mtime = info.mtime.seconds;
 	st->st_blksize = 512;
 
-	xdr_free((xdrproc_t)xdr_GETATTR3res, (char *)&res);
-	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)handle);
-	rt_free(handle);
-
 	return 0;
 }
 
@@ -933,6 +1511,8 @@ int nfs_unlink(struct dfs_filesystem* fs, const char* path)
 		rt_free(handle);	
 	}
 
+	nfs_cache_invalidate(nfs, path);
+
 	return ret;
 }
 
@@ -958,7 +1538,11 @@ int nfs_rename(struct dfs_filesystem* fs, const char *src, const char *dest)
 
 	dHandle=get_dir_handle(nfs, dest);
 	if(dHandle==RT_NULL)
+	{
+		xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)sHandle);
+		rt_free(sHandle);
 		return -1;
+	}
 
 	args.from.dir=*sHandle;
 	args.from.name=strrchr(src, '/') + 1;
@@ -966,7 +1550,7 @@ int nfs_rename(struct dfs_filesystem* fs, const char *src, const char *dest)
 		args.from.name=(char *)src;
 
 	args.to.dir=*dHandle;
-	args.to.name=strrchr(src, '/') + 1;
+	args.to.name=strrchr(dest, '/') + 1;
 	if(args.to.name==RT_NULL)
 		args.to.name=(char *)dest;
 
@@ -983,8 +1567,13 @@ int nfs_rename(struct dfs_filesystem* fs, const char *src, const char *dest)
 		ret = -1;
 	}
 
+	nfs_cache_invalidate(nfs, src);
+	nfs_cache_invalidate(nfs, dest);
+
 	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)sHandle);
 	xdr_free((xdrproc_t)xdr_nfs_fh3, (char *)dHandle);
+	rt_free(sHandle);
+	rt_free(dHandle);
 	xdr_free((xdrproc_t)xdr_RENAME3res, (char *)&res);
 	return ret;
 }
@@ -1032,6 +1621,7 @@ int nfs_getdents(struct dfs_fd* file, struct dirent* dirp, rt_uint32_t count)
 static const struct dfs_filesystem_operation _nfs = 
 {
 	"nfs", 
+	DFS_FS_FLAG_DEFAULT,
 	nfs_mount,
 	nfs_unmount,
 	RT_NULL, /* mkfs */
@@ -1041,7 +1631,7 @@ static const struct dfs_filesystem_operation _nfs =
 	nfs_ioctl,
 	nfs_read,
 	nfs_write,
-	RT_NULL, /* flush */
+	nfs_flush,
 	nfs_lseek,
 	nfs_getdents,
 	nfs_unlink, 
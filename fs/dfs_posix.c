@@ -81,13 +81,14 @@ int close(int fd)
 	result = dfs_file_close(d);
 	fd_put(d);
 
+	/* the descriptor is released even when close reports an error */
+	fd_put(d);
 	if (result < 0)
 	{
 		rt_set_errno(result);
 		return -1;
 	}
 
-	fd_put(d);
 	return 0;
 }
 
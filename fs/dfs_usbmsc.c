@@ -7,6 +7,18 @@
 //Private Defines
 #define USB_LOCK_ENABLE			1
 
+#define USBMSC_SECTOR_SIZE		512
+/* sectors fetched ahead by one READ(10) on a sequential miss,
+ * takes USBMSC_RA_SECTORS * 512 bytes of RAM, 0 turns read-ahead off */
+#ifndef USBMSC_RA_SECTORS
+#define USBMSC_RA_SECTORS		8
+#endif
+/* single sector writes held back and merged into WRITE(10) runs on flush,
+ * takes USBMSC_WB_SECTORS * 516 bytes of RAM, 0 writes every sector through */
+#ifndef USBMSC_WB_SECTORS
+#define USBMSC_WB_SECTORS		16
+#endif
+
 /* Disk Status Bits (DSTATUS) */
 #define STA_NOINIT		0x01	/* Drive not initialized */
 #define STA_NODISK		0x02	/* No medium in the drive */
@@ -19,6 +31,21 @@ static os_sem_t usbmsc_sem;
 #endif
 static struct rt_device usbmsc_device;
 
+#if USBMSC_RA_SECTORS
+/* read-ahead window, always coherent with the device and the dirty sectors */
+static rt_uint8_t usbmsc_ra_buf[USBMSC_RA_SECTORS * USBMSC_SECTOR_SIZE];
+static rt_uint32_t usbmsc_ra_start;
+static rt_uint32_t usbmsc_ra_next;
+#endif
+static rt_uint32_t usbmsc_ra_count;
+
+#if USBMSC_WB_SECTORS
+/* dirty sectors, usbmsc_wb_sect[i] is held in usbmsc_wb_buf[i] */
+static rt_uint8_t usbmsc_wb_buf[USBMSC_WB_SECTORS][USBMSC_SECTOR_SIZE];
+static rt_uint32_t usbmsc_wb_sect[USBMSC_WB_SECTORS];
+#endif
+static rt_uint32_t usbmsc_wb_count;
+
 //Private Macros
 #if USB_LOCK_ENABLE
 #define usbmsc_lock()			os_sem_wait(&usbmsc_sem)
@@ -38,7 +65,12 @@ rt_err_t usbmsc_isready(rt_device_t dev)
 	usbmsc_lock();
 	
 	if (usb_HostIsConnected(dev->user_data) != SYS_R_OK)
+	{
+		/* the medium may be another one next time */
 		usbmsc_state |= STA_NOINIT;
+		usbmsc_ra_count = 0;
+		usbmsc_wb_count = 0;
+	}
 	else
 		usbmsc_state &= ~STA_NOINIT;
 
@@ -50,6 +82,118 @@ rt_err_t usbmsc_isready(rt_device_t dev)
 	return RT_EOK;
 }
 
+#if USBMSC_WB_SECTORS
+static int usbmsc_wb_find(rt_uint32_t sect)
+{
+	int i;
+
+	for (i = 0; i < usbmsc_wb_count; i++)
+	{
+		if (usbmsc_wb_sect[i] == sect)
+			return i;
+	}
+
+	return -1;
+}
+
+/* dirty sectors are newer than what has been read from the device */
+static void usbmsc_wb_overlay(rt_uint32_t pos, rt_uint8_t *buf, rt_size_t size)
+{
+	int i;
+
+	for (i = 0; i < usbmsc_wb_count; i++)
+	{
+		if (usbmsc_wb_sect[i] - pos < size)
+			rt_memcpy(&buf[(usbmsc_wb_sect[i] - pos) * USBMSC_SECTOR_SIZE], usbmsc_wb_buf[i], USBMSC_SECTOR_SIZE);
+	}
+}
+
+static void usbmsc_wb_swap(int a, int b)
+{
+	rt_uint32_t *pa = (rt_uint32_t *)usbmsc_wb_buf[a], *pb = (rt_uint32_t *)usbmsc_wb_buf[b];
+	rt_uint32_t t;
+	int i;
+
+	for (i = 0; i < USBMSC_SECTOR_SIZE / sizeof(rt_uint32_t); i++)
+	{
+		t = pa[i];
+		pa[i] = pb[i];
+		pb[i] = t;
+	}
+	t = usbmsc_wb_sect[a];
+	usbmsc_wb_sect[a] = usbmsc_wb_sect[b];
+	usbmsc_wb_sect[b] = t;
+}
+
+/* write the dirty sectors back, sorted so that adjacent sectors lie next
+ * to each other in memory and go out as one WRITE(10) */
+static int usbmsc_wb_flush(rt_device_t dev)
+{
+	int i, j, n, res;
+
+	for (i = 0; i < usbmsc_wb_count; i++)
+	{
+		n = i;
+		for (j = i + 1; j < usbmsc_wb_count; j++)
+		{
+			if (usbmsc_wb_sect[j] < usbmsc_wb_sect[n])
+				n = j;
+		}
+		if (n != i)
+			usbmsc_wb_swap(i, n);
+	}
+
+	for (i = 0; i < usbmsc_wb_count; i += n)
+	{
+		for (n = 1; i + n < usbmsc_wb_count; n++)
+		{
+			if (usbmsc_wb_sect[i + n] != usbmsc_wb_sect[i] + n)
+				break;
+		}
+		res = usb_HostMscWrite(dev->user_data, usbmsc_wb_sect[i], usbmsc_wb_buf[i], n);
+		if (res)
+		{
+			/* keep what has not been written */
+			for (j = 0; i + j < usbmsc_wb_count; j++)
+			{
+				if (j != i + j)
+					usbmsc_wb_swap(j, i + j);
+			}
+			usbmsc_wb_count -= i;
+			return res;
+		}
+	}
+	usbmsc_wb_count = 0;
+
+	return 0;
+}
+#else
+#define usbmsc_wb_overlay(pos, buf, size)
+
+static int usbmsc_wb_flush(rt_device_t dev)
+{
+
+	return 0;
+}
+#endif
+
+#if USBMSC_RA_SECTORS
+/* the new data of sectors [pos, pos + size) also goes into the window,
+ * called once the data is on the device or held as dirty */
+static void usbmsc_ra_update(rt_uint32_t pos, const rt_uint8_t *buf, rt_size_t size)
+{
+	rt_uint32_t start, end;
+
+	start = pos > usbmsc_ra_start ? pos : usbmsc_ra_start;
+	end = pos + size < usbmsc_ra_start + usbmsc_ra_count ? pos + size : usbmsc_ra_start + usbmsc_ra_count;
+	if (start < end)
+		rt_memcpy(&usbmsc_ra_buf[(start - usbmsc_ra_start) * USBMSC_SECTOR_SIZE],
+			&buf[(start - pos) * USBMSC_SECTOR_SIZE], (end - start) * USBMSC_SECTOR_SIZE);
+}
+#else
+#define usbmsc_ra_update(pos, buf, size)
+#endif
+
 static rt_err_t usbmsc_init(rt_device_t dev)
 {
 
@@ -78,6 +222,10 @@ static rt_err_t usbmsc_close(rt_device_t dev)
 
 	usbmsc_lock();
 
+	if ((usbmsc_state & STA_NOINIT) == 0)
+		usbmsc_wb_flush(dev);
+	usbmsc_wb_count = 0;
+	usbmsc_ra_count = 0;
 	usb_HostClose(dev->user_data);
 	usbmsc_state |= STA_NOINIT;
 
@@ -98,8 +246,47 @@ static rt_size_t usbmsc_read(rt_device_t dev, rt_off_t pos, void* buffer, rt_siz
 
 	usbmsc_lock();
 
+#if USBMSC_WB_SECTORS
+	res = size == 1 ? usbmsc_wb_find(pos) : -1;
+	if (res >= 0)
+	{
+		rt_memcpy(buffer, usbmsc_wb_buf[res], USBMSC_SECTOR_SIZE);
+		res = 0;
+	}
+#else
+	res = -1;
+#endif
+#if USBMSC_RA_SECTORS
+	if (res && pos >= usbmsc_ra_start && pos + size <= usbmsc_ra_start + usbmsc_ra_count)
+	{
+		rt_memcpy(buffer, &usbmsc_ra_buf[(pos - usbmsc_ra_start) * USBMSC_SECTOR_SIZE], size * USBMSC_SECTOR_SIZE);
+		res = 0;
+	}
+	else if (res)
+	{
+		if (size < USBMSC_RA_SECTORS && pos == usbmsc_ra_next)
+		{
+			/* sequential, fill the window from here */
+			usbmsc_ra_count = 0;
+			if (usb_HostMscRead(dev->user_data, pos, usbmsc_ra_buf, USBMSC_RA_SECTORS) == 0)
+			{
+				usbmsc_ra_start = pos;
+				usbmsc_ra_count = USBMSC_RA_SECTORS;
+				usbmsc_wb_overlay(pos, usbmsc_ra_buf, USBMSC_RA_SECTORS);
+				rt_memcpy(buffer, usbmsc_ra_buf, size * USBMSC_SECTOR_SIZE);
+				res = 0;
+			}
+		}
+	}
+	usbmsc_ra_next = pos + size;
+#endif
 	/* READ BLOCK */
-	res = usb_HostMscRead(dev->user_data, pos, buffer, size);
+	if (res)
+	{
+		res = usb_HostMscRead(dev->user_data, pos, buffer, size);
+		if (res == 0)
+			usbmsc_wb_overlay(pos, buffer, size);
+	}
 
 	usbmsc_unlock();
 
@@ -112,6 +299,9 @@ static rt_size_t usbmsc_read(rt_device_t dev, rt_off_t pos, void* buffer, rt_siz
 static rt_size_t usbmsc_write (rt_device_t dev, rt_off_t pos, const void* buffer, rt_size_t size)
 {
 	int res;
+#if USBMSC_WB_SECTORS
+	int i;
+#endif
 
     if (usbmsc_state & STA_NOINIT)
 		return 0;
@@ -120,10 +310,54 @@ static rt_size_t usbmsc_write (rt_device_t dev, rt_off_t pos, const void* buffer
 		return 0;
 	
 	usbmsc_lock();
-	
+
+#if USBMSC_WB_SECTORS
+	if (size == 1)
+	{
+		/* hold it back until the next flush */
+		res = 0;
+		i = usbmsc_wb_find(pos);
+		if (i < 0)
+		{
+			if (usbmsc_wb_count == USBMSC_WB_SECTORS)
+				res = usbmsc_wb_flush(dev);
+			i = usbmsc_wb_count;
+		}
+		if (res == 0)
+		{
+			if (i == usbmsc_wb_count)
+				usbmsc_wb_sect[usbmsc_wb_count++] = pos;
+			rt_memcpy(usbmsc_wb_buf[i], buffer, USBMSC_SECTOR_SIZE);
+		}
+	}
+	else
+	{
+		/* dirty sectors overwritten here are stale */
+		for (i = 0; i < usbmsc_wb_count; )
+		{
+			if (usbmsc_wb_sect[i] - pos < size)
+			{
+				usbmsc_wb_count--;
+				if (i != usbmsc_wb_count)
+					usbmsc_wb_swap(i, usbmsc_wb_count);
+			}
+			else
+				i++;
+		}
+		/* WRITE BLOCK */
+		res = usb_HostMscWrite(dev->user_data, pos, buffer, size);
+	}
+#else
 	/* WRITE BLOCK */
 	res = usb_HostMscWrite(dev->user_data, pos, buffer, size);
-	
+#endif
+
+	/* a failed write may have left part of the sectors on the device */
+	if (res)
+		usbmsc_ra_count = 0;
+	else
+		usbmsc_ra_update(pos, buffer, size);
+
 	usbmsc_unlock();
 	
 	if (res)
@@ -134,7 +368,7 @@ static rt_size_t usbmsc_write (rt_device_t dev, rt_off_t pos, const void* buffer
 
 static rt_err_t usbmsc_control(rt_device_t dev, rt_uint8_t cmd, void *args)
 {
-
+	int res;
 	struct rt_device_blk_geometry *p = (struct rt_device_blk_geometry *)args;
 
 	switch (cmd)
@@ -144,6 +378,13 @@ static rt_err_t usbmsc_control(rt_device_t dev, rt_uint8_t cmd, void *args)
 		p->bytes_per_sector = 512;
 		p->block_size = 512;
 		break;
+	case RT_DEVICE_CTRL_BLK_SYNC:
+		usbmsc_lock();
+		res = usbmsc_wb_flush(dev);
+		usbmsc_unlock();
+		if (res)
+			return RT_ERROR;
+		break;
 	default:
 		break;
 	}
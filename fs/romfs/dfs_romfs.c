@@ -25,9 +25,60 @@ int dfs_romfs_ioctl(struct dfs_fd* file, int cmd,	void* args)
 	return -DFS_STATUS_EIO;
 }
 
+/* compare a dirent name with a path element of length len */
+static int romfs_name_cmp(const char *name, const char *subpath, rt_size_t len)
+{
+	const unsigned char *s1 = (const unsigned char *)name;
+	const unsigned char *s2 = (const unsigned char *)subpath;
+
+	for (; len; len --, s1 ++, s2 ++)
+	{
+		if (*s1 != *s2)
+			return *s1 - *s2;
+	}
+
+	/* the name is longer than the path element */
+	return *s1;
+}
+
+/* index of the entry named by the path element in a directory, or -1 */
+static int romfs_dirent_find(const struct romfs_dirent *dir, const char *subpath, rt_size_t len)
+{
+	const struct romfs_dirent *dirent;
+	int low, high, mid, result;
+
+	dirent = (const struct romfs_dirent *)dir->data;
+	if (dir->type & ROMFS_DIRENT_SORTED)
+	{
+		low = 0;
+		high = (int)dir->size - 1;
+		while (low <= high)
+		{
+			mid = (low + high) / 2;
+			result = romfs_name_cmp(dirent[mid].name, subpath, len);
+			if (result == 0)
+				return mid;
+			if (result < 0)
+				low = mid + 1;
+			else
+				high = mid - 1;
+		}
+	}
+	else
+	{
+		for (mid = 0; mid < (int)dir->size; mid ++)
+		{
+			if (romfs_name_cmp(dirent[mid].name, subpath, len) == 0)
+				return mid;
+		}
+	}
+
+	return -1;
+}
+
 struct romfs_dirent* dfs_romfs_lookup(struct romfs_dirent* root_dirent, const char* path, rt_size_t *size)
 {
-	rt_size_t index, found;
+	int index;
 	const char *subpath, *subpath_end;
 	struct romfs_dirent* dirent;
 	rt_size_t dirent_size;
@@ -38,9 +89,8 @@ struct romfs_dirent* dfs_romfs_lookup(struct romfs_dirent* root_dirent, const ch
 		return root_dirent;
 	}
 
-	/* goto root directy entries */
-	dirent = (struct romfs_dirent*)root_dirent->data;
-	dirent_size = root_dirent->size;
+	/* goto root directy */
+	dirent = root_dirent;
 
 	/* get the end position of this subpath */
 	subpath_end = path;
@@ -49,44 +99,31 @@ struct romfs_dirent* dfs_romfs_lookup(struct romfs_dirent* root_dirent, const ch
 	subpath = subpath_end;
 	while ((*subpath_end != '/') && *subpath_end) subpath_end ++;
 
-	while (dirent != RT_NULL)
+	while (dirent->data != RT_NULL)
 	{
-		found = 0;
-		
 		/* search in folder */
-		for (index = 0; index < dirent_size; index ++)
+		index = romfs_dirent_find(dirent, subpath, subpath_end - subpath);
+		if (index < 0) break; /* not found */
+
+		dirent = (struct romfs_dirent*)dirent->data + index;
+		dirent_size = dirent->size;
+
+		/* skip /// */
+		while (*subpath_end && *subpath_end == '/') subpath_end ++;
+		subpath = subpath_end;
+		while ((*subpath_end != '/') && *subpath_end) subpath_end ++;
+
+		if (!(*subpath))
 		{
-			if (rt_strncmp(dirent[index].name, subpath, (subpath_end - subpath)) == 0)
-			{
-				dirent_size = dirent[index].size;
-
-				/* skip /// */
-				while (*subpath_end && *subpath_end == '/') subpath_end ++;
-				subpath = subpath_end;
-				while ((*subpath_end != '/') && *subpath_end) subpath_end ++;
-
-				if (!(*subpath))
-				{
-					*size = dirent_size;
-					return &dirent[index];
-				}
-
-				if (dirent[index].type == ROMFS_DIRENT_DIR)
-				{
-					/* enter directory */
-					dirent = (struct romfs_dirent*)dirent[index].data;
-					found = 1;
-					break;
-				}
-				else 
-				{
-					/* return file dirent */
-					return &dirent[index];
-				}
-			}
+			*size = dirent_size;
+			return dirent;
 		}
 
-		if (!found) break; /* not found */
+		if (!(dirent->type & ROMFS_DIRENT_DIR))
+		{
+			/* return file dirent */
+			return dirent;
+		}
 	}
 
 	/* not found */
@@ -168,7 +205,7 @@ int dfs_romfs_stat(struct dfs_filesystem* fs, const char *path, struct stat *st)
 	st->st_mode = DFS_S_IFREG | DFS_S_IRUSR | DFS_S_IRGRP | DFS_S_IROTH |
 	DFS_S_IWUSR | DFS_S_IWGRP | DFS_S_IWOTH;
 
-	if (dirent->type == ROMFS_DIRENT_DIR)
+	if (dirent->type & ROMFS_DIRENT_DIR)
 	{
 		st->st_mode &= ~DFS_S_IFREG;
 		st->st_mode |= DFS_S_IFDIR | DFS_S_IXUSR | DFS_S_IXGRP | DFS_S_IXOTH;
@@ -189,7 +226,7 @@ int dfs_romfs_getdents(struct dfs_fd* file, struct dirent* dirp, rt_uint32_t cou
 	struct romfs_dirent *dirent, *sub_dirent;
 
 	dirent = (struct romfs_dirent*) file->data;
-	RT_ASSERT(dirent->type == ROMFS_DIRENT_DIR);
+	RT_ASSERT(dirent->type & ROMFS_DIRENT_DIR);
 
 	/* enter directory */
 	dirent = (struct romfs_dirent*) dirent->data;
@@ -207,7 +244,7 @@ int dfs_romfs_getdents(struct dfs_fd* file, struct dirent* dirp, rt_uint32_t cou
 		name = sub_dirent->name;
 
 		/* fill dirent */
-		if (sub_dirent->type == ROMFS_DIRENT_DIR)
+		if (sub_dirent->type & ROMFS_DIRENT_DIR)
 			d->d_type = DFS_DT_DIR;
 		else
 			d->d_type = DFS_DT_REG;
@@ -226,6 +263,7 @@ int dfs_romfs_getdents(struct dfs_fd* file, struct dirent* dirp, rt_uint32_t cou
 static const struct dfs_filesystem_operation _romfs = 
 {
 	"rom",
+	DFS_FS_FLAG_DEFAULT,
 	dfs_romfs_mount,
 	dfs_romfs_unmount,
 	RT_NULL,
@@ -5,6 +5,10 @@
 
 #define ROMFS_DIRENT_FILE	0x00
 #define ROMFS_DIRENT_DIR	0x01
+/* entries of this directory are sorted bytewise by name, looked up by
+ * binary search */
+#define ROMFS_DIRENT_SORTED	0x02
+#define ROMFS_DIRENT_DIR_SORTED	(ROMFS_DIRENT_DIR | ROMFS_DIRENT_SORTED)
 
 struct romfs_dirent
 {
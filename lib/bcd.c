@@ -4,6 +4,52 @@
 
 
 
+//Internal Functions
+//-------------------------------------------------------------------------
+//˷λ,x < 100 / x < 10000 / x < 100000000
+//-------------------------------------------------------------------------
+static u32 bcd_Bin2Bcd2(u32 x)
+{
+	u32 t;
+
+	t = (x * 205) >> 11;			//x / 10
+	return (t << 4) | (x - t * 10);
+}
+
+static u32 bcd_Bin2Bcd4(u32 x)
+{
+	u32 t;
+
+	t = (x * 5243) >> 19;			//x / 100
+	return (bcd_Bin2Bcd2(t) << 8) | bcd_Bin2Bcd2(x - t * 100);
+}
+
+static u32 bcd_Bin2Bcd8(u32 x)
+{
+	u32 t;
+
+	t = ((u64)x * 109951163) >> 40;	//x / 10000
+	return (bcd_Bin2Bcd4(t) << 16) | bcd_Bin2Bcd4(x - t * 10000);
+}
+
+//x / 10^8 = (x >> 8) / 390625,2^75/390625ĵȡλ,ֻ32x32˷
+static u64 bcd_Div1e8(u64 x)
+{
+	u64 t;
+	u32 nHi, nLo;
+
+	x >>= 8;
+	nHi = x >> 32;
+	nLo = x;
+	t = ((u64)nLo * 587776926) >> 32;
+	t += (u64)nHi * 587776926;
+	t += (u64)nLo * 22517998;
+	return ((u64)nHi * 22517998 + (t >> 32)) >> 11;
+}
+
+
+
+//External Functions
 //-------------------------------------------------------------------------
 //
 //-------------------------------------------------------------------------
@@ -19,25 +65,18 @@ u8 bcd2bin8(u8 x)
 u8 bin2bcd8(u8 x)
 {
 
-	return ((x / 10) << 4) + x % 10;
+	return bcd_Bin2Bcd2(x);
 }
 
 //-------------------------------------------------------------------------
-//
+//ֻ4λ
 //-------------------------------------------------------------------------
 u16 bin2bcd16(u16 x)
 {
-	int i;
-	char str[5 + 1];
-	u_byte2 bcd;
-
-	sprintf(str, "%05u", x);
-	for (i = 1;  i < 3;  i++)
-	{
-		bcd.byte[2 - i] = ((str[2 * i - 1] & 0x0F) << 4) | (str[2 * i] & 0x0F);
-	}
+	u32 t;
 
-	return bcd.n;
+	t = ((u64)x * 107375) >> 30;	//x / 10000
+	return bcd_Bin2Bcd4(x - t * 10000);
 }
 
 //-------------------------------------------------------------------------
@@ -45,35 +84,22 @@ u16 bin2bcd16(u16 x)
 //-------------------------------------------------------------------------
 u16 bcd2bin16(u16 x)
 {
-	int i;
-	u16 y = 0, nTemp;
-	u8 *p = (u8 *)&x;
+	u32 t = x;
 
-	for (i = 0; i < 2; i++)
-	{
-		nTemp = p[i];
-		y += ((u16)(nTemp & 0x0F) * (u16)math_pow10[i * 2]);
-		y += ((u16)((nTemp >> 4) & 0x0F) * (u16)math_pow10[i * 2 + 1]);
-	}
-	return y;
+	//Ȱÿֽת0~99,ٺϲ
+	t = (t & 0x0F0F) + ((t >> 4) & 0x0F0F) * 10;
+	return (t & 0xFF) + (t >> 8) * 100;
 }
 
 //-------------------------------------------------------------------------
-//
+//ֻ8λ
 //-------------------------------------------------------------------------
 u32 bin2bcd32(u32 x)
 {
-	int i;
-	char str[10 + 1];
-	u_byte4 bcd;
-
-	sprintf(str, "%010u", x);
-	for (i = 1;  i < 5;  i++)
-	{
-		bcd.byte[4 - i] = ((str[2 * i] & 0x0F) << 4) | (str[2 * i + 1] & 0x0F);
-	}
+	u32 t;
 
-	return bcd.n;
+	t = ((u64)x * 1441151881) >> 57;	//x / 100000000
+	return bcd_Bin2Bcd8(x - t * 100000000);
 }
 
 //-------------------------------------------------------------------------
@@ -81,66 +107,88 @@ u32 bin2bcd32(u32 x)
 //-------------------------------------------------------------------------
 u32 bcd2bin32(u32 x)
 {
-	int i;
-	u32 y = 0, nTemp;
-	u8 *p = (u8 *)&x;
 
-	for (i = 0; i < 4; i++)
-	{
-		nTemp = p[i];
-		y += ((u32)(nTemp & 0x0F) * (u32)math_pow10[i * 2]);
-		y += ((u32)((nTemp >> 4) & 0x0F) * (u32)math_pow10[i * 2 + 1]);
-	}
-	return y;
+	x = (x & 0x0F0F0F0F) + ((x >> 4) & 0x0F0F0F0F) * 10;
+	x = (x & 0x00FF00FF) + ((x >> 8) & 0x00FF00FF) * 100;
+	return (x & 0xFFFF) + (x >> 16) * 10000;
 }
 
 //-------------------------------------------------------------------------
-//
+//ֻ16λ
 //-------------------------------------------------------------------------
 u64 bin2bcd64(u64 x)
 {
-	u64 i, power;
-	u8 bcd[8];
-	int n1, n2;
+	u64 q;
+	u32 nHigh, t;
+
+	if ((x >> 32) == 0)
+	{
+		nHigh = x;
+		t = ((u64)nHigh * 1441151881) >> 57;
+		return ((u64)bcd_Bin2Bcd2(t) << 32) | bcd_Bin2Bcd8(nHigh - t * 100000000);
+	}
+
+	//x = q * 10^8 + 8λ, qģ10^8(q / 10^8 < 2^30)
+	q = bcd_Div1e8(x);
+	t = ((u64)(u32)(q >> 8) * 2882303762U) >> 50;
+	nHigh = q - (u64)t * 100000000;
+	return ((u64)bcd_Bin2Bcd8(nHigh) << 32) | bcd_Bin2Bcd8(x - q * 100000000);
+}
 
-	power = 10000000000000000ULL;
+//-------------------------------------------------------------------------
+//nQtynSize(1~4)ֽڵBCD(ֽǰ)תɶ
+//-------------------------------------------------------------------------
+void bcd2bin_array(u32 *pBin, const void *pBcd, size_t nSize, size_t nQty)
+{
+	const u8 *p = (const u8 *)pBcd;
+	u32 nData;
 
-	for (i = 8; i; i--)
+	for (; nQty; nQty--, p += nSize)
 	{
-	    x %= power;
-	    power /= 10;
-		n1 = x / power;
+		nData = 0;
+		memcpy(&nData, p, nSize);
+		*pBin++ = bcd2bin32(nData);
+	}
+}
 
-	    x %= power;
-	    power /= 10;
-		n2 = x / power;
+//-------------------------------------------------------------------------
+//nQtyתnSize(1~4)ֽڵBCD(ֽǰ)
+//-------------------------------------------------------------------------
+void bin2bcd_array(void *pBcd, const u32 *pBin, size_t nSize, size_t nQty)
+{
+	u8 *p = (u8 *)pBcd;
+	u32 nData;
 
-		bcd[i - 1] = (n1 << 4) | n2;
+	for (; nQty; nQty--, p += nSize)
+	{
+		nData = bin2bcd32(*pBin++);
+		memcpy(p, &nData, nSize);
 	}
-	
-	memcpy(&i, bcd, sizeof(i));
-	return i;
 }
 
 
 //-------------------------------------------------------------------------
-//
+//һֽڴ91,ÿμ4ֽ
 //-------------------------------------------------------------------------
 int isnotbcd(const void *pAdr, size_t nLen)
 {
-	int i;
-	u8 *p, nTemp;
+	const u8 *p = (const u8 *)pAdr;
+	u32 nData, nErr = 0;
 
-	p = (u8 *)pAdr;
-	for (i = 0; i < nLen; i++)
+	for (; nLen >= 4; nLen -= 4, p += 4)
+	{
+		memcpy(&nData, p, 4);
+		//ֽڼ6λ4λ9
+		nErr |= (nData & 0x0F0F0F0F) + 0x06060606;
+		nErr |= ((nData >> 4) & 0x0F0F0F0F) + 0x06060606;
+	}
+	for (; nLen; nLen--, p++)
 	{
-		nTemp = bcd2bin8(p[i]);
-		nTemp = bin2bcd8(nTemp);
-		if (nTemp != p[i])
-			break;
+		nErr |= (*p & 0x0F) + 0x06;
+		nErr |= (*p >> 4) + 0x06;
 	}
 
-	return (i < nLen) ? 1 : 0;
+	return (nErr & 0xF0F0F0F0) ? 1 : 0;
 }
 
 
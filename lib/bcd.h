@@ -14,6 +14,8 @@ u16 bcd2bin16(u16 x);
 u32 bin2bcd32(u32 x);
 u32 bcd2bin32(u32 x);
 u64 bin2bcd64(u64 x);
+void bcd2bin_array(u32 *pBin, const void *pBcd, size_t nSize, size_t nQty);
+void bin2bcd_array(void *pBcd, const u32 *pBin, size_t nSize, size_t nQty);
 int isnotbcd(const void *pAdr, size_t nLen);
 
 
@@ -156,4 +156,102 @@ u8 xor8(const void *data, size_t len)
 	return (u8)xor;
 }
 
+//У(RFC 1071),,δȡ
+//32λۼ,ʼַȿɲ
+u16 ipcs(int sum, const void *data, size_t len)
+{
+	const u8 *p = (const u8 *)data;
+	u32 acc = 0, w;
+	u16 t = 0;
+	u8 *q = (u8 *)&t;
+	int odd;
+
+	odd = (size_t)p & 1;
+	if (odd && len)
+	{
+		q[1] = *p++;
+		acc = t;
+		len -= 1;
+	}
+	if (((size_t)p & 2) && (len >= 2))
+	{
+		acc += *(const u16 *)p;
+		p += 2;
+		len -= 2;
+	}
+
+	for (; len >= 16; len -= 16, p += 16)
+	{
+		w = ((const u32 *)p)[0];
+		acc += w;
+		if (acc < w)
+			acc++;
+		w = ((const u32 *)p)[1];
+		acc += w;
+		if (acc < w)
+			acc++;
+		w = ((const u32 *)p)[2];
+		acc += w;
+		if (acc < w)
+			acc++;
+		w = ((const u32 *)p)[3];
+		acc += w;
+		if (acc < w)
+			acc++;
+	}
+	for (; len >= 4; len -= 4, p += 4)
+	{
+		w = *(const u32 *)p;
+		acc += w;
+		if (acc < w)
+			acc++;
+	}
+
+	acc = (acc >> 16) + (acc & 0xFFFF);
+	if (len >= 2)
+	{
+		acc += *(const u16 *)p;
+		p += 2;
+		len -= 2;
+	}
+	if (len)
+	{
+		t = 0;
+		q[0] = *p;
+		acc += t;
+	}
+	acc = (acc >> 16) + (acc & 0xFFFF);
+	acc = (acc >> 16) + (acc & 0xFFFF);
+
+	//ڴֽתΪֵ,ַʼʱֽڶԵ
+	t = acc;
+	if (odd)
+		acc = (q[1] << 8) | q[0];
+	else
+		acc = (q[0] << 8) | q[1];
+
+	acc += (u16)sum;
+	acc += acc >> 16;
+	return (u16)acc;
+}
+
+//RFC 1624 : HC' = ~(~HC + ~m + m')
+//csֵֶֽһ¼
+u16 ipcs_update(u16 cs, u16 m, u16 m1)
+{
+	u32 sum;
+
+	sum = (u16)~cs + (u16)~m + m1;
+	sum = (sum >> 16) + (sum & 0xFFFF);
+	sum += sum >> 16;
+	return (u16)~sum;
+}
+
+u16 ipcs_update32(u16 cs, u32 m, u32 m1)
+{
+
+	cs = ipcs_update(cs, m >> 16, m1 >> 16);
+	return ipcs_update(cs, m & 0xFFFF, m1 & 0xFFFF);
+}
+
 
@@ -19,6 +19,9 @@ u16 cs16(int cs, const void *data, size_t len);
 u16 crc16(const void *data, size_t len);
 int fcs16(int fcs, const void *data, size_t len);
 u8 xor8(const void *data, size_t len);
+u16 ipcs(int sum, const void *data, size_t len);
+u16 ipcs_update(u16 cs, u16 m, u16 m1);
+u16 ipcs_update32(u16 cs, u32 m, u32 m1);
 
 
 
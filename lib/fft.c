@@ -0,0 +1,241 @@
+
+
+//Private Variables
+//תcos/sin(2*PI*k/FFT_POINT),Q15
+static const s16 fft_tw[FFT_POINT / 2][2] = {
+	{ 32767,      0}, { 32729,   1608}, { 32610,   3212}, { 32413,   4808},
+	{ 32138,   6393}, { 31786,   7962}, { 31357,   9512}, { 30853,  11039},
+	{ 30274,  12540}, { 29622,  14010}, { 28899,  15447}, { 28106,  16846},
+	{ 27246,  18205}, { 26320,  19520}, { 25330,  20788}, { 24279,  22006},
+	{ 23170,  23170}, { 22006,  24279}, { 20788,  25330}, { 19520,  26320},
+	{ 18205,  27246}, { 16846,  28106}, { 15447,  28899}, { 14010,  29622},
+	{ 12540,  30274}, { 11039,  30853}, {  9512,  31357}, {  7962,  31786},
+	{  6393,  32138}, {  4808,  32413}, {  3212,  32610}, {  1608,  32729},
+	{     0,  32767}, { -1608,  32729}, { -3212,  32610}, { -4808,  32413},
+	{ -6393,  32138}, { -7962,  31786}, { -9512,  31357}, {-11039,  30853},
+	{-12540,  30274}, {-14010,  29622}, {-15447,  28899}, {-16846,  28106},
+	{-18205,  27246}, {-19520,  26320}, {-20788,  25330}, {-22006,  24279},
+	{-23170,  23170}, {-24279,  22006}, {-25330,  20788}, {-26320,  19520},
+	{-27246,  18205}, {-28106,  16846}, {-28899,  15447}, {-29622,  14010},
+	{-30274,  12540}, {-30853,  11039}, {-31357,   9512}, {-31786,   7962},
+	{-32138,   6393}, {-32413,   4808}, {-32610,   3212}, {-32729,   1608},
+};
+
+//atan(2^-i), * 65536
+static const s32 fft_atan[16] = {
+	2949120, 1740967, 919879, 466945, 234379, 117304, 58666, 29335,
+	14668, 7334, 3667, 1833, 917, 458, 229, 115,
+};
+
+
+
+//Internal Functions
+//Hannϵsin^2(PI*i/N) = (1 - cos(2*PI*i/N)) / 2,Q15
+static s32 fft_Hann(int i)
+{
+
+	if (i > FFT_POINT / 2)
+		i = FFT_POINT - i;
+	if (i == FFT_POINT / 2)
+		return 32768;
+	return (32768 - fft_tw[i][0]) >> 1;
+}
+
+static void fft_Result(t_fft_harm *p, s32 nReal, s32 nImag, int h, int nShift)
+{
+	u32 nAmp;
+	s16 nPhs;
+
+	fft_Polar(nReal, nImag, &nAmp, &nPhs);
+	if (h == 0)
+	{
+		//ֱûƵ֮
+		nShift += 1;
+		nPhs = 0;
+	}
+	p->amp[h] = (nAmp + (1 << (nShift - 1))) >> nShift;
+	p->phs[h] = nPhs;
+}
+
+static void fft_Thd(t_fft_harm *p)
+{
+	u64 nSum = 0;
+	u32 nRss;
+	int h;
+
+	for (h = 2; h <= FFT_HARM_MAX; h++)
+	{
+		nSum += (u64)p->amp[h] * p->amp[h];
+	}
+	if (p->amp[1] == 0)
+	{
+		p->thd = 0;
+		return;
+	}
+	nRss = sqrtfix(nSum, 24);
+	nSum = (u64)nRss * 10000 / p->amp[1];
+	p->thd = MIN(nSum, 0xFFFF);
+}
+
+
+
+//External Functions
+//------------------------------------------------------------------------
+//	: fft_Radix2()
+//	: x - ,ԭλ任
+//		  nBits - Ϊ2^nBits,FFT_POINT
+//	: 2ʱȡFFT
+//		  Q15ת,32λݲ,DFT;
+//		  벻2^19ʱ
+//------------------------------------------------------------------------
+void fft_Radix2(t_complex_fix *x, int nBits)
+{
+	t_complex_fix t, *a, *b;
+	int i, j, k, n, nLen, nHalf, nStep;
+	s32 wr, wi;
+
+	n = 1 << nBits;
+
+	//λ
+	for (i = 1, j = 0; i < n; i++)
+	{
+		for (k = n >> 1; j & k; k >>= 1)
+			j ^= k;
+		j |= k;
+		if (i < j)
+		{
+			t = x[i];
+			x[i] = x[j];
+			x[j] = t;
+		}
+	}
+
+	//,ͬһתӵĵηһ
+	for (nLen = 2, nStep = FFT_POINT / 2; nLen <= n; nLen <<= 1, nStep >>= 1)
+	{
+		nHalf = nLen >> 1;
+		//W = 1,Q15ʾ1,ÿ
+		for (i = 0; i < n; i += nLen)
+		{
+			a = &x[i];
+			b = &x[i + nHalf];
+			t = *b;
+			b->real = a->real - t.real;
+			b->imag = a->imag - t.imag;
+			a->real += t.real;
+			a->imag += t.imag;
+		}
+		for (j = 1; j < nHalf; j++)
+		{
+			wr = fft_tw[j * nStep][0];
+			wi = fft_tw[j * nStep][1];
+			for (i = j; i < n; i += nLen)
+			{
+				a = &x[i];
+				b = &x[i + nHalf];
+				//b * (wr - j*wi)
+				t.real = ((s64)b->real * wr + (s64)b->imag * wi + 0x4000) >> 15;
+				t.imag = ((s64)b->imag * wr - (s64)b->real * wi + 0x4000) >> 15;
+				b->real = a->real - t.real;
+				b->imag = a->imag - t.imag;
+				a->real += t.real;
+				a->imag += t.imag;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+//	: fft_Polar()
+//	: x, y - ʵ鲿,ģ2^29
+//	: pAmp - ģ
+//		  pPhs - ,0.01,-18000~18000
+//	: CORDICģ,ÿ͸
+//------------------------------------------------------------------------
+void fft_Polar(s32 x, s32 y, u32 *pAmp, s16 *pPhs)
+{
+	s32 t, nAng = 0;
+	int i;
+
+	//תҰƽ
+	if (x < 0)
+	{
+		x = -x;
+		y = -y;
+		nAng = 180L << 16;
+	}
+	for (i = 0; i < 16; i++)
+	{
+		t = x;
+		if (y > 0)
+		{
+			x += y >> i;
+			y -= t >> i;
+			nAng += fft_atan[i];
+		}
+		else
+		{
+			x -= y >> i;
+			y += t >> i;
+			nAng -= fft_atan[i];
+		}
+	}
+	if (nAng > (180L << 16))
+		nAng -= 360L << 16;
+
+	//ȥCORDIC1.64676
+	*pAmp = ((u64)x * 1304065748 + 0x40000000) >> 31;
+	*pPhs = (nAng * 100 + 0x8000) >> 16;
+}
+
+//------------------------------------------------------------------------
+//	: fft_Harmonic()
+//	: pBuf - ,FFT_POINT
+//		  pA, pB - ·,FFT_POINT,pBΪNULL
+//		  nWin - FFT_WIN_RECT / FFT_WIN_HANN
+//	: pHa, pHb - г
+//	: г,1~FFT_HARM_MAXηֵλTHD
+//		  ·ʵźŷֱʵ鲿һθFFT,
+//		  ͬĵѹһ,λֱ
+//------------------------------------------------------------------------
+void fft_Harmonic(t_complex_fix *x, const s16 *pA, const s16 *pB, int nWin, t_fft_harm *pHa, t_fft_harm *pHb)
+{
+	t_complex_fix *z, *w;
+	s32 nWin1;
+	int i, h, nShift;
+
+	for (i = 0; i < FFT_POINT; i++)
+	{
+		x[i].real = pA[i] * (1 << FFT_AMP_Q);
+		x[i].imag = (pB != NULL) ? (pB[i] * (1 << FFT_AMP_Q)) : 0;
+		if (nWin == FFT_WIN_HANN)
+		{
+			nWin1 = fft_Hann(i);
+			x[i].real = ((s64)x[i].real * nWin1) >> 15;
+			x[i].imag = ((s64)x[i].imag * nWin1) >> 15;
+		}
+	}
+
+	fft_Radix2(x, FFT_POINT_BITS);
+
+	//ֵ = 2|X[k]| / N,2X[k];Hann0.5
+	nShift = FFT_POINT_BITS;
+	if (nWin == FFT_WIN_HANN)
+		nShift -= 1;
+
+	for (h = 0; h <= FFT_HARM_MAX; h++)
+	{
+		z = &x[h * FFT_CYCLE];
+		w = &x[(FFT_POINT - h * FFT_CYCLE) & (FFT_POINT - 1)];
+		//A[k] = (Z[k] + conj(Z[N-k])) / 2
+		fft_Result(pHa, z->real + w->real, z->imag - w->imag, h, nShift);
+		//B[k] = (Z[k] - conj(Z[N-k])) / 2j
+		if (pHb != NULL)
+			fft_Result(pHb, z->imag + w->imag, w->real - z->real, h, nShift);
+	}
+
+	fft_Thd(pHa);
+	if (pHb != NULL)
+		fft_Thd(pHb);
+}
+
@@ -0,0 +1,56 @@
+#ifndef __LIB_FFT_H__
+#define __LIB_FFT_H__
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//Public Defines
+//FFT,ATT7022_SAMPLEPOINTһ
+#define FFT_POINT				128
+#define FFT_POINT_BITS			7
+
+//ڵĹƵ,ATT7022λ3.2k,128Ϊ2
+#ifndef FFT_CYCLE
+#define FFT_CYCLE				2
+#endif
+
+//г
+#ifndef FFT_HARM_MAX
+#define FFT_HARM_MAX			21
+#endif
+
+#if (FFT_CYCLE * FFT_HARM_MAX) >= (FFT_POINT / 2)
+#error "FFT_HARM_MAX too large for FFT_POINT"
+#endif
+
+//ֵСλ
+#define FFT_AMP_Q				4
+
+#define FFT_WIN_RECT			0
+#define FFT_WIN_HANN			1
+
+
+//Public Typedefs
+typedef struct {
+	u32		amp[FFT_HARM_MAX + 1];	//ηֵ(ֵ),ֵλ,Q4,amp[0]Ϊֱ
+	s16		phs[FFT_HARM_MAX + 1];	//λ,0.01
+	u16		thd;					//г,0.01%
+} t_fft_harm;
+
+
+
+//External Functions
+void fft_Radix2(t_complex_fix *x, int nBits);
+void fft_Polar(s32 x, s32 y, u32 *pAmp, s16 *pPhs);
+void fft_Harmonic(t_complex_fix *pBuf, const s16 *pA, const s16 *pB, int nWin, t_fft_harm *pHa, t_fft_harm *pHb);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -79,6 +79,8 @@ void bcd2str32(u32 n, char *pc);
 void int2str32(u32 n, char *pc);
 void bcd2str16(u16 n, char *pc);
 void bcd2str8(u8 n, char *pc);
+size_t hexdump(char *str, size_t nSize, const void *pData, size_t nLen);
+sys_res hexdump_to_buf(buf b, const void *pData, size_t nLen);
 int memtest(const void *s, const u8 c, int len);
 int memcnt(const void *s, const u8 c, int len);
 int memscmp(const char *cs, const char *ct);
@@ -46,7 +46,7 @@ const float math_sint[] =
 //-------------------------------------------------------------------------
 //ƽ
 //-------------------------------------------------------------------------
-u32 sqrtfix(u64 d, size_t n)
+u32 sqrtfix(u64 d, u32 n)
 {
 	u64 t;
 	u32 q = 0;
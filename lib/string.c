@@ -377,23 +377,63 @@ int  strncasecmp ( const char* s1, const char* s2, size_t len )
 #define isdigit(c)  ((unsigned)((c) - '0') < 10)
 #endif
 
-static __INLINE int divide(int *n, int base)
+/* "00" ~ "99", two decimal digits per lookup */
+static const char digits_100[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/*
+ * Put the digits of n into tmp in reverse order, return the count.
+ * Base 10 takes one division per two digits, base 8/16 only shifts.
+ */
+static int print_digits(char *tmp, unsigned long n, int base, const char *digits)
 {
-	int res;
+	const char *d;
+	unsigned long q;
+	int i = 0;
 
-	/* optimized for processor which does not support divide instructions. */
 	if (base == 10)
 	{
-		res = ((int)*n) % 10U;
-		*n = ((int)*n) / 10U;
+		while (n >= 100)
+		{
+			q = n / 100;
+			d = &digits_100[(n - q * 100) * 2];
+			tmp[i++] = d[1];
+			tmp[i++] = d[0];
+			n = q;
+		}
+		if (n >= 10)
+		{
+			tmp[i++] = digits_100[n * 2 + 1];
+			tmp[i++] = digits_100[n * 2];
+		}
+		else
+			tmp[i++] = '0' + n;
 	}
 	else
 	{
-		res = ((int)*n) % 16U;
-		*n = ((int)*n) / 16U;
+		q = (base == 16) ? 4 : 3;
+		do
+		{
+			tmp[i++] = digits[n & (base - 1)];
+			n >>= q;
+		} while (n);
 	}
 
-	return res;
+	return i;
+}
+
+static char *print_reverse(char *buf, char *end, const char *tmp, int i)
+{
+	while (i-- > 0)
+	{
+		if (buf <= end)
+			*buf = tmp[i];
+		++ buf;
+	}
+
+	return buf;
 }
 
 static __INLINE int skip_atoi(const char **s)
@@ -479,14 +519,7 @@ static char *print_number(char *buf,
     }
 #endif
 
-    i = 0;
-    if (num == 0)
-        tmp[i++]='0';
-    else
-    {
-        while (num != 0)
-            tmp[i++] = digits[divide(&num, base)];
-    }
+    i = print_digits(tmp, num, base, digits);
 
 #ifdef RT_PRINTF_PRECISION
     if (i > precision)
@@ -563,12 +596,7 @@ static char *print_number(char *buf,
 #endif
 
     /* put number in the temporary buffer */
-    while (i-- > 0)
-    {
-        if (buf <= end)
-            *buf = tmp[i];
-        ++ buf;
-    }
+    buf = print_reverse(buf, end, tmp, i);
 
     while (size-- > 0)
     {
@@ -593,6 +621,7 @@ int vsnprintf(char       *buf,
     int i, len;
     char *str, *end, c;
     const char *s;
+    char tmp[12];
 
     unsigned char base;            /* the base of number */
     unsigned char flags;           /* flags to print number */
@@ -623,6 +652,59 @@ int vsnprintf(char       *buf,
             continue;
         }
 
+        /* fast path for %d %u %x %X %02X %s without flags */
+        switch (fmt[1])
+        {
+        case 's':
+            s = va_arg(args, char *);
+            if (!s) s = "(NULL)";
+
+            for (; *s; ++s)
+            {
+                if (str <= end) *str = *s;
+                ++ str;
+            }
+            ++ fmt;
+            continue;
+
+        case 'd':
+        case 'u':
+            num = va_arg(args, unsigned int);
+            if ((fmt[1] == 'd') && ((int)num < 0))
+            {
+                if (str <= end) *str = '-';
+                ++ str;
+                num = 0U - (unsigned int)num;
+            }
+            i = print_digits(tmp, num, 10, NULL);
+            str = print_reverse(str, end, tmp, i);
+            ++ fmt;
+            continue;
+
+        case 'x':
+        case 'X':
+            s = (fmt[1] == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
+            i = print_digits(tmp, va_arg(args, unsigned int), 16, s);
+            str = print_reverse(str, end, tmp, i);
+            ++ fmt;
+            continue;
+
+        case '0':
+            if ((fmt[2] != '2') || ((fmt[3] != 'X') && (fmt[3] != 'x')))
+                break;
+
+            s = (fmt[3] == 'X') ? "0123456789ABCDEF" : "0123456789abcdef";
+            i = print_digits(tmp, va_arg(args, unsigned int), 16, s);
+            if (i < 2)
+                tmp[i++] = '0';
+            str = print_reverse(str, end, tmp, i);
+            fmt += 3;
+            continue;
+
+        default:
+            break;
+        }
+
         /* process flags */
         flags = 0;
 
@@ -1160,6 +1242,52 @@ void bcd2str8(u8 n, char *pc)
 }
 
 
+//-------------------------------------------------------------------------
+//ֽתΪ" XX XX"ʽʮƴ,ռ䲻ʱض,ַ
+//-------------------------------------------------------------------------
+size_t hexdump(char *str, size_t nSize, const void *pData, size_t nLen)
+{
+	static const char aHex[] = "0123456789ABCDEF";
+	const u8 *p = (const u8 *)pData;
+	char *pc = str;
+
+	if (nSize == 0)
+		return 0;
+
+	nLen = MIN(nLen, (nSize - 1) / 3);
+	for (; nLen; nLen--, p++)
+	{
+		*pc++ = ' ';
+		*pc++ = aHex[*p >> 4];
+		*pc++ = aHex[*p & 0x0F];
+	}
+	*pc = '\0';
+
+	return pc - str;
+}
+
+//-------------------------------------------------------------------------
+//ֽ鰴" XX"ʽ׷ӵ
+//-------------------------------------------------------------------------
+sys_res hexdump_to_buf(buf b, const void *pData, size_t nLen)
+{
+	sys_res res = SYS_R_OK;
+	const u8 *p = (const u8 *)pData;
+	size_t nQty;
+	char str[16 * 3 + 1];
+
+	for (; nLen; nLen -= nQty, p += nQty)
+	{
+		nQty = MIN(16, nLen);
+		res = buf_Push(b, str, hexdump(str, sizeof(str), p, nQty));
+
+		if (res != SYS_R_OK)
+			break;
+	}
+	return res;
+}
+
+
 //-------------------------------------------------------------------------
 //copyؽָ
 //-------------------------------------------------------------------------
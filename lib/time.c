@@ -1,148 +1,137 @@
 
 
-#if LIB_MINILIBC_ENABLE
-/* days per month -- nonleap! */
-const short __spm[13] =
-  { 0,
-    (31),
-    (31+28),
-    (31+28+31),
-    (31+28+31+30),
-    (31+28+31+30+31),
-    (31+28+31+30+31+30),
-    (31+28+31+30+31+30+31),
-    (31+28+31+30+31+30+31+31),
-    (31+28+31+30+31+30+31+31+30),
-    (31+28+31+30+31+30+31+31+30+31),
-    (31+28+31+30+31+30+31+31+30+31+30),
-    (31+28+31+30+31+30+31+31+30+31+30+31),
-  };
-
-/* seconds per day */
-#define SPD 24*60*60
+//Private Defines
+#define TIME_SPD				(24 * 60 * 60)
+#define TIME_DAYS_0000_1970		719468		//0000-03-011970-01-01
 
-int __isleap(int year)
+
+
+//Internal Functions
+static int time_IsLeap(u32 nYear)
 {
-	/* every fourth year is a leap year except for century years that are
-	 * not divisible by 400. */
-	/*  return (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)); */
-	return (!(year % 4) && ((year % 100) || !(year % 400)));
+
+	return ((nYear & 3) == 0) && ((nYear % 100) || (nYear % 400) == 0);
 }
 
-struct tm *gmtime_r(const time_t *timep, struct tm *r)
+//-------------------------------------------------------------------------
+//תΪ1970-01-01,3¿ʼ,ĩ
+//·1~12,տԳ·Χ
+//-------------------------------------------------------------------------
+static u32 time_Days4Civil(u32 nYear, u32 nMon, u32 nDay)
 {
-	time_t i;
-	register time_t work = *timep % (SPD);
-	r->tm_sec = work % 60;
-	work /= 60;
-	r->tm_min = work % 60;
-	r->tm_hour = work / 60;
-	work = *timep / (SPD);
-	r->tm_wday = (4 + work) % 7;
-	for (i = 1970;; ++i)
+	u32 nEra, nYoe, nDoy;
+
+	if (nMon <= 2)
 	{
-		register time_t k = __isleap(i) ? 366 : 365;
-		if (work >= k)
-			work -= k;
-		else
-			break;
+		nYear -= 1;
+		nMon += 9;
 	}
-	r->tm_year = i - 1900;
-	r->tm_yday = work;
-
-	r->tm_mday = 1;
-	if (__isleap(i) && (work > 58))
+	else
 	{
-		if (work == 59)
-			r->tm_mday = 2; /* 29.2. */
-		work -= 1;
+		nMon -= 3;
 	}
-
-	for (i = 11; i && (__spm[i] > work); --i)
-		;
-	r->tm_mon = i;
-	r->tm_mday += work - __spm[i];
-	return r;
+	nEra = nYear / 400;
+	nYoe = nYear - nEra * 400;
+	nDoy = (153 * nMon + 2) / 5 + nDay - 1;
+	return nEra * 146097 + nYoe * 365 + nYoe / 4 - nYoe / 100 + nDoy - TIME_DAYS_0000_1970;
 }
 
-struct tm* localtime_r(const time_t* t, struct tm* r)
+//-------------------------------------------------------------------------
+//1970-01-01תΪ,ص11
+//-------------------------------------------------------------------------
+static int time_Civil4Days(u32 nDays, int *pYear, int *pMon, int *pDay)
 {
-
-	return gmtime_r(t, r);
+	u32 nEra, nDoe, nYoe, nDoy, nMp;
+
+	nDays += TIME_DAYS_0000_1970;
+	nEra = nDays / 146097;
+	nDoe = nDays - nEra * 146097;
+	nYoe = (nDoe - nDoe / 1460 + nDoe / 36524 - nDoe / 146096) / 365;
+	nDoy = nDoe - (nYoe * 365 + nYoe / 4 - nYoe / 100);
+	nMp = (5 * nDoy + 2) / 153;
+	*pDay = nDoy - (153 * nMp + 2) / 5 + 1;
+	*pYear = nEra * 400 + nYoe;
+	if (nMp < 10)
+	{
+		*pMon = nMp + 3;
+		//31
+		return nDoy + 59 + time_IsLeap(*pYear);
+	}
+	*pMon = nMp - 9;
+	*pYear += 1;
+	return nDoy - 306;
 }
 
-time_t mktime(struct tm * const t)
+//-------------------------------------------------------------------------
+//ֶοԳΧ,·ݴ0ʼ
+//1970-01-01򳬳time_tΧʱ-1
+//-------------------------------------------------------------------------
+static time_t time_Make(int nYear, int nMon, int nDay, int nHour, int nMin, int nSec)
 {
-	register time_t day;
-	register time_t i;
-	register time_t years = t->tm_year - 70;
+	s64 nTime;
+	int nTemp;
 
-	if (t->tm_sec > 60)
+	if ((nMon < 0) || (nMon > 11))
 	{
-		t->tm_min += t->tm_sec / 60;
-		t->tm_sec %= 60;
-	}
-	if (t->tm_min > 60)
-	{
-		t->tm_hour += t->tm_min / 60;
-		t->tm_min %= 60;
-	}
-	if (t->tm_hour > 24)
-	{
-		t->tm_mday += t->tm_hour / 24;
-		t->tm_hour %= 24;
-	}
-	if (t->tm_mon > 12)
-	{
-		t->tm_year += t->tm_mon / 12;
-		t->tm_mon %= 12;
-	}
-	while (t->tm_mday > __spm[1 + t->tm_mon])
-	{
-		if (t->tm_mon == 1 && __isleap(t->tm_year + 1900))
-		{
-			--t->tm_mday;
-		}
-		t->tm_mday -= __spm[t->tm_mon];
-		++t->tm_mon;
-		if (t->tm_mon > 11)
-		{
-			t->tm_mon = 0;
-			++t->tm_year;
-		}
+		nTemp = nMon / 12;
+		if ((nMon % 12) < 0)
+			nTemp -= 1;
+		nYear += nTemp;
+		nMon -= nTemp * 12;
 	}
+	//ռʱܰ1970ڴ1969,зж
+	if (nYear < 1900)
+		return (time_t)-1;
 
-	if (t->tm_year < 70)
-		return (time_t) -1;
+	nTime = (s64)((s32)time_Days4Civil(nYear, nMon + 1, 1) + nDay - 1) * TIME_SPD
+			+ (s64)nHour * 3600 + (s64)nMin * 60 + nSec;
+	if ((nTime < 0) || ((s64)(time_t)nTime != nTime))
+		return (time_t)-1;
+
+	return (time_t)nTime;
+}
 
-	/* Days since 1970 is 365 * number of years + number of leap years since 1970 */
-	day = years * 365 + (years + 1) / 4;
 
-	/* After 2100 we have to substract 3 leap years for every 400 years
-	 This is not intuitive. Most mktime implementations do not support
-	 dates after 2059, anyway, so we might leave this out for it's
-	 bloat. */
-	if (years >= 131)
-	{
-		years -= 131;
-		years /= 100;
-		day -= (years >> 2) * 3 + 1;
-		if ((years &= 3) == 3)
-			years--;
-		day -= years;
-	}
 
-	day += t->tm_yday = __spm[t->tm_mon] + t->tm_mday - 1 +
-			(__isleap(t->tm_year + 1900) & (t->tm_mon > 1));
+//External Functions
+#if LIB_MINILIBC_ENABLE
+int __isleap(int year)
+{
 
-	/* day is now the number of days since 'Jan 1 1970' */
-	i = 7;
-	t->tm_wday = (day + 4) % i; /* Sunday=0, Monday=1, ..., Saturday=6 */
+	return time_IsLeap(year);
+}
 
-	i = 24;
-	day *= i;
-	i = 60;
-	return ((day + t->tm_hour) * i + t->tm_min) * i + t->tm_sec;
+struct tm *gmtime_r(const time_t *timep, struct tm *r)
+{
+	u32 nDays, nSec;
+
+	nDays = *timep / TIME_SPD;
+	nSec = *timep - (time_t)nDays * TIME_SPD;
+	r->tm_hour = nSec / 3600;
+	nSec -= r->tm_hour * 3600;
+	r->tm_min = nSec / 60;
+	r->tm_sec = nSec - r->tm_min * 60;
+	r->tm_wday = (4 + nDays) % 7;
+	r->tm_yday = time_Civil4Days(nDays, &r->tm_year, &r->tm_mon, &r->tm_mday);
+	r->tm_year -= 1900;
+	r->tm_mon -= 1;
+	return r;
+}
+
+struct tm* localtime_r(const time_t* t, struct tm* r)
+{
+
+	return gmtime_r(t, r);
+}
+
+time_t mktime(struct tm * const t)
+{
+	time_t tTime;
+
+	tTime = time_Make(t->tm_year + 1900, t->tm_mon, t->tm_mday, t->tm_hour, t->tm_min, t->tm_sec);
+	if (tTime != (time_t)-1)
+		gmtime_r(&tTime, t);
+	return tTime;
 }
 #endif
 
@@ -152,52 +141,43 @@ time_t mktime(struct tm * const t)
 //-------------------------------------------------------------------------
 time_t array2timet(u8 *p, int nIsBcd)
 {
-	struct tm tmTime;
 
 	if (nIsBcd)
-	{
-		tmTime.tm_sec = bcd2bin8(*p++);
-		tmTime.tm_min = bcd2bin8(*p++);
-		tmTime.tm_hour = bcd2bin8(*p++);
-		tmTime.tm_mday = bcd2bin8(*p++);
-		tmTime.tm_mon = bcd2bin8(*p++) - 1;
-		tmTime.tm_year = bcd2bin8(*p) + 100;
-	}
-	else
-	{
-		tmTime.tm_sec = *p++;
-		tmTime.tm_min = *p++;
-		tmTime.tm_hour = *p++;
-		tmTime.tm_mday = *p++;
-		tmTime.tm_mon = *p++ - 1;
-		tmTime.tm_year = *p + 100;
-	}
-	
-	return mktime(&tmTime);
+		return time_Make(2000 + bcd2bin8(p[5]), bcd2bin8(p[4]) - 1, bcd2bin8(p[3]),
+						bcd2bin8(p[2]), bcd2bin8(p[1]), bcd2bin8(p[0]));
+	return time_Make(2000 + p[5], p[4] - 1, p[3], p[2], p[1], p[0]);
 }
 
 int timet2array(time_t tTime, u8 *p, int nIsBcd)
 {
-	struct tm tmTime;
-
-	localtime_r(&tTime, &tmTime);
+	u32 nDays, nSec;
+	int nYear, nMon, nDay, nHour, nMin;
+
+	nDays = tTime / TIME_SPD;
+	nSec = tTime - (time_t)nDays * TIME_SPD;
+	nHour = nSec / 3600;
+	nSec -= nHour * 3600;
+	nMin = nSec / 60;
+	nSec -= nMin * 60;
+	time_Civil4Days(nDays, &nYear, &nMon, &nDay);
+	nYear -= 2000;
 	if (nIsBcd)
 	{
-		*p++ = bin2bcd8(tmTime.tm_sec);
-		*p++ = bin2bcd8(tmTime.tm_min);
-		*p++ = bin2bcd8(tmTime.tm_hour);
-		*p++ = bin2bcd8(tmTime.tm_mday);
-		*p++ = bin2bcd8(tmTime.tm_mon + 1);
-		*p = bin2bcd8(tmTime.tm_year - 100);
+		*p++ = bin2bcd8(nSec);
+		*p++ = bin2bcd8(nMin);
+		*p++ = bin2bcd8(nHour);
+		*p++ = bin2bcd8(nDay);
+		*p++ = bin2bcd8(nMon);
+		*p = bin2bcd8(nYear);
 	}
 	else
 	{
-		*p++ = tmTime.tm_sec;
-		*p++ = tmTime.tm_min;
-		*p++ = tmTime.tm_hour;
-		*p++ = tmTime.tm_mday;
-		*p++ = tmTime.tm_mon + 1;
-		*p = tmTime.tm_year - 100;
+		*p++ = nSec;
+		*p++ = nMin;
+		*p++ = nHour;
+		*p++ = nDay;
+		*p++ = nMon;
+		*p = nYear;
 	}
 	
 	return 1;
@@ -206,10 +186,7 @@ int timet2array(time_t tTime, u8 *p, int nIsBcd)
 time_t getday0(time_t tTime)
 {
 	
-	tTime /= (3600 * 24);
-	tTime *= (3600 * 24);
-	
-	return tTime;
+	return tTime - tTime % TIME_SPD;
 }
 
 time_t getmin0(time_t tTime)
@@ -290,29 +267,29 @@ void prevmonth(u8 *p, int nIsBcd)
 void month4timet(time_t tTime, int nMon, u8 *p, int nIsBcd)
 {
 	u8 aTime[6];
-	int i;
+	int nTemp;
 
- 	timet2array(tTime, aTime, nIsBcd);
-	
-	if (nMon < 0)
+ 	timet2array(tTime, aTime, 0);
+
+	//ֱӼӼ
+	nMon += aTime[5] * 12 + aTime[4] - 1;
+	nTemp = nMon / 12;
+	if ((nMon % 12) < 0)
+		nTemp -= 1;
+	nMon -= nTemp * 12;
+	if (nIsBcd)
 	{
- 		nMon = -nMon;
- 		for (i = 0; i < nMon; i++)
-		{
-			prevmonth(&aTime[4], nIsBcd);
- 		}
- 		memcpy(p, &aTime[4], 2);
+		p[0] = bin2bcd8(nMon + 1);
+		p[1] = bin2bcd8(nTemp);
 	}
 	else
 	{
-		for (i = 0; i < nMon; i++)
-		{
-			nextmonth(&aTime[4], nIsBcd);
-		}
-		memcpy(p, &aTime[4], 2);
+		p[0] = nMon + 1;
+		p[1] = nTemp;
 	}
 }
 
 
 
 
+
@@ -6,6 +6,9 @@
 #include <lib/bcd.c>
 #include <lib/ecc.c>
 #include <lib/math.c>
+#if LIB_FFT_ENABLE
+#include <lib/fft.c>
+#endif
 #include <lib/string.c>
 #include <lib/time.c>
 
@@ -43,6 +43,9 @@ extern "C" {
 #include "bsp_cfg.h"
 
 #include <lib/lib.h>
+#if LIB_FFT_ENABLE
+#include <lib/fft.h>
+#endif
 
 #include <lib/memory.h>
 #if LIB_ZIP_ENABLE
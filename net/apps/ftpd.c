@@ -12,7 +12,21 @@
 #define FTP_USER			"rtt"
 #define FTP_PASSWORD		"demo"
 #define FTP_WELCOME_MSG		"220-= welcome on RT-Thread FTP server =-\r\n220 \r\n"
-#define FTP_BUFFER_SIZE		256
+#define FTP_BUFFER_SIZE		256		/* control connection */
+
+/* data connection buffer, each transfer uses two of them */
+#ifndef FTP_DATA_BUFSIZE
+#define FTP_DATA_BUFSIZE	2048
+#endif
+/* transfer worker threads, 0 to transfer in the ftpd thread */
+#ifndef FTP_WORKERS
+#define FTP_WORKERS			2
+#endif
+
+#define FTP_XFER_RETR		1
+#define FTP_XFER_STOR		2
+#define FTP_XFER_LIST		3
+#define FTP_XFER_NLST		4
 
 struct ftp_session
 {
@@ -31,18 +45,33 @@ struct ftp_session
 	/* current directory */
 	char currentdir[256];
 
+	/* data transfer handed to a worker, control requests wait for it */
+	volatile char busy;
+	char waiting;		/* a request came in during the transfer */
+	char xfer;
+	int  xfer_fd;
+
 	struct ftp_session* next;
 };
 static struct ftp_session* session_list = NULL;
 
 int ftp_process_request(struct ftp_session* session, char * buf);
 int ftp_get_filesize(char *filename);
+int do_list(char* directory, int sockfd, char *buf);
+int do_simple_list(char* directory, int sockfd, char *buf);
+
+#if FTP_WORKERS
+static rt_mailbox_t ftp_jobs;
+static rt_sem_t ftp_idle;	/* one count per worker waiting for a job */
+#endif
 
 struct ftp_session* ftp_new_session()
 {
 	struct ftp_session* session;
 
 	session = (struct ftp_session*)mem_Malloc(sizeof(struct ftp_session));
+	if (session == NULL) return NULL;
+	memset(session, 0, sizeof(struct ftp_session));
 
 	session->next = session_list;
 	session_list = session;
@@ -113,12 +142,162 @@ int build_full_path(struct ftp_session* session, char* path, char* new_path, siz
 	return 0;
 }
 
+/*
+ * File to data connection. While the stack drains one block the next
+ * one is read into the other buffer.
+ */
+static int ftp_send_file(int fd, int sockfd, char *buf[2])
+{
+	int cur = 0, pos, len, next = 0, n;
+	rt_bool_t ahead = RT_FALSE;
+
+	len = read(fd, buf[0], FTP_DATA_BUFSIZE);
+	while (len > 0)
+	{
+		for (pos = 0; pos < len; pos += n)
+		{
+			n = send(sockfd, buf[cur] + pos, len - pos, ahead ? 0 : MSG_DONTWAIT);
+			if (n > 0) continue;
+			if (ahead || errno != EWOULDBLOCK)
+				return -1;
+
+			/* send buffer full, read ahead meanwhile */
+			next = read(fd, buf[cur ^ 1], FTP_DATA_BUFSIZE);
+			ahead = RT_TRUE;
+			n = 0;
+		}
+
+		cur ^= 1;
+		len = ahead ? next : read(fd, buf[cur], FTP_DATA_BUFSIZE);
+		ahead = RT_FALSE;
+	}
+
+	return len;
+}
+
+/*
+ * Data connection to file in whole buffers, the stack keeps receiving
+ * into its window while a buffer is written.
+ */
+static int ftp_recv_file(int fd, int sockfd, char *buf)
+{
+	struct timeval tv;
+	fd_set readfds;
+	int len = 0, n;
+
+	for (;;)
+	{
+		tv.tv_sec = 3, tv.tv_usec = 0;
+		FD_ZERO(&readfds);
+		FD_SET(sockfd, &readfds);
+		if (select(sockfd + 1, &readfds, 0, 0, &tv) <= 0)
+			return -1;
+
+		n = recv(sockfd, buf + len, FTP_DATA_BUFSIZE - len, 0);
+		if (n < 0) return -1;
+		if (n == 0) break;
+
+		len += n;
+		if (len == FTP_DATA_BUFSIZE)
+		{
+			if (write(fd, buf, len) != len) return -1;
+			len = 0;
+		}
+	}
+
+	if (len > 0 && write(fd, buf, len) != len) return -1;
+	return 0;
+}
+
+/* run the data transfer prepared by ftp_process_request */
+static void ftp_transfer(struct ftp_session* session, char *buf[2])
+{
+	char reply[48];
+	int result = -1;
+	int sockfd = session->sockfd;
+
+	if (buf[0] != NULL)
+	{
+		switch (session->xfer)
+		{
+		case FTP_XFER_RETR:
+			result = ftp_send_file(session->xfer_fd, session->pasv_sockfd, buf);
+			break;
+		case FTP_XFER_STOR:
+			result = ftp_recv_file(session->xfer_fd, session->pasv_sockfd, buf[0]);
+			break;
+		case FTP_XFER_LIST:
+			result = do_list(session->currentdir, session->pasv_sockfd, buf[0]);
+			break;
+		case FTP_XFER_NLST:
+			result = do_simple_list(session->currentdir, session->pasv_sockfd, buf[0]);
+			break;
+		}
+	}
+
+	if (session->xfer == FTP_XFER_RETR || session->xfer == FTP_XFER_STOR)
+		close(session->xfer_fd);
+	closesocket(session->pasv_sockfd);
+	session->pasv_active = 0;
+
+	if (result < 0)
+		rt_sprintf(reply, "426 Transfer aborted.\r\n");
+	else if (session->xfer == FTP_XFER_LIST || session->xfer == FTP_XFER_NLST)
+		rt_sprintf(reply, "226 Transfert Complete.\r\n");
+	else
+		rt_sprintf(reply, "226 Finished.\r\n");
+
+	send(sockfd, reply, strlen(reply), 0);
+	/* the session is the ftpd thread's again once the reply is out */
+	session->busy = 0;
+}
+
+#if FTP_WORKERS
+void ftp_worker_entry(void* parameter)
+{
+	struct ftp_session* session;
+	char *buf[2];
+
+	buf[0] = (char *) mem_Malloc(2 * FTP_DATA_BUFSIZE);
+	buf[1] = buf[0] + FTP_DATA_BUFSIZE;
+
+	for (;;)
+	{
+		rt_sem_release(ftp_idle);
+		if (rt_mb_recv(ftp_jobs, (rt_uint32_t *)&session, RT_WAITING_FOREVER) == RT_EOK)
+			ftp_transfer(session, buf);
+	}
+}
+#endif
+
+/* hand the transfer to an idle worker, or do it here if none is free */
+static void ftp_dispatch(struct ftp_session* session)
+{
+	char *buf[2];
+
+	session->busy = 1;
+#if FTP_WORKERS
+	if (ftp_jobs != RT_NULL && rt_sem_take(ftp_idle, RT_WAITING_NO) == RT_EOK)
+	{
+		/* an idle worker is blocked on the mailbox, so it has room */
+		rt_mb_send(ftp_jobs, (rt_uint32_t)session);
+		return;
+	}
+#endif
+
+	buf[0] = (char *) mem_Malloc(2 * FTP_DATA_BUFSIZE);
+	buf[1] = buf[0] + FTP_DATA_BUFSIZE;
+	ftp_transfer(session, buf);
+	if (buf[0] != NULL) rt_free(buf[0]);
+}
+
 void ftpd_thread_entry(void* parameter)
 {
 	int numbytes;
 	int sockfd, maxfdp1;
 	struct sockaddr_in local;
-	fd_set readfds, tmpfds;
+	fd_set readfds;
+	struct timeval tv, *ptv;
 	struct ftp_session* session;
 	u32_t addr_len = sizeof(struct sockaddr);
 	char * buffer = (char *) mem_Malloc(FTP_BUFFER_SIZE);
@@ -127,9 +306,6 @@ void ftpd_thread_entry(void* parameter)
 	local.sin_family=PF_INET;
 	local.sin_addr.s_addr=INADDR_ANY;
 
-	FD_ZERO(&readfds);
-	FD_ZERO(&tmpfds);
-
 	sockfd=socket(AF_INET, SOCK_STREAM, 0);
 	if(sockfd < 0)
 	{
@@ -140,25 +316,35 @@ void ftpd_thread_entry(void* parameter)
 	bind(sockfd, (struct sockaddr *)&local, addr_len);
 	listen(sockfd, FTP_MAX_CONNECTION);
 
-	FD_SET(sockfd, &readfds);
 	for(;;)
 	{
-	    /* get maximum fd */
-	    maxfdp1 = sockfd + 1;
-        session = session_list;
-	    while (session != RT_NULL)
-	    {
-	        if (maxfdp1 < session->sockfd + 1)
-                maxfdp1 = session->sockfd + 1;
+		FD_ZERO(&readfds);
+		FD_SET(sockfd, &readfds);
 
-            FD_SET(session->sockfd, &readfds);
-            session = session->next;
-	    }
+		/* get maximum fd */
+		maxfdp1 = sockfd + 1;
+		ptv = RT_NULL;
+		session = session_list;
+		while (session != RT_NULL)
+		{
+			if (session->busy && session->waiting)
+			{
+				/* poll for the end of its transfer */
+				tv.tv_sec = 0, tv.tv_usec = 100000;
+				ptv = &tv;
+			}
+			else
+			{
+				if (maxfdp1 < session->sockfd + 1)
+					maxfdp1 = session->sockfd + 1;
+				FD_SET(session->sockfd, &readfds);
+			}
+			session = session->next;
+		}
 
-		tmpfds=readfds;
-		if (select(maxfdp1, &tmpfds, 0, 0, 0) == 0) continue;
+		if (select(maxfdp1, &readfds, 0, 0, ptv) <= 0) continue;
 
-		if(FD_ISSET(sockfd, &tmpfds))
+		if(FD_ISSET(sockfd, &readfds))
 		{
 			int com_socket;
 			struct sockaddr_in remote;
@@ -173,7 +359,6 @@ void ftpd_thread_entry(void* parameter)
 			{
 				rt_kprintf("Got connection from %s\n", inet_ntoa(remote.sin_addr));
 				send(com_socket, FTP_WELCOME_MSG, strlen(FTP_WELCOME_MSG), 0);
-				FD_SET(com_socket, &readfds);
 
 				/* new session */
 				session = ftp_new_session();
@@ -183,6 +368,10 @@ void ftpd_thread_entry(void* parameter)
 					session->sockfd = com_socket;
 					session->remote = remote;
 				}
+				else
+				{
+					closesocket(com_socket);
+				}
 			}
 		}
 
@@ -193,13 +382,17 @@ void ftpd_thread_entry(void* parameter)
 			while (session != NULL)
 			{
 				next = session->next;
-				if (FD_ISSET(session->sockfd, &tmpfds))
+				if (FD_ISSET(session->sockfd, &readfds) && session->busy)
+				{
+					session->waiting = 1;
+				}
+				else if (FD_ISSET(session->sockfd, &readfds))
 				{
-					numbytes=recv(session->sockfd, buffer, FTP_BUFFER_SIZE, 0);
+					session->waiting = 0;
+					numbytes=recv(session->sockfd, buffer, FTP_BUFFER_SIZE - 1, 0);
 					if(numbytes==0 || numbytes==-1)
 					{
 						rt_kprintf("Client %s disconnected\n", inet_ntoa(session->remote.sin_addr));
-						FD_CLR(session->sockfd, &readfds);
 						closesocket(session->sockfd);
 						ftp_close_session(session);
 					}
@@ -223,11 +416,26 @@ void ftpd_thread_entry(void* parameter)
 	// rt_free(buffer);
 }
 
-int do_list(char* directory, int sockfd)
+/* send the listing in FTP_DATA_BUFSIZE batches rather than per line */
+static int list_put(int sockfd, char *buf, int *length, char *line, int line_length)
+{
+	if (*length + line_length > FTP_DATA_BUFSIZE)
+	{
+		if (send(sockfd, buf, *length, 0) != *length) return -1;
+		*length = 0;
+	}
+	memcpy(buf + *length, line, line_length);
+	*length += line_length;
+
+	return 0;
+}
+
+int do_list(char* directory, int sockfd, char *buf)
 {
 	DIR_POSIX* dirp;
 	struct dirent* entry;
-	char line_buffer[256], line_length;
+	char line_buffer[256];
+	int line_length, length = 0, result = 0;
 #ifdef _WIN32
 	struct _stat s;
 #else
@@ -247,7 +455,7 @@ int do_list(char* directory, int sockfd)
 		entry = readdir(dirp);
 		if (entry == NULL) break;
 
-		rt_sprintf(line_buffer, "%s/%s", directory, entry->d_name);
+		rt_snprintf(line_buffer, sizeof(line_buffer), "%s/%s", directory, entry->d_name);
 #ifdef _WIN32
 		if (_stat(line_buffer, &s) ==0)
 #else
@@ -255,11 +463,15 @@ int do_list(char* directory, int sockfd)
 #endif
 		{
 			if (s.st_mode & S_IFDIR)
-				line_length = rt_sprintf(line_buffer, "drw-r--r-- 1 admin admin %d Jan 1 2000 %s\r\n", 0, entry->d_name);
+				line_length = rt_snprintf(line_buffer, sizeof(line_buffer), "drw-r--r-- 1 admin admin %d Jan 1 2000 %s\r\n", 0, entry->d_name);
 			else
-				line_length = rt_sprintf(line_buffer, "-rw-r--r-- 1 admin admin %d Jan 1 2000 %s\r\n", s.st_size, entry->d_name);
+				line_length = rt_snprintf(line_buffer, sizeof(line_buffer), "-rw-r--r-- 1 admin admin %d Jan 1 2000 %s\r\n", s.st_size, entry->d_name);
 
-			send(sockfd, line_buffer, line_length, 0);
+			if (list_put(sockfd, buf, &length, line_buffer, line_length) < 0)
+			{
+				result = -1;
+				break;
+			}
 		}
 		else
 		{
@@ -268,15 +480,19 @@ int do_list(char* directory, int sockfd)
 		}
 	}
 
+	if (result == 0 && length > 0 && send(sockfd, buf, length, 0) != length)
+		result = -1;
+
 	closedir(dirp);
-	return 0;
+	return result;
 }
 
-int do_simple_list(char* directory, int sockfd)
+int do_simple_list(char* directory, int sockfd, char *buf)
 {
 	DIR_POSIX* dirp;
 	struct dirent* entry;
-	char line_buffer[256], line_length;
+	char line_buffer[256];
+	int line_length, length = 0, result = 0;
 
 	dirp = opendir(directory);
 	if (dirp == NULL)
@@ -291,12 +507,19 @@ int do_simple_list(char* directory, int sockfd)
 		entry = readdir(dirp);
 		if (entry == NULL) break;
 
-		line_length = rt_sprintf(line_buffer, "%s\r\n", entry->d_name);
-		send(sockfd, line_buffer, line_length, 0);
+		line_length = rt_snprintf(line_buffer, sizeof(line_buffer), "%s\r\n", entry->d_name);
+		if (list_put(sockfd, buf, &length, line_buffer, line_length) < 0)
+		{
+			result = -1;
+			break;
+		}
 	}
 
+	if (result == 0 && length > 0 && send(sockfd, buf, length, 0) != length)
+		result = -1;
+
 	closedir(dirp);
-	return 0;
+	return result;
 }
 
 int str_begin_with(char* src, char* match)
@@ -319,7 +542,6 @@ int ftp_process_request(struct ftp_session* session, char *buf)
 	struct timeval tv;
 	fd_set readfds;
 	char filename[256];
-	int  numbytes;
 	char *sbuf;
 	char *parameter_ptr, *ptr;
 	u32_t addr_len = sizeof(struct sockaddr_in);
@@ -397,22 +619,16 @@ int ftp_process_request(struct ftp_session* session, char *buf)
 		memset(sbuf,0,FTP_BUFFER_SIZE);
 		rt_sprintf(sbuf, "150 Opening Binary mode connection for file list.\r\n");
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		do_list(session->currentdir, session->pasv_sockfd);
-		closesocket(session->pasv_sockfd);
-		session->pasv_active = 0;
-		rt_sprintf(sbuf, "226 Transfert Complete.\r\n");
-		send(session->sockfd, sbuf, strlen(sbuf), 0);
+		session->xfer = FTP_XFER_LIST;
+		ftp_dispatch(session);
 	}
 	else if(str_begin_with(buf, "NLST")==0 )
 	{
 		memset(sbuf, 0, FTP_BUFFER_SIZE);
 		rt_sprintf(sbuf, "150 Opening Binary mode connection for file list.\r\n");
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		do_simple_list(session->currentdir, session->pasv_sockfd);
-		closesocket(session->pasv_sockfd);
-		session->pasv_active = 0;
-		rt_sprintf(sbuf, "226 Transfert Complete.\r\n");
-		send(session->sockfd, sbuf, strlen(sbuf), 0);
+		session->xfer = FTP_XFER_NLST;
+		ftp_dispatch(session);
 	}
 	else if(str_begin_with(buf, "PWD")==0 || str_begin_with(buf, "XPWD")==0)
 	{
@@ -536,14 +752,9 @@ err1:
 			rt_sprintf(sbuf, "150 Opening binary mode data connection for \"%s\" (%d bytes).\r\n", filename, file_size);
 		}
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		while((numbytes = read(fd, sbuf, FTP_BUFFER_SIZE))>0)
-		{
-			send(session->pasv_sockfd, sbuf, numbytes, 0);
-		}
-		rt_sprintf(sbuf, "226 Finished.\r\n");
-		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		close(fd);
-		closesocket(session->pasv_sockfd);
+		session->xfer = FTP_XFER_RETR;
+		session->xfer_fd = fd;
+		ftp_dispatch(session);
 	}
 	else if (str_begin_with(buf, "STOR")==0)
 	{
@@ -567,32 +778,9 @@ err1:
 		}
 		rt_sprintf(sbuf, "150 Opening binary mode data connection for \"%s\".\r\n", filename);
 		send(session->sockfd, sbuf, strlen(sbuf), 0);
-		FD_ZERO(&readfds);
-		FD_SET(session->pasv_sockfd, &readfds);
-		rt_kprintf("Waiting %d seconds for data...\n", tv.tv_sec);
-		while(select(session->pasv_sockfd+1, &readfds, 0, 0, &tv)>0 )
-		{
-			if((numbytes=recv(session->pasv_sockfd, sbuf, FTP_BUFFER_SIZE, 0))>0)
-			{
-				write(fd, sbuf, numbytes);
-			}
-			else if(numbytes==0)
-			{
-				close(fd);
-				closesocket(session->pasv_sockfd);
-				rt_sprintf(sbuf, "226 Finished.\r\n");
-				send(session->sockfd, sbuf, strlen(sbuf), 0);
-				break;
-			}
-			else if(numbytes==-1)
-			{
-				close(fd);
-				closesocket(session->pasv_sockfd);
-				rt_free(sbuf);
-				return -1;
-			}
-		}
-		closesocket(session->pasv_sockfd);
+		session->xfer = FTP_XFER_STOR;
+		session->xfer_fd = fd;
+		ftp_dispatch(session);
 	}
 	else if(str_begin_with(buf, "SIZE")==0)
 	{
@@ -784,6 +972,24 @@ void ftpd_start()
 		ftpd_thread_entry, RT_NULL,
 		4096, 30, 5);
 	if (tid != RT_NULL) rt_thread_startup(tid);
+#endif
+#if FTP_WORKERS
+	int i;
+
+	/* without the pool every transfer runs in the ftpd thread */
+	ftp_idle = rt_sem_create("ftpi", 0, RT_IPC_FLAG_FIFO);
+	ftp_jobs = rt_mb_create("ftpd", FTP_WORKERS, RT_IPC_FLAG_FIFO);
+	if (ftp_idle != RT_NULL && ftp_jobs != RT_NULL)
+	{
+		for (i = 0; i < FTP_WORKERS; i++)
+			sys_thread_new("ftpw", ftp_worker_entry, RT_NULL, 2048, 30);
+	}
+	else
+	{
+		if (ftp_idle != RT_NULL) rt_sem_delete(ftp_idle);
+		if (ftp_jobs != RT_NULL) rt_mb_delete(ftp_jobs);
+		ftp_jobs = RT_NULL;
+	}
 #endif
 	sys_thread_new("ftpd", ftpd_thread_entry, RT_NULL, 2048, 30);
 }
@@ -1,35 +1,8 @@
 
 
 
-static u16 chksum(u16 sum, const void *data, size_t len)
-{
-	u16 t;
-	const u8 *dataptr;
-	const u8 *last_byte;
-
-	dataptr = (u8 *)data;
-	last_byte = (u8 *)data + len - 1;
-  
-	while (dataptr < last_byte)	/* At least two more bytes */
-	{
-		t = (dataptr[0] << 8) + dataptr[1];
-		sum += t;
-		if (sum < t)
-			sum++;		/* carry */
-		dataptr += 2;
-	}
-
-	if (dataptr == last_byte)
-	{
-		t = (dataptr[0] << 8);
-		sum += t;
-		if (sum < t)
-			sum++;		/* carry */
-	}
-
-	/* Return sum in host byte order. */
-	return (u16)sum;
-}
+//Word-at-a-time core shared with uip, lib/ecc.c
+#define chksum(sum, data, len)	ipcs(sum, data, len)
 
 static u16 ipchksum()
 {
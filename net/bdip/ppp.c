@@ -40,27 +40,68 @@ u32 HTONL(u32 n)
 //-------------------------------------------------------------------------
 //Point-to-point
 //-------------------------------------------------------------------------
-#define PPP_MRU					1500
+//MRU,СͬʱСշת建,1500ʱLCPͨ
+#ifndef ATSVR_PPP_MRU
+#define ATSVR_PPP_MRU			1500
+#endif
+#define PPP_MRU					ATSVR_PPP_MRU
 
 #define PPP_PROCLEN				2
 #define PPP_HDRLEN				4       /* octets for code flag and len */
 #define PPP_FCSLEN				2       /* octets for FCS */
 
 #define PPP_GOODFCS				0xF0B8  /* Good final FCS value */
-#define PPP_INITFCS				0x3DE3
+#define PPP_INITFCS				0x3DE3	/* FCS after address and control */
+#define PPP_RESETFCS			0xFFFF
+
+/* Receive decoder states */
+#define PPP_S_HUNT				0
+#define PPP_S_FRAME				1
+#define PPP_S_ESCAPE			2
 
 
 //Const Variables
 static const u8 PPP_ESCAPE = 0x7D;
 static const u8 PPP_HEFLAG = 0x7E;
 static const u8 PPP_HEADER4[] = {0x7E, 0xFF, 0x7D, 0x23};
-static const u8 PPP_HEADER5[] = {0x7E, 0x7D, 0xDF, 0x7D, 0x23};
+static const u8 PPP_ACF[] = {0xFF, 0x03};
 static const u8 PPP_MAGIC[] = {0x83, 0x23, 0x45, 0x34};
 static const u8 PPP_IPADDRESS[] = {0xC0, 0xA8, 0xFE, 0xFE};
 
+/* Async control character map, 1 = sent escaped */
+static const u8 tbl_pppAccm[256] = {
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
 //Private Variables
 static u8 ppprbuf[PPP_PROCLEN + PPP_MRU + PPP_FCSLEN];
 static u8 ppptbuf[PPP_PROCLEN + PPP_MRU + PPP_FCSLEN];
+/* Escaped frame: header, protocol + MRU + FCS all escaped, closing flag */
+static u8 ppphbuf[sizeof(PPP_HEADER4) + 2 * (PPP_PROCLEN + PPP_MRU + PPP_FCSLEN) + 1];
+
+struct ppp_rx
+{
+	u8	ste;
+	u8	acf;		/* address and control bytes examined */
+	u16	len;
+	u16	fcs;
+};
+static struct ppp_rx ppp_xRx;
 
 
 struct pppcp_header
@@ -118,6 +159,21 @@ static struct ip_header ipt_header;
 
 #define TCP_MSS					(PPP_MRU - IPTCPH_LEN)
 
+#ifndef ATSVR_TCP_WND_QTY
+#define ATSVR_TCP_WND_QTY		4		//segments in flight
+#endif
+#ifndef ATSVR_TCP_RTO
+#define ATSVR_TCP_RTO			1000	//initial retransmission timeout, ms
+#endif
+#ifndef ATSVR_TCP_ACK_DELAY
+#define ATSVR_TCP_ACK_DELAY		200		//ms
+#endif
+
+#define TCP_WND					(TCP_MSS * ATSVR_TCP_WND_QTY)
+#define TCP_RTO_MIN				(200 / OS_TICK_MS)
+#define TCP_RTO_MAX				(8000 / OS_TICK_MS)
+#define TCP_ACK_TICK			(ATSVR_TCP_ACK_DELAY / OS_TICK_MS)
+
 /* Structures and definitions. */
 #define TCP_FIN					0x01
 #define TCP_SYN					0x02
@@ -134,10 +190,23 @@ static struct ip_header ipt_header;
 //Const Variables
 static const u8 TCP_CONST_OPTMSS[] = {0x02, 0x04, 0x05, 0xB4};
 
+/* Unacknowledged segment, payload stays at the head of AT->tbuf */
+struct tcp_seg
+{
+	u16	len;
+	u8	retx;
+	u32	tick;
+};
+
 //Private Variables
 static u16 tcp_ss = TCP_MSS;
-static u32 tcp_seq, tcp_ack;
+static u32 tcp_seq, tcp_ack;		/* tcp_seq is the oldest unacknowledged */
 static int tcp_linked = 0;
+static u16 tcp_wnd, tcp_flight, tcp_rexmit;
+static u8 tcp_segh, tcp_segn, tcp_ackn, tcp_dupn;
+static u32 tcp_acktick;
+static int tcp_srtt, tcp_rttvar, tcp_rto;
+static struct tcp_seg tcp_xSeg[ATSVR_TCP_WND_QTY];
 
 /* TCP header. */
 struct tcp_header
@@ -200,6 +269,13 @@ static struct udp_header udpt_header;
 
 
 
+//˳PPPģʽʱλ֡״̬,ضϵ֡
+static void ppp_reset()
+{
+
+	ppp_xRx.ste = PPP_S_HUNT;
+}
+
 static void cp_output(int len)
 {
 
@@ -315,7 +391,15 @@ static void lcp_input()
 		PCPT->data[0] = 0x02;
 		PCPT->data[1] = 0x06;
 		memset(&PCPT->data[2], 0xFF, 4);
+#if ATSVR_PPP_MRU != 1500
+		PCPT->data[6] = 0x01;		//MRU
+		PCPT->data[7] = 0x04;
+		PCPT->data[8] = PPP_MRU >> 8;
+		PCPT->data[9] = PPP_MRU & 0xFF;
+		cp_output(10);
+#else
 		cp_output(6);
+#endif
 		break;
 
 	//ֹ·
@@ -324,6 +408,7 @@ static void lcp_input()
 		cp_output(0);
 
 		AT->ppp = 0;
+		ppp_reset();
 		break;
 
 	//·ά
@@ -420,50 +505,47 @@ static void ppp_input(int proto)
 //PPPת
 void ppp_output(int len)
 {
-	u8 *p, *end, c;
+	u8 *p, *end, *run, *out;
 	u16 fcs;
-	buf b = {0};
 
 	end = ppptbuf + len;
 	fcs = ~(fcs16(PPP_INITFCS, ppptbuf, len));
 	end = ptrcpy(end, &fcs, PPP_FCSLEN);
 
-	buf_Push(b, PPP_HEADER4, 4);
-
+	//תο
+	out = ptrcpy(ppphbuf, PPP_HEADER4, sizeof(PPP_HEADER4));
 	for (p = ppptbuf; p < end; )
 	{
-		c = *p++;
-		if ((c < 0x20) || (c == PPP_ESCAPE) || (c == PPP_HEFLAG))
+		for (run = p; (p < end) && (tbl_pppAccm[*p] == 0); p++);
+		out = ptrcpy(out, run, p - run);
+
+		if (p < end)
 		{
-			buf_Push(b, &PPP_ESCAPE, 1);
-			c ^= 0x20;
+			*out++ = PPP_ESCAPE;
+			*out++ = *p++ ^ 0x20;
 		}
-		buf_Push(b, &c, 1);
 	}
-
-	buf_Push(b, PPP_HEADER4, 1);
+	*out++ = PPP_HEFLAG;
 
 #if ATSVR_CMUX_ENABLE
 	if (AT->cmux)
 	{
-		atsvr_CmuxSend(UART_PTR, ((AT->dlci + 1) << 2) | 0x03, 0xEF, b->p, b->len);
+		atsvr_CmuxPush(AT, AT->dlci + 1, ppphbuf, out - ppphbuf);
 	}
 	else
 #endif
 	{
-		uart_Send(UART_PTR, b->p, b->len);
+		uart_Send(UART_PTR, ppphbuf, out - ppphbuf);
 	}
 
-	buf_Release(b);
-
 #if 1 && ATSVR_DEBUG_ENABLE
 	{
-		char str[8];
+		char str[16 * 3 + 1];
 
-		ATSVR_DBGOUT("[PPP>] ");
-		for (p = ppptbuf; p < end; )
+		ATSVR_DBGOUT("[PPP>]");
+		for (p = ppptbuf; p < end; p += 16)
 		{
-			sprintf(str, "%02X ", *p++);
+			hexdump(str, sizeof(str), p, MIN(16, end - p));
 			ATSVR_DBGOUT(str);
 		}
 		ATSVR_DBGOUT(STRING_0D0A);
@@ -472,99 +554,149 @@ void ppp_output(int len)
 }
 
 
-void ppp_process(buf b)
+static void ppp_RxStart(struct ppp_rx *r)
 {
-	u8 *p, *end, c;
-	int l, i;
 
-	//
-	while (b->len > 8)
+	r->ste = PPP_S_FRAME;
+	r->acf = 0;
+	r->len = 0;
+	r->fcs = PPP_RESETFCS;
+}
+
+static void ppp_RxRun(struct ppp_rx *r, const u8 *data, size_t len)
+{
+
+#if ATSVR_PPP_FCS_CHECK
+	r->fcs = fcs16(r->fcs, data, len);
+#endif
+
+	//ַ,ȥ
+	for (; len && (r->acf < sizeof(PPP_ACF)); r->acf++)
 	{
-		if (memcmp(b->p, PPP_HEADER4, 4) == 0)
-		{
-			i = 4;
-		}
-		else if (memcmp(b->p, PPP_HEADER5, 5) == 0)
+		if (*data != PPP_ACF[r->acf])
 		{
-			i = 5;
+			//ֽΪ0xFFʱ,
+			if (r->acf)
+				ppprbuf[r->len++] = PPP_ACF[0];
+			r->acf = sizeof(PPP_ACF);
+			break;
 		}
-		else if ((b->p[0] == PPP_HEFLAG) && (b->p[1] != PPP_HEFLAG))
+		data++;
+		len--;
+	}
+
+	//1ֽڸЭ0,֡
+	if ((r->len + len) >= sizeof(ppprbuf))
+	{
+		r->ste = PPP_S_HUNT;
+		return;
+	}
+
+	memcpy(&ppprbuf[r->len], data, len);
+	r->len += len;
+}
+
+static void ppp_RxFrame(struct ppp_rx *r)
+{
+	int l;
+
+	l = r->len;
+	if (l <= (PPP_PROCLEN + PPP_FCSLEN))
+		return;
+
+#if ATSVR_PPP_FCS_CHECK
+	//CSУ
+	if (r->fcs != PPP_GOODFCS)
+	{
+#if 1 && ATSVR_DEBUG_ENABLE
 		{
-			i = 1;
+			char str[32];
+
+			sprintf(str, "[PPP<] ErrorFCS=%04X\r", r->fcs);
+			ATSVR_DBGOUT(str);
 		}
-		else
+#endif
+		return;
+	}
+#endif
+
+	//ȷ
+#if 1 && ATSVR_DEBUG_ENABLE
+	{
+		char str[16 * 3 + 1];
+		int i;
+
+		ATSVR_DBGOUT("[PPP<]");
+		for (i = 0; i < l; i += 16)
 		{
-			buf_Remove(b, 1);
-			continue;
+			hexdump(str, sizeof(str), &ppprbuf[i], MIN(16, l - i));
+			ATSVR_DBGOUT(str);
 		}
+		ATSVR_DBGOUT(STRING_0D0A);
+	}
+#endif
+	//Эѹв0
+	if (ppprbuf[0] == 0x21)
+	{
+		memmove(&ppprbuf[1], ppprbuf, l);
+		ppprbuf[0] = 0x00;
+		l += 1;
+	}
+	memcpy(ppptbuf, ppprbuf, l);
+	ppp_input(ntohs(*(u16 *)ppprbuf));
+
+	AT->tmo = 0;
+}
+
+//PPP,״̬ñ,ÿֻֽһ
+void ppp_process(buf b)
+{
+	struct ppp_rx *r = &ppp_xRx;
+	u8 *p, *end, *run, c;
 
-		end = b->p + b->len;
-		for (p = &b->p[8]; p < end; p++)
+	for (p = b->p, end = p + b->len; p < end; )
+	{
+		switch (r->ste)
 		{
-			if (*p == PPP_HEFLAG)
-				break;
-		}
-		if (p >= end)
+		case PPP_S_ESCAPE:
+			r->ste = PPP_S_FRAME;
+			c = *p++ ^ 0x20;
+			ppp_RxRun(r, &c, 1);
 			break;
 
-		//յ֡,ת
-		end = p - 1;
-		p = &b->p[i];
-		for (l = 0; (l < sizeof(ppprbuf)) && (p <= end); l++)
-		{
-			c = *p++;
-			if (c == 0x7D)
-				ppprbuf[l] = *p++ ^ 0x20;
-			else
-				ppprbuf[l] = c;
-		}
+		case PPP_S_FRAME:
+			for (run = p; (p < end) && (*p != PPP_ESCAPE) && (*p != PPP_HEFLAG); p++);
+			ppp_RxRun(r, run, p - run);
+			if (p >= end)
+				break;
 
-#if ATSVR_PPP_FCS_CHECK
-		//CSУ
-		i = fcs16(PPP_INITFCS, ppprbuf, l);
-		if (i != PPP_GOODFCS)
-		{
-#if 1 && ATSVR_DEBUG_ENABLE
+			if (*p++ == PPP_ESCAPE)
 			{
-				char str[32];
-			
-				sprintf(str, "[PPP<] ErrorFCS=%04X\r", i);
-				ATSVR_DBGOUT(str);
+				if (r->ste == PPP_S_FRAME)
+					r->ste = PPP_S_ESCAPE;
+				break;
 			}
-#endif
-			buf_Remove(b, 1);
-			continue;
-		}
-#endif
-		
-		buf_Remove(b, end - b->p);
-		
-		//ȷ
-#if 1 && ATSVR_DEBUG_ENABLE
-		{
-			char str[8];
-	
-			ATSVR_DBGOUT("[PPP<] ");
-			for (i = 0; i < l; i++)
+
+			//־,ͬʱΪһ֡ʼ
+			if (r->ste == PPP_S_FRAME)
+				ppp_RxFrame(r);
+			ppp_RxStart(r);
+			break;
+
+		default:
+			run = memchr(p, PPP_HEFLAG, end - p);
+			if (run == NULL)
 			{
-				sprintf(str, "%02X ", ppprbuf[i]);
-				ATSVR_DBGOUT(str);
+				p = end;
+				break;
 			}
-			ATSVR_DBGOUT(STRING_0D0A);
-		}
-#endif
-		//Эѹв0
-		if (ppprbuf[0] == 0x21)
-		{
-			memmove(&ppprbuf[1], ppprbuf, l);
-			ppprbuf[0] = 0x00;
-			l += 1;
+			p = run + 1;
+			ppp_RxStart(r);
+			break;
 		}
-		memcpy(ppptbuf, ppprbuf, l);
-		ppp_input(ntohs(*(u16 *)ppprbuf));
-
-		AT->tmo = 0;
 	}
+
+	buf_Release(b);
 }
 
 void ppp_send()
@@ -1,15 +1,15 @@
 
 
-static void tcp_output(int flag, const void *opt, const void *data, int len)
+static void tcp_output(int flag, u32 seq, const void *opt, const void *data, int len)
 {
 	int ol;
 
 	memcpy(TCPT, &tcpt_header, sizeof(tcpt_header));
 
 	TCPT->flags = flag;
-	TCPT->seqno = htonl(tcp_seq);
+	TCPT->seqno = htonl(seq);
 	TCPT->ackno = htonl(tcp_ack);
-	TCPT->wnd = htons(TCP_MSS);
+	TCPT->wnd = htons(TCP_WND);
 
 	if (opt)
 	{
@@ -25,25 +25,131 @@ static void tcp_output(int flag, const void *opt, const void *data, int len)
 	if (len)
 		memcpy(&TCPT->optdata[ol], data, len);
 
+	//ÿĶȷ
+	tcp_ackn = 0;
+
 	ip_output(IPTCPH_LEN + ol + len);
 }
 
+static void tcp_reset()
+{
+
+	tcp_flight = 0;
+	tcp_rexmit = 0;
+	tcp_segh = 0;
+	tcp_segn = 0;
+	tcp_ackn = 0;
+	tcp_dupn = 0;
+	tcp_srtt = 0;
+	tcp_rttvar = 0;
+	tcp_rto = ATSVR_TCP_RTO / OS_TICK_MS;
+}
+
+//˵δȷϴط(go-back-N)
+static void tcp_rewind()
+{
+
+	tcp_rexmit = MAX(tcp_rexmit, tcp_flight);
+	tcp_flight = 0;
+	tcp_segn = 0;
+	tcp_dupn = 0;
+}
+
+//Jacobson/Karels, srtt scaled by 8, rttvar by 4
+static void tcp_rtt(int m)
+{
+	int err;
+
+	if (tcp_srtt == 0)
+	{
+		tcp_srtt = m << 3;
+		tcp_rttvar = m << 1;
+	}
+	else
+	{
+		err = m - (tcp_srtt >> 3);
+		tcp_srtt += err;
+		if (err < 0)
+			err = -err;
+		tcp_rttvar += err - (tcp_rttvar >> 2);
+	}
+	tcp_rto = (tcp_srtt >> 3) + tcp_rttvar;
+	tcp_rto = MAX(tcp_rto, TCP_RTO_MIN);
+	tcp_rto = MIN(tcp_rto, TCP_RTO_MAX);
+}
+
+//ۻȷ,ͷȷ
+static void tcp_acked(buf b, u32 ack)
+{
+	struct tcp_seg *s;
+	u32 len, tick;
 
+	//˺tcp_flight,ԭͶεȷtcp_rexmitΪ
+	len = ack - tcp_seq;
+	if ((len == 0) || (len > MAX(tcp_flight, tcp_rexmit)))
+		return;
 
+	buf_Remove(b, len);
+	tcp_seq = ack;
+	tcp_flight -= MIN(tcp_flight, len);
+	tcp_rexmit -= MIN(tcp_rexmit, len);
+	tcp_dupn = 0;
 
+	tick = os_tick_get();
+	for (; tcp_segn; tcp_segn--)
+	{
+		s = &tcp_xSeg[tcp_segh];
+		if (len < s->len)
+		{
+			s->len -= len;
+			break;
+		}
+		len -= s->len;
+		if (s->retx == 0)
+			tcp_rtt(tick - s->tick);
+		tcp_segh = (tcp_segh + 1) % ATSVR_TCP_WND_QTY;
+	}
+}
 
 static int tcp_send(buf b)
 {
-	int len;
+	struct tcp_seg *s;
+	u32 tick;
+	int len, n = 0;
 
-	len = MIN(tcp_ss, b->len);
-	if (len)
+	tick = os_tick_get();
+
+	//ʱط
+	if (tcp_segn && ((tick - tcp_xSeg[tcp_segh].tick) >= tcp_rto))
 	{
-		tcp_output(TCP_PSH | TCP_ACK, NULL, b->p, len);
-		buf_Remove(b, len);
+		tcp_rewind();
+		tcp_rto = MIN(tcp_rto << 1, TCP_RTO_MAX);
 	}
+
+	//,bֱȷ
+	while (tcp_segn < ATSVR_TCP_WND_QTY)
+	{
+		len = MIN(tcp_ss, (int)b->len - tcp_flight);
+		len = MIN(len, tcp_wnd - tcp_flight);
+		if (len <= 0)
+			break;
+
+		tcp_output(TCP_PSH | TCP_ACK, tcp_seq + tcp_flight, NULL, &b->p[tcp_flight], len);
+
+		s = &tcp_xSeg[(tcp_segh + tcp_segn) % ATSVR_TCP_WND_QTY];
+		s->len = len;
+		s->retx = (tcp_flight < tcp_rexmit);
+		s->tick = tick;
+		tcp_segn += 1;
+		tcp_flight += len;
+		n += len;
+	}
+
+	//ʱȷ
+	if (tcp_ackn && ((tick - tcp_acktick) >= TCP_ACK_TICK))
+		tcp_output(TCP_ACK, tcp_seq + tcp_flight, NULL, NULL, 0);
 	
-	return len;
+	return n;
 }
 
 static void tcp_input()
@@ -66,43 +172,65 @@ static void tcp_input()
 	seq = ntohl(TCPR->seqno);
 	ack = ntohl(TCPR->ackno);
 
-	tcp_seq = ack;
 	opt = (TCPR->tcpoffset >> 2) - TCPH_LEN;
+	len = ntohs(IPR->len) - (IPTCPH_LEN + opt);
 
-	switch (flag)
+	if (flag & TCP_SYN)
 	{
-	case TCP_SYN:	//		
+		//
 		//tcp_ss
 		if ((opt >= 4) && (TCPR->optdata[0] == TCP_OPT_MSS))
 			tcp_ss = MIN(ntohs(*(u16 *)&TCPR->optdata[2]), TCP_MSS);
 
+		tcp_reset();
+		tcp_wnd = ntohs(TCPR->wnd);
 		tcp_ack = seq + 1;
 		tcp_seq = 0x1001;
-		tcp_output(TCP_SYN | TCP_ACK, TCP_CONST_OPTMSS, NULL, 0);
+		tcp_output(TCP_SYN | TCP_ACK, tcp_seq, TCP_CONST_OPTMSS, NULL, 0);
+		tcp_seq += 1;
 
 		tcp_linked = 1;
+		return;
+	}
 
-		break;
-	
-	case TCP_PSH | TCP_ACK:
-		//
-		len = ntohs(IPR->len) - (IPTCPH_LEN + opt);
+	if (flag & TCP_ACK)
+	{
+		tcp_wnd = ntohs(TCPR->wnd);
+		tcp_acked(AT->tbuf, ack);
 
-		atsvr_RxDo(&TCPR->optdata[opt], len);
-		
-		tcp_ack = seq + len;
-		tcp_output(TCP_ACK, NULL, NULL, 0);
+		//3ظȷϿط
+		if ((ack == tcp_seq) && (len <= 0) && tcp_flight && (++tcp_dupn == 3))
+			tcp_rewind();
+	}
 
-		break;
+	if (len > 0)
+	{
+		if (seq == tcp_ack)
+		{
+			//
+			atsvr_RxDo(&TCPR->optdata[opt], len);
+			tcp_ack += len;
 
-	default:
-		if (flag != TCP_ACK)
+			//ÿȷһ,ʱȷ
+			if (tcp_ackn++ == 0)
+				tcp_acktick = os_tick_get();
+		}
+		else
 		{
-			tcp_ack = seq + 1;
-			tcp_output(TCP_ACK, NULL, NULL, 0);
+			//ظ,ȷ
+			tcp_ackn = 2;
 		}
+	}
 
-		break;
+	//FINֻ֮ǰȫյ
+	if (flag & TCP_FIN)
+	{
+		if ((seq + len) == tcp_ack)
+			tcp_ack += 1;
+		tcp_ackn = 2;
 	}
+
+	if (tcp_ackn >= 2)
+		tcp_output(TCP_ACK, tcp_seq + tcp_flight, NULL, NULL, 0);
 }
 
@@ -462,12 +462,10 @@ uip_fw_forward(void)
   /* Decrement the TTL (time-to-live) value in the IP header */
   BUF->ttl = BUF->ttl - 1;
   
-  /* Update the IP checksum. */
-  if(BUF->ipchksum >= HTONS(0xffff - 0x0100)) {
-    BUF->ipchksum = BUF->ipchksum + HTONS(0x0100) + 1;
-  } else {
-    BUF->ipchksum = BUF->ipchksum + HTONS(0x0100);
-  }
+  /* Update the IP checksum (RFC 1624). */
+  BUF->ipchksum = ipcs_update(BUF->ipchksum,
+			      HTONS(((BUF->ttl + 1) << 8) | BUF->proto),
+			      HTONS((BUF->ttl << 8) | BUF->proto));
 
   if(uip_len > 0) {
     uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_TCPIP_HLEN];
@@ -284,32 +284,8 @@ uip_add32(u8_t *op32, u16_t op16)
 static u16_t
 chksum(u16_t sum, const u8_t *data, u16_t len)
 {
-  u16_t t;
-  const u8_t *dataptr;
-  const u8_t *last_byte;
-
-  dataptr = data;
-  last_byte = data + len - 1;
-  
-  while(dataptr < last_byte) {	/* At least two more bytes */
-    t = (dataptr[0] << 8) + dataptr[1];
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-    dataptr += 2;
-  }
-  
-  if(dataptr == last_byte) {
-    t = (dataptr[0] << 8) + 0;
-    sum += t;
-    if(sum < t) {
-      sum++;		/* carry */
-    }
-  }
-
-  /* Return sum in host byte order. */
-  return sum;
+  /* Word-at-a-time routine shared with bdip, returns host byte order. */
+  return ipcs(sum, data, len);
 }
 /*---------------------------------------------------------------------------*/
 u16_t
@@ -63,6 +63,10 @@
 
 #include "uip.h"
 
+/* Internet checksum core and RFC 1624 incremental update, ipcs() and
+ * ipcs_update(), are shared with the bdip stack */
+#include <lib/ecc.h>
+
 /**
  * Carry out a 32-bit addition.
  *
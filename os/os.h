@@ -42,6 +42,7 @@ typedef struct rt_mailbox		os_mbox_t;
 #define os_thd_sleep(t)			rt_thread_delay((t) / OS_TICK_MS)
 #define os_thd_slp1tick()		rt_thread_delay(1)
 #define os_thd_idself()			rt_thread_self()
+#define os_tick_get()			rt_tick_get()
 
 #define os_thd_lock()			rt_enter_critical()
 #define os_thd_unlock()			rt_exit_critical()
@@ -98,6 +99,7 @@ typedef mailbox_t				os_mbox_t;
 #define os_thd_sleep(t)			chThdSleepMilliseconds(t)
 #define os_thd_slp1tick()		chThdSleepMilliseconds(OS_TICK_MS)
 #define os_thd_idself()			chThdGetSelfX()
+#define os_tick_get()			chVTGetSystemTimeX()
 
 #define os_thd_lock()			chSysLock()
 #define os_thd_unlock()			chSysUnlock()
@@ -139,6 +141,7 @@ typedef StaticQueue_t			os_mbox_t;
 
 #define os_thd_sleep(t)			vTaskDelay((t) / OS_TICK_MS)
 #define os_thd_slp1tick()		vTaskDelay(1)
+#define os_tick_get()			xTaskGetTickCount()
 
 #define os_thd_lock()			taskENTER_CRITICAL()
 #define os_thd_unlock()			taskEXIT_CRITICAL()
@@ -103,6 +103,10 @@ void sys_Maintian()
 		bat_VolGet();
 #endif
 
+#if BKP_ENABLE
+		bkp_Flush();
+#endif
+
 #if DEBUG_MEMORY_ENABLE
 		if ((nCnt & 0x03) == 0)
 			list_memdebug(0, 0);
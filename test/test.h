@@ -0,0 +1,103 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+//-------------------------------------------------------------------------
+//˲Թ
+//ԳֱӰ.cļ(libl.cͬķʽ)
+//-------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+
+//Public Typedefs
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+typedef int64_t		s64;
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef uint64_t	u64;
+typedef size_t		adr_t;
+
+#define __INLINE				inline
+#define PACK_STRUCT_STRUCT		__attribute__((packed))
+
+#include <def.h>
+#include <lib/buffer.h>
+#include <lib/lib.h>
+
+
+//Private Variables
+static int test_nFail = 0;
+static int test_nBench = 0;
+static u32 test_nSeed = 2463534242UL;
+static volatile u32 test_nSink;
+
+
+//External Functions
+#define TEST_CHECK(cond, ...) \
+	do { \
+		if (!(cond)) { \
+			if (test_nFail++ < 10) { \
+				printf("%s:%d: ", __FILE__, __LINE__); \
+				printf(__VA_ARGS__); \
+				printf("\n"); \
+			} \
+		} \
+	} while (0)
+
+//ʱnQtyexpr,ÿκʱ(ns),-bִ
+//exprۼtest_nSink,ֹŻ
+#define TEST_BENCH(name, nQty, expr) \
+	do { \
+		if (test_nBench) { \
+			u32 _i; \
+			double _t = test_Now(); \
+			for (_i = 0; _i < (nQty); _i++) test_nSink += (u32)(expr); \
+			printf("  %-32s %8.2f ns\n", name, (test_Now() - _t) * 1e9 / (nQty)); \
+		} \
+	} while (0)
+
+static u32 test_Rand()
+{
+
+	//xorshift32,̶ӱ֤ɸ
+	test_nSeed ^= test_nSeed << 13;
+	test_nSeed ^= test_nSeed >> 17;
+	test_nSeed ^= test_nSeed << 5;
+	return test_nSeed;
+}
+
+static double test_Now()
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void test_Init(int argc, char **argv)
+{
+
+	if ((argc > 1) && (strcmp(argv[1], "-b") == 0))
+		test_nBench = 1;
+}
+
+static int test_Result(const char *pName)
+{
+
+	if (test_nFail) {
+		printf("%s: FAILED (%d)\n", pName, test_nFail);
+		return 1;
+	}
+	printf("%s: ok\n", pName);
+	return 0;
+}
+
+
+#endif
+
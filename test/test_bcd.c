@@ -0,0 +1,164 @@
+#include "test.h"
+#include "../lib/bcd.c"
+
+
+//Private Defines
+#define BCD_TEST_QTY			2000000
+
+
+//Internal Functions
+//οʵ,λȡģ,nDigitsλ
+static u64 bcd_RefBin2Bcd(u64 x, int nDigits)
+{
+	u64 nBcd = 0;
+	int i;
+
+	for (i = 0; i < nDigits; i++) {
+		nBcd |= (x % 10) << (4 * i);
+		x /= 10;
+	}
+	return nBcd;
+}
+
+//οʵ,ֽڿɴ9,λȨۼ
+static u64 bcd_RefBcd2Bin(u64 x, int nDigits)
+{
+	u64 nBin = 0, nPow = 1;
+	int i;
+
+	for (i = 0; i < nDigits; i++, nPow *= 10)
+		nBin += ((x >> (4 * i)) & 0x0F) * nPow;
+	return nBin;
+}
+
+static u64 bcd_Rand64()
+{
+	u64 x;
+
+	x = ((u64)test_Rand() << 32) | test_Rand();
+	return x >> (test_Rand() % 64);
+}
+
+static void bcd_Test16()
+{
+	u32 x;
+
+	for (x = 0; x < 256; x++) {
+		TEST_CHECK(bin2bcd8(x) == (u8)(((x / 10) << 4) + x % 10), "bin2bcd8(%u) = %02X", x, bin2bcd8(x));
+		TEST_CHECK(bcd2bin8(x) == (u8)bcd_RefBcd2Bin(x, 2), "bcd2bin8(%02X) = %u", x, bcd2bin8(x));
+	}
+	for (x = 0; x < 65536; x++) {
+		TEST_CHECK(bin2bcd16(x) == bcd_RefBin2Bcd(x, 4), "bin2bcd16(%u) = %04X", x, bin2bcd16(x));
+		TEST_CHECK(bcd2bin16(x) == (u16)bcd_RefBcd2Bin(x, 4), "bcd2bin16(%04X) = %u", x, bcd2bin16(x));
+	}
+}
+
+static void bcd_Test32()
+{
+	static const u32 aEdge[] = {0, 99999999, 100000000, 999999999, 1000000000, 4294967295U};
+	u32 i, j, x;
+
+	for (i = 0; i < ARR_SIZE(aEdge); i++) {
+		for (j = 0; j < 1000; j++) {
+			x = aEdge[i] + j - 500;
+			TEST_CHECK(bin2bcd32(x) == bcd_RefBin2Bcd(x, 8), "bin2bcd32(%u) = %08X", x, bin2bcd32(x));
+		}
+	}
+	for (i = 0; i < BCD_TEST_QTY; i++) {
+		x = test_Rand();
+		TEST_CHECK(bin2bcd32(x) == bcd_RefBin2Bcd(x, 8), "bin2bcd32(%u) = %08X", x, bin2bcd32(x));
+		TEST_CHECK(bcd2bin32(x) == (u32)bcd_RefBcd2Bin(x, 8), "bcd2bin32(%08X) = %u", x, bcd2bin32(x));
+	}
+}
+
+static void bcd_Test64()
+{
+	static const u64 aEdge[] = {
+		0, 99999999ULL, 100000000ULL, 0xFFFFFFFFULL, 0x100000000ULL,
+		9999999999999999ULL, 10000000000000000ULL, 18446743999999999999ULL,
+		18446744000000000000ULL, 0xFFFFFFFFFFFFFFFFULL - 500,
+	};
+	u64 x, r;
+	u32 i, j;
+
+	for (i = 0; i < ARR_SIZE(aEdge); i++) {
+		for (j = 0; j < 1000; j++) {
+			x = aEdge[i] + j - 500;
+			TEST_CHECK(bin2bcd64(x) == bcd_RefBin2Bcd(x, 16), "bin2bcd64(%llu)", (unsigned long long)x);
+		}
+	}
+	for (i = 0; i < BCD_TEST_QTY; i++) {
+		x = bcd_Rand64();
+		//̵߽: 10^8ǰһ
+		if (i & 1)
+			x = x / 100000000 * 100000000 + ((i & 2) ? 0 : 99999999);
+		r = bcd_RefBin2Bcd(x, 16);
+		TEST_CHECK(bin2bcd64(x) == r, "bin2bcd64(%llu)", (unsigned long long)x);
+	}
+}
+
+static void bcd_TestArray()
+{
+	u32 aBin[64], aOut[64], i, n;
+	u8 aBcd[64 * 4];
+	size_t nSize;
+
+	for (nSize = 1; nSize <= 4; nSize++) {
+		for (n = 1, i = 0; i < nSize * 2; i++)
+			n *= 10;
+		for (i = 0; i < ARR_SIZE(aBin); i++)
+			aBin[i] = test_Rand() % n;
+		bin2bcd_array(aBcd, aBin, nSize, ARR_SIZE(aBin));
+		bcd2bin_array(aOut, aBcd, nSize, ARR_SIZE(aBin));
+		TEST_CHECK(memcmp(aBin, aOut, sizeof(aBin)) == 0, "bcd array round trip, size %u", (u32)nSize);
+		TEST_CHECK(isnotbcd(aBcd, nSize * ARR_SIZE(aBin)) == 0, "isnotbcd on valid array, size %u", (u32)nSize);
+	}
+}
+
+static void bcd_TestIsNot()
+{
+	u8 aBuf[17];
+	int i, k, n, nRef;
+
+	for (i = 0; i < BCD_TEST_QTY; i++) {
+		n = test_Rand() % sizeof(aBuf);
+		for (k = 0; k < n; k++)
+			aBuf[k] = bin2bcd8(test_Rand() % 100);
+		if (n && (test_Rand() & 1))
+			aBuf[test_Rand() % n] = test_Rand();
+		nRef = 0;
+		for (k = 0; k < n; k++) {
+			if (((aBuf[k] & 0x0F) > 9) || ((aBuf[k] >> 4) > 9))
+				nRef = 1;
+		}
+		TEST_CHECK(isnotbcd(aBuf, n) == nRef, "isnotbcd(len %d) = %d", n, isnotbcd(aBuf, n));
+	}
+}
+
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+	static u8 aBlk[256];
+
+	test_Init(argc, argv);
+
+	bcd_Test16();
+	bcd_Test32();
+	bcd_Test64();
+	bcd_TestArray();
+	bcd_TestIsNot();
+
+	memset(aBlk, 0x45, sizeof(aBlk));
+	TEST_BENCH("bin2bcd16", 10000000, bin2bcd16(_i));
+	TEST_BENCH("bcd2bin16", 10000000, bcd2bin16(_i));
+	TEST_BENCH("bin2bcd32", 10000000, bin2bcd32(_i * 2654435761U));
+	TEST_BENCH("bcd2bin32", 10000000, bcd2bin32(_i * 2654435761U));
+	TEST_BENCH("bin2bcd64 (< 2^32)", 10000000, bin2bcd64(_i * 2654435761U));
+	TEST_BENCH("bin2bcd64 (full)", 10000000, bin2bcd64(_i * 0x9E3779B97F4A7C15ULL));
+	TEST_BENCH("isnotbcd (256B)", 1000000, isnotbcd(aBlk, sizeof(aBlk) - (_i & 1)));
+
+	return test_Result("bcd");
+}
+
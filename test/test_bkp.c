@@ -0,0 +1,180 @@
+#define _GNU_SOURCE
+#include "test.h"
+
+#define BKP_ENABLE				1
+#define BKP_TYPE				BKP_T_EEPROM
+#define BKP_COMID				0
+#define BKP_DEVID				0xA0
+#define BKP_PAGE_SIZE			32
+#define BKP_WAIT_MS				20
+#define OS_TICK_MS				1
+#define OS_TMO_FOREVER			0
+
+//I2COS
+typedef struct {
+	int		id;
+} i2c_t;
+
+i2c_t *i2c_Open(int nId, int nTmo);
+void i2c_Close(i2c_t *p);
+sys_res i2c_Write(i2c_t *p, int nDev, const void *pBuf, size_t nLen);
+sys_res i2c_Read(i2c_t *p, int nDev, void *pBuf, size_t nLen);
+void os_thd_slp1tick(void);
+#define mem_Malloc				malloc
+#define mem_Realloc				realloc
+#define mem_Free				free
+
+#include <fs/bkp/bkp.h>
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+#include "../fs/bkp/bkp.c"
+
+
+//Private Defines
+#define EE_SIZE					1024
+#define EE_CYCLE				5		//д(tick)
+
+
+//Private Variables
+static i2c_t ee_xI2c;
+static u8 ee_aMem[EE_SIZE];
+static u8 ee_aModel[EE_SIZE];
+static u32 ee_nTick;
+static u32 ee_nBusy;			//дڽtick
+static int ee_nStuck;			//дӦ
+static adr_t ee_nPtr;
+static u32 ee_nPoll, ee_nPage, ee_nWrap;
+
+
+//Internal Functions
+static void ee_Reset()
+{
+	int i;
+
+	for (i = 0; i < EE_SIZE; i++)
+		ee_aMem[i] = test_Rand();
+	memcpy(ee_aModel, ee_aMem, EE_SIZE);
+	ee_nBusy = ee_nTick;
+	ee_nStuck = 0;
+	ee_nPoll = ee_nPage = ee_nWrap = 0;
+}
+
+static int ee_IsBusy()
+{
+
+	return ee_nStuck || ((s32)(ee_nBusy - ee_nTick) > 0);
+}
+
+//дʱд,һ
+static void ee_TestWrite()
+{
+	u8 aBuf[200], aRead[200];
+	int i, nAdr, nLen, nErr = 0, nBusy = 0;
+
+	ee_Reset();
+	for (i = 0; i < 500; i++)
+	{
+		nLen = 1 + test_Rand() % sizeof(aBuf);
+		nAdr = test_Rand() % (EE_SIZE - nLen);
+		memset(aBuf, i, nLen);
+		aBuf[0] = test_Rand();
+		if (bkp_Write(nAdr, aBuf, nLen) != SYS_R_OK)
+			nErr += 1;
+		memcpy(&ee_aModel[nAdr], aBuf, nLen);
+		nBusy += ee_IsBusy();
+		
+		nLen = 1 + test_Rand() % sizeof(aRead);
+		nAdr = test_Rand() % (EE_SIZE - nLen);
+		if ((bkp_Read(nAdr, aRead, nLen) != SYS_R_OK) || memcmp(aRead, &ee_aModel[nAdr], nLen))
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%d writes or reads failed", nErr);
+	TEST_CHECK(nBusy == 0, "%d writes returned during the write cycle", nBusy);
+	TEST_CHECK(ee_nWrap == 0, "%u page writes wrapped", ee_nWrap);
+	TEST_CHECK(memcmp(ee_aMem, ee_aModel, EE_SIZE) == 0, "memory differs");
+	
+	//ҳ:ҳдÿҳһ,޶д
+	ee_nPage = 0;
+	bkp_Write(BKP_PAGE_SIZE - 1, aBuf, 2 + BKP_PAGE_SIZE);
+	memcpy(&ee_aModel[BKP_PAGE_SIZE - 1], aBuf, 2 + BKP_PAGE_SIZE);
+	TEST_CHECK(ee_nPage == 3, "%u page writes for 3 pages", ee_nPage);
+	
+	bkp_Fill(10, 300, 0x5A);
+	memset(&ee_aModel[10], 0x5A, 290);
+	TEST_CHECK(memcmp(ee_aMem, ee_aModel, EE_SIZE) == 0, "memory differs after fill");
+}
+
+//Ӧʱ,ѯ޲ʧ
+static void ee_TestTimeout()
+{
+	u8 aBuf[4] = {1, 2, 3, 4};
+	u32 nTick;
+
+	ee_Reset();
+	ee_nStuck = 1;
+	ee_nBusy = ee_nTick;
+	nTick = ee_nTick;
+	TEST_CHECK(bkp_Write(0, aBuf, sizeof(aBuf)) != SYS_R_OK, "write to a stuck device succeeded");
+	TEST_CHECK(ee_nPoll <= BKP_WAIT_MS / OS_TICK_MS + 2, "%u polls", ee_nPoll);
+	TEST_CHECK(ee_nTick - nTick <= BKP_WAIT_MS / OS_TICK_MS + 1, "waited %u ticks", ee_nTick - nTick);
+	ee_nStuck = 0;
+}
+
+
+//External Functions
+i2c_t *i2c_Open(int nId, int nTmo) { return &ee_xI2c; }
+void i2c_Close(i2c_t *p) {}
+void os_thd_slp1tick() { ee_nTick += 1; }
+
+//дڲӦ;ҳдҳڻ
+sys_res i2c_Write(i2c_t *p, int nDev, const void *pBuf, size_t nLen)
+{
+	const u8 *pData = pBuf;
+	adr_t nAdr, nPage;
+	size_t i;
+
+	if (nLen == 0)
+		ee_nPoll += 1;
+	if (ee_IsBusy())
+		return SYS_R_ERR;
+	if (nLen < 2)
+		return SYS_R_OK;
+	
+	nAdr = (pData[0] << 8) | pData[1];
+	ee_nPtr = nAdr;
+	if (nLen == 2)
+		return SYS_R_OK;
+	
+	nPage = nAdr - (nAdr % BKP_PAGE_SIZE);
+	if ((nAdr % BKP_PAGE_SIZE) + nLen - 2 > BKP_PAGE_SIZE)
+		ee_nWrap += 1;
+	for (i = 2; i < nLen; i++, nAdr = nPage + (nAdr + 1) % BKP_PAGE_SIZE)
+		ee_aMem[nAdr % EE_SIZE] = pData[i];
+	ee_nPage += 1;
+	ee_nBusy = ee_nTick + EE_CYCLE;
+	if (ee_nStuck)
+		ee_nBusy = ee_nTick + 100000;
+	
+	return SYS_R_OK;
+}
+
+sys_res i2c_Read(i2c_t *p, int nDev, void *pBuf, size_t nLen)
+{
+
+	if (ee_IsBusy())
+		return SYS_R_ERR;
+	memcpy(pBuf, &ee_aMem[ee_nPtr], nLen);
+	return SYS_R_OK;
+}
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	
+	ee_TestWrite();
+	ee_TestTimeout();
+	
+	return test_Result("bkp");
+}
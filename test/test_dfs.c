@@ -0,0 +1,240 @@
+#define _GNU_SOURCE
+#include "test.h"
+
+#define DFS_USING_STDIO
+#define DFS_FD_MAX				8
+#include "test_rtt.h"
+#include <sched.h>
+
+#include "../fs/dfs.c"
+#include "../fs/dfs_fs.c"
+#include "../fs/dfs_file.c"
+
+
+//Private Defines
+#define DFS_THREAD_QTY			4
+#define DFS_THREAD_LOOP			20000
+
+
+//Private Variables
+static volatile int dfs_nInOps;			//ִеļϵͳ
+static volatile int dfs_nOverlap;		//ͬһļϵͳ
+static int dfs_aOwner[FD_BASE + DFS_FD_MAX];
+static volatile int dfs_nDouble;		//ͬһ߳ͬʱ
+
+
+//Internal Functions
+//ļϵͳ,ڼͬһļϵͳǷ񱻲
+static void tst_Enter()
+{
+
+	if (__sync_add_and_fetch(&dfs_nInOps, 1) != 1)
+		__sync_add_and_fetch(&dfs_nOverlap, 1);
+	sched_yield();
+	__sync_sub_and_fetch(&dfs_nInOps, 1);
+}
+
+static int tst_mount(struct dfs_filesystem *fs, unsigned long rwflag, const void *data) { return DFS_STATUS_OK; }
+static int tst_unmount(struct dfs_filesystem *fs) { return DFS_STATUS_OK; }
+
+static int tst_open(struct dfs_fd *fd)
+{
+
+	tst_Enter();
+	if (strstr(fd->path, "missing") != NULL)
+		return -DFS_STATUS_ENOENT;
+	fd->size = 64;
+	return DFS_STATUS_OK;
+}
+
+static int tst_close(struct dfs_fd *fd)
+{
+
+	tst_Enter();
+	return DFS_STATUS_OK;
+}
+
+static int tst_read(struct dfs_fd *fd, void *buf, rt_size_t count)
+{
+
+	tst_Enter();
+	memset(buf, 0x5A, count);
+	return count;
+}
+
+static const struct dfs_filesystem_operation tst_ops =
+{
+	"tst",
+	DFS_FS_FLAG_DEFAULT,
+	tst_mount,
+	tst_unmount,
+	RT_NULL,
+	RT_NULL,
+
+	tst_open,
+	tst_close,
+	RT_NULL,
+	tst_read,
+	RT_NULL,
+	RT_NULL,
+	RT_NULL,
+	RT_NULL,
+	RT_NULL,
+	RT_NULL,
+	RT_NULL,
+};
+
+//dfs_posix.copen/closeͬü÷
+static int dfs_Open(const char *pPath)
+{
+	struct dfs_fd *d;
+	int fd;
+
+	fd = fd_new();
+	if (fd < 0)
+		return -1;
+	d = fd_get(fd);
+	if (dfs_file_open(d, pPath, DFS_O_RDONLY) < 0)
+	{
+		fd_put(d);
+		fd_put(d);
+		return -1;
+	}
+	fd_put(d);
+	return fd;
+}
+
+static int dfs_Close(int fd)
+{
+	struct dfs_fd *d;
+	int res;
+
+	d = fd_get(fd);
+	if (d == RT_NULL)
+		return -1;
+	res = dfs_file_close(d);
+	fd_put(d);
+	fd_put(d);
+	return res;
+}
+
+//䡢ľü
+static void dfs_TestFree()
+{
+	int i, fd, aFd[DFS_FD_MAX], nUsed = 0;
+	struct dfs_fd *d;
+
+	for (i = 0; i < DFS_FD_MAX; i++)
+	{
+		aFd[i] = dfs_Open("/f");
+		TEST_CHECK((aFd[i] >= FD_BASE) && (aFd[i] < FD_BASE + DFS_FD_MAX), "fd %d out of range", aFd[i]);
+		TEST_CHECK((nUsed & BITMASK(aFd[i])) == 0, "fd %d handed out twice", aFd[i]);
+		nUsed |= BITMASK(aFd[i]);
+	}
+	TEST_CHECK(dfs_Open("/f") < 0, "open beyond DFS_FD_MAX");
+	TEST_CHECK(fd_is_open("/f") == 0, "fd_is_open");
+	
+	//ͷŵɸ
+	TEST_CHECK(dfs_Close(aFd[3]) == 0, "close");
+	TEST_CHECK(fd_get(aFd[3]) == RT_NULL, "fd_get on a free slot");
+	TEST_CHECK(dfs_Close(aFd[3]) < 0, "double close");
+	fd = dfs_Open("/f");
+	TEST_CHECK(fd == aFd[3], "reopen got %d, freed %d", fd, aFd[3]);
+	
+	//ʧܲռ
+	TEST_CHECK(dfs_Close(aFd[5]) == 0, "close");
+	TEST_CHECK(dfs_Open("/missing") < 0, "open missing");
+	TEST_CHECK(dfs_Open("/f") == aFd[5], "fd leaked by failed open");
+	
+	//Աõرպ󲻻
+	d = fd_get(aFd[0]);
+	TEST_CHECK(d != RT_NULL, "fd_get");
+	TEST_CHECK(dfs_Close(aFd[0]) == 0, "close held fd");
+	TEST_CHECK(dfs_Open("/f") < 0, "held fd reused");
+	TEST_CHECK(d->ref_count == 1, "held ref_count %d", d->ref_count);
+	fd_put(d);
+	TEST_CHECK(dfs_Open("/f") == aFd[0], "released fd not reused");
+	
+	TEST_CHECK(fd_get(-1) == RT_NULL, "fd_get -1");
+	TEST_CHECK(fd_get(0) == RT_NULL, "fd_get stdio");
+	TEST_CHECK(fd_get(FD_BASE + DFS_FD_MAX) == RT_NULL, "fd_get end");
+	
+	for (i = 0; i < DFS_FD_MAX; i++)
+		TEST_CHECK(dfs_Close(aFd[i]) == 0, "close %d", aFd[i]);
+	TEST_CHECK(fd_is_open("/f") < 0, "fd_is_open after close");
+}
+
+//̴߳򿪡ر:ظ,ͬһļϵͳ
+static void *dfs_Thread(void *pArg)
+{
+	int i, j, fd;
+	char aBuf[16];
+	struct dfs_fd *d;
+
+	for (i = 0; i < DFS_THREAD_LOOP; i++)
+	{
+		fd = dfs_Open("/f");
+		if (fd < 0)
+			continue;
+		if (__sync_val_compare_and_swap(&dfs_aOwner[fd], 0, 1) != 0)
+			__sync_add_and_fetch(&dfs_nDouble, 1);
+		for (j = 0; j < 2; j++)
+		{
+			d = fd_get(fd);
+			dfs_file_read(d, aBuf, sizeof(aBuf));
+			fd_put(d);
+		}
+		dfs_aOwner[fd] = 0;
+		__sync_synchronize();
+		dfs_Close(fd);
+	}
+	return NULL;
+}
+
+static void dfs_TestThread()
+{
+	pthread_t aThd[DFS_THREAD_QTY];
+	int i, nLeak;
+
+	dfs_nOverlap = dfs_nDouble = 0;
+	for (i = 0; i < DFS_THREAD_QTY; i++)
+		pthread_create(&aThd[i], NULL, dfs_Thread, NULL);
+	for (i = 0; i < DFS_THREAD_QTY; i++)
+		pthread_join(aThd[i], NULL);
+	
+	TEST_CHECK(dfs_nDouble == 0, "%d fds owned by two threads", dfs_nDouble);
+	TEST_CHECK(dfs_nOverlap == 0, "%d overlapping filesystem calls", dfs_nOverlap);
+	for (nLeak = 0, i = FD_BASE; i < FD_BASE + DFS_FD_MAX; i++)
+		nLeak += (fd_table[i].ref_count != 0);
+	TEST_CHECK(nLeak == 0, "%d fds leaked", nLeak);
+	for (nLeak = 0, i = 0; i < DFS_FD_MAX; i++)
+		nLeak += (dfs_Open("/f") < 0);
+	TEST_CHECK(nLeak == 0, "%d fds lost from the free list", nLeak);
+}
+
+static int dfs_BenchOpen()
+{
+	int fd;
+
+	fd = dfs_Open("/f");
+	dfs_Close(fd);
+	return fd;
+}
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	
+	dfs_init();
+	dfs_register(&tst_ops);
+	TEST_CHECK(dfs_mount(RT_NULL, "/", "tst", 0, RT_NULL) == 0, "mount");
+	
+	dfs_TestFree();
+	TEST_BENCH("dfs open+close", 100000, dfs_BenchOpen());
+	dfs_TestThread();
+	
+	return test_Result("dfs");
+}
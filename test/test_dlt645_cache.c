@@ -0,0 +1,315 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_os.h"
+
+#define DLT645_CACHE_ENABLE		1
+#define DLT645_CACHE_MAX		256
+#define DLT645_CACHE_DATA_MAX	64
+#define DLT645_CACHE_WAIT		10000
+
+#include <cp/lcp/dlt645.h>
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+#include "../cp/lcp/dlt645.c"
+
+
+//Private Defines
+#define CACHE_METER_QTY			64
+#define CACHE_TRACE_SEC			3600
+#define CACHE_CODE_WRITE07		0x14
+
+
+//Private Variables
+static u32 cache_nRead;				//ʵʳ
+static size_t cache_nReply = 8;		//Ӧ𳤶
+static volatile int cache_nGate;	//>0ʱ
+static volatile int cache_nInRead;
+
+
+//Internal Functions
+//ģⳭ,ӦΪ롢DI
+static sys_res cache_Meter(void *pArg, buf b, const u8 *pAdr, int nCode, const void *pData, size_t nLen)
+{
+	u8 aReply[128];
+	int nGate;
+
+	os_thd_lock();
+	cache_nRead += 1;
+	nGate = cache_nGate;
+	cache_nInRead += 1;
+	os_thd_unlock();
+	while (nGate && cache_nGate)
+		usleep(100);
+
+	memset(aReply, pAdr[0], sizeof(aReply));
+	aReply[0] = nCode | 0x80;
+	aReply[1] = cache_nReply - 2;
+	memcpy(&aReply[2], pData, nLen);
+	buf_Push(b, aReply, cache_nReply);
+	return SYS_R_OK;
+}
+
+static sys_res cache_Read(const u8 *pAdr, int nCode, u32 nDI, size_t *pLen)
+{
+	buf b = {0};
+	sys_res res;
+
+	res = dlt645_CacheRead(b, pAdr, nCode, &nDI, (nCode == DLT645_CODE_READ07) ? 4 : 2, cache_Meter, NULL);
+	if (pLen != NULL)
+		*pLen = b->len;
+	buf_Release(b);
+	return res;
+}
+
+static void cache_Adr(u8 *pAdr, int n)
+{
+
+	memset(pAdr, 0, 6);
+	pAdr[0] = n;
+	pAdr[1] = n >> 8;
+}
+
+static void cache_Reset()
+{
+
+	dlt645_CacheFlush(NULL);
+	cache_nRead = 0;
+	cache_nReply = 8;
+}
+
+//ͬһ(Լ,DI)nSecγǷ
+static int cache_Hit(int nCode, u32 nDI, int nSec)
+{
+	u8 aAdr[6];
+	u32 nRead;
+
+	cache_Reset();
+	cache_Adr(aAdr, 1);
+	cache_Read(aAdr, nCode, nDI, NULL);
+	test_nTick += nSec * (1000 / OS_TICK_MS);
+	nRead = cache_nRead;
+	cache_Read(aAdr, nCode, nDI, NULL);
+	return cache_nRead == nRead;
+}
+
+static void cache_TestRule()
+{
+
+	//DL/T645-1997
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xC010, 0) == 0, "97 C010 cached");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xC011, 0) == 0, "97 C011 cached");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xB611, 14), "97 B611 not cached for 14s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xB611, 15) == 0, "97 B611 cached for 15s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0x9010, 59), "97 9010 not cached for 59s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0x9010, 60) == 0, "97 9010 cached for 60s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xA010, 59), "97 A010 not cached for 59s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xB212, 299), "97 B212 not cached for 299s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xC032, 599), "97 C032 not cached for 599s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ97, 0xC032, 600) == 0, "97 C032 cached for 600s");
+	//DL/T645-2007
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x04000101, 0) == 0, "07 04000101 cached");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x04000102, 0) == 0, "07 04000102 cached");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x00010000, 59), "07 00010000 not cached for 59s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x02010100, 14), "07 02010100 not cached for 14s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x02010100, 15) == 0, "07 02010100 cached for 15s");
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x05060101, 3599), "07 05060101 not cached for 3599s");
+	//ͬDIͬԼӰ
+	TEST_CHECK(cache_Hit(DLT645_CODE_READ07, 0x0000C010, 1), "07 0000C010 not cached");
+}
+
+static void cache_TestFlush()
+{
+	u8 aAdr[6], aData[6] = {0};
+	buf b = {0};
+	u32 nRead;
+
+	cache_Reset();
+	cache_Adr(aAdr, 2);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	dlt645_CacheRead(b, aAdr, CACHE_CODE_WRITE07, aData, sizeof(aData), cache_Meter, NULL);
+	buf_Release(b);
+	nRead = cache_nRead;
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	TEST_CHECK(cache_nRead == nRead + 1, "cache kept after write");
+}
+
+//ʱ̭δõ
+static void cache_TestLru()
+{
+	u8 aAdr[6];
+	u32 nRead;
+	int i;
+
+	cache_Reset();
+	for (i = 0; i < DLT645_CACHE_MAX; i++) {
+		cache_Adr(aAdr, i);
+		cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	}
+	cache_Adr(aAdr, 0);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	cache_Adr(aAdr, DLT645_CACHE_MAX);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	nRead = cache_nRead;
+	cache_Adr(aAdr, 0);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	TEST_CHECK(cache_nRead == nRead, "recently used entry evicted");
+	cache_Adr(aAdr, 1);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	TEST_CHECK(cache_nRead == nRead + 1, "least recently used entry kept");
+}
+
+static size_t cache_aLen[8];
+
+static void *cache_Thread(void *pArg)
+{
+	u8 aAdr[6];
+
+	cache_Adr(aAdr, 3);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x02010100, &cache_aLen[(long)pArg]);
+	return NULL;
+}
+
+//ֻͬһ;Ӧʱȴгõ
+static void cache_TestShare(size_t nReply, u32 nExpect)
+{
+	pthread_t aThd[ARR_SIZE(cache_aLen)];
+	long i;
+
+	cache_Reset();
+	cache_nReply = nReply;
+	cache_nInRead = 0;
+	cache_nGate = 1;
+	pthread_create(&aThd[0], NULL, cache_Thread, (void *)0);
+	while (cache_nInRead == 0)
+		usleep(100);
+	for (i = 1; i < ARR_SIZE(aThd); i++)
+		pthread_create(&aThd[i], NULL, cache_Thread, (void *)i);
+	usleep(20000);
+	cache_nGate = 0;
+	for (i = 0; i < ARR_SIZE(aThd); i++)
+		pthread_join(aThd[i], NULL);
+	TEST_CHECK(cache_nRead == nExpect, "reply %u: %u meter reads, expect %u", (u32)nReply, cache_nRead, nExpect);
+	for (i = 0; i < ARR_SIZE(aThd); i++)
+		TEST_CHECK(cache_aLen[i] == nReply, "reply %u: thread %ld got %u bytes", (u32)nReply, i, (u32)cache_aLen[i]);
+}
+
+//-------------------------------------------------------------------------
+//طվٲ,벻ĲοģͱȽϳ
+//ÿȫй,ÿ15ٲⲿֱĵѹ,
+//˹ظٲʱǰʱٲ
+//-------------------------------------------------------------------------
+static const struct {
+	u8		code;
+	u32		di;
+	u16		ttl;
+} cache_aTrace[] = {
+	{DLT645_CODE_READ07, 0x00010000, 60},
+	{DLT645_CODE_READ07, 0x02010100, 15},
+	{DLT645_CODE_READ07, 0x02020100, 15},
+	{DLT645_CODE_READ07, 0x04000101, 0},
+	{DLT645_CODE_READ97, 0x9010, 60},
+	{DLT645_CODE_READ97, 0xB611, 15},
+	{DLT645_CODE_READ97, 0xC010, 0},
+};
+
+static u32 cache_aExpire[CACHE_METER_QTY][ARR_SIZE(cache_aTrace)];
+static u32 cache_nReq, cache_nRefRead;
+
+static void cache_TraceReq(int nMeter, int nItem)
+{
+	u8 aAdr[6];
+	u32 nTtl = cache_aTrace[nItem].ttl * (1000 / OS_TICK_MS);
+
+	cache_Adr(aAdr, nMeter);
+	cache_Read(aAdr, cache_aTrace[nItem].code, cache_aTrace[nItem].di, NULL);
+	cache_nReq += 1;
+	if ((nTtl == 0) || ((s32)(test_nTick - cache_aExpire[nMeter][nItem]) >= 0)) {
+		cache_nRefRead += 1;
+		cache_aExpire[nMeter][nItem] = test_nTick + nTtl;
+	}
+}
+
+static void cache_TestTrace()
+{
+	u32 nSec, nHit, nRead, nShare;
+	int i, n;
+
+	cache_Reset();
+	memset(cache_aExpire, 0, sizeof(cache_aExpire));
+	cache_nReq = cache_nRefRead = 0;
+	for (nSec = 0; nSec < CACHE_TRACE_SEC; nSec++) {
+		test_nTick += 1000 / OS_TICK_MS;
+		if ((nSec % 60) == 0) {
+			for (i = 0; i < CACHE_METER_QTY; i++)
+				cache_TraceReq(i, (i & 1) ? 4 : 0);
+		}
+		if ((nSec % 15) == 0) {
+			for (i = 0; i < CACHE_METER_QTY / 4; i++) {
+				n = test_Rand() % CACHE_METER_QTY;
+				if (n & 1) {
+					cache_TraceReq(n, 5);
+				} else {
+					cache_TraceReq(n, 1);
+					cache_TraceReq(n, 2);
+				}
+			}
+		}
+		//˹ٲ,ڼظ
+		for (i = test_Rand() % 4; i; i--)
+			cache_TraceReq(test_Rand() % 8, test_Rand() % ARR_SIZE(cache_aTrace));
+		if ((nSec % 900) == 0) {
+			for (i = 0; i < CACHE_METER_QTY; i++)
+				cache_TraceReq(i, (i & 1) ? 6 : 3);
+		}
+	}
+	TEST_CHECK(cache_nRead == cache_nRefRead, "trace: %u meter reads, reference %u", cache_nRead, cache_nRefRead);
+	if (test_nBench) {
+		dlt645_CacheCount(&nHit, &nRead, &nShare);
+		printf("  trace %u s, %d meters: %u requests, %u meter reads (%.1f%% saved)\n",
+			CACHE_TRACE_SEC, CACHE_METER_QTY, cache_nReq, cache_nRead,
+			100.0 * (cache_nReq - cache_nRead) / cache_nReq);
+		printf("  cache counters: %u hits, %u misses, %u shared\n", nHit, nRead, nShare);
+	}
+}
+
+
+
+//External Functions
+sys_res chl_Send(chl p, const void *pData, size_t nLen)
+{
+
+	return SYS_R_OK;
+}
+
+sys_res chl_RecData(chl p, buf b, size_t nTmo)
+{
+
+	return SYS_R_TMO;
+}
+
+void gpio_Set(int nId, int nHL)
+{
+}
+
+int main(int argc, char **argv)
+{
+	u8 aAdr[6];
+
+	test_Init(argc, argv);
+
+	cache_TestRule();
+	cache_TestFlush();
+	cache_TestLru();
+	cache_TestShare(8, 1);
+	cache_TestShare(DLT645_CACHE_DATA_MAX + 16, ARR_SIZE(cache_aLen));
+	cache_TestTrace();
+
+	cache_Reset();
+	cache_Adr(aAdr, 9);
+	cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL);
+	TEST_BENCH("dlt645_CacheRead (hit)", 1000000, cache_Read(aAdr, DLT645_CODE_READ07, 0x00010000, NULL));
+
+	return test_Result("dlt645_cache");
+}
+
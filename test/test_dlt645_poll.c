@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_os.h"
+
+//,dlt645_DirHoldpIfȡ
+typedef struct {
+	struct {
+		u32	baud;
+	} para;
+} uart_t;
+
+#define DLT645_POLL_ENABLE		1
+#define DLT645_DIR_CTRL			1
+#define DLT645_POLL_PORT_MAX	4
+#define DLT645_POLL_JOB_MAX		64
+
+#include <cp/lcp/dlt645.h>
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+#include "../cp/lcp/dlt645.c"
+
+
+//Private Defines
+#define POLL_PIN_BASE			10
+#define POLL_PIN_MAX			(POLL_PIN_BASE + DLT645_POLL_PORT_MAX)
+#define POLL_TICK_MAX			100000
+
+
+//Private Typedefs
+//ģһRS485߼ϵĵ
+typedef struct {
+	uart_t	uart;
+	int		port;
+	int		delay;		//Ӧʱ(tick)
+	int		jitter;		//ʱ(tick)
+	int		loss;		//֡(%)
+	int		drop;		//ǰɸ
+	u32		due;		//Ӧ𵽴tick,0Ϊ
+	u8		reply[64];
+	int		len;
+	int		pos;		//ѵֽ
+	u32		nReq;
+	u32		nErr;		//
+} poll_bus_t;
+
+
+//Private Variables
+static dlt645_poll_t poll_x;
+static poll_bus_t poll_aBus[DLT645_POLL_PORT_MAX];
+static chl_t poll_aChl[DLT645_POLL_PORT_MAX];
+static int poll_aPin[POLL_PIN_MAX];
+static u32 poll_nBadPin;
+
+static u32 poll_nDone, poll_nOk, poll_nTmo, poll_nBadReply;
+static u32 poll_aOrder[DLT645_POLL_JOB_MAX], poll_nOrder;
+static u32 poll_aDoneTick[DLT645_POLL_PORT_MAX];
+
+
+//Internal Functions
+static void poll_Reset(int nBaud)
+{
+	int i;
+
+	dlt645_PollInit(&poll_x);
+	memset(poll_aBus, 0, sizeof(poll_aBus));
+	memset(poll_aPin, 0, sizeof(poll_aPin));
+	poll_nBadPin = 0;
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+	{
+		poll_aBus[i].uart.para.baud = nBaud;
+		poll_aBus[i].port = i;
+		poll_aBus[i].delay = 20;
+		poll_aChl[i].pIf = &poll_aBus[i];
+		TEST_CHECK(dlt645_PollAttach(&poll_x, i, &poll_aChl[i], POLL_PIN_BASE + i) == SYS_R_OK, "attach %d", i);
+		TEST_CHECK(poll_aPin[POLL_PIN_BASE + i] == 1, "port %d not left in receive", i);
+	}
+	TEST_CHECK(dlt645_PollAttach(&poll_x, DLT645_POLL_PORT_MAX, &poll_aChl[0], 0) != SYS_R_OK, "attach out of range");
+	poll_nDone = poll_nOk = poll_nTmo = poll_nBadReply = 0;
+	poll_nOrder = 0;
+	memset(poll_aDoneTick, 0, sizeof(poll_aDoneTick));
+}
+
+static void poll_Done(dlt645_job_t *pJob, sys_res res, const u8 *pData, size_t nLen)
+{
+
+	poll_nDone += 1;
+	if (poll_nOrder < ARR_SIZE(poll_aOrder))
+		poll_aOrder[poll_nOrder++] = (u32)(long)pJob->arg;
+	poll_aDoneTick[pJob->port] = test_nTick;
+	if (res != SYS_R_OK)
+	{
+		poll_nTmo += 1;
+		return;
+	}
+	poll_nOk += 1;
+	//Ӧ:롢ȡDIԡַֽ
+	if ((pData[0] != (pJob->code | 0x80)) || (nLen != pData[1] + 2) ||
+		memcmp(&pData[2], pJob->data, pJob->len) || (pData[2 + pJob->len] != pJob->adr[0]))
+		poll_nBadReply += 1;
+}
+
+static void poll_Job(int nPort, int nMeter, int nPrio, int nRetry, u32 nDeadline, int nTag)
+{
+	dlt645_job_t x;
+	u32 nDI = 0x00010000 + nMeter;
+
+	memset(&x, 0, sizeof(x));
+	x.port = nPort;
+	x.prio = nPrio;
+	x.retry = nRetry;
+	x.code = DLT645_CODE_READ07;
+	x.adr[0] = nMeter;
+	x.adr[1] = nPort;
+	x.len = 4;
+	memcpy(x.data, &nDI, 4);
+	x.tmo = 500;
+	x.deadline = nDeadline;
+	x.cb = poll_Done;
+	x.arg = (void *)(long)nTag;
+	TEST_CHECK(dlt645_PollSubmit(&poll_x, &x) == SYS_R_OK, "submit %d", nTag);
+}
+
+//еȫ˿ڿ,tick
+static u32 poll_Run()
+{
+	u32 nStart = test_nTick;
+
+	while (dlt645_PollHandler(&poll_x))
+	{
+		test_nTick += 1;
+		if ((test_nTick - nStart) > POLL_TICK_MAX)
+		{
+			TEST_CHECK(0, "poller stuck");
+			break;
+		}
+	}
+	return test_nTick - nStart;
+}
+
+static int poll_FreeQty()
+{
+
+	return poll_x.nfree;
+}
+
+//ȼߵȳ,ͬύ˳
+static void poll_TestOrder()
+{
+	static const u32 aExpect[] = {3, 1, 4, 2, 5};
+
+	poll_Reset(9600);
+	poll_Job(0, 1, 2, 0, 0, 1);
+	poll_Job(0, 2, 3, 0, 0, 2);
+	poll_Job(0, 3, 0, 0, 0, 3);
+	poll_Job(0, 4, 2, 0, 0, 4);
+	poll_Job(0, 5, 3, 0, 0, 5);
+	poll_Run();
+	TEST_CHECK(poll_nOk == 5, "order: %u ok", poll_nOk);
+	TEST_CHECK(memcmp(poll_aOrder, aExpect, sizeof(aExpect)) == 0, "order: %u %u %u %u %u",
+		poll_aOrder[0], poll_aOrder[1], poll_aOrder[2], poll_aOrder[3], poll_aOrder[4]);
+	TEST_CHECK(poll_nBadReply == 0, "order: %u bad replies", poll_nBadReply);
+	TEST_CHECK(poll_nBadPin == 0, "order: %u direction errors", poll_nBadPin);
+	TEST_CHECK(poll_FreeQty() == DLT645_POLL_JOB_MAX, "order: %d jobs leaked", DLT645_POLL_JOB_MAX - poll_FreeQty());
+}
+
+//֡ط,طֹʱʱ
+static void poll_TestRetry()
+{
+
+	poll_Reset(9600);
+	poll_aBus[0].drop = 2;
+	poll_Job(0, 1, 0, 2, 0, 1);
+	poll_Run();
+	TEST_CHECK((poll_nOk == 1) && (poll_aBus[0].nReq == 3), "retry: %u ok after %u requests", poll_nOk, poll_aBus[0].nReq);
+
+	poll_Reset(9600);
+	poll_aBus[1].drop = 2;
+	poll_Job(1, 1, 0, 1, 0, 1);
+	poll_Run();
+	TEST_CHECK((poll_nTmo == 1) && (poll_aBus[1].nReq == 2), "retry: %u timeouts after %u requests", poll_nTmo, poll_aBus[1].nReq);
+
+	//ֹʱڵһγʱǰ,ط
+	poll_Reset(9600);
+	poll_aBus[2].drop = 1;
+	poll_Job(2, 1, 0, 3, test_nTick + 30, 1);
+	poll_Run();
+	TEST_CHECK((poll_nTmo == 1) && (poll_aBus[2].nReq == 1), "deadline: %u timeouts after %u requests", poll_nTmo, poll_aBus[2].nReq);
+
+	//Ŷʱѹֹʱҵ
+	poll_Reset(9600);
+	poll_aBus[3].delay = 40;
+	poll_Job(3, 1, 0, 0, 0, 1);
+	poll_Job(3, 2, 1, 0, test_nTick + 30, 2);
+	poll_Run();
+	TEST_CHECK((poll_nOk == 1) && (poll_nTmo == 1) && (poll_aBus[3].nReq == 1), "expired: %u ok %u tmo %u requests",
+		poll_nOk, poll_nTmo, poll_aBus[3].nReq);
+	TEST_CHECK(poll_FreeQty() == DLT645_POLL_JOB_MAX, "retry: %d jobs leaked", DLT645_POLL_JOB_MAX - poll_FreeQty());
+}
+
+//˿ڶշ,ܺʱӽ˿ڶǶ˿
+static void poll_TestParallel()
+{
+	u32 nTick, nSerial;
+	int i, j;
+
+	poll_Reset(1200);
+	for (j = 0; j < 8; j++)
+	{
+		for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+		{
+			poll_aBus[i].delay = 30 + i * 5;
+			poll_Job(i, j, 0, 0, 0, j);
+		}
+	}
+	nTick = poll_Run();
+	//˿:л+Ӧʱ+߼
+	nSerial = 0;
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+		nSerial += 8 * (200 / OS_TICK_MS + poll_aBus[i].delay + DLT645_POLL_GAP / OS_TICK_MS);
+	TEST_CHECK(poll_nOk == 8 * DLT645_POLL_PORT_MAX, "parallel: %u ok", poll_nOk);
+	TEST_CHECK(nTick * 2 < nSerial, "parallel: %u ticks, serial %u", nTick, nSerial);
+	TEST_CHECK(poll_nBadPin == 0, "parallel: %u direction errors", poll_nBadPin);
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+		TEST_CHECK(poll_aBus[i].nErr == 0, "parallel: port %d replied while transmitting", i);
+	if (test_nBench)
+		printf("  %d ports x 8 jobs: %u ticks, %u if polled serially\n", DLT645_POLL_PORT_MAX, nTick, nSerial);
+}
+
+//ʱ붪֡,ÿҵǡûصһ
+static void poll_TestRandom()
+{
+	u32 nSubmit = 0, nTick;
+	int i, nRound;
+
+	poll_Reset(2400);
+	for (i = 0; i < DLT645_POLL_PORT_MAX; i++)
+	{
+		poll_aBus[i].delay = 12;
+		poll_aBus[i].jitter = 40;
+		poll_aBus[i].loss = 10 * i;
+	}
+	for (nRound = 0; nRound < 2000; nRound++)
+	{
+		while ((poll_FreeQty() > 8) && (test_Rand() & 1))
+		{
+			poll_Job(test_Rand() % DLT645_POLL_PORT_MAX, test_Rand() & 0xFF, test_Rand() & 3, test_Rand() % 3, 0, 0);
+			nSubmit += 1;
+		}
+		dlt645_PollHandler(&poll_x);
+		test_nTick += 1;
+	}
+	nTick = poll_Run();
+	TEST_CHECK(poll_nDone == nSubmit, "random: %u callbacks for %u jobs", poll_nDone, nSubmit);
+	TEST_CHECK(poll_nBadReply == 0, "random: %u bad replies", poll_nBadReply);
+	TEST_CHECK(poll_nBadPin == 0, "random: %u direction errors", poll_nBadPin);
+	TEST_CHECK(poll_FreeQty() == DLT645_POLL_JOB_MAX, "random: %d jobs leaked", DLT645_POLL_JOB_MAX - poll_FreeQty());
+	if (test_nBench)
+		printf("  random: %u jobs, %u ok, %u timeout, drained in %u ticks\n", nSubmit, poll_nOk, poll_nTmo, nTick);
+}
+
+
+
+//External Functions
+void gpio_Set(int nId, int nHL)
+{
+
+	if ((nId < POLL_PIN_BASE) || (nId >= POLL_PIN_MAX))
+	{
+		poll_nBadPin += 1;
+		return;
+	}
+	poll_aPin[nId] = nHL;
+}
+
+//󷢳ɵʱӦ,֡Ӧ
+sys_res chl_Send(chl p, const void *pData, size_t nLen)
+{
+	poll_bus_t *pBus = (poll_bus_t *)p->pIf;
+	const u8 *pH;
+	u8 aAdr[6], aData[8];
+	buf b = {0};
+
+	if (poll_aPin[POLL_PIN_BASE + pBus->port] != 0)
+		pBus->nErr += 1;
+	pH = dlt645_PacketAnalyze(pData, nLen);
+	if (pH == NULL)
+		return SYS_R_OK;
+	pBus->nReq += 1;
+	if (pBus->drop)
+	{
+		pBus->drop -= 1;
+		return SYS_R_OK;
+	}
+	if ((pBus->loss) && ((test_Rand() % 100) < pBus->loss))
+		return SYS_R_OK;
+
+	memcpy(aAdr, &pH[1], 6);
+	memcpy(aData, &pH[10], 4);
+	byteadd(aData, -0x33, 4);
+	aData[4] = aAdr[0];
+	dlt645_Packet2Buf(b, aAdr, pH[8] | 0x80, aData, 5);
+	//ǰֽ
+	memset(pBus->reply, 0xFE, 2);
+	memcpy(&pBus->reply[2], b->p, b->len);
+	pBus->len = b->len + 2;
+	buf_Release(b);
+	pBus->pos = 0;
+	pBus->due = test_nTick + pBus->delay + (pBus->jitter ? test_Rand() % pBus->jitter : 0) + 1;
+	return SYS_R_OK;
+}
+
+sys_res chl_RecData(chl p, buf b, size_t nTmo)
+{
+	poll_bus_t *pBus = (poll_bus_t *)p->pIf;
+
+	if ((pBus->due == 0) || ((s32)(test_nTick - pBus->due) < 0))
+		return SYS_R_TMO;
+	//ڷͷʱӦʧ
+	if (poll_aPin[POLL_PIN_BASE + pBus->port] == 0)
+	{
+		pBus->due = 0;
+		pBus->nErr += 1;
+		return SYS_R_TMO;
+	}
+	//Ӧtick
+	if (pBus->pos == 0)
+	{
+		pBus->pos = pBus->len / 2;
+		buf_Push(b, pBus->reply, pBus->pos);
+		return SYS_R_OK;
+	}
+	pBus->due = 0;
+	buf_Push(b, &pBus->reply[pBus->pos], pBus->len - pBus->pos);
+	return SYS_R_OK;
+}
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+
+	poll_TestOrder();
+	poll_TestRetry();
+	poll_TestParallel();
+	poll_TestRandom();
+
+	return test_Result("dlt645_poll");
+}
+
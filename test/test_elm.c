@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_rtt.h"
+
+#include "../fs/dfs.c"
+#include "../fs/dfs_fs.c"
+#include "../fs/dfs_file.c"
+#include "../fs/elmfat/ff.c"
+#include "../fs/dfs_elm.c"
+
+
+//Private Defines
+#define ELM_SECTORS				8192
+#define ELM_CLUST				(4 * 512)		//4MʽĴشС
+#define ELM_FILE_MAX			(640 * 1024)
+#define ELM_LOOP				4000
+
+
+//Private Variables
+static u8 elm_aDisk[ELM_SECTORS][512];
+static struct rt_device elm_dev;
+static u32 elm_nRead, elm_nReadSect, elm_nWrite;
+static u8 elm_aModel[ELM_FILE_MAX];		//ļ
+static rt_size_t elm_nSize;
+static u8 elm_aBuf[ELM_FILE_MAX];
+
+
+//Internal Functions
+//ڴ,ͳô
+static rt_size_t elm_DevRead(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+
+	if (pos + size > ELM_SECTORS)
+		return 0;
+	elm_nRead += 1;
+	elm_nReadSect += size;
+	memcpy(buffer, elm_aDisk[pos], size * 512);
+	return size;
+}
+
+static rt_size_t elm_DevWrite(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+
+	if (pos + size > ELM_SECTORS)
+		return 0;
+	elm_nWrite += 1;
+	memcpy(elm_aDisk[pos], buffer, size * 512);
+	return size;
+}
+
+static rt_err_t elm_DevControl(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+	struct rt_device_blk_geometry *p = args;
+
+	if (cmd == RT_DEVICE_CTRL_BLK_GETGEOME)
+	{
+		p->sector_count = ELM_SECTORS;
+		p->bytes_per_sector = 512;
+		p->block_size = 512;
+	}
+	return RT_EOK;
+}
+
+static void elm_Fill(u8 *p, rt_size_t nLen)
+{
+
+	for (; nLen; nLen--)
+		*p++ = test_Rand();
+}
+
+static int elm_Check(struct dfs_fd *pFd, rt_size_t nPos, rt_size_t nLen)
+{
+	int nRes;
+
+	if (dfs_file_lseek(pFd, nPos) != nPos)
+		return -1;
+	nRes = dfs_file_read(pFd, elm_aBuf, nLen);
+	if (nLen > elm_nSize - nPos)
+		nLen = elm_nSize - nPos;
+	if (nRes != nLen || pFd->pos != nPos + nLen)
+		return -1;
+	return memcmp(elm_aBuf, elm_aModel + nPos, nLen) ? 1 : 0;
+}
+
+static int elm_Write(struct dfs_fd *pFd, rt_size_t nPos, rt_size_t nLen)
+{
+
+	if (dfs_file_lseek(pFd, nPos) != nPos)
+		return -1;
+	elm_Fill(elm_aModel + nPos, nLen);
+	if (dfs_file_write(pFd, elm_aModel + nPos, nLen) != nLen)
+		return -1;
+	if (nPos + nLen > elm_nSize)
+		elm_nSize = nPos + nLen;
+	return (pFd->pos == nPos + nLen && pFd->size == elm_nSize) ? 0 : -1;
+}
+
+//ζļ˶,ֱӴ
+static int elm_Verify(const char *pPath)
+{
+	struct dfs_fd xFd;
+	rt_size_t i;
+	int nRes = 0;
+
+	if (dfs_file_open(&xFd, pPath, DFS_O_RDONLY) < 0)
+		return -1;
+	if (xFd.size != elm_nSize)
+		nRes = -1;
+	for (i = 0; nRes == 0 && i < elm_nSize; i += 300)
+	{
+		if (dfs_file_read(&xFd, elm_aBuf, 300) != MIN(300, elm_nSize - i))
+			nRes = -1;
+		else if (memcmp(elm_aBuf, elm_aModel + i, MIN(300, elm_nSize - i)))
+			nRes = 1;
+	}
+	dfs_file_close(&xFd);
+	return nRes;
+}
+
+//ļдɴ,pPathƬ
+static int elm_Fragment(const char *pPath, const char *pOther, int nFrag, int nMax)
+{
+	struct dfs_fd xFd, xOther;
+	u8 aClust[ELM_CLUST];
+	int i, j, n;
+
+	if (dfs_file_open(&xFd, pPath, DFS_O_RDWR | DFS_O_CREAT | DFS_O_TRUNC) < 0)
+		return -1;
+	if (dfs_file_open(&xOther, pOther, DFS_O_RDWR | DFS_O_CREAT | DFS_O_TRUNC) < 0)
+		return -1;
+	elm_nSize = 0;
+	for (i = 0; i < nFrag; i++)
+	{
+		n = test_Rand() % nMax + 1;
+		for (j = 0; j < n; j++)
+		{
+			if (elm_Write(&xFd, elm_nSize, ELM_CLUST))
+				return -1;
+		}
+		elm_Fill(aClust, ELM_CLUST);
+		if (dfs_file_write(&xOther, aClust, ELM_CLUST) != ELM_CLUST)
+			return -1;
+	}
+	dfs_file_close(&xOther);
+	dfs_file_close(&xFd);
+	return nFrag;
+}
+
+static void elm_TestMap()
+{
+	struct dfs_fd xFd;
+	struct elm_file *ef;
+	int nFrag;
+
+	//Ƭ,ļṹ
+	nFrag = elm_Fragment("/A.BIN", "/B.BIN", 10, 4);
+	TEST_CHECK(nFrag == 10 && elm_Verify("/A.BIN") == 0, "small map create");
+	TEST_CHECK(dfs_file_open(&xFd, "/A.BIN", DFS_O_RDONLY) == 0, "open A");
+	ef = xFd.data;
+	TEST_CHECK(dfs_file_lseek(&xFd, 0) == 0, "seek A");
+	TEST_CHECK(ef->clmt_state == ELM_CLMT_VALID && ef->fil.cltbl == ef->clmt, "inline map %d", ef->clmt_state);
+	elm_nRead = elm_nReadSect = 0;
+	TEST_CHECK(dfs_file_read(&xFd, elm_aBuf, elm_nSize) == elm_nSize, "read A");
+	TEST_CHECK(memcmp(elm_aBuf, elm_aModel, elm_nSize) == 0, "data A");
+	//ÿƬһ,FAT
+	TEST_CHECK(elm_nRead == nFrag && elm_nReadSect == elm_nSize / 512, "A read %u calls %u sectors", elm_nRead, elm_nReadSect);
+	dfs_file_close(&xFd);
+
+	//Ƭ,Ӷз
+	nFrag = elm_Fragment("/C.BIN", "/D.BIN", 60, 3);
+	TEST_CHECK(nFrag == 60 && elm_Verify("/C.BIN") == 0, "heap map create");
+	TEST_CHECK(dfs_file_open(&xFd, "/C.BIN", DFS_O_RDONLY) == 0, "open C");
+	ef = xFd.data;
+	TEST_CHECK(dfs_file_lseek(&xFd, 0) == 0, "seek C");
+	TEST_CHECK(ef->clmt_state == ELM_CLMT_VALID && ef->fil.cltbl != ef->clmt && ef->fil.cltbl[0] == 2 * nFrag + 2, "heap map %d", ef->clmt_state);
+	elm_nRead = 0;
+	TEST_CHECK(dfs_file_read(&xFd, elm_aBuf, elm_nSize) == elm_nSize, "read C");
+	TEST_CHECK(memcmp(elm_aBuf, elm_aModel, elm_nSize) == 0, "data C");
+	TEST_CHECK(elm_nRead == nFrag, "C read %u calls", elm_nRead);
+	dfs_file_close(&xFd);
+
+	//ʱ˻FatFsض
+	nFrag = elm_Fragment("/E.BIN", "/F.BIN", 300, 1);
+	TEST_CHECK(nFrag == 300 && elm_Verify("/E.BIN") == 0, "no map create");
+	TEST_CHECK(dfs_file_open(&xFd, "/E.BIN", DFS_O_RDONLY) == 0, "open E");
+	ef = xFd.data;
+	TEST_CHECK(dfs_file_lseek(&xFd, 0) == 0, "seek E");
+	TEST_CHECK(ef->clmt_state == ELM_CLMT_OFF && ef->fil.cltbl == RT_NULL, "map off %d", ef->clmt_state);
+	TEST_CHECK(dfs_file_read(&xFd, elm_aBuf, elm_nSize) == elm_nSize, "read E");
+	TEST_CHECK(memcmp(elm_aBuf, elm_aModel, elm_nSize) == 0, "data E");
+	dfs_file_close(&xFd);
+	dfs_file_unlink("/E.BIN");
+	dfs_file_unlink("/F.BIN");
+}
+
+static void elm_TestRandom()
+{
+	struct dfs_fd xFd;
+	rt_size_t nPos, nLen;
+	int i, nBad = 0;
+	u32 nOp;
+
+	elm_Fragment("/A.BIN", "/B.BIN", 20, 4);
+	TEST_CHECK(dfs_file_open(&xFd, "/A.BIN", DFS_O_RDWR) == 0, "open A rw");
+	for (i = 0; i < ELM_LOOP && nBad == 0; i++)
+	{
+		nOp = test_Rand();
+		nPos = test_Rand() % (elm_nSize + 1);
+		if (nOp & 1)
+			nPos &= ~511;
+		nLen = (test_Rand() % 12) * 512;
+		if (nOp & 2)
+			nLen += test_Rand() % 512;
+		switch ((nOp >> 2) % 32)
+		{
+		case 0:
+			//׷ʱʧЧ,´ζλؽ
+			if (elm_nSize + nLen <= ELM_FILE_MAX)
+				nBad = elm_Write(&xFd, elm_nSize, nLen);
+			break;
+		case 1:
+		case 2:
+		case 3:
+			if (nPos + nLen > elm_nSize)
+				nLen = elm_nSize - nPos;
+			nBad = elm_Write(&xFd, nPos, nLen);
+			break;
+		case 4:
+			//ɢд,ϲ
+			if (nPos + 20 > elm_nSize)
+				nPos = elm_nSize - 20;
+			nBad = elm_Write(&xFd, nPos | 7, 13);
+			//,֮
+			if (nBad == 0 && (nOp & 0x100) && (nPos & ~(rt_size_t)1023) + 4 * 512 <= elm_nSize)
+				nBad = elm_Write(&xFd, nPos & ~(rt_size_t)1023, 4 * 512);
+			if (nBad == 0)
+				nBad = elm_Check(&xFd, nPos | 7, 13);
+			if (nBad == 0)
+				nBad = elm_Check(&xFd, nPos & ~(rt_size_t)1023, 8 * 512);
+			break;
+		case 5:
+			dfs_file_close(&xFd);
+			nBad = elm_Verify("/A.BIN");
+			if (dfs_file_open(&xFd, "/A.BIN", DFS_O_RDWR) < 0)
+				nBad = -1;
+			break;
+		default:
+			nBad = elm_Check(&xFd, nPos, nLen);
+			break;
+		}
+	}
+	TEST_CHECK(nBad == 0, "random op %d failed %d", i, nBad);
+	TEST_CHECK(dfs_file_close(&xFd) == 0, "close A rw");
+	TEST_CHECK(elm_Verify("/A.BIN") == 0, "random verify");
+}
+
+static int elm_BenchRead(const char *pPath)
+{
+	struct dfs_fd xFd;
+	int nRes;
+
+	dfs_file_open(&xFd, pPath, DFS_O_RDONLY);
+	dfs_file_lseek(&xFd, 0);
+	nRes = dfs_file_read(&xFd, elm_aBuf, elm_nSize);
+	dfs_file_close(&xFd);
+	return nRes;
+}
+
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	elm_dev.read = elm_DevRead;
+	elm_dev.write = elm_DevWrite;
+	elm_dev.control = elm_DevControl;
+	rt_device_register(&elm_dev, "sd0", RT_DEVICE_FLAG_RDWR);
+	dfs_init();
+	elm_init();
+	TEST_CHECK(dfs_mount("sd0", "/", "elm", 0, RT_NULL) == 0, "mount");
+	TEST_CHECK(dfs_mkfs("elm", "sd0") == 0, "mkfs");
+
+	elm_TestMap();
+	elm_TestRandom();
+
+	elm_Fragment("/C.BIN", "/D.BIN", 60, 3);
+	TEST_BENCH("read 60 fragments", 200, elm_BenchRead("/C.BIN"));
+
+	return test_Result("elm");
+}
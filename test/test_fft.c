@@ -0,0 +1,167 @@
+#include <math.h>
+#include "test.h"
+#include <lib/fft.h>
+#include "../lib/math.c"
+#include "../lib/fft.c"
+
+
+//Private Defines
+#define FFT_TEST_QTY			1000
+
+
+//Private Variables
+static t_complex_fix fft_aBuf[FFT_POINT];
+static s16 fft_aA[FFT_POINT], fft_aB[FFT_POINT];
+static double fft_aDa[FFT_POINT], fft_aDb[FFT_POINT];
+
+
+//Internal Functions
+static double fft_Rand(double nMax)
+{
+
+	return (test_Rand() % 100000) * nMax / 100000;
+}
+
+//˫DFTο,صhгֵ(ֵ)λ()
+static void fft_Ref(const double *x, int h, double *pAmp, double *pPhs)
+{
+	double re = 0, im = 0;
+	int n, k = h * FFT_CYCLE;
+
+	for (n = 0; n < FFT_POINT; n++) {
+		re += x[n] * cos(2 * M_PI * k * n / FFT_POINT);
+		im -= x[n] * sin(2 * M_PI * k * n / FFT_POINT);
+	}
+	*pAmp = (h ? 2 : 1) * sqrt(re * re + im * im) / FFT_POINT;
+	*pPhs = atan2(im, re) * 180 / M_PI;
+}
+
+static double fft_PhsErr(double a, double b)
+{
+	double e = fabs(a - b);
+
+	return (e > 180) ? (360 - e) : e;
+}
+
+//ֱDFTȽ,
+static void fft_TestRadix2()
+{
+	double xr[FFT_POINT], xi[FFT_POINT], re, im, e;
+	int nBits, n, i, k;
+
+	for (nBits = 1; nBits <= FFT_POINT_BITS; nBits++) {
+		n = 1 << nBits;
+		for (i = 0; i < n; i++) {
+			xr[i] = fft_aBuf[i].real = (s32)(test_Rand() % 200000) - 100000;
+			xi[i] = fft_aBuf[i].imag = (s32)(test_Rand() % 200000) - 100000;
+		}
+		fft_Radix2(fft_aBuf, nBits);
+		for (k = 0; k < n; k++) {
+			re = im = 0;
+			for (i = 0; i < n; i++) {
+				re += xr[i] * cos(2 * M_PI * k * i / n) + xi[i] * sin(2 * M_PI * k * i / n);
+				im += xi[i] * cos(2 * M_PI * k * i / n) - xr[i] * sin(2 * M_PI * k * i / n);
+			}
+			e = hypot(re - fft_aBuf[k].real, im - fft_aBuf[k].imag);
+			TEST_CHECK(e <= 2 * n, "fft_Radix2(%d) bin %d err %.2f", n, k, e);
+		}
+	}
+}
+
+static void fft_TestPolar()
+{
+	double r = 3.5e7, e;
+	u32 nAmp;
+	s16 nPhs;
+	int a;
+
+	for (a = 0; a < 3600; a++) {
+		fft_Polar(lround(r * cos(a * M_PI / 1800)), lround(r * sin(a * M_PI / 1800)), &nAmp, &nPhs);
+		e = fabs(nAmp - r) / r;
+		TEST_CHECK(e < 1e-6, "fft_Polar(%d) amp err %.2e", a, e);
+		e = fft_PhsErr(nPhs / 100.0, a / 10.0);
+		TEST_CHECK(e <= 0.02, "fft_Polar(%d) phase err %.3f", a, e);
+	}
+}
+
+//·21гź,ֵ<=2LSB,λ<=0.5,THD<=0.03%
+static void fft_TestHarmonic(int nWin)
+{
+	double A[FFT_HARM_MAX + 1], P[FFT_HARM_MAX + 1], B[FFT_HARM_MAX + 1], Q[FFT_HARM_MAX + 1];
+	double x, y, am, ph, s2, a1, e, *d;
+	t_fft_harm ha, hb, *r;
+	int t, h, n, c;
+
+	for (t = 0; t < FFT_TEST_QTY; t++) {
+		for (h = 0; h <= FFT_HARM_MAX; h++) {
+			A[h] = (h == 1) ? 20000 + fft_Rand(8000) : fft_Rand(h ? 1200 : 200);
+			B[h] = (h == 1) ? 5000 + fft_Rand(20000) : fft_Rand(h ? 1500 : 200);
+			P[h] = fft_Rand(360);
+			Q[h] = fft_Rand(360);
+		}
+		for (n = 0; n < FFT_POINT; n++) {
+			x = A[0];
+			y = B[0];
+			for (h = 1; h <= FFT_HARM_MAX; h++) {
+				x += A[h] * cos(2 * M_PI * h * FFT_CYCLE * n / FFT_POINT + P[h] * M_PI / 180);
+				y += B[h] * cos(2 * M_PI * h * FFT_CYCLE * n / FFT_POINT + Q[h] * M_PI / 180);
+			}
+			fft_aA[n] = lround(fmax(-32768, fmin(32767, x)));
+			fft_aB[n] = lround(fmax(-32768, fmin(32767, y)));
+			fft_aDa[n] = fft_aA[n];
+			fft_aDb[n] = fft_aB[n];
+		}
+		fft_Harmonic(fft_aBuf, fft_aA, fft_aB, nWin, &ha, &hb);
+		for (c = 0; c < 2; c++) {
+			r = c ? &hb : &ha;
+			d = c ? fft_aDb : fft_aDa;
+			s2 = a1 = 0;
+			for (h = 0; h <= FFT_HARM_MAX; h++) {
+				fft_Ref(d, h, &am, &ph);
+				e = fabs(r->amp[h] / (double)(1 << FFT_AMP_Q) - am);
+				TEST_CHECK(e <= 2, "fft_Harmonic(win %d) ch %d h%d amp err %.2f", nWin, c, h, e);
+				if (h && (am > 100)) {
+					e = fft_PhsErr(r->phs[h] / 100.0, ph);
+					TEST_CHECK(e <= 0.5, "fft_Harmonic(win %d) ch %d h%d phase err %.2f", nWin, c, h, e);
+				}
+				if (h == 1)
+					a1 = am;
+				if (h >= 2)
+					s2 += am * am;
+			}
+			e = fabs(r->thd / 100.0 - 100 * sqrt(s2) / a1);
+			TEST_CHECK(e <= 0.03, "fft_Harmonic(win %d) ch %d thd err %.3f", nWin, c, e);
+		}
+	}
+}
+
+static u32 fft_BenchRef()
+{
+	double am, ph;
+	int h;
+
+	for (h = 0; h <= FFT_HARM_MAX; h++)
+		fft_Ref(fft_aDa, h, &am, &ph);
+	return (u32)am;
+}
+
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+	t_fft_harm ha, hb;
+
+	test_Init(argc, argv);
+
+	fft_TestRadix2();
+	fft_TestPolar();
+	fft_TestHarmonic(FFT_WIN_RECT);
+	fft_TestHarmonic(FFT_WIN_HANN);
+
+	TEST_BENCH("fft_Harmonic (2 channels)", 100000, (fft_Harmonic(fft_aBuf, fft_aA, fft_aB, FFT_WIN_RECT, &ha, &hb), ha.amp[1]));
+	TEST_BENCH("double DFT (1 channel)", 1000, fft_BenchRef());
+
+	return test_Result("fft");
+}
+
@@ -0,0 +1,429 @@
+#define _GNU_SOURCE
+#include <time.h>
+
+//⺯,glibcͬ
+#define gmtime_r				lib_gmtime_r
+#define localtime_r				lib_localtime_r
+#define mktime					lib_mktime
+#undef __isleap
+#define __isleap				lib_isleap
+#define LIB_MINILIBC_ENABLE		1
+
+#include "test.h"
+#include "test_os.h"
+#include <lib/mathlib.h>
+
+typedef struct {
+	u32		baud;
+} uart_para_t;
+
+#define GW3761_TYPE				GW3761_T_GWJC2009
+#include <cp/dlrcp.h>
+#include <cp/gw3761.h>
+#include "../lib/bcd.c"
+#include "../lib/time.c"
+#include "../lib/math.c"
+#include "../cp/gw3761_convert.c"
+
+
+//Private Defines
+#define GW_FIX(x)				((u32)DOUBLE2FIX(x))
+
+
+//Private Typedefs
+//AFN0C F25 ǰ༰/޹ʡѹڹ
+typedef struct {
+	time_t	time;
+	u32		p[4];
+	u32		q[4];
+	u32		pf[4];
+	u32		u[3];
+	u32		i[3];
+	u32		i0;
+	u32		s[4];
+} gw_f25_t;
+
+//AFN0D F161 նйʾֵʽ
+typedef struct {
+	time_t	time;
+	float	e[5];
+	u32		demand;
+	u32		pf;
+	u32		ratio;
+	u32		percent;
+	u32		count;
+	u32		angle;
+	u32		energy;
+	u32		fine;
+	time_t	read;
+	time_t	day;
+	time_t	hour;
+} gw_f161_t;
+
+
+//Private Consts
+static t_gw3761_conv gw_aConvF25[] = {
+	{FPOS(gw_f25_t, time), GW3761_DATA_T_15, 0, 0},
+	{FPOS(gw_f25_t, p[0]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, p[1]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, p[2]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, p[3]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, q[0]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, q[1]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, q[2]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, q[3]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, pf[0]), GW3761_DATA_T_05, 1, 0},
+	{FPOS(gw_f25_t, pf[1]), GW3761_DATA_T_05, 1, 0},
+	{FPOS(gw_f25_t, pf[2]), GW3761_DATA_T_05, 1, 0},
+	{FPOS(gw_f25_t, pf[3]), GW3761_DATA_T_05, 1, 0},
+	{FPOS(gw_f25_t, u[0]), GW3761_DATA_T_07, 0, 0},
+	{FPOS(gw_f25_t, u[1]), GW3761_DATA_T_07, 0, 0},
+	{FPOS(gw_f25_t, u[2]), GW3761_DATA_T_07, 0, 0},
+	{FPOS(gw_f25_t, i[0]), GW3761_DATA_T_25, 1, 0},
+	{FPOS(gw_f25_t, i[1]), GW3761_DATA_T_25, 1, 0},
+	{FPOS(gw_f25_t, i[2]), GW3761_DATA_T_25, 1, 0},
+	{FPOS(gw_f25_t, i0), GW3761_DATA_T_25, 1, 0},
+	{FPOS(gw_f25_t, s[0]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, s[1]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, s[2]), GW3761_DATA_T_09, 1, 0},
+	{FPOS(gw_f25_t, s[3]), GW3761_DATA_T_09, 1, 0},
+};
+
+static t_gw3761_conv gw_aConvF161[] = {
+	{FPOS(gw_f161_t, time), GW3761_DATA_T_15, 0, 0},
+	{FPOS(gw_f161_t, e[0]), GW3761_DATA_T_14, 0, 0},
+	{FPOS(gw_f161_t, e[1]), GW3761_DATA_T_14, 0, 0},
+	{FPOS(gw_f161_t, e[2]), GW3761_DATA_T_14, 0, 0},
+	{FPOS(gw_f161_t, e[3]), GW3761_DATA_T_14, 0, 0},
+	{FPOS(gw_f161_t, e[4]), GW3761_DATA_T_14, 0, 0},
+	{FPOS(gw_f161_t, demand), GW3761_DATA_T_23, 0, 0},
+	{FPOS(gw_f161_t, pf), GW3761_DATA_T_26, 0, 0},
+	{FPOS(gw_f161_t, ratio), GW3761_DATA_T_22, 0, 0},
+	{FPOS(gw_f161_t, percent), GW3761_DATA_T_05, 1, 2},
+	{FPOS(gw_f161_t, count), GW3761_DATA_T_03, 1, 0},
+	{FPOS(gw_f161_t, angle), GW3761_DATA_T_06, 1, 0},
+	{FPOS(gw_f161_t, energy), GW3761_DATA_T_11, 0, 0},
+	{FPOS(gw_f161_t, fine), GW3761_DATA_T_13, 0, 0},
+	{FPOS(gw_f161_t, read), GW3761_DATA_T_01, 0, 0},
+	{FPOS(gw_f161_t, day), GW3761_DATA_T_17, 0, 0},
+	{FPOS(gw_f161_t, hour), GW3761_DATA_T_18, 0, 0},
+};
+
+//ֳ¼,2014-03-18 10:25
+static const gw_f25_t gw_xF25 = {
+	1395138300,
+	{GW_FIX(3.2514), GW_FIX(1.0625), GW_FIX(1.1109), GW_FIX(1.0780)},
+	{GW_FIX(0.8120), GW_FIX(0.2513), GW_FIX(-0.2807), GW_FIX(0.2790)},
+	{GW_FIX(97.0), GW_FIX(97.3), GW_FIX(-96.1), GW_FIX(96.8)},
+	{GW_FIX(221.3), GW_FIX(220.8), GW_FIX(222.1)},
+	{GW_FIX(4.912), GW_FIX(5.134), GW_FIX(-4.996)},
+	GW_FIX(0.125),
+	{GW_FIX(3.3512), GW_FIX(1.0917), GW_FIX(1.1458), GW_FIX(1.1137)},
+};
+
+static const gw_f161_t gw_xF161 = {
+	1395072000,
+	{12345.67f, 3210.55f, 4120.08f, 2980.11f, 2034.93f},
+	GW_FIX(3.4021),
+	GW_FIX(0.985),
+	GW_FIX(2.5),
+	GW_FIX(-1.53),
+	GW_FIX(-1234),
+	GW_FIX(-120.25),
+	GW_FIX(123456.78),
+	GW_FIX(234.5625),
+	1395138312,
+	1395072000,
+	1395136800,
+};
+
+
+//ԭת¼ı
+static const u8 gw_aF25[] = {
+	0x25, 0x10, 0x18, 0x03, 0x14, 0x13, 0x25, 0x03, 0x25, 0x06, 0x01, 0x08,
+	0x11, 0x01, 0x79, 0x07, 0x01, 0x19, 0x81, 0x00, 0x12, 0x25, 0x00, 0x06,
+	0x28, 0x80, 0x89, 0x27, 0x00, 0x70, 0x09, 0x73, 0x09, 0x61, 0x89, 0x68,
+	0x09, 0x13, 0x22, 0x08, 0x22, 0x21, 0x22, 0x12, 0x49, 0x00, 0x34, 0x51,
+	0x00, 0x96, 0x49, 0x80, 0x25, 0x01, 0x00, 0x12, 0x35, 0x03, 0x17, 0x09,
+	0x01, 0x58, 0x14, 0x01, 0x36, 0x11, 0x01,
+};
+static const u8 gw_aF161[] = {
+	0x00, 0x16, 0x17, 0x03, 0x14, 0x00, 0x67, 0x45, 0x23, 0x01, 0x00, 0x55,
+	0x10, 0x32, 0x00, 0x00, 0x08, 0x20, 0x41, 0x00, 0x00, 0x11, 0x80, 0x29,
+	0x00, 0x00, 0x93, 0x34, 0x20, 0x00, 0x21, 0x40, 0x03, 0x85, 0x09, 0x25,
+	0x30, 0x95, 0x34, 0x12, 0x00, 0x10, 0x25, 0xA0, 0x78, 0x56, 0x34, 0x12,
+	0x25, 0x56, 0x34, 0x02, 0x12, 0x25, 0x10, 0x18, 0x43, 0x14, 0x00, 0x16,
+	0x17, 0x14, 0x00, 0x10, 0x18,
+};
+
+
+
+//Internal Functions
+//ԭתı
+static size_t gw_OldF25(u8 *p, const gw_f25_t *r)
+{
+	u8 *p0 = p;
+	int i;
+
+	gw3761_ConvertData_15(p, r->time);
+	p += 5;
+	for (i = 0; i < 4; i++, p += 3)
+		gw3761_ConvertData_09(p, r->p[i], 1);
+	for (i = 0; i < 4; i++, p += 3)
+		gw3761_ConvertData_09(p, r->q[i], 1);
+	for (i = 0; i < 4; i++, p += 2)
+		gw3761_ConvertData_05(p, r->pf[i], 1);
+	for (i = 0; i < 3; i++, p += 2)
+		gw3761_ConvertData_07(p, r->u[i]);
+	for (i = 0; i < 3; i++, p += 3)
+		gw3761_ConvertData_25(p, r->i[i], 1);
+	gw3761_ConvertData_25(p, r->i0, 1);
+	p += 3;
+	for (i = 0; i < 4; i++, p += 3)
+		gw3761_ConvertData_09(p, r->s[i], 1);
+	return p - p0;
+}
+
+static size_t gw_OldF161(u8 *p, const gw_f161_t *r)
+{
+	u8 *p0 = p;
+	int i;
+
+	gw3761_ConvertData_15(p, r->time);
+	p += 5;
+	for (i = 0; i < 5; i++, p += 5)
+		gw3761_ConvertData_14(p, r->e[i]);
+	gw3761_ConvertData_23(p, r->demand);
+	p += 3;
+	gw3761_ConvertData_26(p, r->pf);
+	p += 2;
+	gw3761_ConvertData_22(p, r->ratio);
+	p += 1;
+	gw3761_ConvertData_05_Percent(p, r->percent, 1);
+	p += 2;
+	gw3761_ConvertData_03(p, r->count, 1);
+	p += 4;
+	gw3761_ConvertData_06(p, r->angle, 1);
+	p += 2;
+	gw3761_ConvertData_11(p, r->energy);
+	p += 4;
+	gw3761_ConvertData_13(p, r->fine);
+	p += 4;
+	gw3761_ConvertData_01(p, r->read);
+	p += 6;
+	gw3761_ConvertData_17(p, r->day);
+	p += 4;
+	gw3761_ConvertData_18(p, r->hour);
+	p += 3;
+	return p - p0;
+}
+
+//ֳ¼:¾ֱ붼Ӧ¼ıһ
+static void gw_TestGolden()
+{
+	static gw_f25_t aF25[8];
+	u8 aOld[sizeof(gw_aF161) + 16], aNew[sizeof(gw_aF25) * ARR_SIZE(aF25)];
+	int i, n;
+
+	n = gw_OldF25(aOld, &gw_xF25);
+	TEST_CHECK((n == sizeof(gw_aF25)) && (memcmp(aOld, gw_aF25, n) == 0), "F25 old path differs from golden");
+	n = gw3761_ConvertRecord(aNew, &gw_xF25, sizeof(gw_f25_t), 1, gw_aConvF25, ARR_SIZE(gw_aConvF25));
+	TEST_CHECK((n == sizeof(gw_aF25)) && (memcmp(aNew, gw_aF25, n) == 0), "F25 record differs from golden");
+
+	n = gw_OldF161(aOld, &gw_xF161);
+	TEST_CHECK((n == sizeof(gw_aF161)) && (memcmp(aOld, gw_aF161, n) == 0), "F161 old path differs from golden");
+	n = gw3761_ConvertRecord(aNew, &gw_xF161, sizeof(gw_f161_t), 1, gw_aConvF161, ARR_SIZE(gw_aConvF161));
+	TEST_CHECK((n == sizeof(gw_aF161)) && (memcmp(aNew, gw_aF161, n) == 0), "F161 record differs from golden");
+
+	//¼α
+	for (i = 0; i < ARR_SIZE(aF25); i++)
+		aF25[i] = gw_xF25;
+	n = gw3761_ConvertRecord(aNew, aF25, sizeof(gw_f25_t), ARR_SIZE(aF25), gw_aConvF25, ARR_SIZE(gw_aConvF25));
+	TEST_CHECK(n == sizeof(aNew), "F25 x%d: %d bytes", (int)ARR_SIZE(aF25), n);
+	for (i = 0; i < ARR_SIZE(aF25); i++)
+		TEST_CHECK(memcmp(&aNew[i * sizeof(gw_aF25)], gw_aF25, sizeof(gw_aF25)) == 0, "F25 record %d differs", i);
+}
+
+static void gw_TestInvalid()
+{
+	static t_gw3761_conv aBad[] = {{0, GW3761_DATA_T_02, 0, 0}};
+	gw_f25_t x = gw_xF25;
+	u8 aOut[sizeof(gw_aF25)];
+	int n;
+
+	//ЧֵΪ0xEE
+	x.u[1] = GW3761_DATA_INVALID;
+	x.i[2] = GW3761_DATA_INVALID;
+	n = gw3761_ConvertRecord(aOut, &x, sizeof(x), 1, gw_aConvF25, ARR_SIZE(gw_aConvF25));
+	TEST_CHECK(n == sizeof(gw_aF25), "invalid: %d bytes", n);
+	TEST_CHECK((aOut[39] == 0xEE) && (aOut[40] == 0xEE), "invalid A.7 not EE");
+	TEST_CHECK((aOut[49] == 0xEE) && (aOut[50] == 0xEE) && (aOut[51] == 0xEE), "invalid A.25 not EE");
+	TEST_CHECK(memcmp(aOut, gw_aF25, 39) == 0, "invalid: fields before changed");
+	TEST_CHECK(memcmp(&aOut[52], &gw_aF25[52], n - 52) == 0, "invalid: fields after changed");
+
+	//ֵ֧ĸʽ
+	TEST_CHECK(gw3761_ConvertRecord(aOut, &x, sizeof(x), 1, aBad, 1) == -1, "A.2 accepted");
+}
+
+//-------------------------------------------------------------------------
+//ֵȽ:ԭfloat,floatܾȷʾķΧӦһ,
+//±ӦȷĽ
+//-------------------------------------------------------------------------
+typedef void (*gw_conv_s)(void *, u32, int);
+typedef void (*gw_conv_u)(void *, u32);
+
+static const struct {
+	u8			type;
+	u8			sign;
+	u8			scale;
+	gw_conv_s	fs;
+	gw_conv_u	fu;
+} gw_aCase[] = {
+	{GW3761_DATA_T_03, 1, 0, gw3761_ConvertData_03, NULL},
+	{GW3761_DATA_T_05, 1, 0, gw3761_ConvertData_05, NULL},
+	{GW3761_DATA_T_05, 1, 2, gw3761_ConvertData_05_Percent, NULL},
+	{GW3761_DATA_T_06, 1, 0, gw3761_ConvertData_06, NULL},
+	{GW3761_DATA_T_07, 0, 0, NULL, gw3761_ConvertData_07},
+	{GW3761_DATA_T_09, 1, 0, gw3761_ConvertData_09, NULL},
+	{GW3761_DATA_T_11, 0, 0, NULL, gw3761_ConvertData_11},
+	{GW3761_DATA_T_13, 0, 0, NULL, gw3761_ConvertData_13},
+	{GW3761_DATA_T_22, 0, 0, NULL, gw3761_ConvertData_22},
+	{GW3761_DATA_T_23, 0, 0, NULL, gw3761_ConvertData_23},
+	{GW3761_DATA_T_25, 1, 0, gw3761_ConvertData_25, NULL},
+	{GW3761_DATA_T_26, 0, 0, NULL, gw3761_ConvertData_26},
+};
+
+static void gw_TestRandom()
+{
+	t_gw3761_format *pFmt;
+	struct {
+		u16	ofs;
+		u8	type;
+		u8	sign : 1,
+			scale : 7;
+	} xConv;
+	u8 aOld[4], aNew[4];
+	u32 nData, nMag, nExact, nTotal = 0, nFloat = 0;
+	u64 nTemp;
+	int c, i, n, nSign, nDec;
+
+	for (c = 0; c < ARR_SIZE(gw_aCase); c++)
+	{
+		pFmt = &gw3761_tblFormat[gw_aCase[c].type];
+		nDec = pFmt->dec + gw_aCase[c].scale;
+		for (i = 0; i < 100000; i++)
+		{
+			switch (i % 3)
+			{
+			case 0:
+				nData = test_Rand() % (1 << 20);
+				break;
+			case 1:
+				nData = test_Rand() % (1 << 26);
+				break;
+			default:
+				nData = test_Rand() & 0x7FFFFFFF;
+				break;
+			}
+			nSign = gw_aCase[c].sign && (test_Rand() & 1);
+			if (nSign && (test_Rand() & 1))
+				nData = -(s32)nData;
+			if (nData == GW3761_DATA_INVALID)
+				continue;
+
+			memset(aOld, 0, sizeof(aOld));
+			memset(aNew, 0, sizeof(aNew));
+			if (gw_aCase[c].fs != NULL)
+				gw_aCase[c].fs(aOld, nData, nSign);
+			else
+				gw_aCase[c].fu(aOld, nData);
+			xConv.ofs = 0;
+			xConv.type = gw_aCase[c].type;
+			xConv.sign = nSign;
+			xConv.scale = gw_aCase[c].scale;
+			n = gw3761_ConvertRecord(aNew, &nData, sizeof(nData), 1, (t_gw3761_conv *)&xConv, 1);
+			nTotal += 1;
+
+			nMag = (nSign && ((s32)nData < 0)) ? -(s32)nData : nData;
+			nTemp = ((u64)nMag * math_pow10[nDec] + (1 << (EXP - 1))) >> EXP;
+			nExact = ((u32)bin2bcd64(nTemp) & pFmt->mask);
+			if (nSign && pFmt->signbit && ((s32)nData < 0))
+				nExact |= BITMASK(pFmt->signbit);
+			TEST_CHECK((n == pFmt->size) && (memcmp(aNew, &nExact, n) == 0), "A.%d%s %08X: not exactly rounded",
+				gw_aCase[c].type, gw_aCase[c].scale ? "%" : "", nData);
+
+			//float24λβԭ
+			if (((u64)nMag * math_pow10[nDec]) < (1 << 24))
+				TEST_CHECK(memcmp(aOld, aNew, n) == 0, "A.%d%s %08X: differs from gw3761_ConvertData",
+					gw_aCase[c].type, gw_aCase[c].scale ? "%" : "", nData);
+			else if (memcmp(aOld, aNew, n))
+				nFloat += 1;
+		}
+	}
+	if (test_nBench)
+		printf("  %u random values, %u where the float path rounds differently\n", nTotal, nFloat);
+}
+
+//A.14ʱʽȽ
+static void gw_TestFloatTime()
+{
+	static t_gw3761_conv aConv[] = {
+		{0, GW3761_DATA_T_14, 0, 0},
+		{8, GW3761_DATA_T_01, 0, 0},
+		{8, GW3761_DATA_T_15, 0, 0},
+		{8, GW3761_DATA_T_17, 0, 0},
+		{8, GW3761_DATA_T_18, 0, 0},
+	};
+	struct {
+		float	f;
+		u32		pad;
+		time_t	t;
+	} x;
+	u8 aOld[32], aNew[32];
+	int i, n;
+
+	for (i = 0; i < 20000; i++)
+	{
+		x.f = (test_Rand() % 100000000) / 100.0f;
+		x.t = 946684800 + test_Rand() % 1000000000;
+		gw3761_ConvertData_14(aOld, x.f);
+		gw3761_ConvertData_01(&aOld[5], x.t);
+		gw3761_ConvertData_15(&aOld[11], x.t);
+		gw3761_ConvertData_17(&aOld[16], x.t);
+		gw3761_ConvertData_18(&aOld[20], x.t);
+		n = gw3761_ConvertRecord(aNew, &x, sizeof(x), 1, aConv, ARR_SIZE(aConv));
+		TEST_CHECK((n == 23) && (memcmp(aOld, aNew, 23) == 0), "A.14/time: %.2f %ld", x.f, (long)x.t);
+	}
+}
+
+static gw_f25_t gw_aRec[64];
+static u8 gw_aOut[sizeof(gw_aF25) * ARR_SIZE(gw_aRec)];
+
+static int gw_BenchOld()
+{
+	int i;
+
+	for (i = 0; i < ARR_SIZE(gw_aRec); i++)
+		gw_OldF25(&gw_aOut[i * sizeof(gw_aF25)], &gw_aRec[i]);
+	return gw_aOut[0];
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	test_Init(argc, argv);
+
+	gw_TestGolden();
+	gw_TestInvalid();
+	gw_TestRandom();
+	gw_TestFloatTime();
+
+	for (i = 0; i < ARR_SIZE(gw_aRec); i++)
+		gw_aRec[i] = gw_xF25;
+	TEST_BENCH("F25 x64 gw3761_ConvertData", 2000, gw_BenchOld());
+	TEST_BENCH("F25 x64 gw3761_ConvertRecord", 2000, gw3761_ConvertRecord(gw_aOut, gw_aRec, sizeof(gw_f25_t), ARR_SIZE(gw_aRec), gw_aConvF25, ARR_SIZE(gw_aConvF25)));
+
+	return test_Result("gw3761");
+}
+
@@ -0,0 +1,116 @@
+#include "test.h"
+#include "../lib/ecc.c"
+
+
+//Private Defines
+#define IPCS_BUF_SIZE			1600
+
+
+//Private Variables
+static u8 ipcs_aBuf[IPCS_BUF_SIZE + 8];
+
+
+//Internal Functions
+//οʵ,ԭbdip16λۼӵchksum
+static u16 ipcs_Ref(u16 sum, const u8 *p, size_t len)
+{
+	u16 t;
+	const u8 *last = p + len - 1;
+
+	for (; p < last; p += 2) {
+		t = (p[0] << 8) + p[1];
+		sum += t;
+		if (sum < t)
+			sum++;
+	}
+	if (p == last) {
+		t = p[0] << 8;
+		sum += t;
+		if (sum < t)
+			sum++;
+	}
+	return sum;
+}
+
+static u32 ipcs_Get32(const u8 *p)
+{
+
+	return ((u32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void ipcs_Set32(u8 *p, u32 n)
+{
+
+	p[0] = n >> 24;
+	p[1] = n >> 16;
+	p[2] = n >> 8;
+	p[3] = n;
+}
+
+static u16 ipcs_Fold(u16 cs)
+{
+
+	//0x00000xFFFFڷеȼ
+	return (cs == 0xFFFF) ? 0 : cs;
+}
+
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+	size_t nOfs, nLen;
+	u16 cs, cs1;
+	u32 i, m, m1;
+	int sum;
+
+	test_Init(argc, argv);
+
+	for (i = 0; i < sizeof(ipcs_aBuf); i++)
+		ipcs_aBuf[i] = test_Rand();
+
+	//ȫʼ뷽ʽ볤
+	for (nOfs = 0; nOfs < 8; nOfs++) {
+		for (nLen = 0; nLen <= IPCS_BUF_SIZE; nLen++) {
+			sum = (nLen & 3) ? (test_Rand() & 0xFFFF) : 0;
+			cs = ipcs(sum, &ipcs_aBuf[nOfs], nLen);
+			cs1 = ipcs_Ref(sum, &ipcs_aBuf[nOfs], nLen);
+			TEST_CHECK(ipcs_Fold(cs) == ipcs_Fold(cs1),
+				"ipcs(%04X, +%u, %u) = %04X, expect %04X", sum, (u32)nOfs, (u32)nLen, cs, cs1);
+		}
+	}
+
+	//ȫ0xFF,λؾ
+	memset(ipcs_aBuf, 0xFF, sizeof(ipcs_aBuf));
+	for (nOfs = 0; nOfs < 4; nOfs++) {
+		cs = ipcs(0, &ipcs_aBuf[nOfs], IPCS_BUF_SIZE - 1);
+		cs1 = ipcs_Ref(0, &ipcs_aBuf[nOfs], IPCS_BUF_SIZE - 1);
+		TEST_CHECK(ipcs_Fold(cs) == ipcs_Fold(cs1), "ipcs(0xFF, +%u) = %04X, expect %04X", (u32)nOfs, cs, cs1);
+	}
+
+	//һ
+	for (i = 0; i < 100000; i++) {
+		nLen = 20 + (test_Rand() % 40) * 2;
+		for (nOfs = 0; nOfs < nLen; nOfs++)
+			ipcs_aBuf[nOfs] = test_Rand();
+		nOfs = (test_Rand() % (nLen / 4)) * 4;
+		cs = ~ipcs(0, ipcs_aBuf, nLen);
+		m = ipcs_Get32(&ipcs_aBuf[nOfs]);
+		m1 = test_Rand();
+		if ((i & 3) == 0)
+			m1 = m ^ 0xFFFF;
+		ipcs_Set32(&ipcs_aBuf[nOfs], m1);
+		cs1 = ~ipcs(0, ipcs_aBuf, nLen);
+		cs = ipcs_update32(cs, m, m1);
+		TEST_CHECK(ipcs_Fold(~cs & 0xFFFF) == ipcs_Fold(~cs1 & 0xFFFF),
+			"ipcs_update32(%08X->%08X) = %04X, expect %04X", m, m1, cs, cs1);
+	}
+
+	TEST_BENCH("ipcs 1500B", 100000, ipcs(0, &ipcs_aBuf[(_i & 1) << 1], 1500));
+	TEST_BENCH("ipcs_Ref 1500B", 100000, ipcs_Ref(0, &ipcs_aBuf[(_i & 1) << 1], 1500));
+	TEST_BENCH("ipcs 20B", 10000000, ipcs(0, &ipcs_aBuf[(_i & 1) << 2], 20));
+	TEST_BENCH("ipcs_update32", 10000000, ipcs_update32(_i, _i * 3, _i * 5));
+
+	return test_Result("ipcs");
+}
+
@@ -0,0 +1,401 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include <math.h>
+
+#define ATT7022_ENABLE			1
+#define ATT7022_COMID			0
+#define ATT7022_CSID			0
+#define ATT7022_DEBUG_ENABLE	0
+#define ATT7022_SNAP_ENABLE		1
+#define RN8302_ENABLE			1
+#define RN8302_COMID			1
+#define RN8302_CSID				0
+#define RN8302_DEBUG_ENABLE		0
+#define RN8302_SNAP_ENABLE		1
+#define SPI_SEL_ENABLE			0
+#define OS_TMO_FOREVER			0
+
+//SPIGPIOOS
+typedef struct {
+	int		id;
+} spi_t;
+
+struct gpio_def {
+	int		pin;
+};
+typedef const struct gpio_def t_gpio_def;
+
+#define SPI_SCKIDLE_LOW			0
+#define SPI_LATCH_2EDGE			1
+
+spi_t *spi_Open(int nId, size_t nTmo);
+sys_res spi_Close(spi_t *p);
+sys_res spi_Config(spi_t *p, int nSckMode, int nLatch, int nSpeed);
+sys_res spi_Send(spi_t *p, const void *pData, size_t nLen);
+sys_res spi_Transce(spi_t *p, const void *pCmd, size_t nCmdLen, void *pRec, size_t nRecLen);
+
+static u32 mt_nSleep;
+#define os_thd_lock()
+#define os_thd_unlock()
+#define os_tick_get()			(mt_nSleep)
+#define sys_Delay(us)
+
+static void os_thd_slp1tick()
+{
+
+	mt_nSleep += 1;
+}
+
+static void os_thd_sleep(size_t nMs)
+{
+
+	mt_nSleep += 1;
+}
+
+static void sys_GpioConf(t_gpio_def *p)
+{
+}
+
+static void sys_GpioSet(t_gpio_def *p, int nHL)
+{
+}
+
+static int sys_GpioGet(t_gpio_def *p)
+{
+
+	return 0;
+}
+
+#define gpio_node(n, i)			(n[0] + (i))
+static t_gpio_def mt_aGpio[2];
+static t_gpio_def *tbl_bspAtt7022[] = {mt_aGpio, mt_aGpio + 2};
+static t_gpio_def *tbl_bspRn8302[] = {mt_aGpio, mt_aGpio + 2};
+
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+
+//տ;ɼ,ģⵥϲɼռ
+static int mt_bPreempt;
+static void mt_Preempt(void);
+
+static void *mt_Memcpy(void *pDst, const void *pSrc, size_t nLen)
+{
+	u8 *pD = pDst;
+	const u8 *pS = pSrc;
+	size_t i, nAt;
+
+	nAt = mt_bPreempt ? test_Rand() % nLen : nLen;
+	for (i = 0; i < nLen; i++)
+	{
+		if (i == nAt)
+			mt_Preempt();
+		pD[i] = pS[i];
+	}
+	return pDst;
+}
+
+#undef memcpy
+#define memcpy					mt_Memcpy
+#include "../drivers/att7022.c"
+#include "../drivers/rn8302.c"
+#undef memcpy
+
+
+
+//Private Defines
+#define MT_ATT					0
+#define MT_RN					1
+#define MT_FAIL_ALWAYS			0xFF
+
+
+//Private Variables
+//оƬ:Ĵֵźʹ,RData/RSPIDataϴζ
+static u32 mt_nGen;
+static u32 mt_aLast[2];
+static u8 mt_aFail[2][0x10000];		//ĴУʧܵĴ
+static u32 mt_nOpen, mt_nXfer;
+static spi_t mt_aSpi[2];
+static const u8 mt_aAttReg[] = {
+	ATT7022_REG_PA, ATT7022_REG_PB, ATT7022_REG_PC, ATT7022_REG_PT,
+	ATT7022_REG_QA, ATT7022_REG_QB, ATT7022_REG_QC, ATT7022_REG_QT,
+	ATT7022_REG_URmsA, ATT7022_REG_URmsB, ATT7022_REG_URmsC,
+	ATT7022_REG_IRmsA, ATT7022_REG_IRmsB, ATT7022_REG_IRmsC,
+	ATT7022_REG_PfA, ATT7022_REG_PfB, ATT7022_REG_PfC, ATT7022_REG_PfT,
+	ATT7022_REG_Freq, ATT7022_REG_EpA2, ATT7022_REG_EpB2, ATT7022_REG_EpC2,
+	ATT7022_REG_SFlag, ATT7022_REG_PFlag,
+};
+static const rn8302_snapreg_t mt_aRnReg[] = {
+	{0x0007, 4}, {0x0008, 4}, {0x0009, 4}, {0x000B, 4}, {0x000C, 4}, {0x000D, 4},
+	{0x0014, 4}, {0x0015, 4}, {0x0016, 4}, {0x0017, 4}, {0x0039, 3}, {0x003A, 3},
+	{0x003B, 3}, {0x0057, 2}, {0x00A2, 3}, {0x0102, 2}, {0x0103, 2}, {0x0104, 2},
+};
+
+
+//Internal Functions
+static u32 mt_Value(int nChip, u32 nReg)
+{
+
+	return (mt_nGen << 16) ^ (nReg * 0x9E3779B1) ^ ((u32)nChip << 31);
+}
+
+spi_t *spi_Open(int nId, size_t nTmo)
+{
+
+	mt_nOpen += 1;
+	mt_aSpi[nId].id = nId;
+	return &mt_aSpi[nId];
+}
+
+sys_res spi_Close(spi_t *p)
+{
+
+	return SYS_R_OK;
+}
+
+sys_res spi_Config(spi_t *p, int nSckMode, int nLatch, int nSpeed)
+{
+
+	return SYS_R_OK;
+}
+
+sys_res spi_Send(spi_t *p, const void *pData, size_t nLen)
+{
+
+	return SYS_R_OK;
+}
+
+//ݸֽǰ
+sys_res spi_Transce(spi_t *p, const void *pCmd, size_t nCmdLen, void *pRec, size_t nRecLen)
+{
+	u8 *pData = pRec;
+	u32 nReg, nData;
+	static u32 nLastReg[2];
+	size_t i;
+
+	mt_nXfer += 1;
+	if (p->id == MT_ATT)
+	{
+		nReg = *(const u8 *)pCmd;
+		if (nReg == ATT7022_REG_RSPIData)
+			nReg = 0x10000;
+	}
+	else
+	{
+		nReg = *(const u16 *)pCmd;
+		if (nReg == RN8302_REG_RData)
+			nReg = 0x10000;
+	}
+	if (nReg == 0x10000)
+	{
+		nData = mt_aLast[p->id];
+		//ݴ
+		if (mt_aFail[p->id][nLastReg[p->id]])
+		{
+			if (mt_aFail[p->id][nLastReg[p->id]] != MT_FAIL_ALWAYS)
+				mt_aFail[p->id][nLastReg[p->id]] -= 1;
+			nData ^= 0x10;
+		}
+	}
+	else
+	{
+		nData = mt_Value(p->id, nReg);
+		if (nRecLen < 4)
+			nData &= (1UL << (nRecLen * 8)) - 1;
+		mt_aLast[p->id] = nData;
+		nLastReg[p->id] = nReg;
+	}
+	for (i = nRecLen; i; i--)
+	{
+		pData[i - 1] = nData;
+		nData >>= 8;
+	}
+	return SYS_R_OK;
+}
+
+static u32 mt_AttExpect(int i)
+{
+
+	return mt_Value(MT_ATT, mt_aAttReg[i]) & ATT7022_DATA_MASK;
+}
+
+static u32 mt_RnExpect(int i)
+{
+	u32 nData = mt_Value(MT_RN, mt_aRnReg[i].reg);
+
+	if (mt_aRnReg[i].len < 4)
+		nData &= (1UL << (mt_aRnReg[i].len * 8)) - 1;
+	return nData;
+}
+
+static int mt_AttCheck(att7022_snap_t *pSnap, int nBad)
+{
+	int i;
+
+	for (i = 0; i < ARR_SIZE(mt_aAttReg); i++)
+	{
+		if (pSnap->data[i] != ((i == nBad) ? 0 : mt_AttExpect(i)))
+			return 1;
+	}
+	return 0;
+}
+
+static int mt_RnCheck(rn8302_snap_t *pSnap, int nBad)
+{
+	int i;
+
+	for (i = 0; i < ARR_SIZE(mt_aRnReg); i++)
+	{
+		if (pSnap->data[i] != ((i == nBad) ? 0 : mt_RnExpect(i)))
+			return 1;
+	}
+	return 0;
+}
+
+static void mt_TestAtt()
+{
+	att7022_snap_t xSnap;
+	int nQty = ARR_SIZE(mt_aAttReg);
+	u32 nOpen, nXfer, nSleep;
+
+	TEST_CHECK(att7022_SnapGet(&xSnap) == 0, "att no snapshot");
+	TEST_CHECK(att7022_Snapshot() == SYS_R_ERR, "att no list");
+	TEST_CHECK(att7022_SnapConfig(mt_aAttReg, 0) == SYS_R_ERR, "att empty list");
+	TEST_CHECK(att7022_SnapConfig(mt_aAttReg, ATT7022_SNAP_MAX + 1) == SYS_R_ERR, "att long list");
+	TEST_CHECK(att7022_SnapConfig(mt_aAttReg, nQty) == SYS_R_OK, "att config");
+
+	//бһռSPI,ÿĴݺУһ,
+	nOpen = mt_nOpen, nXfer = mt_nXfer, nSleep = mt_nSleep;
+	TEST_CHECK(att7022_Snapshot() == SYS_R_OK, "att snapshot");
+	TEST_CHECK(mt_nOpen - nOpen == 1 && mt_nXfer - nXfer == 2 * nQty && mt_nSleep == nSleep,
+		"att bus %u xfer %u sleep %u", mt_nOpen - nOpen, mt_nXfer - nXfer, mt_nSleep - nSleep);
+	TEST_CHECK(att7022_SnapGet(&xSnap) == 1 && xSnap.qty == nQty && xSnap.err == 0, "att seq 1");
+	TEST_CHECK(mt_AttCheck(&xSnap, -1) == 0, "att data");
+
+	//żУ,бһͳһض
+	mt_nGen += 1;
+	mt_aFail[MT_ATT][ATT7022_REG_PA] = 1;
+	mt_aFail[MT_ATT][ATT7022_REG_IRmsB] = 1;
+	mt_aFail[MT_ATT][ATT7022_REG_PFlag] = 1;
+	nXfer = mt_nXfer, nSleep = mt_nSleep;
+	TEST_CHECK(att7022_Snapshot() == SYS_R_OK, "att retry");
+	TEST_CHECK(mt_nXfer - nXfer == 2 * nQty + 6 && mt_nSleep - nSleep == 1, "att retry xfer %u sleep %u",
+		mt_nXfer - nXfer, mt_nSleep - nSleep);
+	TEST_CHECK(att7022_SnapGet(&xSnap) == 2 && xSnap.err == 0 && mt_AttCheck(&xSnap, -1) == 0, "att retry data");
+
+	//ضʧܵļΪ0
+	mt_nGen += 1;
+	mt_aFail[MT_ATT][ATT7022_REG_URmsB] = MT_FAIL_ALWAYS;
+	TEST_CHECK(att7022_Snapshot() == SYS_R_ERR, "att bad reg");
+	TEST_CHECK(att7022_SnapGet(&xSnap) == 3 && xSnap.err == 1, "att bad seq %u err %u", xSnap.seq, xSnap.err);
+	TEST_CHECK(mt_AttCheck(&xSnap, 9) == 0, "att bad data");
+	mt_aFail[MT_ATT][ATT7022_REG_URmsB] = 0;
+
+	//Ĵսһ
+	TEST_CHECK(att7022_Read(ATT7022_REG_Freq) == mt_AttExpect(18), "att read");
+
+	//úɿ
+	TEST_CHECK(att7022_SnapConfig(mt_aAttReg, 4) == SYS_R_OK, "att reconfig");
+	TEST_CHECK(att7022_SnapGet(&xSnap) == 0, "att reconfig drop");
+	TEST_CHECK(att7022_Snapshot() == SYS_R_OK && att7022_SnapGet(&xSnap) == 4 && xSnap.qty == 4, "att reconfig seq");
+	TEST_CHECK(att7022_SnapConfig(mt_aAttReg, nQty) == SYS_R_OK, "att config");
+}
+
+static void mt_TestRn()
+{
+	rn8302_snap_t xSnap;
+	rn8302_snapreg_t aReg[2] = {{0x0007, 4}, {0x0008, 1}};
+	int nQty = ARR_SIZE(mt_aRnReg);
+	u32 nOpen, nXfer, nSleep;
+
+	TEST_CHECK(rn8302_SnapGet(&xSnap) == 0, "rn no snapshot");
+	TEST_CHECK(rn8302_SnapConfig(aReg, 2) == SYS_R_ERR, "rn 1 byte reg");
+	aReg[1].len = 5;
+	TEST_CHECK(rn8302_SnapConfig(aReg, 2) == SYS_R_ERR, "rn 5 byte reg");
+	TEST_CHECK(rn8302_SnapConfig(mt_aRnReg, RN8302_SNAP_MAX + 1) == SYS_R_ERR, "rn long list");
+	TEST_CHECK(rn8302_SnapConfig(mt_aRnReg, nQty) == SYS_R_OK, "rn config");
+
+	nOpen = mt_nOpen, nXfer = mt_nXfer, nSleep = mt_nSleep;
+	TEST_CHECK(rn8302_Snapshot() == SYS_R_OK, "rn snapshot");
+	TEST_CHECK(mt_nOpen - nOpen == 1 && mt_nXfer - nXfer == 2 * nQty && mt_nSleep == nSleep,
+		"rn bus %u xfer %u sleep %u", mt_nOpen - nOpen, mt_nXfer - nXfer, mt_nSleep - nSleep);
+	TEST_CHECK(rn8302_SnapGet(&xSnap) == 1 && xSnap.qty == nQty && xSnap.err == 0, "rn seq 1");
+	TEST_CHECK(mt_RnCheck(&xSnap, -1) == 0, "rn data");
+
+	//234ֽڼĴһżУ
+	mt_nGen += 1;
+	mt_aFail[MT_RN][0x0009] = 1;
+	mt_aFail[MT_RN][0x003A] = 1;
+	mt_aFail[MT_RN][0x0103] = 1;
+	nXfer = mt_nXfer, nSleep = mt_nSleep;
+	TEST_CHECK(rn8302_Snapshot() == SYS_R_OK, "rn retry");
+	TEST_CHECK(mt_nXfer - nXfer == 2 * nQty + 6 && mt_nSleep - nSleep == 1, "rn retry xfer %u sleep %u",
+		mt_nXfer - nXfer, mt_nSleep - nSleep);
+	TEST_CHECK(rn8302_SnapGet(&xSnap) == 2 && xSnap.err == 0 && mt_RnCheck(&xSnap, -1) == 0, "rn retry data");
+
+	mt_nGen += 1;
+	mt_aFail[MT_RN][0x0057] = MT_FAIL_ALWAYS;
+	TEST_CHECK(rn8302_Snapshot() == SYS_R_ERR, "rn bad reg");
+	TEST_CHECK(rn8302_SnapGet(&xSnap) == 3 && xSnap.err == 1, "rn bad seq %u err %u", xSnap.seq, xSnap.err);
+	TEST_CHECK(mt_RnCheck(&xSnap, 13) == 0, "rn bad data");
+	mt_aFail[MT_RN][0x0057] = 0;
+
+	TEST_CHECK(rn8302_SnapConfig(mt_aRnReg, 3) == SYS_R_OK && rn8302_SnapGet(&xSnap) == 0, "rn reconfig drop");
+	TEST_CHECK(rn8302_SnapConfig(mt_aRnReg, nQty) == SYS_R_OK, "rn config");
+}
+
+//ɼ0~2,ʱڶθдڿĻ
+static void mt_Preempt()
+{
+	int n;
+
+	mt_bPreempt = 0;
+	for (n = test_Rand() % 3; n; n--)
+	{
+		mt_nGen = (mt_nGen + 1) & 0xFF;
+		att7022_Snapshot();
+	}
+	mt_bPreempt = 1;
+}
+
+//ȡĿͬһε,Ų
+static void mt_TestReader()
+{
+	att7022_snap_t xSnap;
+	u32 nSeq, nLast = 0, nGen;
+	int i, j, nTorn = 0, nBack = 0;
+
+	att7022_Snapshot();
+	for (i = 0; i < 20000; i++)
+	{
+		mt_bPreempt = 1;
+		nSeq = att7022_SnapGet(&xSnap);
+		mt_bPreempt = 0;
+		if (nSeq < nLast)
+			nBack += 1;
+		nLast = nSeq;
+		//δӵһĴ
+		nGen = ((xSnap.data[0] ^ (mt_aAttReg[0] * 0x9E3779B1)) & ATT7022_DATA_MASK) >> 16;
+		for (j = 0; j < xSnap.qty; j++)
+		{
+			if (xSnap.data[j] != (((nGen << 16) ^ (mt_aAttReg[j] * 0x9E3779B1)) & ATT7022_DATA_MASK))
+				break;
+		}
+		if (j < xSnap.qty || xSnap.seq != nSeq)
+			nTorn += 1;
+	}
+	TEST_CHECK(nTorn == 0 && nBack == 0, "reader torn %d back %d", nTorn, nBack);
+}
+
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	mt_TestAtt();
+	mt_TestRn();
+	mt_TestReader();
+
+	TEST_BENCH("att7022 snapshot 24 regs", 10000, att7022_Snapshot());
+	TEST_BENCH("rn8302 snapshot 18 regs", 10000, rn8302_Snapshot());
+	return test_Result("meter");
+}
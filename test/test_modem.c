@@ -0,0 +1,584 @@
+#include "test.h"
+
+#define MODEM_ENABLE			1
+#define MODEM_UART_ID			0
+#define MODEM_UART_BAUD			115200
+#define MODEM_BAUD_ADJUST		0
+#ifndef MODEM_TCP_ENABLE
+#define MODEM_TCP_ENABLE		0
+#endif
+#define MODEM_SMS_ENABLE		0
+#define MODEM_PWR_ENABLE		0
+#define MODEM_RST_ENABLE		0
+#define MODEM_CTS_ENABLE		0
+#define MODEM_RTS_ENABLE		0
+#define MODEM_DTR_ENABLE		0
+#define MODEM_DCD_ENABLE		0
+#define MODEM_FLOWCTL_ENABLE	0
+#define MODEM_DEBUG_ENABLE		0
+#define TCPPS_TYPE				TCPPS_T_NULL
+#define RTC_ENABLE				1
+#define OS_TICK_MS				10
+#define OS_TMO_FOREVER			0
+
+#define mem_Realloc				realloc
+#define mem_Free				free
+#include "../lib/buffer.c"
+
+//ڡGPIOOS,ʱΪ
+typedef struct {
+	int		id;
+} uart_t;
+
+struct gpio_def {
+	int		pin;
+};
+typedef const struct gpio_def t_gpio_def;
+
+#define GPIO_EFFECT_LOW			0
+#define GPIO_EFFECT_HIGH		1
+#define UART_PARI_NO			0
+#define UART_DATA_8D			1
+#define UART_STOP_1D			1
+
+static u32 fm_nMs;
+#define os_tick_get()			(fm_nMs / OS_TICK_MS)
+
+static void os_thd_sleep(size_t nMs)
+{
+
+	fm_nMs += nMs;
+}
+
+static void sys_GpioConf(t_gpio_def *p)
+{
+}
+
+static void sys_GpioSet(t_gpio_def *p, int nHL)
+{
+}
+
+static void uart_Config(uart_t *p, int nBaud, int nPari, int nData, int nStop)
+{
+}
+
+static struct tm *rtc_pTm()
+{
+	static struct tm xTm;
+
+	return &xTm;
+}
+
+static uart_t fm_xUart;
+
+static uart_t *uart_Open(int nId, int nTmo)
+{
+
+	return &fm_xUart;
+}
+
+static void uart_SendStr(uart_t *p, const char *str);
+static int uart_Recive(uart_t *p, buf b);
+#if MODEM_TCP_ENABLE
+static void uart_Send(uart_t *p, const void *pData, size_t nLen);
+#endif
+
+//lib/string.cͬ:ƥ䴮֮λ
+int memscmp(const char *cs, const char *ct)
+{
+
+	return memcmp(cs, ct, strlen(ct));
+}
+
+char *buffstr(buf b, const char *str)
+{
+	const char *s = (const char *)b->p;
+	int l1 = b->len, l2 = strlen(str);
+
+	for (; l1 >= l2; l1--, s++)
+	{
+		if (memcmp(s, str, l2) == 0)
+			return (char *)(s + l2);
+	}
+	return NULL;
+}
+
+static sys_res uart_RecTmo(uart_t *p, buf b, size_t nTmo);
+
+#include <drivers/modem.h>
+
+static const struct modem_def tbl_bspModem = {
+	GPIO_EFFECT_LOW, {0},
+};
+
+#include "../drivers/modem.c"
+
+
+//Private Defines
+#define FM_LATENCY				30		//ģӦʱ(ms)
+#define FM_CHUNK				5		//Ӧεļ(ms)
+#define FM_EVT_QTY				64
+#define FM_NET_QTY				64
+#define FM_BUSY					0x40000000
+
+
+//Private Variables
+static char fm_aLine[128];
+static size_t fm_nLine;
+static buf fm_bOut;					//ֽ
+static struct {
+	u32		end;					//fm_bOutеĽλ
+	u32		due;					//ʱ
+} fm_aEvt[FM_EVT_QTY];
+static int fm_nEvt;
+static u32 fm_nIdle;				//һ뷢ʱ
+static int fm_nOverlap;				//δʱյ
+static int fm_nCmd;					//յ
+static int fm_nCreg;				//+CREG?ѯκע
+static int fm_nPinErr;				//+CPIN?Ȼؼδ
+static int fm_nMute;				//Ӧ
+static int fm_nRing;				//ӦвURC
+#if MODEM_TCP_ENABLE
+static buf fm_bNet;					//Զ˷
+static struct {
+	u32		end;
+	u32		due;
+	int		urc;
+} fm_aNet[FM_NET_QTY];
+static int fm_nNet;
+static u32 fm_nNetRead;				//ѱߵֽ
+static buf fm_bSent;				//ģյķ
+static size_t fm_nRaw;				//$MYNETWRITEֽ
+static int fm_nDropRead;			//ζ
+static int fm_nRead;				//
+#endif
+
+
+//Internal Functions
+static void fm_Emit(const void *pData, size_t nLen, u32 nDue)
+{
+
+	if (fm_nEvt && ((s32)(nDue - fm_aEvt[fm_nEvt - 1].due) < 0))
+		nDue = fm_aEvt[fm_nEvt - 1].due;
+	if (nLen)
+		buf_Push(fm_bOut, pData, nLen);
+	fm_aEvt[fm_nEvt].end = fm_bOut->len;
+	fm_aEvt[fm_nEvt].due = nDue;
+	fm_nEvt += 1;
+}
+
+//Ӧε,鰴ɨ԰еĴ
+static void fm_Reply(const void *pData, size_t nLen)
+{
+	size_t n = test_Rand() % nLen;
+	u32 nDue = fm_nMs + FM_LATENCY;
+
+	fm_Emit(pData, n, nDue);
+	fm_Emit((const u8 *)pData + n, nLen - n, nDue + FM_CHUNK);
+	//һѵʱ,һμ
+	fm_nIdle = fm_aEvt[fm_nEvt - 1].due;
+	if (n >= nLen - 2)
+		fm_nIdle = fm_aEvt[fm_nEvt - 2].due;
+}
+
+#if MODEM_TCP_ENABLE
+//ԶݵURC,ڷ͵Ӧ֮
+static void fm_NetUrc()
+{
+	int i;
+
+	for (i = 0; i < fm_nNet; i++)
+	{
+		if (fm_aNet[i].urc || ((s32)(fm_nMs - fm_aNet[i].due) < 0))
+			continue;
+		fm_aNet[i].urc = 1;
+		fm_Emit("\r\n$MYURCREAD: 0\r\n", 17, fm_nMs);
+	}
+}
+
+static void fm_NetRead(int nMax)
+{
+	u8 aBuf[MTCP_READ_SIZE + 64];
+	u32 nAvail = fm_nNetRead;
+	int i, n;
+
+	for (i = 0; (i < fm_nNet) && ((s32)(fm_nMs - fm_aNet[i].due) >= 0); i++)
+		nAvail = fm_aNet[i].end;
+	n = MIN(nAvail - fm_nNetRead, (u32)nMax);
+	i = sprintf((char *)aBuf, "\r\n$MYNETREAD: 0,%d\r\n", n);
+	memcpy(&aBuf[i], &fm_bNet->p[fm_nNetRead], n);
+	fm_nNetRead += n;
+	i += n;
+	i += sprintf((char *)&aBuf[i], "\r\nOK\r\n");
+	fm_Reply(aBuf, i);
+}
+#endif
+
+static void fm_Answer(const char *pCmd)
+{
+	char str[128];
+
+	str[0] = '\0';
+	if (fm_nMute)
+		return;
+#if MODEM_TCP_ENABLE
+	if (memcmp(pCmd, "AT$MYNETREAD=0,", 15) == 0)
+	{
+		fm_nRead += 1;
+		if (fm_nDropRead)
+		{
+			fm_nDropRead -= 1;
+			return;
+		}
+		fm_NetRead(atoi(&pCmd[15]));
+		return;
+	}
+	if (memcmp(pCmd, "AT$MYNETWRITE=0,", 16) == 0)
+	{
+		fm_nRaw = atoi(&pCmd[16]);
+		sprintf(str, "\r\n$MYNETWRITE: 0,%d\r\n", (int)fm_nRaw);
+		fm_Reply(str, strlen(str));
+		fm_nIdle = fm_nMs + FM_BUSY;
+		return;
+	}
+#endif
+	if (fm_nRing)
+		strcat(str, "\r\nRING\r\n");
+
+	if ((strcmp(pCmd, "ATZ0") == 0) || (strcmp(pCmd, "ATE0") == 0))
+		strcat(str, "\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+CGMR") == 0)
+		strcat(str, "\r\n+CGMR: M10R01A01\r\n\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+CPIN?") == 0)
+	{
+		if (fm_nPinErr)
+		{
+			fm_nPinErr -= 1;
+			strcat(str, "\r\n+CME ERROR: 10\r\n");
+		}
+		else
+			strcat(str, "\r\n+CPIN: READY\r\n\r\nOK\r\n");
+	}
+	else if (strcmp(pCmd, "AT+CCID") == 0)
+		strcat(str, "\r\nERROR\r\n");
+	else if (strcmp(pCmd, "AT+ZGETICCID") == 0)
+		strcat(str, "\r\n+ZGETICCID: 89860012345678901234\r\n\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+GSN") == 0)
+		strcat(str, "\r\n861234567890123\r\n\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+CREG?") == 0)
+	{
+		if (fm_nCreg)
+		{
+			fm_nCreg -= 1;
+			strcat(str, "\r\n+CREG: 0,2\r\n\r\nOK\r\n");
+		}
+		else
+			strcat(str, "\r\n+CREG: 0,1\r\n\r\nOK\r\n");
+	}
+	else if (strcmp(pCmd, "AT+CSQ") == 0)
+		strcat(str, "\r\n+CSQ: 23,99\r\n\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+CIMI") == 0)
+		strcat(str, "\r\n460001234567890\r\n\r\nOK\r\n");
+	else if (strcmp(pCmd, "AT+CGATT?") == 0)
+		strcat(str, "\r\n+CGATT: 1\r\n\r\nOK\r\n");
+	else if ((memcmp(pCmd, "AT+CGDCONT=", 11) == 0) || (strcmp(pCmd, "AT+CGATT=1") == 0))
+		strcat(str, "\r\nOK\r\n");
+	else
+		strcat(str, "\r\nERROR\r\n");
+
+	fm_Reply(str, strlen(str));
+}
+
+static void uart_SendStr(uart_t *p, const char *str)
+{
+
+	for (; *str; str++)
+	{
+		if (fm_nLine < sizeof(fm_aLine) - 1)
+			fm_aLine[fm_nLine++] = *str;
+		if ((fm_nLine >= 2) && (memcmp(&fm_aLine[fm_nLine - 2], "\r\n", 2) == 0))
+		{
+			fm_aLine[fm_nLine - 2] = '\0';
+			fm_nLine = 0;
+			fm_nCmd += 1;
+			if ((s32)(fm_nMs - fm_nIdle) < 0)
+				fm_nOverlap += 1;
+			fm_Answer(fm_aLine);
+		}
+	}
+}
+
+#if MODEM_TCP_ENABLE
+static void uart_Send(uart_t *p, const void *pData, size_t nLen)
+{
+
+	if (nLen > fm_nRaw)
+		fm_nOverlap += 1;
+	nLen = MIN(nLen, fm_nRaw);
+	buf_Push(fm_bSent, pData, nLen);
+	fm_nRaw -= nLen;
+	if (fm_nRaw == 0)
+		fm_Reply("\r\nOK\r\n", 6);
+}
+#endif
+
+static int uart_Recive(uart_t *p, buf b)
+{
+	int i, j, n;
+
+#if MODEM_TCP_ENABLE
+	fm_NetUrc();
+#endif
+	for (i = 0; (i < fm_nEvt) && ((s32)(fm_nMs - fm_aEvt[i].due) >= 0); i++);
+	if (i == 0)
+		return 0;
+	n = fm_aEvt[i - 1].end;
+	for (j = i; j < fm_nEvt; j++)
+	{
+		fm_aEvt[j - i].end = fm_aEvt[j].end - n;
+		fm_aEvt[j - i].due = fm_aEvt[j].due;
+	}
+	fm_nEvt -= i;
+	if (n == 0)
+		return 0;
+	buf_Push(b, fm_bOut->p, n);
+	buf_Remove(fm_bOut, n);
+	return n;
+}
+
+//sys/uart.cͬ:һ,֮ÿtickһ
+static sys_res uart_RecTmo(uart_t *p, buf b, size_t nTmo)
+{
+
+	for (nTmo /= OS_TICK_MS; ; nTmo--)
+	{
+		if (uart_Recive(p, b) > 0)
+			return SYS_R_OK;
+		if (nTmo == 0)
+			return SYS_R_TMO;
+		fm_nMs += OS_TICK_MS;
+	}
+}
+
+static void fm_Reset()
+{
+
+	buf_Release(fm_bOut);
+	buf_Release(gsm_xModem.rbuf);
+	fm_nEvt = 0;
+	fm_nIdle = fm_nMs;
+	fm_nOverlap = 0;
+	fm_nLine = 0;
+	fm_nCmd = 0;
+	fm_nCreg = 0;
+	fm_nPinErr = 0;
+	fm_nMute = 0;
+	fm_nRing = 0;
+#if MODEM_TCP_ENABLE
+	buf_Release(fm_bNet);
+	buf_Release(fm_bSent);
+	fm_nNet = 0;
+	fm_nNetRead = 0;
+	fm_nRaw = 0;
+	fm_nDropRead = 0;
+	fm_nRead = 0;
+#endif
+}
+
+//:Ӧһ,ǰ,Ӧʱ
+static void fm_TestCmd()
+{
+	p_modem p = &gsm_xModem;
+	u32 nMs;
+
+	fm_Reset();
+	nMs = fm_nMs;
+	TEST_CHECK(modem_SendCmd(p, "+CSQ", "OK\r", 1) == SYS_R_OK, "+CSQ failed");
+	nMs = fm_nMs - nMs;
+	TEST_CHECK(nMs <= FM_LATENCY + FM_CHUNK + OS_TICK_MS, "+CSQ took %u ms", nMs);
+	TEST_CHECK(buffstr(p->rbuf, "+CSQ: 23,99") != NULL, "answer lost");
+
+	//ERRORʱ
+	nMs = fm_nMs;
+	TEST_CHECK(modem_SendCmd(p, "+CCID", "OK\r", 1) != SYS_R_OK, "ERROR taken as OK");
+	nMs = fm_nMs - nMs;
+	TEST_CHECK(nMs <= FM_LATENCY + FM_CHUNK + OS_TICK_MS, "ERROR took %u ms", nMs);
+
+	//+CME ERRORMODEM_AT_ITV
+	fm_nPinErr = 2;
+	nMs = fm_nMs;
+	fm_nCmd = 0;
+	TEST_CHECK(modem_SendCmd(p, "+CPIN?", "OK\r", 30) == SYS_R_OK, "+CPIN? failed");
+	nMs = fm_nMs - nMs;
+	TEST_CHECK(fm_nCmd == 3, "%d +CPIN? attempts", fm_nCmd);
+	TEST_CHECK(nMs <= 2 * MODEM_AT_ITV + 3 * (FM_LATENCY + FM_CHUNK + OS_TICK_MS), "+CPIN? took %u ms", nMs);
+
+	//Ӧ:ÿεMODEM_AT_TMO,
+	fm_nMute = 1;
+	fm_nCmd = 0;
+	nMs = fm_nMs;
+	TEST_CHECK(modem_SendCmd(p, "+CSQ", "OK\r", 3) == SYS_R_TMO, "mute modem answered");
+	nMs = fm_nMs - nMs;
+	TEST_CHECK(fm_nCmd == 3, "%d attempts", fm_nCmd);
+	TEST_CHECK((nMs >= 3 * MODEM_AT_TMO) && (nMs <= 3 * (MODEM_AT_TMO + 2 * OS_TICK_MS)), "mute took %u ms", nMs);
+	fm_nMute = 0;
+
+	//URCӦ޳
+	fm_nRing = 1;
+	TEST_CHECK(modem_SendCmd(p, "+CIMI", "OK\r", 1) == SYS_R_OK, "+CIMI with URC failed");
+	TEST_CHECK(buffstr(p->rbuf, "RING") == NULL, "URC left in the answer");
+	TEST_CHECK(buffstr(p->rbuf, "460001234567890") != NULL, "answer lost with URC");
+}
+
+//ʼ:¼ϵʼʱ
+static u32 fm_BringUp(int nRing, int *pCmd)
+{
+	p_modem p = &gsm_xModem;
+	u32 nMs;
+
+	fm_Reset();
+	fm_nRing = nRing;
+	memset(p->ver, 0, sizeof(p->ver));
+	memset(p->ccid, 0, sizeof(p->ccid));
+	memset(p->imei, 0, sizeof(p->imei));
+	nMs = fm_nMs;
+	TEST_CHECK(modem_InitCmd(p) == SYS_R_OK, "init failed");
+	*pCmd = fm_nCmd;
+	return fm_nMs - nMs;
+}
+
+static void fm_TestInit()
+{
+	p_modem p = &gsm_xModem;
+	u32 nMs;
+	int nCmd;
+
+	nMs = fm_BringUp(0, &nCmd);
+	TEST_CHECK(p->type == MODEM_TYPE_GPRS, "type %d", p->type);
+	TEST_CHECK(p->signal == 23, "signal %d", p->signal);
+	TEST_CHECK(memcmp(p->ccid, "89860012345678901234", 20) == 0, "ccid %.20s", p->ccid);
+	TEST_CHECK(memcmp(p->imei, "861234567890123", 15) == 0, "imei %.15s", p->imei);
+	TEST_CHECK(strstr(p->ver, "M10R01A01") != NULL, "ver %.20s", p->ver);
+	//ԭʵÿ˯100ms
+	TEST_CHECK(nMs < nCmd * 100, "bring-up %u ms for %d commands", nMs, nCmd);
+	TEST_CHECK(nMs <= nCmd * (FM_LATENCY + FM_CHUNK + OS_TICK_MS), "bring-up %u ms for %d commands", nMs, nCmd);
+	if (test_nBench)
+		printf("  %-32s %8u ms, %d commands\n", "bring-up", nMs, nCmd);
+
+	//URC岻Ӱ
+	nMs = fm_BringUp(1, &nCmd);
+	TEST_CHECK(p->signal == 23, "signal %d with URC", p->signal);
+	TEST_CHECK(memcmp(p->imei, "861234567890123", 15) == 0, "imei %.15s with URC", p->imei);
+	TEST_CHECK(strstr(p->ver, "M10R01A01") != NULL, "ver %.20s with URC", p->ver);
+
+	//עȴԭѯ
+	fm_Reset();
+	fm_nCreg = 3;
+	nMs = fm_nMs;
+	TEST_CHECK(modem_InitCmd(p) == SYS_R_OK, "init with late registration failed");
+	nMs = fm_nMs - nMs;
+	TEST_CHECK(nMs >= 3000, "registration polled too fast, %u ms", nMs);
+	if (test_nBench)
+		printf("  %-32s %8u ms\n", "bring-up, registered after 3s", nMs);
+}
+
+
+#if MODEM_TCP_ENABLE
+//Զ:,ݼдURC
+static void fm_NetSchedule(int nQty, u32 nSpan)
+{
+	static const char * const tbl[] = {"\r\nOK\r\n", "$MYURCREAD: 0\r\n", "\r\nERROR\r\n", "\r\n"};
+	u8 aBuf[3000];
+	u32 nDue = fm_nMs;
+	int i, j, nLen;
+
+	for (i = 0; i < nQty; i++)
+	{
+		nLen = 1 + test_Rand() % sizeof(aBuf);
+		for (j = 0; j < nLen; j++)
+			aBuf[j] = test_Rand();
+		for (j = test_Rand() % 4; j; j--)
+		{
+			const char *pStr = tbl[test_Rand() % ARR_SIZE(tbl)];
+			size_t nStr = strlen(pStr);
+			if (nStr < (size_t)nLen)
+				memcpy(&aBuf[test_Rand() % (nLen - nStr + 1)], pStr, nStr);
+		}
+		nDue += test_Rand() % nSpan;
+		buf_Push(fm_bNet, aBuf, nLen);
+		fm_aNet[fm_nNet].end = fm_bNet->len;
+		fm_aNet[fm_nNet].due = nDue;
+		fm_aNet[fm_nNet].urc = 0;
+		fm_nNet += 1;
+	}
+}
+
+static void fm_TcpOnline()
+{
+	p_modem p = &gsm_xModem;
+
+	p->mtcp = 1;
+	p->mcon = 1;
+	p->ste = MODEM_S_ONLINE;
+	mtcp_RxReset(&mtcp_xRx);
+}
+
+//,дʱص
+static void fm_TestTcp(int nSend, int nDrop)
+{
+	u8 aBuf[600];
+	buf b = {0}, bSend = {0};
+	u32 nMs, nLast;
+	int i, n, nLoop;
+
+	fm_Reset();
+	fm_TcpOnline();
+	fm_nDropRead = nDrop;
+	fm_NetSchedule(FM_NET_QTY, 200);
+	nLast = fm_aNet[fm_nNet - 1].due;
+	nMs = fm_nMs;
+	for (nLoop = 0; (nLoop < 100000) && (b->len < fm_bNet->len); nLoop++)
+	{
+		mtcp_TcpRecv(b);
+		if (nSend && ((test_Rand() % 20) == 0))
+		{
+			n = 1 + test_Rand() % sizeof(aBuf);
+			for (i = 0; i < n; i++)
+				aBuf[i] = test_Rand();
+			if (mtcp_TcpSend(aBuf, n) == SYS_R_OK)
+				buf_Push(bSend, aBuf, n);
+		}
+	}
+	TEST_CHECK((b->len == fm_bNet->len) && (memcmp(b->p, fm_bNet->p, b->len) == 0),
+				"received %u of %u bytes", (u32)b->len, (u32)fm_bNet->len);
+	TEST_CHECK((bSend->len == fm_bSent->len) && ((bSend->len == 0) || (memcmp(bSend->p, fm_bSent->p, bSend->len) == 0)),
+				"modem got %u of %u bytes", (u32)fm_bSent->len, (u32)bSend->len);
+	TEST_CHECK(fm_nOverlap == 0, "%d commands before the previous result code", fm_nOverlap);
+	//һε,ʣݵʱ
+	nLast = fm_nMs - nLast;
+	TEST_CHECK(nLast <= (nDrop ? MTCP_READ_TMO * OS_TICK_MS : 0) + 8 * (FM_LATENCY + FM_CHUNK + OS_TICK_MS),
+				"drained %u ms after the last segment", nLast);
+	if (test_nBench)
+		printf("  %-32s %8u ms, %d reads, %u bytes\n", nSend ? "tcp rx with tx" : "tcp rx",
+				fm_nMs - nMs, fm_nRead, (u32)b->len);
+	buf_Release(b);
+	buf_Release(bSend);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	modem_Init();
+	fm_TestCmd();
+	fm_TestInit();
+#if MODEM_TCP_ENABLE
+	fm_TestTcp(0, 0);
+	fm_TestTcp(1, 0);
+	fm_TestTcp(1, 2);
+	return test_Result("modem tcp");
+#else
+	return test_Result("modem");
+#endif
+}
@@ -0,0 +1,716 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_rtt.h"
+#include <errno.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//rpc/types.hRT-ThreadminilibcԶ64λ,stdintͻ,ܿ
+#define int64_t					rpc_int64_t
+#define uint64_t				rpc_uint64_t
+
+#define RT_TICK_PER_SECOND		100
+#define mem_Malloc				malloc
+#define mem_Free				free
+#define rt_thread_self()		((void *)0x1000)
+#define rt_tick_get()			ns_nTick
+
+static rt_tick_t ns_nTick;
+
+//UDP׽:NFS/MOUNTӦ,ӦŶӵrecvfromȡ
+#define socket					ns_Socket
+#define lwip_close				ns_Close
+#define setsockopt				ns_Setsockopt
+#define sendto					ns_Sendto
+#define recvfrom				ns_Recvfrom
+#define gethostbyname			ns_Gethost
+
+static int ns_Socket(int nDomain, int nType, int nProt)
+{
+
+	return 3;
+}
+
+static int ns_Close(int s)
+{
+
+	return 0;
+}
+
+static int ns_Setsockopt(int s, int nLevel, int nOpt, const void *pVal, socklen_t nLen)
+{
+
+	return 0;
+}
+
+static struct hostent *ns_Gethost(const char *pName)
+{
+	static char aAddr[4] = {192, 168, 1, 1};
+	static char *apAddr[] = {aAddr, NULL};
+	static struct hostent h;
+
+	h.h_addrtype = AF_INET;
+	h.h_length = 4;
+	h.h_addr_list = apAddr;
+	return &h;
+}
+
+static ssize_t ns_Sendto(int s, const void *pBuf, size_t nLen, int nFlag, const struct sockaddr *pTo, socklen_t nToLen);
+static ssize_t ns_Recvfrom(int s, void *pBuf, size_t nLen, int nFlag, struct sockaddr *pFrom, socklen_t *pFromLen);
+
+static unsigned short pmap_getport(struct sockaddr_in *raddr, unsigned long prog, unsigned long vers, unsigned int prot)
+{
+
+	return 2049;
+}
+
+#include "../cp/rpc/xdr.c"
+#include "../cp/rpc/xdr_mem.c"
+#include "../cp/rpc/rpc_prot.c"
+#include "../cp/rpc/auth_none.c"
+#include "../cp/rpc/clnt_udp.c"
+#include "../cp/rpc/clnt_generic.c"
+#include "../fs/nfs/nfs_xdr.c"
+#include "../fs/nfs/mount_xdr.c"
+#include "../fs/nfs/nfs_clnt.c"
+#include "../fs/nfs/mount_clnt.c"
+#undef NAME_MAX
+#include "../fs/dfs_nfs.c"
+
+
+//Private Defines
+#define NS_NODES				48
+#define NS_DATA					(64 * 1024)
+#define NS_QTY					8
+#define NS_MSG_SIZE				UDPMSGSIZE
+#define NS_PROCS				22
+
+
+//Private Typedefs
+//ļڵ,ΪڵżӴ
+typedef struct {
+	char name[32];
+	int parent;
+	int type;				//0δ,NFS3REGNFS3DIR
+	u32 gen;
+	u32 size;
+	u32 mtime;
+	u8 *data;
+} ns_node;
+
+typedef struct {
+	int len;
+	char buf[NS_MSG_SIZE];
+} ns_msg;
+
+
+//Private Variables
+static ns_node ns_aNode[NS_NODES];
+static ns_msg ns_aRep[NS_QTY];
+static int ns_nRep;
+static int ns_aCall[NS_PROCS];			//NFS̵ĵô
+static char ns_aVerf[NFS3_WRITEVERFSIZE] = "srv-1";
+static struct dfs_filesystem ns_fs;
+
+
+//Internal Functions
+int dfs_register(const struct dfs_filesystem_operation *ops)
+{
+
+	return 0;
+}
+
+static int ns_Add(int nParent, const char *pName, int nType, u32 nSize)
+{
+	ns_node *p;
+	int i;
+
+	for (i = 1; i < NS_NODES; i++)
+	{
+		p = &ns_aNode[i];
+		if (p->type == 0)
+			break;
+	}
+	if (i == NS_NODES)
+		return -1;
+	strncpy(p->name, pName, sizeof(p->name) - 1);
+	p->parent = nParent;
+	p->type = nType;
+	p->gen += 1;
+	p->size = nSize;
+	p->mtime = ns_nTick;
+	if (nType == NFS3REG)
+	{
+		if (p->data == NULL)
+			p->data = malloc(NS_DATA);
+		for (i = 0; i < (int)nSize; i++)
+			p->data[i] = test_Rand();
+	}
+	return p - ns_aNode;
+}
+
+static void ns_Del(int n)
+{
+
+	ns_aNode[n].type = 0;
+	ns_aNode[n].name[0] = '\0';
+}
+
+static int ns_Child(int nParent, const char *pName)
+{
+	int i;
+
+	for (i = 1; i < NS_NODES; i++)
+	{
+		if (ns_aNode[i].type && ns_aNode[i].parent == nParent &&
+			strcmp(ns_aNode[i].name, pName) == 0)
+			return i;
+	}
+	return -1;
+}
+
+//˰·ҽڵ,ֱ޸ķ
+static int ns_Path(const char *pPath)
+{
+	char aName[32];
+	int n = 0, nLen;
+
+	while (*pPath)
+	{
+		while (*pPath == '/')
+			pPath++;
+		for (nLen = 0; pPath[nLen] && pPath[nLen] != '/'; nLen++);
+		if (nLen == 0)
+			break;
+		memcpy(aName, pPath, nLen);
+		aName[nLen] = '\0';
+		n = ns_Child(n, aName);
+		if (n < 0)
+			return -1;
+		pPath += nLen;
+	}
+	return n;
+}
+
+static void ns_Handle(nfs_fh3 *pFh, u32 *pBuf, int n)
+{
+
+	pBuf[0] = n;
+	pBuf[1] = ns_aNode[n].gen;
+	pFh->data.data_len = 8;
+	pFh->data.data_val = (char *)pBuf;
+}
+
+//ʧЧʱ-1
+static int ns_Node(const nfs_fh3 *pFh)
+{
+	u32 aFh[2];
+
+	if (pFh->data.data_len != 8)
+		return -1;
+	memcpy(aFh, pFh->data.data_val, 8);
+	if (aFh[0] >= NS_NODES || ns_aNode[aFh[0]].type == 0 || ns_aNode[aFh[0]].gen != aFh[1])
+		return -1;
+	return aFh[0];
+}
+
+static void ns_Attr(post_op_attr *pAttr, int n)
+{
+	fattr3 *p = &pAttr->post_op_attr_u.attributes;
+
+	pAttr->attributes_follow = TRUE;
+	p->type = ns_aNode[n].type;
+	p->mode = 0644;
+	p->nlink = 1;
+	p->size = ns_aNode[n].size;
+	p->used = ns_aNode[n].size;
+	p->fileid = n;
+	p->mtime.seconds = ns_aNode[n].mtime;
+}
+
+//Ŀ¼½ͬڵ
+static int ns_Create(diropargs3 *pWhere, int nType, nfsstat3 *pStatus)
+{
+	int nDir, n;
+
+	nDir = ns_Node(&pWhere->dir);
+	if (nDir < 0)
+	{
+		*pStatus = NFS3ERR_STALE;
+		return -1;
+	}
+	if (ns_Child(nDir, pWhere->name) >= 0)
+	{
+		*pStatus = NFS3ERR_EXIST;
+		return -1;
+	}
+	n = ns_Add(nDir, pWhere->name, nType, 0);
+	*pStatus = (n < 0) ? NFS3ERR_NOSPC : NFS3_OK;
+	return n;
+}
+
+static int ns_Remove(diropargs3 *pWhat, int nType)
+{
+	int nDir, n, i;
+
+	nDir = ns_Node(&pWhat->dir);
+	if (nDir < 0)
+		return NFS3ERR_STALE;
+	n = ns_Child(nDir, pWhat->name);
+	if (n < 0)
+		return NFS3ERR_NOENT;
+	if (ns_aNode[n].type != nType)
+		return (nType == NFS3DIR) ? NFS3ERR_NOTDIR : NFS3ERR_ISDIR;
+	for (i = 1; i < NS_NODES; i++)
+	{
+		if (ns_aNode[i].type && ns_aNode[i].parent == n)
+			return NFS3ERR_NOTEMPTY;
+	}
+	ns_Del(n);
+	return NFS3_OK;
+}
+
+static void ns_Nfs(XDR *in, XDR *out, u32 nProc)
+{
+	union {
+		GETATTR3args getattr;
+		LOOKUP3args lookup;
+		READ3args read;
+		WRITE3args write;
+		CREATE3args create;
+		MKDIR3args mkdir;
+		REMOVE3args remove;
+		RENAME3args rename;
+		COMMIT3args commit;
+	} a;
+	union {
+		GETATTR3res getattr;
+		LOOKUP3res lookup;
+		READ3res read;
+		WRITE3res write;
+		CREATE3res create;
+		MKDIR3res mkdir;
+		REMOVE3res remove;
+		RENAME3res rename;
+		COMMIT3res commit;
+	} r;
+	xdrproc_t xargs, xres;
+	u32 aFh[2];
+	int n, m;
+
+	memset(&a, 0, sizeof(a));
+	memset(&r, 0, sizeof(r));
+	if (nProc < NS_PROCS)
+		ns_aCall[nProc] += 1;
+	switch (nProc)
+	{
+	case NFSPROC3_GETATTR:
+		xargs = (xdrproc_t)xdr_GETATTR3args;
+		xres = (xdrproc_t)xdr_GETATTR3res;
+		xargs(in, &a);
+		n = ns_Node(&a.getattr.object);
+		if (n < 0)
+		{
+			r.getattr.status = NFS3ERR_STALE;
+			break;
+		}
+		{
+			post_op_attr op;
+
+			memset(&op, 0, sizeof(op));
+			ns_Attr(&op, n);
+			r.getattr.GETATTR3res_u.resok.obj_attributes = op.post_op_attr_u.attributes;
+		}
+		break;
+	case NFSPROC3_LOOKUP:
+		xargs = (xdrproc_t)xdr_LOOKUP3args;
+		xres = (xdrproc_t)xdr_LOOKUP3res;
+		xargs(in, &a);
+		m = ns_Node(&a.lookup.what.dir);
+		n = (m < 0) ? -1 : ns_Child(m, a.lookup.what.name);
+		if (n < 0)
+		{
+			r.lookup.status = (m < 0) ? NFS3ERR_STALE : NFS3ERR_NOENT;
+			break;
+		}
+		ns_Handle(&r.lookup.LOOKUP3res_u.resok.object, aFh, n);
+		ns_Attr(&r.lookup.LOOKUP3res_u.resok.obj_attributes, n);
+		break;
+	case NFSPROC3_READ:
+		xargs = (xdrproc_t)xdr_READ3args;
+		xres = (xdrproc_t)xdr_READ3res;
+		xargs(in, &a);
+		n = ns_Node(&a.read.file);
+		if (n < 0)
+		{
+			r.read.status = NFS3ERR_STALE;
+			break;
+		}
+		{
+			READ3resok *p = &r.read.READ3res_u.resok;
+			u32 nOff = a.read.offset, nCnt = a.read.count;
+
+			if (nOff > ns_aNode[n].size)
+				nOff = ns_aNode[n].size;
+			if (nCnt > ns_aNode[n].size - nOff)
+				nCnt = ns_aNode[n].size - nOff;
+			p->count = nCnt;
+			p->eof = (nOff + nCnt >= ns_aNode[n].size);
+			p->data.data_len = nCnt;
+			p->data.data_val = (char *)ns_aNode[n].data + nOff;
+			ns_Attr(&p->file_attributes, n);
+		}
+		break;
+	case NFSPROC3_WRITE:
+		xargs = (xdrproc_t)xdr_WRITE3args;
+		xres = (xdrproc_t)xdr_WRITE3res;
+		xargs(in, &a);
+		n = ns_Node(&a.write.file);
+		if (n < 0 || a.write.offset + a.write.data.data_len > NS_DATA)
+		{
+			r.write.status = (n < 0) ? NFS3ERR_STALE : NFS3ERR_FBIG;
+			break;
+		}
+		memcpy(ns_aNode[n].data + a.write.offset, a.write.data.data_val, a.write.data.data_len);
+		if (a.write.offset + a.write.data.data_len > ns_aNode[n].size)
+			ns_aNode[n].size = a.write.offset + a.write.data.data_len;
+		ns_aNode[n].mtime = ns_nTick;
+		r.write.WRITE3res_u.resok.count = a.write.data.data_len;
+		r.write.WRITE3res_u.resok.committed = a.write.stable;
+		memcpy(r.write.WRITE3res_u.resok.verf, ns_aVerf, NFS3_WRITEVERFSIZE);
+		break;
+	case NFSPROC3_CREATE:
+		xargs = (xdrproc_t)xdr_CREATE3args;
+		xres = (xdrproc_t)xdr_CREATE3res;
+		xargs(in, &a);
+		n = ns_Create(&a.create.where, NFS3REG, &r.create.status);
+		if (n >= 0)
+		{
+			r.create.CREATE3res_u.resok.obj.handle_follows = TRUE;
+			ns_Handle(&r.create.CREATE3res_u.resok.obj.post_op_fh3_u.handle, aFh, n);
+			ns_Attr(&r.create.CREATE3res_u.resok.obj_attributes, n);
+		}
+		break;
+	case NFSPROC3_MKDIR:
+		xargs = (xdrproc_t)xdr_MKDIR3args;
+		xres = (xdrproc_t)xdr_MKDIR3res;
+		xargs(in, &a);
+		n = ns_Create(&a.mkdir.where, NFS3DIR, &r.mkdir.status);
+		if (n >= 0)
+		{
+			r.mkdir.MKDIR3res_u.resok.obj.handle_follows = TRUE;
+			ns_Handle(&r.mkdir.MKDIR3res_u.resok.obj.post_op_fh3_u.handle, aFh, n);
+			ns_Attr(&r.mkdir.MKDIR3res_u.resok.obj_attributes, n);
+		}
+		break;
+	case NFSPROC3_REMOVE:
+		xargs = (xdrproc_t)xdr_REMOVE3args;
+		xres = (xdrproc_t)xdr_REMOVE3res;
+		xargs(in, &a);
+		r.remove.status = ns_Remove(&a.remove.object, NFS3REG);
+		break;
+	case NFSPROC3_RMDIR:
+		xargs = (xdrproc_t)xdr_RMDIR3args;
+		xres = (xdrproc_t)xdr_RMDIR3res;
+		xargs(in, &a);
+		r.remove.status = ns_Remove(&a.remove.object, NFS3DIR);
+		break;
+	case NFSPROC3_RENAME:
+		xargs = (xdrproc_t)xdr_RENAME3args;
+		xres = (xdrproc_t)xdr_RENAME3res;
+		xargs(in, &a);
+		m = ns_Node(&a.rename.from.dir);
+		n = (m < 0) ? -1 : ns_Child(m, a.rename.from.name);
+		m = ns_Node(&a.rename.to.dir);
+		if (n < 0 || m < 0)
+		{
+			r.rename.status = NFS3ERR_NOENT;
+			break;
+		}
+		if (ns_Child(m, a.rename.to.name) >= 0)
+			ns_Del(ns_Child(m, a.rename.to.name));
+		ns_aNode[n].parent = m;
+		strncpy(ns_aNode[n].name, a.rename.to.name, sizeof(ns_aNode[n].name) - 1);
+		break;
+	case NFSPROC3_COMMIT:
+		xargs = (xdrproc_t)xdr_COMMIT3args;
+		xres = (xdrproc_t)xdr_COMMIT3res;
+		xargs(in, &a);
+		memcpy(r.commit.COMMIT3res_u.resok.verf, ns_aVerf, NFS3_WRITEVERFSIZE);
+		break;
+	default:
+		TEST_CHECK(0, "unexpected NFS procedure %u", nProc);
+		return;
+	}
+	xres(out, &r);
+	xdr_free(xargs, (char *)&a);
+}
+
+static void ns_Mount(XDR *in, XDR *out, u32 nProc)
+{
+	mountres3 res;
+	dirpath path = NULL;
+	u32 aFh[2] = {0, 0};
+
+	xdr_dirpath(in, &path);
+	if (nProc == MOUNTPROC3_MNT)
+	{
+		memset(&res, 0, sizeof(res));
+		res.fhs_status = strcmp(path, "/export") ? MNT3ERR_NOENT : MNT3_OK;
+		res.mountres3_u.mountinfo.fhandle.fhandle3_len = 8;
+		res.mountres3_u.mountinfo.fhandle.fhandle3_val = (char *)aFh;
+		xdr_mountres3(out, &res);
+	}
+	xdr_free((xdrproc_t)xdr_dirpath, (char *)&path);
+}
+
+//:⿪ͷŷַ,ӦͷΪMSG_ACCEPTED/SUCCESS
+static ssize_t ns_Sendto(int s, const void *pBuf, size_t nLen, int nFlag, const struct sockaddr *pTo, socklen_t nToLen)
+{
+	struct opaque_auth auth;
+	long aHdr[6], l;
+	XDR in, out;
+	ns_msg *pRep;
+	int i;
+
+	if (ns_nRep >= NS_QTY)
+		return nLen;
+	xdrmem_create(&in, pBuf, nLen, XDR_DECODE);
+	for (i = 0; i < 6; i++)
+		XDR_GETLONG(&in, &aHdr[i]);
+	for (i = 0; i < 2; i++)
+	{
+		memset(&auth, 0, sizeof(auth));
+		xdr_opaque_auth(&in, &auth);
+		xdr_free((xdrproc_t)xdr_opaque_auth, (char *)&auth);
+	}
+
+	pRep = &ns_aRep[ns_nRep++];
+	xdrmem_create(&out, pRep->buf, NS_MSG_SIZE, XDR_ENCODE);
+	XDR_PUTLONG(&out, &aHdr[0]);
+	l = REPLY;
+	XDR_PUTLONG(&out, &l);
+	l = MSG_ACCEPTED;
+	XDR_PUTLONG(&out, &l);
+	xdr_opaque_auth(&out, &_null_auth);
+	l = SUCCESS;
+	XDR_PUTLONG(&out, &l);
+	if (aHdr[3] == MOUNT_PROGRAM)
+		ns_Mount(&in, &out, aHdr[5]);
+	else
+		ns_Nfs(&in, &out, aHdr[5]);
+	pRep->len = XDR_GETPOS(&out);
+	return nLen;
+}
+
+static ssize_t ns_Recvfrom(int s, void *pBuf, size_t nLen, int nFlag, struct sockaddr *pFrom, socklen_t *pFromLen)
+{
+
+	if (ns_nRep == 0)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	if ((size_t)ns_aRep[0].len < nLen)
+		nLen = ns_aRep[0].len;
+	memcpy(pBuf, ns_aRep[0].buf, nLen);
+	ns_nRep -= 1;
+	memmove(&ns_aRep[0], &ns_aRep[1], ns_nRep * sizeof(ns_msg));
+	return nLen;
+}
+
+static int ns_Rpcs(void)
+{
+	int i, n = 0;
+
+	for (i = 0; i < NS_PROCS; i++)
+		n += ns_aCall[i];
+	return n;
+}
+
+static int ns_Stat(const char *pPath)
+{
+	struct stat st;
+
+	if (nfs_stat(&ns_fs, pPath, &st) < 0)
+		return -1;
+	return st.st_size;
+}
+
+static int ns_Open(struct dfs_fd *pFd, const char *pPath, u32 nFlag)
+{
+
+	memset(pFd, 0, sizeof(struct dfs_fd));
+	pFd->path = (char *)pPath;
+	pFd->type = FT_REGULAR;
+	pFd->fs = &ns_fs;
+	pFd->flags = nFlag;
+	return nfs_open(pFd);
+}
+
+//·Ի:ظʲLOOKUP,ں֤,ɾ
+static void ns_TestCache(void)
+{
+	struct dfs_fd fd;
+	int i, nFile, nBase;
+
+	memset(ns_aCall, 0, sizeof(ns_aCall));
+	for (i = 0; i < 20; i++)
+	{
+		TEST_CHECK(ns_Stat("/a/b/c/d/f") == 3000, "stat size");
+		TEST_CHECK(ns_Open(&fd, "/a/b/c/d/f", 0) == 0, "open failed");
+		TEST_CHECK(fd.data && ((nfs_file *)fd.data)->size == 3000, "open size");
+		nfs_close(&fd);
+	}
+#if NFS_CACHE_SIZE
+	TEST_CHECK(ns_aCall[NFSPROC3_LOOKUP] == 5 && ns_Rpcs() == 5,
+		"20 stat/open: %d LOOKUP %d RPC", ns_aCall[NFSPROC3_LOOKUP], ns_Rpcs());
+#else
+	TEST_CHECK(ns_aCall[NFSPROC3_LOOKUP] == 200, "uncached LOOKUP %d", ns_aCall[NFSPROC3_LOOKUP]);
+#endif
+
+	//ͻ˸ĶڻЧںɼ
+	nFile = ns_Path("/a/b/c/d/f");
+	ns_aNode[nFile].size = 5000;
+	ns_nTick += NFS_CACHE_TTL;
+	memset(ns_aCall, 0, sizeof(ns_aCall));
+	TEST_CHECK(ns_Stat("/a/b/c/d/f") == 5000, "expired attributes served");
+#if NFS_CACHE_SIZE
+	TEST_CHECK(ns_aCall[NFSPROC3_LOOKUP] == 5, "revalidation %d LOOKUP", ns_aCall[NFSPROC3_LOOKUP]);
+#endif
+
+	//ԼдʹʧЧ
+	TEST_CHECK(ns_Open(&fd, "/a/b/c/d/f", DFS_O_APPEND) == 0, "open append failed");
+	TEST_CHECK(nfs_write(&fd, "0123456789", 10) == 10, "append");
+	TEST_CHECK(nfs_close(&fd) == 0, "close after append");
+	TEST_CHECK(ns_Stat("/a/b/c/d/f") == 5010, "own write not seen");
+
+	//½ļþ
+	TEST_CHECK(ns_Stat("/a/b/c/d/g") < 0, "missing file found");
+	TEST_CHECK(ns_Open(&fd, "/a/b/c/d/g", DFS_O_CREAT) == 0, "create failed");
+	nfs_close(&fd);
+	TEST_CHECK(ns_Stat("/a/b/c/d/g") == 0, "created file size");
+
+	//·ʧЧ,·õͬһļ
+	TEST_CHECK(nfs_rename(&ns_fs, "/a/b", "/a/x") == 0, "rename failed");
+	TEST_CHECK(ns_Stat("/a/b/c/d/f") < 0, "renamed path still cached");
+	TEST_CHECK(ns_Stat("/a/x/c/d/f") == 5010, "new path");
+
+	//ɾ,ͬؽõļ
+	TEST_CHECK(nfs_unlink(&ns_fs, "/a/x/c/d/f") == 0, "unlink failed");
+	TEST_CHECK(ns_Stat("/a/x/c/d/f") < 0, "unlinked file still cached");
+	TEST_CHECK(ns_Open(&fd, "/a/x/c/d/f", DFS_O_CREAT) == 0, "recreate failed");
+	TEST_CHECK(fd.data && ((nfs_file *)fd.data)->size == 0, "recreated file has old size");
+	nfs_close(&fd);
+
+	//Ŀ¼ɾͬ»һʧЧ
+	TEST_CHECK(nfs_unlink(&ns_fs, "/a/x/c/d/f") == 0 && nfs_unlink(&ns_fs, "/a/x/c/d/g") == 0, "unlink");
+	TEST_CHECK(nfs_unlink(&ns_fs, "/a/x/c/d") == 0, "rmdir failed");
+	TEST_CHECK(ns_Stat("/a/x/c/d") < 0, "removed directory still cached");
+
+	//ʱLRU滻,ʼȷ
+	nBase = ns_Path("/a/x/c");
+	for (i = 0; i < 3 * NFS_CACHE_SIZE + 3; i++)
+	{
+		char aName[8];
+
+		sprintf(aName, "n%d", i);
+		ns_Add(nBase, aName, NFS3REG, 100 + i);
+	}
+	for (i = 0; i < 2000; i++)
+	{
+		char aPath[32];
+		int n = test_Rand() % (3 * NFS_CACHE_SIZE + 3);
+
+		sprintf(aPath, "/a/x/c/n%d", n);
+		if (ns_Stat(aPath) != 100 + n)
+			break;
+	}
+	TEST_CHECK(i == 2000, "LRU stat %d wrong", i);
+}
+
+//˳дԤӳύһ
+static void ns_TestData(void)
+{
+	static u8 aData[20000], aBuf[20000];
+	struct dfs_fd fd;
+	int i, n, nRead;
+
+	for (i = 0; i < (int)sizeof(aData); i++)
+		aData[i] = test_Rand();
+	TEST_CHECK(ns_Open(&fd, "/data", DFS_O_CREAT) == 0, "create data failed");
+	memset(ns_aCall, 0, sizeof(ns_aCall));
+	for (i = 0; i < (int)sizeof(aData); i += n)
+	{
+		n = MIN(1000, (int)sizeof(aData) - i);
+		if (nfs_write(&fd, aData + i, n) != n)
+			break;
+	}
+	TEST_CHECK(i == sizeof(aData), "write stopped at %d", i);
+	TEST_CHECK(nfs_close(&fd) == 0, "close after write");
+	TEST_CHECK(ns_aCall[NFSPROC3_WRITE] == 20, "%d WRITE", ns_aCall[NFSPROC3_WRITE]);
+#if NFS_WB_DEPTH
+	TEST_CHECK(ns_aCall[NFSPROC3_COMMIT] == 1, "%d COMMIT", ns_aCall[NFSPROC3_COMMIT]);
+#endif
+	n = ns_Path("/data");
+	TEST_CHECK(ns_aNode[n].size == sizeof(aData) &&
+		memcmp(ns_aNode[n].data, aData, sizeof(aData)) == 0, "server data differs");
+
+	TEST_CHECK(ns_Open(&fd, "/data", 0) == 0, "open data failed");
+	memset(ns_aCall, 0, sizeof(ns_aCall));
+	for (nRead = 0; nRead < (int)sizeof(aBuf); nRead += n)
+	{
+		n = nfs_read(&fd, aBuf + nRead, 700);
+		if (n <= 0)
+			break;
+	}
+	TEST_CHECK(nRead == sizeof(aData) && memcmp(aBuf, aData, nRead) == 0, "read back %d", nRead);
+	TEST_CHECK(nfs_read(&fd, aBuf, 700) == 0, "read past end");
+#if NFS_RA_PAGES
+	TEST_CHECK(ns_aCall[NFSPROC3_READ] <= (int)(sizeof(aData) + NFS_PAGE_SIZE - 1) / NFS_PAGE_SIZE + NFS_RA_PAGES,
+		"%d READ", ns_aCall[NFSPROC3_READ]);
+#endif
+	nfs_close(&fd);
+	TEST_CHECK(nfs_unlink(&ns_fs, "/data") == 0, "unlink data");
+}
+
+static void ns_Bench(void)
+{
+	struct stat st;
+
+	TEST_BENCH("stat 4 deep", 100000, nfs_stat(&ns_fs, "/a/x/c/n1", &st));
+}
+
+int main(int argc, char **argv)
+{
+	int n;
+
+	test_Init(argc, argv);
+
+	ns_aNode[0].type = NFS3DIR;
+	n = ns_Add(0, "a", NFS3DIR, 0);
+	n = ns_Add(n, "b", NFS3DIR, 0);
+	n = ns_Add(n, "c", NFS3DIR, 0);
+	n = ns_Add(n, "d", NFS3DIR, 0);
+	ns_Add(n, "f", NFS3REG, 3000);
+
+	TEST_CHECK(nfs_mount(&ns_fs, 0, "nas:/export") == 0, "mount failed");
+	if (ns_fs.data)
+	{
+		ns_TestCache();
+		ns_TestData();
+		ns_Bench();
+		TEST_CHECK(nfs_unmount(&ns_fs) == 0, "unmount failed");
+	}
+
+	for (n = 0; n < NS_NODES; n++)
+		free(ns_aNode[n].data);
+#if NFS_CACHE_SIZE
+	return test_Result("nfs");
+#else
+	return test_Result("nfs no cache");
+#endif
+}
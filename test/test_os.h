@@ -0,0 +1,51 @@
+#ifndef __TEST_OS_H__
+#define __TEST_OS_H__
+
+//-------------------------------------------------------------------------
+//OSڴͨ,Эģʹ
+//tickɲƽ,os_thd_lockΪ뻥
+//-------------------------------------------------------------------------
+#include <pthread.h>
+#include <unistd.h>
+
+
+//Public Defines
+#ifndef OS_TICK_MS
+#define OS_TICK_MS				10
+#endif
+
+
+//Public Typedefs
+struct _chl
+{
+	u8		ste;
+	u8		type;
+	void *	pIf;
+} PACK_STRUCT_STRUCT;
+typedef struct _chl chl_t, chl[1];
+
+
+//Private Variables
+static pthread_mutex_t test_os_mtx __attribute__((unused)) = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static volatile u32 test_nTick = 0;
+
+
+//External Functions
+#define os_thd_lock()			pthread_mutex_lock(&test_os_mtx)
+#define os_thd_unlock()			pthread_mutex_unlock(&test_os_mtx)
+#define os_tick_get()			(test_nTick)
+#define os_thd_slp1tick()		usleep(100)
+#define sys_Delay(us)
+
+#define mem_Malloc				malloc
+#define mem_Realloc				realloc
+#define mem_Free				free
+
+//ɸʵ
+sys_res chl_Send(chl p, const void *pData, size_t nLen);
+sys_res chl_RecData(chl p, buf b, size_t nTmo);
+void gpio_Set(int nId, int nHL);
+
+
+#endif
+
@@ -0,0 +1,452 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_os.h"
+
+//弶ͨ
+struct gpio_def
+{
+	u16	type : 2,
+		port : 4,
+		pin : 5,
+		mode : 3,
+		init : 2;
+} PACK_STRUCT_STRUCT;
+typedef const struct gpio_def t_gpio_def;
+
+#define GPIO_EFFECT_LOW			0
+#define GPIO_EFFECT_HIGH		1
+#define CHL_T_RS232				0
+#define UART_PARI_NO			0
+#define UART_PARI_EVEN			2
+#define UART_DATA_8D			8
+#define UART_STOP_1D			1
+#define LOG_T_STRING			0
+#define LCP_SN_MAX				4096
+
+#define XCN6N12_ENABLE			0
+#define PLC_SET_ENABLE			0
+#define PLC_PROBE_ENABLE		0
+#define DLT645_CACHE_ENABLE		0
+
+//ͳͬڴ
+static void *plc_TestMalloc(size_t nSize);
+#undef mem_Malloc
+#define mem_Malloc				plc_TestMalloc
+
+#include <cp/lcp/dlt645.h>
+#include <cp/lcp/plc.h>
+#include <cp/lcp/gw3762.h>
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/bcd.c"
+#include "../lib/lib.c"
+#include "../cp/lcp/dlt645.c"
+
+void sys_GpioConf(t_gpio_def *p);
+void sys_GpioSet(t_gpio_def *p, int nHL);
+sys_res chl_rs232_Config(chl p, int nBaud, int nPari, int nData, int nStop);
+sys_res chl_Bind(chl p, int nType, int nId, size_t nTmo);
+time_t rtc_GetTimet(void);
+void dbg_trace(const char *str);
+void log_Write(int nType, const void *pData, size_t nLen);
+void os_thd_sleep(u32 nMs);
+
+t_plc_def tbl_bspPlc;
+
+#include "../cp/lcp/plc.c"
+
+
+//Private Defines
+#define SYNC_METER_MAX			LCP_SN_MAX
+#define SYNC_MODULE_MAX			(LCP_SN_MAX * 2)
+
+
+//Private Typedefs
+//ģزģ·ɱ
+typedef struct {
+	u8		node[SYNC_MODULE_MAX][GW3762_SUBADR_ADD_SIZE];
+	int		qty;
+	int		batch;		//֡ڵ,
+	u32		nAdd;
+	u32		nDel;
+} sync_module_t;
+
+
+//Private Variables
+static plc_t plc_x;
+static sync_module_t sync_xMod;
+static u8 sync_aMeter[SYNC_METER_MAX][6];
+static int sync_nMeter;
+static u32 sync_nMeterAdr;
+static size_t sync_nAlloc;
+
+
+//Internal Functions
+static void *plc_TestMalloc(size_t nSize)
+{
+
+	sync_nAlloc = MAX(sync_nAlloc, nSize);
+	return malloc(nSize);
+}
+
+static void sync_Adr(u8 *pAdr)
+{
+	int i;
+
+	for (i = 0; i < 6; i++)
+		pAdr[i] = test_Rand();
+}
+
+static void sync_Config(int nQty)
+{
+	int i;
+
+	sync_nMeter = nQty;
+	for (i = 0; i < nQty; i++)
+	{
+		//,ֲֳ
+		memset(sync_aMeter[i], 0, 6);
+		sync_aMeter[i][0] = bin2bcd8(i % 100);
+		sync_aMeter[i][1] = bin2bcd8(i / 100 % 100);
+		sync_aMeter[i][2] = bin2bcd8(i / 10000);
+		sync_aMeter[i][3] = 0x12;
+	}
+}
+
+static int sync_ModFind(const u8 *pAdr)
+{
+	int i;
+
+	for (i = 0; i < sync_xMod.qty; i++)
+	{
+		if (memcmp(sync_xMod.node[i], pAdr, 6) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static void sync_ModPush(const u8 *pAdr, int nSn)
+{
+	u8 *pNode = sync_xMod.node[sync_xMod.qty++];
+
+	memcpy(pNode, pAdr, 6);
+	pNode[6] = nSn;
+	pNode[7] = nSn >> 8;
+	pNode[8] = 2;
+}
+
+//ģ·ɱӦ뵵һһӦ,һ
+static void sync_Verify(const char *pName, int nFrom1)
+{
+	int i, j, nErr = 0;
+
+	TEST_CHECK(sync_xMod.qty == sync_nMeter, "%s: module %d nodes, %d meters", pName, sync_xMod.qty, sync_nMeter);
+	for (i = 0; i < sync_nMeter; i++)
+	{
+		j = sync_ModFind(sync_aMeter[i]);
+		if ((j < 0) || ((sync_xMod.node[j][6] | (sync_xMod.node[j][7] << 8)) != i + nFrom1) || (sync_xMod.node[j][8] != 2))
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%s: %d meters missing or misnumbered", pName, nErr);
+}
+
+static int sync_BenchFind()
+{
+	plc_sync_t xSync;
+	int i, nFound = 0;
+
+	plc_SyncInit(&xSync, sync_nMeter);
+	for (i = 0; i < sync_nMeter; i++)
+		nFound += (plc_SyncFind(&xSync, sync_aMeter[i]) >= 0);
+	mem_Free(xSync.hash);
+	
+	return nFound;
+}
+
+//ÿҵ,ǵַҲ
+static void sync_TestHash()
+{
+	plc_sync_t xSync;
+	int i, nErr;
+	u8 aAdr[6];
+	u32 nRead;
+
+	sync_Config(2048);
+	sync_nAlloc = 0;
+	TEST_CHECK(plc_SyncInit(&xSync, sync_nMeter) == SYS_R_OK, "init");
+	//ԭʵԼ23KB,Ӧÿ5ֽ
+	TEST_CHECK(sync_nAlloc <= (size_t)sync_nMeter * 5, "sync table %u bytes for %d meters", (unsigned)sync_nAlloc, sync_nMeter);
+	
+	for (nErr = 0, i = 0; i < sync_nMeter; i++)
+	{
+		if (plc_SyncFind(&xSync, sync_aMeter[i]) != i)
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%d meters not found", nErr);
+	
+	//ָƹ˺,δеַض
+	nRead = sync_nMeterAdr;
+	for (nErr = 0, i = 0; i < 10000; i++)
+	{
+		sync_Adr(aAdr);
+		aAdr[3] = 0x34;
+		if (plc_SyncFind(&xSync, aAdr) >= 0)
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%d foreign addresses found", nErr);
+	TEST_CHECK(sync_nMeterAdr - nRead < 1000, "%u archive reads for 10000 misses", sync_nMeterAdr - nRead);
+	
+	mem_Free(xSync.hash);
+	
+	TEST_BENCH("sync init+find 2048", 100, sync_BenchFind());
+}
+
+static void sync_TestFlow(int nType, int nBatch)
+{
+	int i, j, nFrom1 = (nType == PLC_T_ES_RT) ? 0 : 1;
+	char str[32];
+
+	sprintf(str, "type %d batch %d", nType, nBatch);
+	plc_x.type = nType;
+	sync_xMod.batch = nBatch;
+	
+	//ģ:ȫ
+	sync_Config(2048);
+	sync_xMod.qty = 0;
+	TEST_CHECK(plc_Sync(&plc_x) == SYS_R_OK, "%s: empty sync", str);
+	sync_Verify(str, nFrom1);
+	
+	//ͬ:Ӧɾ
+	sync_xMod.nAdd = sync_xMod.nDel = 0;
+	TEST_CHECK(plc_Sync(&plc_x) == SYS_R_OK, "%s: resync", str);
+	TEST_CHECK((sync_xMod.nAdd | sync_xMod.nDel) == 0, "%s: resync added %u deleted %u", str, sync_xMod.nAdd, sync_xMod.nDel);
+	
+	//ģ,ڵظڵ,ֵȱʧ
+	sync_xMod.qty = 0;
+	for (i = 0; i < sync_nMeter; i++)
+	{
+		if (test_Rand() % 8)
+			sync_ModPush(sync_aMeter[i], i + nFrom1);
+	}
+	for (i = 0; i < 100; i++)
+	{
+		u8 aAdr[6];
+
+		sync_Adr(aAdr);
+		sync_ModPush(aAdr, i);
+	}
+	for (i = 0; i < 5; i++)
+		sync_ModPush(sync_xMod.node[i], sync_xMod.node[i][6] | (sync_xMod.node[i][7] << 8));
+	for (i = sync_xMod.qty - 1; i > 0; i--)
+	{
+		u8 aTmp[GW3762_SUBADR_ADD_SIZE];
+
+		j = test_Rand() % (i + 1);
+		memcpy(aTmp, sync_xMod.node[i], sizeof(aTmp));
+		memcpy(sync_xMod.node[i], sync_xMod.node[j], sizeof(aTmp));
+		memcpy(sync_xMod.node[j], aTmp, sizeof(aTmp));
+	}
+	sync_xMod.nAdd = sync_xMod.nDel = 0;
+	TEST_CHECK(plc_Sync(&plc_x) == SYS_R_OK, "%s: mixed sync", str);
+	sync_Verify(str, nFrom1);
+	TEST_CHECK(sync_xMod.nDel == 105, "%s: deleted %u", str, sync_xMod.nDel);
+}
+
+//ÿӦȴʱԴ
+static void rto_TestWait()
+{
+	u8 aAdr[6] = {0x01, 0x00, 0x00, 0x12, 0x00, 0x00};
+	u8 aOther[6] = {0x02, 0x00, 0x00, 0x12, 0x00, 0x00};
+	int i, nMax, nWait, nLast, nOver;
+	u32 nRtt;
+
+	memset(plc_aStat, 0, sizeof(plc_aStat));
+	plc_x.type = PLC_T_TOPCOM;
+	nMax = plc_GetWait(&plc_x, 0) * 1000;
+	
+	//ͳʱȡģ̶ֵ
+	TEST_CHECK(plc_MeterWait(&plc_x, aAdr, 0) == nMax, "no stat wait %d", plc_MeterWait(&plc_x, aAdr, 0));
+	TEST_CHECK(plc_MeterRetry(&plc_x, aAdr) == plc_GetRetry(&plc_x), "no stat retry");
+	
+	//ȶʱsrtt + ,
+	for (i = 0; i < 32; i++)
+		plc_StatUpdate(aAdr, 1, 3000);
+	nWait = plc_MeterWait(&plc_x, aAdr, 0);
+	TEST_CHECK((nWait >= 3000 + PLC_WAIT_MARGIN) && (nWait < 3000 + PLC_WAIT_MARGIN + 400), "steady wait %d", nWait);
+	TEST_CHECK(plc_MeterWait(&plc_x, aOther, 0) == nMax, "other meter shares stat");
+	for (i = 0; i < 64; i++)
+		plc_StatUpdate(aOther, 1, 100);
+	TEST_CHECK(plc_MeterWait(&plc_x, aOther, 0) == PLC_WAIT_MIN, "fast meter wait %d", plc_MeterWait(&plc_x, aOther, 0));
+	
+	//ʱ:ȴʱӦǾ
+	memset(plc_aStat, 0, sizeof(plc_aStat));
+	for (nOver = 0, i = 0; i < 2000; i++)
+	{
+		nRtt = 4000 + test_Rand() % 4000;
+		if ((i >= 32) && (nRtt > (u32)plc_MeterWait(&plc_x, aAdr, 0)))
+			nOver += 1;
+		plc_StatUpdate(aAdr, 1, nRtt);
+	}
+	TEST_CHECK(nOver < 2000 / 50, "%d of 2000 replies beyond wait", nOver);
+	nWait = plc_MeterWait(&plc_x, aAdr, 0);
+	TEST_CHECK(nWait < nMax, "jitter wait %d reached fixed %d", nWait, nMax);
+	
+	//ʱ˱:ȴ,ʱص̶ֵ
+	for (nLast = nWait, i = 0; i < PLC_WAIT_FALLBACK - 1; i++)
+	{
+		plc_StatUpdate(aAdr, 0, 0);
+		nWait = plc_MeterWait(&plc_x, aAdr, 0);
+		TEST_CHECK((nWait > nLast) || (nWait == nMax), "backoff %d: %d after %d", i, nWait, nLast);
+		nLast = nWait;
+	}
+	plc_StatUpdate(aAdr, 0, 0);
+	TEST_CHECK(plc_MeterWait(&plc_x, aAdr, 0) == nMax, "fallback wait %d", plc_MeterWait(&plc_x, aAdr, 0));
+	plc_StatUpdate(aAdr, 1, 5000);
+	nWait = plc_MeterWait(&plc_x, aAdr, 0);
+	TEST_CHECK(nWait < nMax, "success does not leave fallback");
+	
+	//м̵ȴ漶
+	TEST_CHECK(plc_MeterWait(&plc_x, aAdr, 2) >= nWait, "relay wait");
+	
+	//ɹ:ƫͶһ,ڲֻͨһ
+	memset(plc_aStat, 0, sizeof(plc_aStat));
+	for (i = 0; i < 3; i++)
+		plc_StatUpdate(aAdr, 0, 0);
+	TEST_CHECK(plc_MeterRetry(&plc_x, aAdr) == plc_GetRetry(&plc_x), "retry with few samples");
+	for (i = 0; i < 3; i++)
+		plc_StatUpdate(aAdr, 0, 0);
+	TEST_CHECK(plc_MeterRetry(&plc_x, aAdr) == plc_GetRetry(&plc_x) + 1, "retry at low rate %d", plc_StatGet(aAdr, 0)->rate);
+	for (i = 0; i < 10; i++)
+		plc_StatUpdate(aAdr, 0, 0);
+	TEST_CHECK(plc_MeterRetry(&plc_x, aAdr) == 0, "dead meter retry %d", plc_MeterRetry(&plc_x, aAdr));
+	for (i = 0; i < 40; i++)
+		plc_StatUpdate(aAdr, 1, 3000);
+	TEST_CHECK(plc_MeterRetry(&plc_x, aAdr) == plc_GetRetry(&plc_x), "recovered meter retry");
+}
+
+
+//External Functions
+//زģ
+sys_res gw3762_SubAdrQty(plc_t *p, u16 *pQty)
+{
+
+	*pQty = sync_xMod.qty;
+	return SYS_R_OK;
+}
+
+sys_res gw3762_SubAdrReadN(plc_t *p, int nSn, int *pCnt, u16 *pQty, u8 *pAdr)
+{
+	int i;
+
+	if (*pCnt > sync_xMod.batch)
+		return SYS_R_ERR;
+	
+	nSn -= (p->type == PLC_T_ES_RT) ? 0 : 1;
+	for (i = 0; (i < *pCnt) && (nSn + i < sync_xMod.qty); i++)
+		memcpy(&pAdr[i * 6], sync_xMod.node[nSn + i], 6);
+	*pCnt = i;
+	if (pQty != NULL)
+		*pQty = sync_xMod.qty;
+	return SYS_R_OK;
+}
+
+sys_res gw3762_SubAdrDeleteN(plc_t *p, const void *pAdr, int nCnt)
+{
+	int i, j;
+
+	if (nCnt > sync_xMod.batch)
+		return SYS_R_ERR;
+	
+	for (i = 0; i < nCnt; i++)
+	{
+		j = sync_ModFind((const u8 *)pAdr + i * 6);
+		if (j < 0)
+			continue;
+		sync_xMod.qty -= 1;
+		memmove(sync_xMod.node[j], sync_xMod.node[j + 1], (sync_xMod.qty - j) * GW3762_SUBADR_ADD_SIZE);
+		sync_xMod.nDel += 1;
+	}
+	return SYS_R_OK;
+}
+
+sys_res gw3762_SubAdrAddN(plc_t *p, const void *pList, int nCnt)
+{
+	const u8 *pNode = pList;
+	int i;
+
+	if (nCnt > sync_xMod.batch)
+		return SYS_R_ERR;
+	
+	for (i = 0; i < nCnt; i++, pNode += GW3762_SUBADR_ADD_SIZE)
+	{
+		memcpy(sync_xMod.node[sync_xMod.qty++], pNode, GW3762_SUBADR_ADD_SIZE);
+		sync_xMod.nAdd += 1;
+	}
+	return SYS_R_OK;
+}
+
+sys_res gw3762_ParaReset(plc_t *p)
+{
+
+	sync_xMod.qty = 0;
+	return SYS_R_OK;
+}
+
+sys_res gw3762_ModAdrSet(plc_t *p) { return SYS_R_OK; }
+sys_res gw3762_RtCtrl(plc_t *p, u16 nDT, int nRetry) { return SYS_R_OK; }
+sys_res gw3762_Es_ModeSet(plc_t *p, int nMode) { return SYS_R_OK; }
+sys_res gw3762_Es_ModeGet(plc_t *p, u8 *pMode) { return SYS_R_ERR; }
+sys_res gw3762_Analyze(plc_t *p) { return SYS_R_ERR; }
+sys_res gw3762_Broadcast(plc_t *p, const void *pAdr, const void *pData, size_t nLen) { return SYS_R_ERR; }
+sys_res gw3762_MeterRead(plc_t *p, const void *pAdr, int nRelay, const void *pRtAdr, const void *pData, size_t nLen) { return SYS_R_ERR; }
+sys_res gw3762_MeterRT(plc_t *p, const void *pAdr, const void *pData, size_t nLen) { return SYS_R_ERR; }
+sys_res gw3762_MeterConcurrent(plc_t *p, const void *pAdr, const void *pData, size_t nLen) { return SYS_R_ERR; }
+sys_res gw3762_Confirm(plc_t *p, int nFlag, size_t nTmo) { return SYS_R_ERR; }
+sys_res gw3762_InfoGet(plc_t *p, int nRetry) { return SYS_R_ERR; }
+sys_res gw3762_StateGet(plc_t *p, int nRetry) { return SYS_R_ERR; }
+sys_res gw3762_ModeSet(plc_t *p, int nMode) { return SYS_R_ERR; }
+sys_res gw3762_MeterProbe(plc_t *p, int nTime) { return SYS_R_ERR; }
+sys_res gw3762_RequestAnswer(plc_t *p, int nPhase, const void *pAdr, int nIsRead, const void *pData, size_t nLen) { return SYS_R_ERR; }
+sys_res gw3762_Transmit(plc_t *p, buf b, const void *pData, size_t nLen) { return SYS_R_ERR; }
+
+//,عԼ
+int plc_MeterAdr(int nSn, void *pAdr)
+{
+
+	sync_nMeterAdr += 1;
+	if (nSn >= sync_nMeter)
+		return 0;
+	memcpy(pAdr, sync_aMeter[nSn], 6);
+	return 2;
+}
+
+u32 plc_Request(const void *pAdr, int *pIs97) { return 0; }
+void plc_NewMeter(const u8 *pAdr) {}
+int plc_IsInTime() { return 1; }
+
+void sys_GpioConf(t_gpio_def *p) {}
+void sys_GpioSet(t_gpio_def *p, int nHL) {}
+sys_res chl_rs232_Config(chl p, int nBaud, int nPari, int nData, int nStop) { return SYS_R_OK; }
+sys_res chl_Bind(chl p, int nType, int nId, size_t nTmo) { return SYS_R_OK; }
+sys_res chl_Send(chl p, const void *pData, size_t nLen) { return SYS_R_OK; }
+sys_res chl_RecData(chl p, buf b, size_t nTmo) { return SYS_R_TMO; }
+void gpio_Set(int nId, int nHL) {}
+time_t rtc_GetTimet() { return test_nTick / (1000 / OS_TICK_MS); }
+void dbg_trace(const char *str) {}
+void log_Write(int nType, const void *pData, size_t nLen) {}
+void os_thd_sleep(u32 nMs) { test_nTick += nMs / OS_TICK_MS; }
+int timet2array(time_t tTime, u8 *p, int nIsBcd) { memset(p, 0, 6); return 0; }
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	
+	sync_TestHash();
+	sync_TestFlow(PLC_T_TOPCOM, GW3762_SUBADR_N_MAX);
+	sync_TestFlow(PLC_T_ES_RT, GW3762_SUBADR_N_MAX);
+	sync_TestFlow(PLC_T_TOPCOM, 5);
+	rto_TestWait();
+	
+	return test_Result("plc");
+}
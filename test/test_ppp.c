@@ -0,0 +1,346 @@
+#include "test.h"
+
+#define ATSVR_UART_ID			0
+#define ATSVR_CMUX_ENABLE		0
+#define ATSVR_TCP_ENABLE		1
+#define ATSVR_UDP_ENABLE		1
+#define ATSVR_BDID_ENABLE		0
+#define ATSVR_DEBUG_ENABLE		0
+#define ATSVR_PPP_FCS_CHECK		1
+#define OS_TICK_MS				10
+
+#define mem_Realloc				realloc
+#define mem_Free				free
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+
+//atserver,ppp.cֻõ⼸ֶ
+typedef struct {
+	int		x;
+} uart_t;
+
+static struct {
+	u8		ppp;
+	u8		tmo;
+	buf		tbuf;
+} test_xAT;
+#define AT						(&test_xAT)
+
+static uart_t dev_Uart[1];
+static buf ppp_bOut;			//ڷֽ
+
+static u32 test_nTick;
+#define os_tick_get()			(test_nTick)
+
+void atsvr_RxDo(void *data, size_t len)
+{
+}
+
+void uart_Send(uart_t *p, const void *pData, size_t nLen)
+{
+
+	buf_Push(ppp_bOut, pData, nLen);
+}
+
+void *ptrcpy(void *dst, const void *src, size_t count)
+{
+
+	memcpy(dst, src, count);
+	return (u8 *)dst + count;
+}
+
+int memtest(const void *s, const u8 c, int len)
+{
+	const u8 *p = (const u8 *)s;
+
+	for (; len; len--)
+	{
+		if (*p++ != c)
+			return 1;
+	}
+	return 0;
+}
+
+#include "../net/bdip/ppp.c"
+
+
+//Private Defines
+#define PPP_TEST_MAX			(PPP_MRU + 8)
+
+
+//Internal Functions
+//οʵ:ֽת
+static size_t ppp_RefEscape(u8 *pOut, const u8 *pIn, size_t nLen)
+{
+	u8 *p = pOut;
+
+	*p++ = 0x7E;
+	for (; nLen; nLen--, pIn++)
+	{
+		if ((*pIn < 0x20) || (*pIn == 0x7D) || (*pIn == 0x7E))
+		{
+			*p++ = 0x7D;
+			*p++ = *pIn ^ 0x20;
+		}
+		else
+		{
+			*p++ = *pIn;
+		}
+	}
+	*p++ = 0x7E;
+	return p - pOut;
+}
+
+//οʵ:ȥβ־ת,ȥתĳ,ʽ-1
+static int ppp_RefUnescape(u8 *pOut, const u8 *pIn, size_t nLen)
+{
+	u8 *p = pOut;
+	size_t i;
+
+	if ((nLen < 2) || (pIn[0] != 0x7E) || (pIn[nLen - 1] != 0x7E))
+		return -1;
+	for (i = 1; i < nLen - 1; i++)
+	{
+		if (pIn[i] == 0x7E)
+			return -1;
+		if ((pIn[i] < 0x20) && (pIn[i] != 0x7D))
+			return -1;
+		if (pIn[i] == 0x7D)
+		{
+			if (++i >= nLen - 1)
+				return -1;
+			*p++ = pIn[i] ^ 0x20;
+		}
+		else
+		{
+			*p++ = pIn[i];
+		}
+	}
+	return p - pOut;
+}
+
+//֡:ѡַ,Э,,FCS
+static size_t ppp_RefFrame(u8 *pOut, int nAcf, int nProto, const u8 *pData, size_t nLen)
+{
+	u8 aRaw[PPP_TEST_MAX + 8];
+	size_t n = 0;
+	u16 nFcs;
+
+	if (nAcf)
+	{
+		aRaw[n++] = 0xFF;
+		aRaw[n++] = 0x03;
+	}
+	aRaw[n++] = nProto >> 8;
+	aRaw[n++] = nProto;
+	memcpy(&aRaw[n], pData, nLen);
+	n += nLen;
+	nFcs = ~fcs16(PPP_RESETFCS, aRaw, n);
+	aRaw[n++] = nFcs;
+	aRaw[n++] = nFcs >> 8;
+	return ppp_RefEscape(pOut, aRaw, n);
+}
+
+static void ppp_Feed(const u8 *p, size_t nLen, size_t nStep)
+{
+	buf b = {0};
+	size_t n;
+
+	for (; nLen; nLen -= n, p += n)
+	{
+		n = MIN(nStep, nLen);
+		buf_Push(b, p, n);
+		ppp_process(b);
+	}
+}
+
+//ppp_output֡:ͷת塢FCSȷ,ΪppptbufǰnLenֽ
+static int ppp_CheckOutput(const u8 *pExpect, size_t nLen)
+{
+	static u8 aRaw[PPP_TEST_MAX * 2];
+	int n;
+
+	if ((ppp_bOut->len < 4) || memcmp(ppp_bOut->p, PPP_HEADER4, 4))
+		return 0;
+	//ͷ0xFF 0x7D 0x23FF 03
+	n = ppp_RefUnescape(aRaw, ppp_bOut->p, ppp_bOut->len);
+	if (n != (int)(nLen + 4))
+		return 0;
+	if ((aRaw[0] != 0xFF) || (aRaw[1] != 0x03))
+		return 0;
+	if (fcs16(PPP_RESETFCS, aRaw, n) != PPP_GOODFCS)
+		return 0;
+	return memcmp(&aRaw[2], pExpect, nLen) == 0;
+}
+
+static void ppp_TestOutput()
+{
+	u8 aData[PPP_TEST_MAX];
+	size_t nLen;
+	int i, j;
+
+	for (i = 0; i < 200; i++)
+	{
+		nLen = PPP_PROCLEN + 1 + test_Rand() % PPP_MRU;
+		for (j = 0; j < nLen; j++)
+		{
+			//ƫҪתֽ
+			aData[j] = (test_Rand() & 1) ? (test_Rand() & 0x1F) : test_Rand();
+			if ((test_Rand() % 8) == 0)
+				aData[j] = 0x7D + (test_Rand() & 1);
+		}
+		memcpy(ppptbuf, aData, nLen);
+		buf_Release(ppp_bOut);
+		ppp_output(nLen);
+		TEST_CHECK(ppp_CheckOutput(aData, nLen), "output %d bytes", (int)nLen);
+	}
+	//ȫת֡Խ
+	memset(ppptbuf, 0x7E, PPP_PROCLEN + PPP_MRU);
+	memset(aData, 0x7E, PPP_PROCLEN + PPP_MRU);
+	buf_Release(ppp_bOut);
+	ppp_output(PPP_PROCLEN + PPP_MRU);
+	TEST_CHECK(ppp_bOut->len <= sizeof(ppphbuf), "worst case %u > %u", (u32)ppp_bOut->len, (u32)sizeof(ppphbuf));
+	TEST_CHECK(ppp_CheckOutput(aData, PPP_PROCLEN + PPP_MRU), "worst case output");
+}
+
+//LCP Echo-Requestppp_process,Ӧppp_output,ȽӦ
+static int ppp_Echo(int nAcf, size_t nLen, size_t nStep, int nCorrupt)
+{
+	static u8 aWire[PPP_TEST_MAX * 2 + 16], aLcp[PPP_TEST_MAX], aExpect[PPP_TEST_MAX];
+	size_t i, n;
+
+	aLcp[0] = 0x09;
+	aLcp[1] = test_Rand();
+	aLcp[2] = (nLen + 8) >> 8;
+	aLcp[3] = nLen + 8;
+	for (i = 4; i < nLen + 8; i++)
+		aLcp[i] = test_Rand();
+	n = ppp_RefFrame(aWire, nAcf, 0xC021, aLcp, nLen + 8);
+	if (nCorrupt)
+		aWire[1 + test_Rand() % (n - 4)] ^= 0x40;
+
+	buf_Release(ppp_bOut);
+	ppp_reset();
+	//ǰһ֡Ĳ
+	ppp_Feed((const u8 *)"\x12\x34\x7E", 3, 3);
+	ppp_Feed(aWire, n, nStep);
+	if (nCorrupt)
+		return ppp_bOut->len == 0;
+
+	aExpect[0] = 0xC0;
+	aExpect[1] = 0x21;
+	memcpy(&aExpect[2], aLcp, nLen + 8);
+	aExpect[2] = 0x0A;
+	memcpy(&aExpect[6], PPP_MAGIC, 4);
+	return ppp_CheckOutput(aExpect, nLen + 10);
+}
+
+static void ppp_TestInput()
+{
+	static const size_t aStep[] = {1, 2, 3, 7, 64, 100000};
+	size_t nLen;
+	int i, j;
+
+	for (i = 0; i < ARR_SIZE(aStep); i++)
+	{
+		for (j = 0; j < 50; j++)
+		{
+			nLen = test_Rand() % (PPP_MRU - 16);
+			TEST_CHECK(ppp_Echo(1, nLen, aStep[i], 0), "echo acf len %d step %d", (int)nLen, (int)aStep[i]);
+			TEST_CHECK(ppp_Echo(0, nLen, aStep[i], 0), "echo acfc len %d step %d", (int)nLen, (int)aStep[i]);
+			TEST_CHECK(ppp_Echo(j & 1, nLen, aStep[i], 1), "bad fcs accepted, len %d step %d", (int)nLen, (int)aStep[i]);
+		}
+	}
+	//֡,Ӱһ֡
+	{
+		static u8 aLong[PPP_MRU + 64];
+
+		memset(aLong, 0x55, sizeof(aLong));
+		aLong[0] = 0x7E;
+		buf_Release(ppp_bOut);
+		ppp_Feed(aLong, sizeof(aLong), 100);
+		TEST_CHECK(ppp_bOut->len == 0, "oversized frame answered");
+		TEST_CHECK(ppp_Echo(1, 16, 5, 0), "echo after oversized frame");
+	}
+}
+
+//ַѹ:ֻFF 03,0xFF
+static void ppp_TestAcfc()
+{
+	static const struct {
+		u8		in[4];
+		u8		n;
+		u8		out[4];
+		u8		m;
+	} aCase[] = {
+		{{0xFF, 0x03, 0xC0, 0x21}, 4, {0xC0, 0x21}, 2},
+		{{0xC0, 0x21, 0x01, 0x02}, 4, {0xC0, 0x21, 0x01, 0x02}, 4},
+		{{0xFF, 0x57, 0x01, 0x02}, 4, {0xFF, 0x57, 0x01, 0x02}, 4},
+		{{0xFF, 0xFF, 0x03, 0x01}, 4, {0xFF, 0xFF, 0x03, 0x01}, 4},
+		{{0x21, 0xFF, 0x03, 0x45}, 4, {0x21, 0xFF, 0x03, 0x45}, 4},
+	};
+	struct ppp_rx *r = &ppp_xRx;
+	int i, j;
+
+	for (i = 0; i < ARR_SIZE(aCase); i++)
+	{
+		//ֵֽ﷽ʽ
+		for (j = 0; j < 2; j++)
+		{
+			ppp_RxStart(r);
+			if (j)
+			{
+				int k;
+
+				for (k = 0; k < aCase[i].n; k++)
+					ppp_RxRun(r, &aCase[i].in[k], 1);
+			}
+			else
+			{
+				ppp_RxRun(r, aCase[i].in, aCase[i].n);
+			}
+			TEST_CHECK((r->len == aCase[i].m) && (memcmp(ppprbuf, aCase[i].out, aCase[i].m) == 0),
+				"acfc case %d split %d: %u bytes %02X %02X", i, j, r->len, ppprbuf[0], ppprbuf[1]);
+		}
+	}
+}
+
+static size_t ppp_BenchOutput()
+{
+
+	buf_Release(ppp_bOut);
+	ppp_output(PPP_PROCLEN + PPP_MRU);
+	return ppp_bOut->len;
+}
+
+static size_t ppp_BenchInput(const u8 *p, size_t n)
+{
+
+	ppp_Feed(p, n, n);
+	return ppp_xRx.len;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	static u8 aWire[PPP_TEST_MAX * 2 + 16];
+	size_t i, n;
+
+	test_Init(argc, argv);
+
+	ppp_TestOutput();
+	ppp_TestInput();
+	ppp_TestAcfc();
+
+	for (i = 0; i < PPP_PROCLEN + PPP_MRU; i++)
+		ppptbuf[i] = test_Rand();
+	TEST_BENCH("ppp_output (1500 bytes)", 2000, ppp_BenchOutput());
+	n = ppp_RefFrame(aWire, 1, 0x0057, ppptbuf, PPP_MRU);
+	TEST_BENCH("ppp_process (1500 bytes)", 2000, ppp_BenchInput(aWire, n));
+
+	buf_Release(ppp_bOut);
+	return test_Result("ppp");
+}
+
@@ -0,0 +1,180 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_rtt.h"
+
+#include "../fs/dfs.c"
+#include "../fs/dfs_fs.c"
+#include "../fs/dfs_file.c"
+#include "../fs/romfs/dfs_romfs.c"
+
+
+//Private Defines
+#define ROMFS_BIG_QTY			600
+
+
+//Private Variables
+static const rt_uint8_t romfs_aData[] = "romfs test data";
+
+static const struct romfs_dirent romfs_aSub[] = {
+	{ROMFS_DIRENT_FILE, "x", romfs_aData, sizeof(romfs_aData)},
+	{ROMFS_DIRENT_FILE, "y", romfs_aData, 5},
+};
+
+//δĿ¼,˳
+static const struct romfs_dirent romfs_aMix[] = {
+	{ROMFS_DIRENT_FILE, "zeta", romfs_aData, 1},
+	{ROMFS_DIRENT_FILE, "alpha", romfs_aData, 2},
+	{ROMFS_DIRENT_FILE, "al", romfs_aData, 3},
+};
+
+static char romfs_aName[ROMFS_BIG_QTY][8];
+static struct romfs_dirent romfs_aBig[ROMFS_BIG_QTY];
+static struct romfs_dirent romfs_xBig = {ROMFS_DIRENT_DIR_SORTED, "big", (const rt_uint8_t *)romfs_aBig, ROMFS_BIG_QTY};
+static struct romfs_dirent romfs_xBigLinear = {ROMFS_DIRENT_DIR, "big", (const rt_uint8_t *)romfs_aBig, ROMFS_BIG_QTY};
+
+static struct romfs_dirent romfs_aRoot[] = {
+	{ROMFS_DIRENT_FILE, "a", romfs_aData, 1},
+	{ROMFS_DIRENT_DIR_SORTED, "ab", (const rt_uint8_t *)romfs_aSub, ARR_SIZE(romfs_aSub)},
+	{ROMFS_DIRENT_FILE, "abc", romfs_aData, 3},
+	{ROMFS_DIRENT_DIR_SORTED, "big", (const rt_uint8_t *)romfs_aBig, ROMFS_BIG_QTY},
+	{ROMFS_DIRENT_DIR, "mix", (const rt_uint8_t *)romfs_aMix, ARR_SIZE(romfs_aMix)},
+};
+static struct romfs_dirent romfs_xRoot = {ROMFS_DIRENT_DIR_SORTED, "/", (const rt_uint8_t *)romfs_aRoot, ARR_SIZE(romfs_aRoot)};
+
+
+//Internal Functions
+//ֽɲȳļ:f000..,g,g0,g00..
+static void romfs_BigInit()
+{
+	int i;
+
+	for (i = 0; i < ROMFS_BIG_QTY / 2; i++)
+		sprintf(romfs_aName[i], "f%03d", i);
+	for (; i < ROMFS_BIG_QTY; i++)
+		sprintf(romfs_aName[i], "g%.*s%d", (i % 3), "00", i);
+	qsort(romfs_aName, ROMFS_BIG_QTY, sizeof(romfs_aName[0]), (int (*)(const void *, const void *))strcmp);
+	for (i = 0; i < ROMFS_BIG_QTY; i++)
+	{
+		romfs_aBig[i].type = ROMFS_DIRENT_FILE;
+		romfs_aBig[i].name = romfs_aName[i];
+		romfs_aBig[i].data = romfs_aData;
+		romfs_aBig[i].size = i;
+	}
+}
+
+static const struct romfs_dirent *romfs_Find(const char *pPath)
+{
+	rt_size_t nSize;
+
+	return dfs_romfs_lookup(&romfs_xRoot, pPath, &nSize);
+}
+
+//ƥ,ǰ׺ƾ
+static void romfs_TestExact()
+{
+	const struct romfs_dirent *d;
+
+	TEST_CHECK(romfs_Find("/") == &romfs_xRoot, "root");
+	TEST_CHECK(romfs_Find("/a") == &romfs_aRoot[0], "/a");
+	TEST_CHECK(romfs_Find("/ab") == &romfs_aRoot[1], "/ab");
+	TEST_CHECK(romfs_Find("/abc") == &romfs_aRoot[2], "/abc");
+	TEST_CHECK(romfs_Find("/abd") == NULL, "/abd");
+	TEST_CHECK(romfs_Find("/abcd") == NULL, "/abcd");
+	TEST_CHECK(romfs_Find("/ab/x") == &romfs_aSub[0], "/ab/x");
+	TEST_CHECK(romfs_Find("//ab//y") == &romfs_aSub[1], "//ab//y");
+	TEST_CHECK(romfs_Find("/ab/") == &romfs_aRoot[1], "/ab/");
+	TEST_CHECK(romfs_Find("/ab/z") == NULL, "/ab/z");
+	TEST_CHECK(romfs_Find("/ab/xy") == NULL, "/ab/xy");
+	TEST_CHECK(romfs_Find("/mix/al") == &romfs_aMix[2], "/mix/al");
+	TEST_CHECK(romfs_Find("/mix/alpha") == &romfs_aMix[1], "/mix/alpha");
+	TEST_CHECK(romfs_Find("/mix/alp") == NULL, "/mix/alp");
+	TEST_CHECK(romfs_Find("/mix/zeta") == &romfs_aMix[0], "/mix/zeta");
+	TEST_CHECK(romfs_Find("/big/g") == NULL, "/big/g");
+	TEST_CHECK(romfs_Find("/big/g30") == NULL, "/big/g30");
+	d = romfs_Find("/big/g300");
+	TEST_CHECK((d != NULL) && (strcmp(d->name, "g300") == 0), "/big/g300");
+}
+
+//Ŀ¼ֲ˳ҽһ
+static void romfs_TestSorted()
+{
+	char str[16];
+	int i, nErr;
+
+	for (nErr = 0, i = 0; i < ROMFS_BIG_QTY; i++)
+	{
+		if (romfs_dirent_find(&romfs_xBig, romfs_aName[i], strlen(romfs_aName[i])) != i)
+			nErr += 1;
+		if (romfs_dirent_find(&romfs_xBigLinear, romfs_aName[i], strlen(romfs_aName[i])) != i)
+			nErr += 1;
+		//·Ӵ
+		sprintf(str, "%s/x", romfs_aName[i]);
+		if (romfs_dirent_find(&romfs_xBig, str, strlen(romfs_aName[i])) != i)
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%d sorted lookups wrong", nErr);
+	
+	for (nErr = 0, i = 0; i < 10000; i++)
+	{
+		int nLen = 1 + test_Rand() % 5, j;
+
+		for (j = 0; j < nLen; j++)
+			str[j] = "fg0123456789"[test_Rand() % 12];
+		str[nLen] = '\0';
+		if (romfs_dirent_find(&romfs_xBig, str, nLen) != romfs_dirent_find(&romfs_xBigLinear, str, nLen))
+			nErr += 1;
+	}
+	TEST_CHECK(nErr == 0, "%d random lookups differ from linear search", nErr);
+	
+	TEST_BENCH("romfs sorted find 600", 100000, romfs_dirent_find(&romfs_xBig, "g00599", 6));
+	TEST_BENCH("romfs linear find 600", 100000, romfs_dirent_find(&romfs_xBigLinear, "g00599", 6));
+}
+
+//DFSغĴ򿪡ȡ״̬Ŀ¼ö
+static void romfs_TestMount()
+{
+	struct dfs_fd xFd;
+	struct stat xStat;
+	struct dirent aDir[4];
+	char str[32];
+
+	dfs_init();
+	dfs_romfs_init();
+	TEST_CHECK(dfs_mount(RT_NULL, "/", "rom", 0, &romfs_xRoot) == 0, "mount");
+	
+	memset(&xFd, 0, sizeof(xFd));
+	TEST_CHECK(dfs_file_open(&xFd, "/ab/x", DFS_O_RDONLY) == 0, "open /ab/x");
+	TEST_CHECK(dfs_file_read(&xFd, str, sizeof(str)) == sizeof(romfs_aData), "read /ab/x");
+	TEST_CHECK(memcmp(str, romfs_aData, sizeof(romfs_aData)) == 0, "data /ab/x");
+	TEST_CHECK(dfs_file_close(&xFd) == 0, "close /ab/x");
+	
+	memset(&xFd, 0, sizeof(xFd));
+	TEST_CHECK(dfs_file_open(&xFd, "/ab/xy", DFS_O_RDONLY) < 0, "open /ab/xy");
+	TEST_CHECK(dfs_file_open(&xFd, "/abc", DFS_O_WRONLY) < 0, "open /abc for write");
+	
+	TEST_CHECK(dfs_file_stat("/ab", &xStat) == 0, "stat /ab");
+	TEST_CHECK(DFS_S_ISDIR(xStat.st_mode), "/ab not a directory");
+	TEST_CHECK(dfs_file_stat("/abc", &xStat) == 0, "stat /abc");
+	TEST_CHECK(DFS_S_ISREG(xStat.st_mode) && (xStat.st_size == 3), "/abc mode %o size %u", xStat.st_mode, (unsigned)xStat.st_size);
+	
+	memset(&xFd, 0, sizeof(xFd));
+	TEST_CHECK(dfs_file_open(&xFd, "/ab", DFS_O_RDONLY | DFS_O_DIRECTORY) == 0, "open dir /ab");
+	TEST_CHECK(dfs_file_getdents(&xFd, aDir, sizeof(aDir)) == 2 * sizeof(struct dirent), "getdents /ab");
+	TEST_CHECK((strcmp(aDir[0].d_name, "x") == 0) && (strcmp(aDir[1].d_name, "y") == 0), "dirents %s %s", aDir[0].d_name, aDir[1].d_name);
+	dfs_file_close(&xFd);
+}
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	
+	romfs_BigInit();
+	romfs_TestExact();
+	romfs_TestSorted();
+	romfs_TestMount();
+	
+	return test_Result("romfs");
+}
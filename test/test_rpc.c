@@ -0,0 +1,444 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_rtt.h"
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//rpc/types.hRT-ThreadminilibcԶ64λ,stdintͻ,ܿ
+#define int64_t					rpc_int64_t
+#define uint64_t				rpc_uint64_t
+
+#define mem_Malloc				malloc
+#define mem_Free				free
+#define rt_thread_self()		((void *)0x1000)
+#define rt_tick_get()			0x55AA
+
+//UDP׽:÷Ӧ,ӦŶӵrecvfromȡ
+#define socket					fs_Socket
+#define lwip_close				fs_Close
+#define setsockopt				fs_Setsockopt
+#define sendto					fs_Sendto
+#define recvfrom				fs_Recvfrom
+
+static int fs_Socket(int nDomain, int nType, int nProt)
+{
+
+	return 3;
+}
+
+static int fs_Close(int s)
+{
+
+	return 0;
+}
+
+static int fs_Setsockopt(int s, int nLevel, int nOpt, const void *pVal, socklen_t nLen)
+{
+
+	return 0;
+}
+
+
+static ssize_t fs_Sendto(int s, const void *pBuf, size_t nLen, int nFlag, const struct sockaddr *pTo, socklen_t nToLen);
+static ssize_t fs_Recvfrom(int s, void *pBuf, size_t nLen, int nFlag, struct sockaddr *pFrom, socklen_t *pFromLen);
+
+static unsigned short pmap_getport(struct sockaddr_in *raddr, unsigned long prog, unsigned long vers, unsigned int prot)
+{
+
+	return 0;
+}
+
+#include "../cp/rpc/xdr.c"
+#include "../cp/rpc/xdr_mem.c"
+#include "../cp/rpc/rpc_prot.c"
+#include "../cp/rpc/auth_none.c"
+#include "../cp/rpc/clnt_udp.c"
+
+
+//Private Defines
+#define FS_PROG					100003
+#define FS_VERS					3
+#define FS_QTY					8
+#define FS_MSG_SIZE				1500
+#define FS_VERF_SIZE			8
+#define FS_DATA_MAX				1024
+
+
+//Private Typedefs
+//ӦĽ:䳤
+typedef struct {
+	char *data;
+	unsigned int len;
+} fs_res;
+
+typedef struct {
+	int len;
+	char buf[FS_MSG_SIZE];
+} fs_msg;
+
+
+//Private Variables
+static fs_msg fs_aRep[FS_QTY];
+static int fs_nRep;
+static int fs_nDrop;			//>0ʱn
+static int fs_bReverse;			//Ӧͳ
+static int fs_nSend;
+
+
+//Internal Functions
+static u8 fs_Byte(u32 nXid, unsigned int i)
+{
+
+	return (u8)(nXid * 7 + i);
+}
+
+static bool_t fs_XdrRes(XDR *xdrs, fs_res *p)
+{
+
+	return xdr_bytes(xdrs, &p->data, &p->len, FS_DATA_MAX);
+}
+
+//:ΪҪصݳ,ӦǿУ
+static ssize_t fs_Sendto(int s, const void *pBuf, size_t nLen, int nFlag, const struct sockaddr *pTo, socklen_t nToLen)
+{
+	const u32 *pReq = pBuf;
+	u32 aBody[6], nXid, nSize;
+	unsigned int i;
+	fs_msg *pRep;
+	char *p;
+
+	fs_nSend += 1;
+	if (fs_nDrop && fs_nDrop--)
+		return nLen;
+	if (fs_nRep >= FS_QTY)
+		return nLen;
+	//xid,CALL,rpcvers,prog,vers,proc,cred,verfΪ
+	nXid = pReq[0];
+	nSize = ntohl(pReq[10]);
+	aBody[0] = nXid;
+	aBody[1] = htonl(REPLY);
+	aBody[2] = htonl(MSG_ACCEPTED);
+	aBody[3] = 0;					//AUTH_NULL
+	aBody[4] = htonl(FS_VERF_SIZE);
+	pRep = &fs_aRep[fs_nRep++];
+	p = pRep->buf;
+	memcpy(p, aBody, 20);
+	p += 20;
+	memset(p, 0xEE, FS_VERF_SIZE);
+	p += FS_VERF_SIZE;
+	aBody[0] = htonl(SUCCESS);
+	aBody[1] = htonl(nSize);
+	memcpy(p, aBody, 8);
+	p += 8;
+	for (i = 0; i < nSize; i++)
+		*p++ = fs_Byte(nXid, i);
+	for (; i & 3; i++)
+		*p++ = 0;
+	pRep->len = p - pRep->buf;
+	return nLen;
+}
+
+//Ӧʱʱ
+static ssize_t fs_Recvfrom(int s, void *pBuf, size_t nLen, int nFlag, struct sockaddr *pFrom, socklen_t *pFromLen)
+{
+	fs_msg *pRep;
+
+	if (fs_nRep == 0)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	if (fs_bReverse)
+		pRep = &fs_aRep[fs_nRep - 1];
+	else
+		pRep = &fs_aRep[0];
+	if ((size_t)pRep->len < nLen)
+		nLen = pRep->len;
+	memcpy(pBuf, pRep->buf, nLen);
+	fs_nRep -= 1;
+	if (fs_bReverse == 0)
+		memmove(&fs_aRep[0], &fs_aRep[1], fs_nRep * sizeof(fs_msg));
+	return nLen;
+}
+
+static int fs_Check(const fs_res *p, u32 nXid, unsigned int nSize)
+{
+	unsigned int i;
+
+	if (p->len != nSize)
+		return -1;
+	for (i = 0; i < nSize; i++)
+	{
+		if ((u8)p->data[i] != fs_Byte(nXid, i))
+			return -1;
+	}
+	return 0;
+}
+
+static CLIENT *fs_Create(void)
+{
+	struct sockaddr_in sa;
+	struct timeval tv = {1, 0};
+	int nSock = -1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(2049);
+	fs_nRep = 0;
+	fs_nDrop = 0;
+	fs_bReverse = 0;
+	fs_nSend = 0;
+	return clntudp_create(&sa, FS_PROG, FS_VERS, tv, &nSock);
+}
+
+static u32 fs_Xid(CLIENT *cl)
+{
+	struct cu_data *cu = (struct cu_data *)cl->cl_private;
+
+	return *(u32 *)cu->cu_outbuf;
+}
+
+//XDR:sinkֻһ䳤,sizeԼ,addrΪʱֱ
+static void fs_TestXdr(void)
+{
+	char aStream[64], aDst[16];
+	struct xdr_sink sink;
+	unsigned int nLen;
+	char *pData;
+	XDR xdrs;
+	int i;
+
+	xdrmem_create(&xdrs, aStream, sizeof(aStream), XDR_ENCODE);
+	pData = "0123456789";
+	nLen = 10;
+	xdr_bytes(&xdrs, &pData, &nLen, 64);
+	pData = "abcdef";
+	nLen = 6;
+	xdr_bytes(&xdrs, &pData, &nLen, 64);
+	TEST_CHECK(XDR_GETPOS(&xdrs) == 4 + 12 + 4 + 8, "encoded %u", XDR_GETPOS(&xdrs));
+
+	//ģʽ,ùһμʧЧ
+	xdrmem_create(&xdrs, aStream, sizeof(aStream), XDR_DECODE);
+	TEST_CHECK(xdrs.x_public == NULL, "fresh stream has a sink");
+	sink.addr = aDst;
+	sink.size = sizeof(aDst);
+	xdrmem_setsink(&xdrs, &sink);
+	pData = NULL;
+	TEST_CHECK(xdr_bytes(&xdrs, &pData, &nLen, 64), "copy decode failed");
+	TEST_CHECK(pData == aDst && nLen == 10 && sink.size == 10 &&
+		memcmp(aDst, "0123456789", 10) == 0, "copy sink content");
+	TEST_CHECK(xdrs.x_public == NULL, "sink not one-shot");
+	pData = NULL;
+	TEST_CHECK(xdr_bytes(&xdrs, &pData, &nLen, 64), "heap decode failed");
+	TEST_CHECK(pData != NULL && pData != aDst && nLen == 6 &&
+		memcmp(pData, "abcdef", 6) == 0, "second payload not on heap");
+	TEST_CHECK(XDR_GETPOS(&xdrs) == 28, "position %u", XDR_GETPOS(&xdrs));
+	free(pData);
+
+	//ݱsinkʱʧҲԽ
+	xdrmem_create(&xdrs, aStream, sizeof(aStream), XDR_DECODE);
+	memset(aDst, 0x5A, sizeof(aDst));
+	sink.addr = aDst;
+	sink.size = 4;
+	xdrmem_setsink(&xdrs, &sink);
+	pData = NULL;
+	TEST_CHECK(xdr_bytes(&xdrs, &pData, &nLen, 64) == FALSE, "oversize payload accepted");
+	for (i = 0; i < (int)sizeof(aDst); i++)
+	{
+		if (aDst[i] != 0x5A)
+			break;
+	}
+	TEST_CHECK(i == sizeof(aDst), "oversize payload written to sink");
+
+	//ԭ,λð4ֽڶǰ
+	xdrmem_create(&xdrs, aStream, sizeof(aStream), XDR_DECODE);
+	sink.addr = NULL;
+	sink.size = 0;
+	xdrmem_setsink(&xdrs, &sink);
+	pData = NULL;
+	TEST_CHECK(xdr_bytes(&xdrs, &pData, &nLen, 64), "in-place decode failed");
+	TEST_CHECK(pData == aStream + 4 && sink.size == 10, "in-place pointer");
+	TEST_CHECK(XDR_GETPOS(&xdrs) == 16, "in-place position %u", XDR_GETPOS(&xdrs));
+
+	//ضϵԽ
+	xdrmem_create(&xdrs, aStream, 10, XDR_DECODE);
+	xdrmem_setsink(&xdrs, &sink);
+	pData = NULL;
+	TEST_CHECK(xdr_bytes(&xdrs, &pData, &nLen, 64) == FALSE, "truncated stream accepted");
+}
+
+//ͬ:sinkֻս,У߶,һεûָ
+static void fs_TestCall(void)
+{
+	struct timeval tv = {1, 0};
+	char aDst[FS_DATA_MAX];
+	struct xdr_sink sink;
+	unsigned int nSize;
+	fs_res res;
+	CLIENT *cl;
+	u32 nXid;
+
+	cl = fs_Create();
+	TEST_CHECK(cl != NULL, "create failed");
+	if (cl == NULL)
+		return;
+
+	sink.addr = aDst;
+	sink.size = sizeof(aDst);
+	TEST_CHECK(CLNT_CONTROL(cl, CLSET_SINK, (char *)&sink), "CLSET_SINK refused");
+	nSize = 700;
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize,
+		(xdrproc_t)fs_XdrRes, (char *)&res, tv) == RPC_SUCCESS, "sink call failed");
+	nXid = fs_Xid(cl);
+	TEST_CHECK(res.data == aDst && sink.size == 700, "payload not in sink");
+	TEST_CHECK(fs_Check(&res, nXid, 700) == 0, "sink payload corrupt");
+
+	nSize = 33;
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize,
+		(xdrproc_t)fs_XdrRes, (char *)&res, tv) == RPC_SUCCESS, "plain call failed");
+	TEST_CHECK(res.data != NULL && res.data != aDst, "sink applied twice");
+	TEST_CHECK(fs_Check(&res, fs_Xid(cl), 33) == 0, "heap payload corrupt");
+	CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res);
+	TEST_CHECK(res.data == NULL, "freeres");
+
+	//sinkʱʧ
+	sink.addr = aDst;
+	sink.size = 100;
+	CLNT_CONTROL(cl, CLSET_SINK, (char *)&sink);
+	nSize = 101;
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize,
+		(xdrproc_t)fs_XdrRes, (char *)&res, tv) == RPC_CANTDECODERES, "oversize reply accepted");
+
+	//Ӧʧʱط
+	fs_nDrop = 2;
+	fs_nSend = 0;
+	nSize = 16;
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize,
+		(xdrproc_t)fs_XdrRes, (char *)&res, tv) == RPC_SUCCESS, "retry call failed");
+	TEST_CHECK(fs_nSend == 3 && fs_Check(&res, fs_Xid(cl), 16) == 0, "retry sent %d", fs_nSend);
+	CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res);
+
+	fs_nDrop = CLNTUDP_RETRY + 1;
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize,
+		(xdrproc_t)fs_XdrRes, (char *)&res, tv) == RPC_CANTRECV, "lost call succeeded");
+
+	CLNT_DESTROY(cl);
+}
+
+//ֶε:Ӧݴ,ԭõĽһεǰЧ
+static void fs_TestSplit(void)
+{
+	u32 aXid[CLNTUDP_PENDING], nXid;
+	unsigned int aSize[CLNTUDP_PENDING];
+	struct cu_data *cu;
+	struct xdr_sink sink;
+	fs_res res;
+	CLIENT *cl;
+	int i;
+
+	cl = fs_Create();
+	if (cl == NULL)
+		return;
+	cu = (struct cu_data *)cl->cl_private;
+
+	fs_bReverse = 1;
+	for (i = 0; i < CLNTUDP_PENDING; i++)
+	{
+		aSize[i] = 100 + i * 50;
+		TEST_CHECK(clntudp_send(cl, 1, (xdrproc_t)xdr_u_int, (char *)&aSize[i], &aXid[i]) == RPC_SUCCESS,
+			"send %d failed", i);
+	}
+	TEST_CHECK(clntudp_send(cl, 1, (xdrproc_t)xdr_u_int, (char *)&aSize[0], &nXid) == RPC_CANTSEND,
+		"pending limit not enforced");
+
+	//յһ,Ӧȵݴ
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clntudp_recv(cl, aXid[0], (xdrproc_t)fs_XdrRes, (char *)&res) == RPC_SUCCESS, "recv 0 failed");
+	TEST_CHECK(fs_Check(&res, aXid[0], aSize[0]) == 0, "recv 0 payload");
+	CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res);
+	for (i = 1; i < CLNTUDP_PENDING; i++)
+		TEST_CHECK(cu->cu_pend[i].buf != NULL, "reply %d not stashed", i);
+
+	for (i = 1; i < CLNTUDP_PENDING; i++)
+	{
+		sink.addr = NULL;
+		sink.size = 0;
+		CLNT_CONTROL(cl, CLSET_SINK, (char *)&sink);
+		memset(&res, 0, sizeof(res));
+		TEST_CHECK(clntudp_recv(cl, aXid[i], (xdrproc_t)fs_XdrRes, (char *)&res) == RPC_SUCCESS,
+			"recv %d failed", i);
+		TEST_CHECK(cu->cu_held != NULL && res.data > cu->cu_held &&
+			res.data + res.len <= cu->cu_held + FS_MSG_SIZE, "payload %d not in held reply", i);
+		TEST_CHECK(fs_Check(&res, aXid[i], aSize[i]) == 0, "recv %d payload", i);
+	}
+	for (i = 0; i < CLNTUDP_PENDING; i++)
+		TEST_CHECK(cu->cu_pend[i].busy == FALSE, "slot %d still busy", i);
+
+	//ʧķֶεðط
+	fs_bReverse = 0;
+	fs_nDrop = 1;
+	fs_nSend = 0;
+	aSize[0] = 64;
+	clntudp_send(cl, 1, (xdrproc_t)xdr_u_int, (char *)&aSize[0], &nXid);
+	TEST_CHECK(cu->cu_held == NULL, "held reply kept across a call");
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clntudp_recv(cl, nXid, (xdrproc_t)fs_XdrRes, (char *)&res) == RPC_SUCCESS, "resent recv failed");
+	TEST_CHECK(fs_nSend == 2 && fs_Check(&res, nXid, 64) == 0, "resent sent %d", fs_nSend);
+	CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res);
+
+	//ȡĵóٵӦ𱻶
+	clntudp_send(cl, 1, (xdrproc_t)xdr_u_int, (char *)&aSize[0], &nXid);
+	clntudp_cancel(cl, nXid);
+	TEST_CHECK(clntudp_recv(cl, nXid, (xdrproc_t)fs_XdrRes, (char *)&res) == RPC_CANTRECV, "cancelled call collected");
+	aSize[1] = 8;
+	memset(&res, 0, sizeof(res));
+	TEST_CHECK(clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&aSize[1],
+		(xdrproc_t)fs_XdrRes, (char *)&res, cu->cu_wait) == RPC_SUCCESS, "call after cancel failed");
+	TEST_CHECK(fs_Check(&res, fs_Xid(cl), 8) == 0, "stale reply taken");
+	CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res);
+
+	CLNT_DESTROY(cl);
+}
+
+static void fs_Bench(void)
+{
+	struct timeval tv = {1, 0};
+	char aDst[FS_DATA_MAX];
+	struct xdr_sink sink;
+	unsigned int nSize = FS_DATA_MAX;
+	fs_res res;
+	CLIENT *cl;
+
+	cl = fs_Create();
+	if (cl == NULL)
+		return;
+	TEST_BENCH("call heap 1k", 100000,
+		(memset(&res, 0, sizeof(res)),
+		clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize, (xdrproc_t)fs_XdrRes, (char *)&res, tv),
+		CLNT_FREERES(cl, (xdrproc_t)fs_XdrRes, (char *)&res)));
+	TEST_BENCH("call sink 1k", 100000,
+		(sink.addr = aDst, sink.size = sizeof(aDst), CLNT_CONTROL(cl, CLSET_SINK, (char *)&sink),
+		res.data = NULL,
+		clnt_call(cl, 1, (xdrproc_t)xdr_u_int, (char *)&nSize, (xdrproc_t)fs_XdrRes, (char *)&res, tv)));
+	CLNT_DESTROY(cl);
+}
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+
+	fs_TestXdr();
+	fs_TestCall();
+	fs_TestSplit();
+	fs_Bench();
+
+	return test_Result("rpc");
+}
@@ -0,0 +1,217 @@
+#ifndef __TEST_RTT_H__
+#define __TEST_RTT_H__
+
+//-------------------------------------------------------------------------
+//RT-Thread,DFSļϵͳģʹ
+//pthreadʵ,жһȫֵݹ
+//-------------------------------------------------------------------------
+#include <pthread.h>
+#include <stdarg.h>
+
+//ʵںͷļ
+#define __RT_THREAD_H__
+#define __RT_HW_H__
+#define RT_USING_MINILIBC
+#define RT_NAME_MAX				8
+
+#ifndef DFS_FILESYSTEMS_MAX
+#define DFS_FILESYSTEMS_MAX		2
+#endif
+#ifndef DFS_FD_MAX
+#define DFS_FD_MAX				4
+#endif
+
+
+//Public Typedefs
+typedef int8_t		rt_int8_t;
+typedef int16_t		rt_int16_t;
+typedef signed long	rt_int32_t;
+typedef uint8_t		rt_uint8_t;
+typedef uint16_t	rt_uint16_t;
+typedef unsigned long	rt_uint32_t;
+typedef int			rt_bool_t;
+typedef long		rt_base_t;
+typedef unsigned long	rt_ubase_t;
+typedef rt_base_t	rt_err_t;
+typedef rt_uint32_t	rt_time_t;
+typedef rt_uint32_t	rt_tick_t;
+typedef rt_ubase_t	rt_size_t;
+typedef rt_base_t	rt_off_t;
+
+typedef struct rt_device *rt_device_t;
+//豸Ŀrt_uint8_t
+struct rt_device
+{
+	struct { char name[RT_NAME_MAX]; } parent;
+	int			type;
+	rt_uint16_t	flag;
+	rt_uint8_t	ref_count;
+	rt_err_t	(*init)(rt_device_t dev);
+	rt_err_t	(*open)(rt_device_t dev, rt_uint16_t oflag);
+	rt_err_t	(*close)(rt_device_t dev);
+	rt_size_t	(*read)(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size);
+	rt_size_t	(*write)(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size);
+	rt_err_t	(*control)(rt_device_t dev, rt_uint8_t cmd, void *args);
+	void		*user_data;
+};
+
+struct rt_device_blk_geometry
+{
+	rt_uint32_t	sector_count;
+	rt_uint32_t	bytes_per_sector;
+	rt_uint32_t	block_size;
+};
+
+struct rt_mutex
+{
+	pthread_mutex_t	m;
+};
+typedef struct rt_mutex *rt_mutex_t;
+typedef void *rt_sem_t;
+
+
+//Public Defines
+#define RT_NULL					NULL
+#define RT_EOK					0
+#define RT_ERROR				1
+#define RT_TRUE					1
+#define RT_FALSE				0
+#define RT_IPC_FLAG_FIFO		0
+#define RT_WAITING_FOREVER		-1
+#define RT_DEVICE_OFLAG_RDWR	0x003
+#define RT_DEVICE_FLAG_RDWR		0x003
+#define RT_DEVICE_FLAG_STANDALONE	0x008
+#define RT_DEVICE_CTRL_BLK_GETGEOME	0x10
+#define RT_DEVICE_CTRL_BLK_SYNC	0x11
+#define RT_Device_Class_Block	1
+#define RT_ASSERT(x)			do { if (!(x)) { printf("%s:%d: assert %s\n", __FILE__, __LINE__, #x); abort(); } } while (0)
+
+
+//Private Variables
+static pthread_mutex_t test_rtt_irq __attribute__((unused)) = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static volatile int test_rtt_errno;
+
+
+//External Functions
+static __INLINE rt_base_t rt_hw_interrupt_disable(void)
+{
+
+	pthread_mutex_lock(&test_rtt_irq);
+	return 0;
+}
+
+static __INLINE void rt_hw_interrupt_enable(rt_base_t level)
+{
+
+	pthread_mutex_unlock(&test_rtt_irq);
+}
+
+static __INLINE rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&mutex->m, &attr);
+	pthread_mutexattr_destroy(&attr);
+	return RT_EOK;
+}
+
+static __INLINE rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+
+	pthread_mutex_destroy(&mutex->m);
+	return RT_EOK;
+}
+
+static __INLINE rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
+{
+
+	pthread_mutex_lock(&mutex->m);
+	return RT_EOK;
+}
+
+static __INLINE rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+
+	pthread_mutex_unlock(&mutex->m);
+	return RT_EOK;
+}
+
+#define rt_malloc				malloc
+#define rt_free					free
+#define rt_strdup				strdup
+#define rt_memset				memset
+#define rt_memcpy				memcpy
+#define rt_strlen				strlen
+#define rt_strncmp				strncmp
+#define rt_snprintf				snprintf
+#define rt_kprintf(...)
+#define rt_set_errno(e)			(test_rtt_errno = (e))
+
+static __INLINE char *rt_strncpy(char *dst, const char *src, rt_ubase_t n)
+{
+
+	return memcpy(dst, src, MIN(strlen(src) + 1, n));
+}
+
+//ֻǼһ豸,κƶ
+static rt_device_t test_rtt_dev;
+
+static __INLINE rt_err_t rt_device_register(rt_device_t dev, const char *name, rt_uint16_t flags)
+{
+
+	strncpy(dev->parent.name, name, RT_NAME_MAX);
+	dev->flag = flags;
+	test_rtt_dev = dev;
+	return RT_EOK;
+}
+
+static __INLINE rt_device_t rt_device_find(const char *name)
+{
+	static struct rt_device dev;
+
+	return (test_rtt_dev != RT_NULL) ? test_rtt_dev : &dev;
+}
+
+static __INLINE rt_err_t rt_device_open(rt_device_t dev, rt_uint16_t oflag)
+{
+
+	dev->ref_count += 1;
+	if (dev->open != RT_NULL)
+		return dev->open(dev, oflag);
+	return RT_EOK;
+}
+
+static __INLINE rt_err_t rt_device_close(rt_device_t dev)
+{
+
+	dev->ref_count -= 1;
+	if (dev->close != RT_NULL)
+		return dev->close(dev);
+	return RT_EOK;
+}
+
+static __INLINE rt_size_t rt_device_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+
+	return dev->read(dev, pos, buffer, size);
+}
+
+static __INLINE rt_size_t rt_device_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+
+	return dev->write(dev, pos, buffer, size);
+}
+
+static __INLINE rt_err_t rt_device_control(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+
+	if (dev->control != RT_NULL)
+		return dev->control(dev, cmd, args);
+	return RT_EOK;
+}
+
+
+#endif
+
@@ -0,0 +1,272 @@
+#include <ctype.h>
+#include <stdarg.h>
+#include <limits.h>
+#include "test.h"
+#include "../lib/bcd.c"
+#include "../lib/ecc.c"
+
+//minilibc,libcͬ
+#define memset					lib_memset
+#define memcpy					lib_memcpy
+#define memmove					lib_memmove
+#define memcmp					lib_memcmp
+#define strlen					lib_strlen
+#define strcpy					lib_strcpy
+#define strncpy					lib_strncpy
+#define strlcpy					lib_strlcpy
+#define strcmp					lib_strcmp
+#define strncmp					lib_strncmp
+#define strcat					lib_strcat
+#define strncat					lib_strncat
+#define strrchr					lib_strrchr
+#define strncasecmp				lib_strncasecmp
+#define vsnprintf				lib_vsnprintf
+#define snprintf				lib_snprintf
+#define vsprintf				lib_vsprintf
+#define sprintf					lib_sprintf
+#define simple_strtoul			lib_simple_strtoul
+#define simple_strtol			lib_simple_strtol
+#define simple_strtoull			lib_simple_strtoull
+#define simple_strtoll			lib_simple_strtoll
+#define strspn					lib_strspn
+#define strcspn					lib_strcspn
+#define strtok_r				lib_strtok_r
+#define strtok					lib_strtok
+#define strchr					lib_strchr
+#define strtol					lib_strtol
+#define strtoll					lib_strtoll
+#define atoi					lib_atoi
+#define atol					lib_atol
+#define LIB_MINILIBC_ENABLE		1
+
+//string.cúĺ
+char *strncpy(char *dst, const char *src, size_t n);
+
+#include "../lib/string.c"
+
+#undef memset
+#undef memcpy
+#undef memmove
+#undef memcmp
+#undef strlen
+#undef strcpy
+#undef strncpy
+#undef strlcpy
+#undef strcmp
+#undef strncmp
+#undef strcat
+#undef strncat
+#undef strrchr
+#undef strncasecmp
+#undef vsnprintf
+#undef snprintf
+#undef vsprintf
+#undef sprintf
+#undef simple_strtoul
+#undef simple_strtol
+#undef simple_strtoull
+#undef simple_strtoll
+#undef strspn
+#undef strcspn
+#undef strtok_r
+#undef strtok
+#undef strchr
+#undef strtol
+#undef strtoll
+#undef atoi
+#undef atol
+
+
+//Private Defines
+#define STR_TEST_QTY			1000000
+
+//
+#define STR_ARG_INT				0	//·,intȡ
+#define STR_ARG_WIDE			1	//ͨ·,Ŀƽ̨longȡ,봫long
+#define STR_ARG_LONG			2	//l,߶long
+
+
+//Private Typedefs
+typedef struct {
+	const char *	fmt;
+	int				type;
+} t_str_fmt;
+
+
+//Private Consts
+static const t_str_fmt str_aFmt[] = {
+	{"%d", STR_ARG_INT}, {"%u", STR_ARG_INT}, {"%x", STR_ARG_INT}, {"%X", STR_ARG_INT},
+	{"%02X", STR_ARG_INT}, {"%02x", STR_ARG_INT}, {"[%d]", STR_ARG_INT}, {" %02X", STR_ARG_INT},
+	{"%5d", STR_ARG_WIDE}, {"%-5d|", STR_ARG_WIDE}, {"%05d", STR_ARG_WIDE}, {"%+d", STR_ARG_WIDE},
+	{"% d", STR_ARG_WIDE}, {"%8X", STR_ARG_WIDE}, {"%-8x|", STR_ARG_WIDE}, {"%.3d", STR_ARG_WIDE},
+	{"%08X", STR_ARG_WIDE}, {"%i", STR_ARG_WIDE}, {"%o", STR_ARG_WIDE}, {"%3u%%", STR_ARG_WIDE},
+	{"%hd", STR_ARG_WIDE}, {"%hu", STR_ARG_WIDE},
+	{"%ld", STR_ARG_LONG}, {"%lu", STR_ARG_LONG}, {"%lx", STR_ARG_LONG}, {"%-9lX|", STR_ARG_LONG},
+};
+
+static const char * const str_aStrFmt[] = {"%s", "<%s>", "%3s", "%-6s|", "%.2s", "%10.3s"};
+static const char * const str_aStr[] = {"", "a", "hello", "0123456789"};
+
+
+//Internal Functions
+static int str_Lib(char *pBuf, size_t nSize, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = lib_vsnprintf(pBuf, nSize, fmt, args);
+	va_end(args);
+	return n;
+}
+
+static int str_Rand()
+{
+	static const int aEdge[] = {
+		0, 1, -1, 9, 10, 99, 100, 255, 256, 4095, INT_MIN, INT_MAX, -2, 1000000000, -1000000000,
+	};
+	u32 k = test_Rand() % 40;
+
+	if (k < ARR_SIZE(aEdge))
+		return aEdge[k];
+	if (k < 25)
+		return (int)(test_Rand() % 1000) - 500;
+	return (int)test_Rand();
+}
+
+//ʽ,glibc
+static int str_Print(int nLib, char *pBuf, size_t nSize, const t_str_fmt *f, int v)
+{
+	int nSign = (strpbrk(f->fmt, "di") != NULL);
+	long l = nSign ? (long)v : (long)(u32)v;
+
+	if (f->type == STR_ARG_INT)
+		return nLib ? str_Lib(pBuf, nSize, f->fmt, v) : snprintf(pBuf, nSize, f->fmt, v);
+	if (f->type == STR_ARG_WIDE)
+		return nLib ? str_Lib(pBuf, nSize, f->fmt, l) : snprintf(pBuf, nSize, f->fmt, v);
+	//longΪ64λ,%ldֻȡ31λڵֵ,Ŀƽ̨32λlongһ
+	if (!nSign)
+		l = v & INT_MAX;
+	return nLib ? str_Lib(pBuf, nSize, f->fmt, l) : snprintf(pBuf, nSize, f->fmt, l);
+}
+
+static void str_TestFormat()
+{
+	char a[64], b[64], c[64];
+	const t_str_fmt *f;
+	int i, v, na, nb, nc;
+	size_t n, l;
+
+	for (i = 0; i < STR_TEST_QTY; i++) {
+		f = &str_aFmt[test_Rand() % ARR_SIZE(str_aFmt)];
+		v = str_Rand();
+		na = str_Print(0, a, sizeof(a), f, v);
+		nb = str_Print(1, b, sizeof(b), f, v);
+		TEST_CHECK((na == nb) && (strcmp(a, b) == 0), "\"%s\" %d: \"%s\", expect \"%s\"", f->fmt, v, b, a);
+		//ضʱΪǰ׺
+		n = 1 + test_Rand() % 11;
+		memset(c, 'Q', sizeof(c));
+		nc = str_Print(1, c, n, f, v);
+		l = MIN(n - 1, (size_t)nb);
+		TEST_CHECK((nc == nb) && (memcmp(c, b, l) == 0) && (c[l] == '\0') && (c[n] == 'Q'),
+			"\"%s\" %d size %u: \"%s\" (%d), expect %d", f->fmt, v, (u32)n, c, nc, nb);
+	}
+	for (i = 0; i < 100000; i++) {
+		const char *fmt = str_aStrFmt[test_Rand() % ARR_SIZE(str_aStrFmt)];
+		const char *s = str_aStr[test_Rand() % ARR_SIZE(str_aStr)];
+
+		na = snprintf(a, sizeof(a), fmt, s);
+		nb = str_Lib(b, sizeof(b), fmt, s);
+		TEST_CHECK((na == nb) && (strcmp(a, b) == 0), "\"%s\" \"%s\": \"%s\", expect \"%s\"", fmt, s, b, a);
+	}
+	nb = str_Lib(b, sizeof(b), "%s|%c|%%|%-3c|", NULL, 'x', 'y');
+	TEST_CHECK((nb == 15) && (strcmp(b, "(NULL)|x|%|y  |") == 0), "misc: \"%s\"", b);
+}
+
+//hexdumpsprintf(" %02X")ѭȽ
+static void str_TestHexdump()
+{
+	char x[128], y[128];
+	u8 aData[64];
+	size_t nSize, nLen, l, j;
+	int i;
+
+	for (i = 0; i < 200000; i++) {
+		nSize = test_Rand() % 100;
+		nLen = test_Rand() % sizeof(aData);
+		for (j = 0; j < nLen; j++)
+			aData[j] = test_Rand();
+		memset(x, 'Q', sizeof(x));
+		memset(y, 'Q', sizeof(y));
+		if (nSize)
+			y[0] = '\0';
+		for (j = 0, l = 0; (j < nLen) && ((l + 3) < nSize); j++)
+			l += sprintf(&y[l], " %02X", aData[j]);
+		TEST_CHECK((hexdump(x, nSize, aData, nLen) == l) && (memcmp(x, y, nSize ? l + 1 : 1) == 0),
+			"hexdump(size %u, len %u)", (u32)nSize, (u32)nLen);
+	}
+}
+
+static u32 str_BenchLoop(const u8 *p, u32 n)
+{
+	static char str[256];
+	int i, l = 0;
+
+	for (i = 0; i < 64; i++)
+		l += str_Lib(&str[l], 4, " %02X", p[(i + n) & 63]);
+	return l;
+}
+
+
+
+//External Functions
+//hexdump_to_bufĻ,reallocʵ
+sys_res buf_Push(buf b, const void *p, size_t len)
+{
+	u8 *pNew;
+
+	pNew = realloc(b->p, b->len + len);
+	if (pNew == NULL)
+		return SYS_R_EMEM;
+	memcpy(pNew + b->len, p, len);
+	b->p = pNew;
+	b->len += len;
+	return SYS_R_OK;
+}
+
+sys_res buf_Cut(buf b, int offset, size_t len)
+{
+
+	memmove(b->p + offset, b->p + offset + len, b->len - offset - len);
+	b->len -= len;
+	return SYS_R_OK;
+}
+
+int main(int argc, char **argv)
+{
+	buf b = {0};
+	char str[64 * 3 + 1];
+	u8 aData[64];
+	u32 i;
+
+	test_Init(argc, argv);
+
+	str_TestFormat();
+	str_TestHexdump();
+
+	for (i = 0; i < sizeof(aData); i++)
+		aData[i] = test_Rand();
+	hexdump_to_buf(b, aData, sizeof(aData));
+	hexdump(str, sizeof(str), aData, sizeof(aData));
+	TEST_CHECK((b->len == strlen(str)) && (memcmp(b->p, str, b->len) == 0), "hexdump_to_buf");
+	free(b->p);
+
+	TEST_BENCH("vsnprintf %d", 1000000, str_Lib(str, 64, "%d", (int)(_i * 2654435761U)));
+	TEST_BENCH("glibc snprintf %d", 1000000, snprintf(str, 64, "%d", (int)(_i * 2654435761U)));
+	TEST_BENCH("vsnprintf %08X", 1000000, str_Lib(str, 64, "%08X", (long)(_i * 2654435761U)));
+	TEST_BENCH("vsnprintf 64 x \" %02X\"", 100000, str_BenchLoop(aData, _i));
+	TEST_BENCH("hexdump 64 bytes", 1000000, hexdump(str + (_i & 1), 190, aData, 63));
+
+	return test_Result("string");
+}
+
@@ -0,0 +1,379 @@
+#include "test.h"
+
+#define ATSVR_UART_ID			0
+#define ATSVR_CMUX_ENABLE		0
+#define ATSVR_TCP_ENABLE		1
+#define ATSVR_UDP_ENABLE		1
+#define ATSVR_BDID_ENABLE		0
+#define ATSVR_DEBUG_ENABLE		0
+#define ATSVR_PPP_FCS_CHECK		1
+#define OS_TICK_MS				10
+
+#define mem_Realloc				realloc
+#define mem_Free				free
+#include "../lib/buffer.c"
+#include "../lib/ecc.c"
+#include "../lib/lib.c"
+
+//atserver,tcp.cֻõ⼸ֶ
+typedef struct {
+	int		x;
+} uart_t;
+
+static struct {
+	u8		ppp;
+	u8		tmo;
+	buf		tbuf;
+} test_xAT;
+#define AT						(&test_xAT)
+
+static uart_t dev_Uart[1];
+
+static u32 test_nTick;
+#define os_tick_get()			(test_nTick)
+
+void atsvr_RxDo(void *data, size_t len);
+void uart_Send(uart_t *p, const void *pData, size_t nLen);
+
+void *ptrcpy(void *dst, const void *src, size_t count)
+{
+
+	memcpy(dst, src, count);
+	return (u8 *)dst + count;
+}
+
+int memtest(const void *s, const u8 c, int len)
+{
+	const u8 *p = (const u8 *)s;
+
+	for (; len; len--)
+	{
+		if (*p++ != c)
+			return 1;
+	}
+	return 0;
+}
+
+#include "../net/bdip/ppp.c"
+
+
+//Private Defines
+#define TP_PKT_QTY				256
+#define TP_PKT_SIZE				(IPTCPH_LEN + 4 + TCP_MSS)
+#define TP_PORT					5000
+
+
+//Private Typedefs
+struct tp_pkt
+{
+	u32		due;
+	u16		len;
+	u8		down;					//Զ˷
+	u8		data[TP_PKT_SIZE];
+};
+
+
+//Private Variables
+static struct tp_pkt tp_aPkt[TP_PKT_QTY];
+static int tp_nPkt;
+static u32 tp_nLat;					//ʱ(tick)
+static u32 tp_nLoss;				//ж(1/1000)
+static u16 tp_nWnd;					//Զͨ洰
+static u32 tp_nRcvNxt, tp_nSndNxt;	//Զ
+static u32 tp_nAcked;				//յȷϺ
+static buf tp_bRcv;					//Զյ
+static buf tp_bDev;					//˽atsvr
+static buf tp_bExp;					//˴
+static int tp_nSeg, tp_nAck;
+static int tp_nOverWnd, tp_nOverQty;
+static u32 tp_nAckNo;				//һȷϺ
+static u32 tp_nAckTick;
+
+
+//Internal Functions
+void atsvr_RxDo(void *data, size_t len)
+{
+
+	buf_Push(tp_bDev, data, len);
+}
+
+static void tp_Queue(int nDown, const void *pData, size_t nLen, u32 nDelay)
+{
+	struct tp_pkt *p;
+
+	if (tp_nPkt >= TP_PKT_QTY)
+		return;
+	p = &tp_aPkt[tp_nPkt++];
+	p->due = test_nTick + nDelay;
+	p->down = nDown;
+	p->len = nLen;
+	memcpy(p->data, pData, nLen);
+}
+
+//˷IP,ppp_outputʱppptbuf
+void uart_Send(uart_t *p, const void *pData, size_t nLen)
+{
+	struct tcp_header *t = TCPT;
+	u32 nSeq, nEnd;
+	int nData;
+
+	nLen = ntohs(IPT->len);
+	nData = nLen - IPH_LEN - (t->tcpoffset >> 4) * 4;
+	nSeq = ntohl(t->seqno);
+	if (nData > 0)
+	{
+		tp_nSeg += 1;
+		nEnd = nSeq + nData;
+		if ((s32)(nEnd - tp_nAcked) > tp_nWnd)
+			tp_nOverWnd += 1;
+		if ((s32)(nEnd - tp_nAcked) > ATSVR_TCP_WND_QTY * TCP_MSS)
+			tp_nOverQty += 1;
+	}
+	else if (t->flags == TCP_ACK)
+	{
+		tp_nAck += 1;
+		tp_nAckNo = ntohl(t->ackno);
+		tp_nAckTick = test_nTick;
+	}
+	if ((nData > 0) && ((test_Rand() % 1000) < tp_nLoss))
+		return;
+	tp_Queue(0, IPT, nLen, tp_nLat);
+}
+
+//Զ˷İдppprbuf󽻸ip_input
+static void tp_Send(int nFlag, u32 nSeq, const void *pData, size_t nLen, u32 nDelay)
+{
+	u8 aPkt[TP_PKT_SIZE];
+	struct ip_header *ip = (struct ip_header *)aPkt;
+	struct tcp_header *t = (struct tcp_header *)&aPkt[IPH_LEN];
+	int nOpt = (nFlag & TCP_SYN) ? 4 : 0;
+
+	memset(aPkt, 0, IPTCPH_LEN);
+	ip->vhl = 0x45;
+	ip->proto = IP_PROTO_TCP;
+	ip->len = htons(IPTCPH_LEN + nOpt + nLen);
+	t->srcport = htons(TP_PORT);
+	t->destport = htons(TP_PORT);
+	t->seqno = htonl(nSeq);
+	t->ackno = htonl(tp_nRcvNxt);
+	t->flags = nFlag;
+	t->wnd = htons(tp_nWnd);
+	t->tcpoffset = ((TCPH_LEN + nOpt) / 4) << 4;
+	if (nOpt)
+		memcpy(t->optdata, TCP_CONST_OPTMSS, 4);
+	if (nLen)
+		memcpy(&t->optdata[nOpt], pData, nLen);
+	tp_Queue(1, aPkt, IPTCPH_LEN + nOpt + nLen, nDelay);
+}
+
+//Զ:²ȷ,ظȷ
+static void tp_Peer(const u8 *pPkt)
+{
+	const struct ip_header *ip = (const struct ip_header *)pPkt;
+	const struct tcp_header *t = (const struct tcp_header *)&pPkt[IPH_LEN];
+	int nOff = (t->tcpoffset >> 4) * 4;
+	int nData = ntohs(ip->len) - IPH_LEN - nOff;
+	u32 nSeq = ntohl(t->seqno);
+
+	if (t->flags & TCP_SYN)
+	{
+		tp_nRcvNxt = nSeq + 1;
+		tp_Send(TCP_ACK, tp_nSndNxt, NULL, 0, tp_nLat);
+		return;
+	}
+	if (nData <= 0)
+		return;
+	if (nSeq == tp_nRcvNxt)
+	{
+		buf_Push(tp_bRcv, &pPkt[IPH_LEN + nOff], nData);
+		tp_nRcvNxt += nData;
+	}
+	tp_Send(TCP_ACK, tp_nSndNxt, NULL, 0, tp_nLat);
+}
+
+static void tp_Run()
+{
+	struct tp_pkt x;
+	int i;
+
+	for (i = 0; i < tp_nPkt; )
+	{
+		if ((s32)(test_nTick - tp_aPkt[i].due) < 0)
+		{
+			i++;
+			continue;
+		}
+		x = tp_aPkt[i];
+		memmove(&tp_aPkt[i], &tp_aPkt[i + 1], (tp_nPkt - i - 1) * sizeof(x));
+		tp_nPkt -= 1;
+		if (x.down == 0)
+		{
+			tp_Peer(x.data);
+			continue;
+		}
+		ppprbuf[0] = 0x00;
+		ppprbuf[1] = 0x21;
+		memcpy(&ppprbuf[PPP_PROCLEN], x.data, x.len);
+		if (((struct tcp_header *)&x.data[IPH_LEN])->flags & TCP_ACK)
+		{
+			u32 nAck = ntohl(((struct tcp_header *)&x.data[IPH_LEN])->ackno);
+			if ((s32)(nAck - tp_nAcked) > 0)
+				tp_nAcked = nAck;
+		}
+		ip_input();
+	}
+}
+
+static void tp_Connect(u32 nLat, u16 nWnd)
+{
+
+	tp_nPkt = 0;
+	tp_nLat = nLat;
+	tp_nLoss = 0;
+	tp_nWnd = nWnd;
+	tp_nSndNxt = 0x8000;
+	tp_nSeg = tp_nAck = 0;
+	tp_nOverWnd = tp_nOverQty = 0;
+	buf_Release(tp_bRcv);
+	buf_Release(tp_bDev);
+	buf_Release(AT->tbuf);
+	tcp_linked = 0;
+
+	tp_Send(TCP_SYN, tp_nSndNxt, NULL, 0, 0);
+	tp_nSndNxt += 1;
+	tp_Run();
+	tp_nAcked = tcp_seq;
+	TEST_CHECK(tcp_linked, "no connection");
+	for (; tp_nPkt; test_nTick++)
+		tp_Run();
+}
+
+//˷nLenֽ,tick
+static u32 tp_Upload(size_t nLen, u32 nLimit)
+{
+	u8 aBuf[512];
+	u32 nTick = test_nTick;
+	size_t i, n;
+
+	buf_Release(tp_bRcv);
+	buf_Release(tp_bExp);
+	for (; nLen; nLen -= n)
+	{
+		n = MIN(nLen, sizeof(aBuf));
+		for (i = 0; i < n; i++)
+			aBuf[i] = test_Rand();
+		buf_Push(AT->tbuf, aBuf, n);
+		buf_Push(tp_bExp, aBuf, n);
+	}
+	for (; (AT->tbuf->len || tp_nPkt) && (test_nTick - nTick < nLimit); test_nTick++)
+	{
+		tp_Run();
+		ppp_send();
+	}
+	return test_nTick - nTick;
+}
+
+//,ͣ;Զ˴ںͶ
+static void tp_TestUpload()
+{
+	u32 nTick, nStop;
+	int nSeg;
+
+	//30kB,150ms
+	tp_Connect(15, 0xFFFF);
+	nSeg = (30000 + TCP_MSS - 1) / TCP_MSS;
+	nStop = nSeg * 2 * 15;
+	nTick = tp_Upload(30000, 5000);
+	TEST_CHECK((tp_bRcv->len == 30000) && (memcmp(tp_bRcv->p, tp_bExp->p, 30000) == 0),
+				"peer got %u of 30000 bytes", (u32)tp_bRcv->len);
+	TEST_CHECK(nTick * 3 < nStop, "30kB in %u ticks, stop-and-wait %u", nTick, nStop);
+	TEST_CHECK(tp_nSeg == nSeg, "%d segments for %d", tp_nSeg, nSeg);
+	TEST_CHECK(tp_nOverQty == 0, "%d segments beyond the segment window", tp_nOverQty);
+	if (test_nBench)
+		printf("  %-32s %8u ms, stop-and-wait %u ms\n", "30kB, 150ms one-way", nTick * OS_TICK_MS, nStop * OS_TICK_MS);
+
+	//Զ˴Сڶδ
+	tp_Connect(15, 2000);
+	nTick = tp_Upload(20000, 5000);
+	TEST_CHECK((tp_bRcv->len == 20000) && (memcmp(tp_bRcv->p, tp_bExp->p, 20000) == 0),
+				"peer got %u of 20000 bytes, small window", (u32)tp_bRcv->len);
+	TEST_CHECK(tp_nOverWnd == 0, "%d segments beyond the peer window", tp_nOverWnd);
+}
+
+//ʱط,
+static void tp_TestLoss()
+{
+	static const u32 tbl[] = {20, 100, 300};
+	u32 nTick;
+	int i;
+
+	for (i = 0; i < ARR_SIZE(tbl); i++)
+	{
+		tp_Connect(10, 0xFFFF);
+		tp_nLoss = tbl[i];
+		nTick = tp_Upload(40000, 60000);
+		TEST_CHECK((tp_bRcv->len == 40000) && (memcmp(tp_bRcv->p, tp_bExp->p, 40000) == 0),
+					"peer got %u of 40000 bytes, loss %u/1000", (u32)tp_bRcv->len, tbl[i]);
+		TEST_CHECK(AT->tbuf->len == 0, "%u bytes left unacknowledged, loss %u/1000", (u32)AT->tbuf->len, tbl[i]);
+		TEST_CHECK(tcp_rto >= TCP_RTO_MIN && tcp_rto <= TCP_RTO_MAX, "rto %d", tcp_rto);
+		if (test_nBench)
+			printf("  %-32s %8u ms, %d segments\n", tbl[i] == 20 ? "40kB, 2% loss" : tbl[i] == 100 ? "40kB, 10% loss" : "40kB, 30% loss",
+					nTick * OS_TICK_MS, tp_nSeg);
+	}
+}
+
+//Զ:ÿȷһ,һʱȷ
+static void tp_TestDelayedAck()
+{
+	u8 aBuf[100];
+	u32 nSeq, nTick;
+	int i, j;
+
+	tp_Connect(5, 0xFFFF);
+	buf_Release(tp_bRcv);
+	nSeq = tp_nSndNxt;
+	for (i = 0; i < 7; i++)
+	{
+		for (j = 0; j < sizeof(aBuf); j++)
+			aBuf[j] = test_Rand();
+		buf_Push(tp_bRcv, aBuf, sizeof(aBuf));
+		tp_Send(TCP_ACK | TCP_PSH, nSeq, aBuf, sizeof(aBuf), 0);
+		nSeq += sizeof(aBuf);
+	}
+	tp_nSndNxt = nSeq;
+	tp_nAck = 0;
+	nTick = test_nTick;
+	tp_Run();
+	TEST_CHECK((tp_bDev->len == tp_bRcv->len) && (memcmp(tp_bDev->p, tp_bRcv->p, tp_bDev->len) == 0),
+				"device got %u of %u bytes", (u32)tp_bDev->len, (u32)tp_bRcv->len);
+	TEST_CHECK(tp_nAck == 3, "%d ACKs for 7 segments", tp_nAck);
+	for (i = 0; i < TCP_ACK_TICK + 2; i++, test_nTick++)
+	{
+		tp_Run();
+		ppp_send();
+	}
+	TEST_CHECK(tp_nAck == 4, "%d ACKs after the delay", tp_nAck);
+	TEST_CHECK(tp_nAckTick - nTick == TCP_ACK_TICK, "delayed ACK after %u ticks", tp_nAckTick - nTick);
+	TEST_CHECK(tp_nAckNo == nSeq, "last ACK %08X, expected %08X", tp_nAckNo, nSeq);
+
+	//ȷ,ݲϽ
+	tp_nAck = 0;
+	buf_Release(tp_bDev);
+	tp_Send(TCP_ACK | TCP_PSH, nSeq + 50, aBuf, 50, 0);
+	tp_Run();
+	TEST_CHECK((tp_nAck == 1) && (tp_nAckNo == nSeq), "out of order: %d ACKs, ack %08X", tp_nAck, tp_nAckNo);
+	TEST_CHECK(tp_bDev->len == 0, "out of order data delivered");
+	for (; tp_nPkt; test_nTick++)
+		tp_Run();
+}
+
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	tp_TestUpload();
+	tp_TestLoss();
+	tp_TestDelayedAck();
+	return test_Result("tcp");
+}
@@ -0,0 +1,150 @@
+#define _GNU_SOURCE
+#include <time.h>
+
+
+//glibcοʵ,ڸǰȡ
+static struct tm *ref_gmtime_r(const time_t *t, struct tm *r)
+{
+
+	return gmtime_r(t, r);
+}
+
+static time_t ref_timegm(struct tm *t)
+{
+
+	return timegm(t);
+}
+
+//⺯,glibcͬ
+#define gmtime_r				lib_gmtime_r
+#define localtime_r				lib_localtime_r
+#define mktime					lib_mktime
+#undef __isleap
+#define __isleap				lib_isleap
+#define LIB_MINILIBC_ENABLE		1
+
+#include "test.h"
+#include "../lib/bcd.c"
+#include "../lib/time.c"
+
+
+//Private Defines
+#define TIME_DAY_QTY			47482		//1970-01-012099-12-31
+#define TIME_TEST_QTY			2000000
+
+
+//Internal Functions
+static int time_TmEq(const struct tm *a, const struct tm *b)
+{
+
+	return (a->tm_sec == b->tm_sec) && (a->tm_min == b->tm_min) && (a->tm_hour == b->tm_hour)
+		&& (a->tm_mday == b->tm_mday) && (a->tm_mon == b->tm_mon) && (a->tm_year == b->tm_year)
+		&& (a->tm_wday == b->tm_wday) && (a->tm_yday == b->tm_yday);
+}
+
+static void time_TestArray(time_t t, const struct tm *r)
+{
+	u8 aTime[6], aMon[2];
+	int nIsBcd, k, nMon;
+
+	for (nIsBcd = 0; nIsBcd < 2; nIsBcd++) {
+		timet2array(t, aTime, nIsBcd);
+		TEST_CHECK((aTime[0] == (nIsBcd ? bin2bcd8(r->tm_sec) : r->tm_sec))
+			&& (aTime[3] == (nIsBcd ? bin2bcd8(r->tm_mday) : r->tm_mday))
+			&& (aTime[4] == (nIsBcd ? bin2bcd8(r->tm_mon + 1) : r->tm_mon + 1))
+			&& (aTime[5] == (nIsBcd ? bin2bcd8(r->tm_year - 100) : r->tm_year - 100)),
+			"timet2array(%ld, %d)", (long)t, nIsBcd);
+		TEST_CHECK(array2timet(aTime, nIsBcd) == t, "array2timet(%ld, %d)", (long)t, nIsBcd);
+	}
+	for (k = -40; k <= 40; k += 3) {
+		nMon = (r->tm_year - 100) * 12 + r->tm_mon + k;
+		if (nMon < 0)
+			continue;
+		month4timet(t, k, aMon, 0);
+		TEST_CHECK((aMon[0] == (nMon % 12) + 1) && (aMon[1] == nMon / 12),
+			"month4timet(%ld, %d) = %u-%u", (long)t, k, aMon[1], aMon[0]);
+	}
+	TEST_CHECK(getday0(t) == t - (r->tm_hour * 3600 + r->tm_min * 60 + r->tm_sec), "getday0(%ld)", (long)t);
+}
+
+//glibcȽgmtime_r/mktimeת
+static void time_TestDays()
+{
+	struct tm a, b;
+	time_t t;
+	u32 d;
+
+	for (d = 0; d < TIME_DAY_QTY; d++) {
+		t = (time_t)d * TIME_SPD + test_Rand() % TIME_SPD;
+		ref_gmtime_r(&t, &a);
+		gmtime_r(&t, &b);
+		TEST_CHECK(time_TmEq(&a, &b), "gmtime_r(%ld)", (long)t);
+		a.tm_wday = a.tm_yday = -1;
+		TEST_CHECK((mktime(&a) == t) && time_TmEq(&a, &b), "mktime(%ld)", (long)t);
+		if (b.tm_year >= 100)
+			time_TestArray(t, &b);
+	}
+}
+
+//ֶγΧʱĹ,timegmȽ;1970뷵-1
+static void time_TestNormalize(int nYear, int nYearSpan)
+{
+	struct tm a, b, c;
+	time_t t, t1;
+	u32 i;
+
+	for (i = 0; i < TIME_TEST_QTY; i++) {
+		memset(&a, 0, sizeof(a));
+		a.tm_year = nYear + test_Rand() % nYearSpan;
+		a.tm_mon = test_Rand() % 60 - 24;
+		a.tm_mday = test_Rand() % 120 - 40;
+		a.tm_hour = test_Rand() % 100 - 30;
+		a.tm_min = test_Rand() % 200 - 100;
+		a.tm_sec = test_Rand() % 300 - 150;
+		b = c = a;
+		t = ref_timegm(&a);
+		t1 = mktime(&b);
+		if (t < 0)
+			TEST_CHECK(t1 == (time_t)-1, "mktime(%d-%d-%d %d:%d:%d) = %ld, expect -1",
+				c.tm_year, c.tm_mon, c.tm_mday, c.tm_hour, c.tm_min, c.tm_sec, (long)t1);
+		else
+			TEST_CHECK((t1 == t) && time_TmEq(&a, &b), "mktime(%d-%d-%d %d:%d:%d) = %ld, expect %ld",
+				c.tm_year, c.tm_mon, c.tm_mday, c.tm_hour, c.tm_min, c.tm_sec, (long)t1, (long)t);
+	}
+}
+
+static u32 time_BenchGmtime(u32 n)
+{
+	struct tm r;
+	time_t t = n >> 1;
+
+	gmtime_r(&t, &r);
+	return r.tm_mday;
+}
+
+static u32 time_BenchArray(u32 n)
+{
+	u8 aTime[6];
+
+	timet2array(946684800 + n % 3000000000U, aTime, 1);
+	return array2timet(aTime, 1);
+}
+
+
+
+//External Functions
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+
+	time_TestDays();
+	time_TestNormalize(75, 100);
+	time_TestNormalize(68, 4);
+
+	TEST_BENCH("gmtime_r", 10000000, time_BenchGmtime(_i * 2654435761U));
+	TEST_BENCH("timet2array + array2timet", 10000000, time_BenchArray(_i * 2654435761U));
+
+	return test_Result("time");
+}
+
@@ -0,0 +1,263 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "test_rtt.h"
+
+//U:ڴе,ɰעдʧ
+typedef int os_sem_t;
+#define os_sem_init(s, v)		(*(s) = (v))
+#define os_sem_wait(s)			(*(s) -= 1)
+#define os_sem_signal(s)		(*(s) += 1)
+
+void *usb_HostOpen(void);
+void usb_HostClose(void *p);
+int usb_HostIsConnected(void *p);
+int usb_HostMscRead(void *p, u32 nSector, void *pBuf, size_t nLen);
+int usb_HostMscWrite(void *p, u32 nSector, const void *pBuf, size_t nLen);
+
+#include "../fs/dfs_usbmsc.c"
+
+
+//Private Defines
+#define MSC_SECTORS				256
+#define MSC_LOOP				20000
+
+
+//Private Variables
+static u8 msc_aDisk[MSC_SECTORS][USBMSC_SECTOR_SIZE];
+static u8 msc_aModel[MSC_SECTORS][USBMSC_SECTOR_SIZE];
+static u32 msc_nRead, msc_nWrite;
+static int msc_nFail;			//>0ʱnдʧ
+static int msc_nPartial;		//ʧܵдд
+static rt_device_t msc_dev = &usbmsc_device;
+
+
+//Internal Functions
+static void msc_Fill(u8 *p, rt_size_t nSize)
+{
+	rt_size_t i;
+
+	for (i = 0; i < nSize * USBMSC_SECTOR_SIZE; i++)
+		p[i] = test_Rand();
+}
+
+static int msc_Dirty(u32 nPos)
+{
+
+#if USBMSC_WB_SECTORS
+	return usbmsc_wb_find(nPos) >= 0;
+#else
+	return 0;
+#endif
+}
+
+static int msc_Read(u32 nPos, rt_size_t nSize)
+{
+	u8 aBuf[16 * USBMSC_SECTOR_SIZE];
+
+	if (usbmsc_read(msc_dev, nPos, aBuf, nSize) != nSize)
+		return -1;
+	return memcmp(aBuf, msc_aModel[nPos], nSize * USBMSC_SECTOR_SIZE) ? 1 : 0;
+}
+
+//д벢ؽά
+static int msc_Write(u32 nPos, rt_size_t nSize)
+{
+	u8 aBuf[16 * USBMSC_SECTOR_SIZE];
+
+	msc_Fill(aBuf, nSize);
+	if (usbmsc_write(msc_dev, nPos, aBuf, nSize) == nSize)
+	{
+		memcpy(msc_aModel[nPos], aBuf, nSize * USBMSC_SECTOR_SIZE);
+		return 0;
+	}
+	//дʧܺδ豸ʵΪ׼
+	for (; nSize; nSize--, nPos++)
+	{
+		if (msc_Dirty(nPos) == 0)
+			memcpy(msc_aModel[nPos], msc_aDisk[nPos], USBMSC_SECTOR_SIZE);
+	}
+	return -1;
+}
+
+static int msc_Sync()
+{
+
+	return usbmsc_control(msc_dev, RT_DEVICE_CTRL_BLK_SYNC, RT_NULL) == RT_EOK ? 0 : -1;
+}
+
+static void msc_Reset()
+{
+
+	msc_Fill(msc_aDisk[0], MSC_SECTORS);
+	memcpy(msc_aModel, msc_aDisk, sizeof(msc_aDisk));
+	msc_nFail = 0;
+	usbmsc_close(msc_dev);
+	usbmsc_open(msc_dev, RT_DEVICE_OFLAG_RDWR);
+	usbmsc_isready(msc_dev);
+	msc_nRead = msc_nWrite = 0;
+}
+
+//˳ϲΪԤ,дͬʱϲ
+static void msc_TestMerge()
+{
+	int i, nErr;
+
+	msc_Reset();
+	for (nErr = 0, i = 0; i < 64; i++)
+		nErr += (msc_Read(i, 1) != 0);
+	TEST_CHECK(nErr == 0, "%d sequential reads wrong", nErr);
+#if USBMSC_RA_SECTORS
+	TEST_CHECK(msc_nRead <= 64 / USBMSC_RA_SECTORS + 1, "%u commands for 64 sequential reads", msc_nRead);
+#else
+	TEST_CHECK(msc_nRead == 64, "%u commands for 64 reads", msc_nRead);
+#endif
+	
+	for (nErr = 0, i = 0; i < 16; i++)
+		nErr += msc_Write(100 + (i ^ 5), 1);
+	TEST_CHECK(nErr == 0, "%d single writes failed", nErr);
+	TEST_CHECK(msc_Sync() == 0, "sync");
+	TEST_CHECK(memcmp(msc_aDisk[100], msc_aModel[100], 16 * USBMSC_SECTOR_SIZE) == 0, "disk differs after sync");
+#if USBMSC_WB_SECTORS >= 16
+	TEST_CHECK(msc_nWrite == 1, "%u commands for 16 adjacent writes", msc_nWrite);
+#elif USBMSC_WB_SECTORS == 0
+	TEST_CHECK(msc_nWrite == 16, "%u commands for 16 writes", msc_nWrite);
+#endif
+}
+
+//дʧܺԤڲñδд豸
+static void msc_TestWriteFail()
+{
+	int i;
+
+	//дֻд˵һ
+	msc_Reset();
+	msc_Read(100, 1);
+	TEST_CHECK(msc_Read(101, 1) == 0, "fill window");
+	msc_nFail = 1;
+	msc_nPartial = 1;
+	TEST_CHECK(msc_Write(101, 4) != 0, "multi-sector write should fail");
+	for (i = 101; i < 105; i++)
+		TEST_CHECK(msc_Read(i, 1) == 0, "sector %d stale after failed write", i);
+	
+#if USBMSC_WB_SECTORS
+	//,дʧܵµдʧ
+	msc_Reset();
+	msc_Read(100, 1);
+	msc_Read(101, 1);
+	for (i = 0; i < USBMSC_WB_SECTORS; i++)
+		msc_Write(200 + 2 * (i % 20) + i / 20, 1);
+	msc_nFail = 1;
+	msc_nPartial = 0;
+	TEST_CHECK(msc_Write(102, 1) != 0, "single write with failing flush should fail");
+	TEST_CHECK(msc_Read(102, 1) == 0, "window holds data of a failed write");
+	for (i = 0; i < USBMSC_WB_SECTORS; i++)
+		TEST_CHECK(msc_Read(200 + 2 * (i % 20) + i / 20, 1) == 0, "dirty sector %d lost", i);
+	TEST_CHECK(msc_Sync() == 0, "sync after failure");
+	TEST_CHECK(memcmp(msc_aDisk, msc_aModel, sizeof(msc_aDisk)) == 0, "disk differs after sync");
+#endif
+}
+
+//дͬдʧ,ʼһ
+static void msc_TestRandom()
+{
+	int i, nErr = 0, nFail = 0;
+	u32 nPos = 0;
+	rt_size_t nSize;
+
+	msc_Reset();
+	for (i = 0; i < MSC_LOOP; i++)
+	{
+		switch (test_Rand() % 8)
+		{
+		case 0:
+			nPos = test_Rand() % MSC_SECTORS;
+			break;
+		case 1:
+		case 2:
+		case 3:
+			nErr += (msc_Read(nPos, 1) != 0);
+			nPos = (nPos + 1) % MSC_SECTORS;
+			break;
+		case 4:
+			nSize = 1 + test_Rand() % 12;
+			if (nPos + nSize > MSC_SECTORS)
+				nPos = MSC_SECTORS - nSize;
+			nErr += (msc_Read(nPos, nSize) != 0);
+			break;
+		case 5:
+			if ((test_Rand() % 8) == 0)
+			{
+				msc_nFail = 1 + test_Rand() % 3;
+				msc_nPartial = test_Rand() % 4;
+			}
+			nFail += (msc_Write(nPos, 1) != 0);
+			break;
+		case 6:
+			nSize = 2 + test_Rand() % 10;
+			if (nPos + nSize > MSC_SECTORS)
+				nPos = MSC_SECTORS - nSize;
+			nFail += (msc_Write(nPos, nSize) != 0);
+			break;
+		default:
+			if ((test_Rand() % 16) == 0)
+				msc_Sync();
+			break;
+		}
+	}
+	TEST_CHECK(nErr == 0, "%d of %d random reads wrong (%d failed writes)", nErr, MSC_LOOP, nFail);
+	TEST_CHECK(nFail > 0, "no write failure injected");
+	
+	msc_nFail = 0;
+	TEST_CHECK(msc_Sync() == 0, "final sync");
+	TEST_CHECK(memcmp(msc_aDisk, msc_aModel, sizeof(msc_aDisk)) == 0, "disk differs after final sync");
+}
+
+
+//External Functions
+void *usb_HostOpen() { return msc_aDisk; }
+void usb_HostClose(void *p) {}
+int usb_HostIsConnected(void *p) { return SYS_R_OK; }
+
+int usb_HostMscRead(void *p, u32 nSector, void *pBuf, size_t nLen)
+{
+
+	msc_nRead += 1;
+	if (nSector + nLen > MSC_SECTORS)
+		return -1;
+	memcpy(pBuf, msc_aDisk[nSector], nLen * USBMSC_SECTOR_SIZE);
+	return 0;
+}
+
+int usb_HostMscWrite(void *p, u32 nSector, const void *pBuf, size_t nLen)
+{
+
+	msc_nWrite += 1;
+	if (nSector + nLen > MSC_SECTORS)
+		return -1;
+	if (msc_nFail && (--msc_nFail == 0))
+	{
+		memcpy(msc_aDisk[nSector], pBuf, MIN((size_t)msc_nPartial, nLen) * USBMSC_SECTOR_SIZE);
+		return -1;
+	}
+	memcpy(msc_aDisk[nSector], pBuf, nLen * USBMSC_SECTOR_SIZE);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+
+	test_Init(argc, argv);
+	
+	usbmsc_dev_Init();
+	usbmsc_init(msc_dev);
+	
+	msc_TestMerge();
+	msc_TestWriteFail();
+	msc_TestRandom();
+	
+#if USBMSC_RA_SECTORS || USBMSC_WB_SECTORS
+	return test_Result("usbmsc");
+#else
+	return test_Result("usbmsc no cache");
+#endif
+}